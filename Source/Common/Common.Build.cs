@@ -31,10 +31,15 @@ public class Common : ModuleRules
             "InputCore",                // Input模块（EKeys相关）
             "DesktopPlatform",          // 桌面平台（文件对话框）
             "Json",                     // JSON parsing
-            "JsonUtilities"             // JSON utilities
+            "JsonUtilities",            // JSON utilities
+            "MusicDollRuntime",         // 运行时演奏资产（烘焙目标）
+            "LiveLinkInterface",        // 实时预览的 Live Link 源
+            "Sockets",                  // 流式导入的本地连接
+            "Networking"                // FTcpSocketBuilder（流式导入测试服务器）
         });
 
         PrivateDependencyModuleNames.AddRange(new string[] {
+            "AssetRegistry"             // 分段子序列资产注册
         });
     }
 }
\ No newline at end of file
@@ -4,516 +4,694 @@
 #include "ControlRig.h"
 #include "Math/UnrealMathSSE.h"
 #include "Math/Vector.h"
+#include "PoleTargetSolverCore.h"
 #include "RigVMDeveloper/Public/RigVMModel/RigVMFunctionLibrary.h"
 #include "Rigs/RigHierarchy.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(ArcDistributedIK)
 
 struct FArcDistributedIKData {
-    TArray<float> BoneLengths;
     float TotalChainLength;
     FVector ReferencePlaneNormal;
     FVector RootPosition;
     FVector InitialEffectorDistance;
 };
 
-FRigUnit_ArcDistributedIK_Execute() {
-    struct Local {
-        // ========================================
-        // 数据结构和基础计算
-        // ========================================
+bool FRigUnit_ArcDistributedIK_WorkData::IsValidFor(
+    const TArray<FRigElementKey>& InItems,
+    const URigHierarchy* InHierarchy) const {
+    if (!InHierarchy ||
+        TopologyVersion != (int32)InHierarchy->GetTopologyVersion() ||
+        CachedItems.Num() != InItems.Num() || CachedKeys != InItems ||
+        RestPositions.Num() != CachedItems.Num()) {
+        return false;
+    }
 
-        static float CalculateBoneLength(const FVector& Start,
-                                         const FVector& End) {
-            return FVector::Dist(Start, End);
+    // 初始姿态变化（如编辑骨骼的初始变换）时静止骨骼长度需要重新计算
+    for (int32 i = 0; i < CachedItems.Num(); ++i) {
+        if (!InHierarchy->GetInitialGlobalTransform(CachedItems[i].GetIndex())
+                 .GetLocation()
+                 .Equals(RestPositions[i], 0.0)) {
+            return false;
         }
+    }
+    return true;
+}
 
-        static FVector CalculateReferencePlaneNormal(
-            const FVector& RootPosition, const FVector& EffectorPosition,
-            const FVector& PoleTarget) {
-            FVector RootToEffector =
-                (EffectorPosition - RootPosition).GetSafeNormal();
-            FVector RootToPole = (PoleTarget - RootPosition).GetSafeNormal();
+void FRigUnit_ArcDistributedIK_WorkData::Reset() {
+    CachedKeys.Reset();
+    TopologyVersion = INDEX_NONE;
+    CachedItems.Reset();
+    CachedRootParent.Reset();
+    RestPositions.Reset();
+    RestBoneLengths.Reset();
+    RestChainLength = 0.0f;
+    Chain.Reset();
+    SolvedPositions.Reset();
+}
+
+namespace {
 
-            FVector PlaneNormal =
-                FVector::CrossProduct(RootToEffector, RootToPole);
+struct Local {
+    // ========================================
+    // 数据结构和基础计算
+    // ========================================
 
-            if (PlaneNormal.IsNearlyZero(KINDA_SMALL_NUMBER)) {
-                PlaneNormal =
-                    FVector::CrossProduct(RootToEffector, FVector::UpVector);
+    static float CalculateBoneLength(const FVector& Start,
+                                     const FVector& End) {
+        return FVector::Dist(Start, End);
+    }
 
-                if (PlaneNormal.IsNearlyZero(KINDA_SMALL_NUMBER)) {
-                    PlaneNormal = FVector::CrossProduct(RootToEffector,
-                                                        FVector::ForwardVector);
+    static FVector CalculateReferencePlaneNormal(
+        const FVector& RootPosition, const FVector& EffectorPosition,
+        const FVector& PoleTarget) {
+        return PoleTargetSolverCore::CalculateReferencePlaneNormal(
+            RootPosition, EffectorPosition, PoleTarget);
+    }
+
+    // 解析骨骼并计算静止姿态骨骼长度，结果保存在WorkData中跨帧复用
+    static bool BuildChainCache(URigHierarchy* Hierarchy,
+                                const TArray<FRigElementKey>& Items,
+                                FRigUnit_ArcDistributedIK_WorkData& Cache,
+                                bool bUseDebug) {
+        Cache.Reset();
+
+        Cache.CachedItems.Reserve(Items.Num());
+        for (int32 i = 0; i < Items.Num(); ++i) {
+            const FRigElementKey& Key = Items[i];
+            if (!Hierarchy->Find<FRigBoneElement>(Key)) {
+                if (bUseDebug) {
+                    UE_LOG(LogControlRig, Error,
+                           TEXT("Item %d is not a bone."), i);
                 }
+                Cache.Reset();
+                return false;
             }
+            Cache.CachedItems.Add(FCachedRigElement(Key, Hierarchy, true));
+        }
 
-            return PlaneNormal.GetSafeNormal();
+        const FRigElementKey RootParentKey =
+            Hierarchy->GetFirstParent(Cache.CachedItems[0].GetKey());
+        if (RootParentKey.IsValid()) {
+            Cache.CachedRootParent =
+                FCachedRigElement(RootParentKey, Hierarchy, true);
         }
 
-        static FArcDistributedIKData GatherChainData(
-            const TArray<FCCDIKChainLink>& Chain,
-            const FVector& EffectorPosition, const FVector& PoleTarget) {
-            FArcDistributedIKData Data;
+        const int32 NumChainLinks = Cache.CachedItems.Num();
+        Cache.RestPositions.SetNumUninitialized(NumChainLinks);
+        for (int32 i = 0; i < NumChainLinks; ++i) {
+            Cache.RestPositions[i] =
+                Hierarchy
+                    ->GetInitialGlobalTransform(
+                        Cache.CachedItems[i].GetIndex())
+                    .GetLocation();
+        }
 
-            if (Chain.Num() < 2) {
-                return Data;
-            }
+        Cache.RestBoneLengths.SetNumZeroed(NumChainLinks);
+        for (int32 i = 0; i < NumChainLinks - 1; ++i) {
+            const float Length = CalculateBoneLength(
+                Cache.RestPositions[i], Cache.RestPositions[i + 1]);
+            Cache.RestBoneLengths[i] = Length;
+            Cache.RestChainLength += Length;
+        }
 
-            Data.BoneLengths.SetNum(Chain.Num());
-            Data.TotalChainLength = 0.0f;
+        Cache.Chain.SetNum(NumChainLinks);
+        Cache.CachedKeys = Items;
+        Cache.TopologyVersion = (int32)Hierarchy->GetTopologyVersion();
 
-            for (int32 i = 0; i < Chain.Num() - 1; ++i) {
-                float Length =
-                    CalculateBoneLength(Chain[i].Transform.GetLocation(),
-                                        Chain[i + 1].Transform.GetLocation());
-                Data.BoneLengths[i] = Length;
-                Data.TotalChainLength += Length;
-            }
+        if (bUseDebug) {
+            UE_LOG(LogControlRig, Warning,
+                   TEXT("[ArcDistributedIK] Chain cache rebuilt. "
+                        "Links=%d, RestChainLength=%.2f"),
+                   NumChainLinks, Cache.RestChainLength);
+        }
+        return true;
+    }
 
-            Data.BoneLengths[Chain.Num() - 1] = 0.0f;
-            Data.RootPosition = Chain[0].Transform.GetLocation();
-            Data.ReferencePlaneNormal = CalculateReferencePlaneNormal(
-                Data.RootPosition, EffectorPosition, PoleTarget);
+    static FArcDistributedIKData GatherChainData(
+        const TArray<FCCDIKChainLink>& Chain, float RestChainLength,
+        const FVector& EffectorPosition, const FVector& PoleTarget) {
+        FArcDistributedIKData Data;
 
+        if (Chain.Num() < 2) {
             return Data;
         }
 
-        // ========================================
-        // 算法判断
-        // ========================================
+        Data.TotalChainLength = RestChainLength;
+        Data.RootPosition = Chain[0].Transform.GetLocation();
+        Data.ReferencePlaneNormal = CalculateReferencePlaneNormal(
+            Data.RootPosition, EffectorPosition, PoleTarget);
 
-        static bool IsEffectorTooFar(float TotalChainLength,
-                                     float EffectorDistance) {
-            return EffectorDistance > TotalChainLength;
-        }
+        return Data;
+    }
 
-        static bool DetermineAlgorithmBranch(float TotalChainLength,
-                                             float EffectorDistance,
-                                             int32& OutAlgorithmType) {
-            if (IsEffectorTooFar(TotalChainLength, EffectorDistance)) {
-                OutAlgorithmType = 1;
-                return true;
-            }
+    // ========================================
+    // 算法判断
+    // ========================================
+
+    static bool IsEffectorTooFar(float TotalChainLength,
+                                 float EffectorDistance) {
+        return EffectorDistance > TotalChainLength;
+    }
 
-            OutAlgorithmType = 2;
+    static bool DetermineAlgorithmBranch(float TotalChainLength,
+                                         float EffectorDistance,
+                                         int32& OutAlgorithmType) {
+        if (IsEffectorTooFar(TotalChainLength, EffectorDistance)) {
+            OutAlgorithmType = 1;
             return true;
         }
 
-        // ========================================
-        // 链条变换
-        // ========================================
+        OutAlgorithmType = 2;
+        return true;
+    }
 
-        static float CalculateEffectorDistance(
-            const TArray<FCCDIKChainLink>& Chain,
-            const FVector& EffectorPosition) {
-            if (Chain.Num() < 1) {
-                return 0.0f;
-            }
+    // ========================================
+    // 链条变换
+    // ========================================
 
-            FVector EndEffectorPosition =
-                Chain[Chain.Num() - 1].Transform.GetLocation();
-            return FVector::Dist(EndEffectorPosition, EffectorPosition);
+    static float CalculateEffectorDistance(
+        const TArray<FCCDIKChainLink>& Chain,
+        const FVector& EffectorPosition) {
+        if (Chain.Num() < 1) {
+            return 0.0f;
         }
 
-        static void StretchChainAlongDirection(TArray<FCCDIKChainLink>& Chain,
-                                               const TArray<float>& BoneLengths,
-                                               const FVector& Direction) {
-            if (Chain.Num() < 1) {
-                return;
-            }
-
-            FVector RootPosition = Chain[0].Transform.GetLocation();
-            FVector CurrentPosition = RootPosition;
+        FVector EndEffectorPosition =
+            Chain[Chain.Num() - 1].Transform.GetLocation();
+        return FVector::Dist(EndEffectorPosition, EffectorPosition);
+    }
 
-            for (int32 i = 1; i < Chain.Num(); ++i) {
-                CurrentPosition =
-                    CurrentPosition + Direction * BoneLengths[i - 1];
-                Chain[i].Transform.SetLocation(CurrentPosition);
-            }
+    static void StretchChainAlongDirection(TArray<FCCDIKChainLink>& Chain,
+                                           const TArray<float>& BoneLengths,
+                                           const FVector& Direction) {
+        if (Chain.Num() < 1) {
+            return;
         }
 
-        static FVector RotatePointAroundAxis(const FVector& Position,
-                                             const FVector& PivotPoint,
-                                             const FVector& RotationAxis,
-                                             float Angle) {
-            FVector RelativePos = Position - PivotPoint;
-            FQuat RotationQuat = FQuat(RotationAxis.GetSafeNormal(), Angle);
-            FVector RotatedRelativePos = RotationQuat.RotateVector(RelativePos);
-            return PivotPoint + RotatedRelativePos;
-        }
-
-        static void RotateChainAroundAxis(TArray<FCCDIKChainLink>& Chain,
-                                          const FVector& RootPosition,
-                                          const FVector& RotationAxis,
-                                          float Angle) {
-            for (int32 i = 1; i < Chain.Num(); ++i) {
-                FVector OldPos = Chain[i].Transform.GetLocation();
-                FVector NewPos = RotatePointAroundAxis(OldPos, RootPosition,
-                                                       RotationAxis, Angle);
-                Chain[i].Transform.SetLocation(NewPos);
-            }
-        }
+        FVector RootPosition = Chain[0].Transform.GetLocation();
+        FVector CurrentPosition = RootPosition;
 
-        static void HandleTooFarCase(TArray<FCCDIKChainLink>& Chain,
-                                     const TArray<float>& BoneLengths,
-                                     const FVector& EffectorPosition) {
-            if (Chain.Num() < 1) {
-                return;
-            }
+        for (int32 i = 1; i < Chain.Num(); ++i) {
+            CurrentPosition =
+                CurrentPosition + Direction * BoneLengths[i - 1];
+            Chain[i].Transform.SetLocation(CurrentPosition);
+        }
+    }
 
-            FVector RootPosition = Chain[0].Transform.GetLocation();
-            FVector DirectionToEffector =
-                (EffectorPosition - RootPosition).GetSafeNormal();
+    static FVector RotatePointAroundAxis(const FVector& Position,
+                                         const FVector& PivotPoint,
+                                         const FVector& RotationAxis,
+                                         float Angle) {
+        FVector RelativePos = Position - PivotPoint;
+        FQuat RotationQuat = FQuat(RotationAxis.GetSafeNormal(), Angle);
+        FVector RotatedRelativePos = RotationQuat.RotateVector(RelativePos);
+        return PivotPoint + RotatedRelativePos;
+    }
 
-            StretchChainAlongDirection(Chain, BoneLengths, DirectionToEffector);
+    static void RotateChainAroundAxis(TArray<FCCDIKChainLink>& Chain,
+                                      const FVector& RootPosition,
+                                      const FVector& RotationAxis,
+                                      float Angle) {
+        for (int32 i = 1; i < Chain.Num(); ++i) {
+            FVector OldPos = Chain[i].Transform.GetLocation();
+            FVector NewPos = RotatePointAroundAxis(OldPos, RootPosition,
+                                                   RotationAxis, Angle);
+            Chain[i].Transform.SetLocation(NewPos);
         }
+    }
 
-        // ========================================
-        // 准备阶段
-        // ========================================
+    static void HandleTooFarCase(TArray<FCCDIKChainLink>& Chain,
+                                 const TArray<float>& BoneLengths,
+                                 const FVector& EffectorPosition) {
+        if (Chain.Num() < 1) {
+            return;
+        }
 
-        static float PreparePhaseStretchChain(TArray<FCCDIKChainLink>& Chain,
-                                              const TArray<float>& BoneLengths,
-                                              const FVector& EffectorPosition) {
-            if (Chain.Num() < 1) {
-                return 0.0f;
-            }
+        FVector RootPosition = Chain[0].Transform.GetLocation();
+        FVector DirectionToEffector =
+            (EffectorPosition - RootPosition).GetSafeNormal();
 
-            FVector RootPosition = Chain[0].Transform.GetLocation();
-            FVector DirectionToEffector =
-                (EffectorPosition - RootPosition).GetSafeNormal();
+        StretchChainAlongDirection(Chain, BoneLengths, DirectionToEffector);
+    }
 
-            StretchChainAlongDirection(Chain, BoneLengths, DirectionToEffector);
+    // ========================================
+    // 准备阶段
+    // ========================================
 
-            return CalculateEffectorDistance(Chain, EffectorPosition);
+    static float PreparePhaseStretchChain(TArray<FCCDIKChainLink>& Chain,
+                                          const TArray<float>& BoneLengths,
+                                          const FVector& EffectorPosition) {
+        if (Chain.Num() < 1) {
+            return 0.0f;
         }
 
-        // ========================================
-        // 旋转重建相关方法
-        // ========================================
+        FVector RootPosition = Chain[0].Transform.GetLocation();
+        FVector DirectionToEffector =
+            (EffectorPosition - RootPosition).GetSafeNormal();
 
-        static FVector FindSecondaryAxisPointOnPlane(
-            const FVector& CurrentPosition, const FVector& PlaneNormal,
-            const FVector& PrimaryDirection, const FVector& MiddlePosition,
-            const FVector& PoleTarget, bool bUseMiddlePosition,
-            float Distance) {
-            FVector PerpendicularInPlane = FVector::CrossProduct(
-                PlaneNormal, PrimaryDirection.GetSafeNormal());
+        StretchChainAlongDirection(Chain, BoneLengths, DirectionToEffector);
 
-            if (PerpendicularInPlane.IsNearlyZero()) {
-                if (FMath::Abs(PrimaryDirection.X) < 0.9f) {
-                    PerpendicularInPlane = FVector::CrossProduct(
-                        PrimaryDirection, FVector::RightVector);
-                } else {
-                    PerpendicularInPlane = FVector::CrossProduct(
-                        PrimaryDirection, FVector::ForwardVector);
-                }
-            }
+        return CalculateEffectorDistance(Chain, EffectorPosition);
+    }
 
-            PerpendicularInPlane.Normalize();
+    // ========================================
+    // 闭式圆弧求解
+    // ========================================
+
+    // 曲率为 Curvature 时整条链在圆弧上张开的总角度
+    static double CalculateArcAngle(const TArray<float>& BoneLengths,
+                                    int32 NumBones, double Curvature) {
+        double TotalAngle = 0.0;
+        for (int32 i = 0; i < NumBones; ++i) {
+            TotalAngle += 2.0 * FMath::Asin(FMath::Min(
+                                    1.0, 0.5 * BoneLengths[i] * Curvature));
+        }
+        return TotalAngle;
+    }
 
-            FVector ReferencePosition =
-                bUseMiddlePosition ? MiddlePosition : PoleTarget;
+    // 圆弧两端点之间的弦长
+    static double CalculateArcChord(double Curvature, double ArcAngle,
+                                    double TotalChainLength) {
+        if (Curvature < UE_DOUBLE_KINDA_SMALL_NUMBER) {
+            return TotalChainLength;
+        }
+        return 2.0 / Curvature * FMath::Sin(0.5 * ArcAngle);
+    }
 
-            if (!ReferencePosition.IsNearlyZero()) {
-                FVector ToReference = ReferencePosition - CurrentPosition;
+    /**
+     * 把关节直接排布到参考平面内的一段圆弧上（每节骨骼为圆弧的一条弦），
+     * 通过二分曲率使首尾弦长等于根到目标的距离。
+     * 圆弧朝 PlaneNormal x (根->目标) 方向凸出，即与FABRIK路径相同的pole一侧。
+     *
+     * @return 目标不可达或无法收敛时返回false（链条保持不变），应回退到FABRIK
+     */
+    static bool SolveArcClosedForm(TArray<FCCDIKChainLink>& Chain,
+                                   const TArray<float>& BoneLengths,
+                                   float TotalChainLength,
+                                   const FVector& EffectorPosition,
+                                   const FVector& PlaneNormal,
+                                   float Precision) {
+        const int32 NumBones = Chain.Num() - 1;
+        if (NumBones < 1 || BoneLengths.Num() < NumBones ||
+            TotalChainLength <= KINDA_SMALL_NUMBER) {
+            return false;
+        }
 
-                if (ToReference.Length() > KINDA_SMALL_NUMBER) {
-                    ToReference = ToReference.GetSafeNormal();
-                    float DotWithReference =
-                        FVector::DotProduct(PerpendicularInPlane, ToReference);
+        const FVector RootPosition = Chain[0].Transform.GetLocation();
+        const FVector RootToEffector = EffectorPosition - RootPosition;
+        const double TargetDistance = RootToEffector.Size();
+        if (TargetDistance < KINDA_SMALL_NUMBER ||
+            TargetDistance >= TotalChainLength) {
+            return false;
+        }
 
-                    if (DotWithReference < 0) {
-                        PerpendicularInPlane = -PerpendicularInPlane;
-                    }
-                }
+        const FVector ChordDir = RootToEffector / TargetDistance;
+        const FVector BendDir =
+            FVector::CrossProduct(PlaneNormal, ChordDir).GetSafeNormal();
+        if (BendDir.IsNearlyZero()) {
+            return false;
+        }
+
+        double MaxBoneLength = 0.0;
+        for (int32 i = 0; i < NumBones; ++i) {
+            MaxBoneLength = FMath::Max(MaxBoneLength, (double)BoneLengths[i]);
+        }
+        if (MaxBoneLength <= KINDA_SMALL_NUMBER) {
+            return false;
+        }
+
+        // 曲率上限：最长的骨骼恰好成为直径；总角度超过一整圈视为过弯
+        double LowCurvature = 0.0;
+        double HighCurvature = 2.0 / MaxBoneLength;
+        double Curvature = 0.0;
+        double ArcAngle = 0.0;
+        double ChordError = TotalChainLength - TargetDistance;
+
+        for (int32 Iter = 0; Iter < 64; ++Iter) {
+            Curvature = 0.5 * (LowCurvature + HighCurvature);
+            ArcAngle = CalculateArcAngle(BoneLengths, NumBones, Curvature);
+            const double Chord =
+                CalculateArcChord(Curvature, ArcAngle, TotalChainLength);
+            ChordError = Chord - TargetDistance;
+
+            if (ArcAngle > 2.0 * PI || ChordError < 0.0) {
+                HighCurvature = Curvature;
+            } else {
+                LowCurvature = Curvature;
+            }
+
+            if (ArcAngle <= 2.0 * PI &&
+                FMath::Abs(ChordError) < 0.1 * Precision) {
+                break;
             }
+        }
+
+        if (ArcAngle > 2.0 * PI || FMath::Abs(ChordError) > Precision) {
+            return false;
+        }
 
-            return CurrentPosition + PerpendicularInPlane * Distance;
+        // 沿圆弧依次放置关节：第i节骨骼与弦方向的夹角为
+        // (总角度/2 - 前面各节的角度 - 本节角度/2)
+        double RemainingAngle = 0.5 * ArcAngle;
+        FVector CurrentPosition = RootPosition;
+        for (int32 i = 0; i < NumBones; ++i) {
+            const double BoneAngle = 2.0 * FMath::Asin(FMath::Min(
+                                               1.0, 0.5 * BoneLengths[i] *
+                                                        Curvature));
+            const double Direction = RemainingAngle - 0.5 * BoneAngle;
+            CurrentPosition += (ChordDir * FMath::Cos(Direction) +
+                                BendDir * FMath::Sin(Direction)) *
+                               BoneLengths[i];
+            Chain[i + 1].Transform.SetLocation(CurrentPosition);
+            RemainingAngle -= BoneAngle;
         }
 
-        static FQuat BuildRotationFromTwoAxes(const FVector& PrimaryDir,
-                                              const FVector& SecondaryDir,
-                                              const FVector& LocalPrimaryAxis,
-                                              const FVector& LocalSecondaryAxis,
-                                              const FVector& PlaneNormal) {
-            FVector WorldX = PrimaryDir.GetSafeNormal();
-            FVector WorldY = SecondaryDir.GetSafeNormal();
-            FVector WorldZ = PlaneNormal.GetSafeNormal();
+        return true;
+    }
 
-            FVector LocalX = LocalPrimaryAxis.GetSafeNormal();
-            FVector LocalY = LocalSecondaryAxis.GetSafeNormal();
-            FVector LocalZ =
-                FVector::CrossProduct(LocalX, LocalY).GetSafeNormal();
+    // ========================================
+    // 旋转重建相关方法
+    // ========================================
 
-            FMatrix LocalToWorldMatrix(
-                FPlane(WorldX.X, WorldX.Y, WorldX.Z, 0.0f),
-                FPlane(WorldY.X, WorldY.Y, WorldY.Z, 0.0f),
-                FPlane(WorldZ.X, WorldZ.Y, WorldZ.Z, 0.0f),
-                FPlane(0.0f, 0.0f, 0.0f, 1.0f));
+    static void RebuildRotationsForChain(
+        TArray<FCCDIKChainLink>& Chain, const FVector& ReferencePlaneNormal,
+        const PoleTargetSolverCore::FLocalAxisBasis& LocalBasis,
+        const FVector& PoleTarget, int32 AlgorithmType) {
+        if (Chain.Num() < 1) {
+            return;
+        }
 
-            FMatrix LocalAxisMatrix(FPlane(LocalX.X, LocalX.Y, LocalX.Z, 0.0f),
-                                    FPlane(LocalY.X, LocalY.Y, LocalY.Z, 0.0f),
-                                    FPlane(LocalZ.X, LocalZ.Y, LocalZ.Z, 0.0f),
-                                    FPlane(0.0f, 0.0f, 0.0f, 1.0f));
+        FVector RootPosition = Chain[0].Transform.GetLocation();
+        FVector EffectorPosition =
+            Chain[Chain.Num() - 1].Transform.GetLocation();
+        FVector MiddlePosition = (RootPosition + EffectorPosition) * 0.5f;
+        float TotalChainLength =
+            CalculateBoneLength(RootPosition, EffectorPosition);
+
+        FVector DirectionToPole =
+            (PoleTarget - MiddlePosition).GetSafeNormal();
+        float PoleOffset = 0.1 * TotalChainLength;
+
+        bool bUseOriginalMiddlePosition = AlgorithmType == 2;
+        FVector AdjustedMiddlePosition =
+            bUseOriginalMiddlePosition
+                ? MiddlePosition - 0.5f * PoleOffset * DirectionToPole
+                : MiddlePosition - DirectionToPole * PoleOffset;
+
+        // 次轴背离偏移后的中点
+        PoleTargetSolverCore::FArcDistributionSolver::RebuildRotations(
+            Chain, ReferencePlaneNormal, AdjustedMiddlePosition, LocalBasis);
+    }
 
-            FMatrix RotationMatrix =
-                LocalAxisMatrix.Inverse() * LocalToWorldMatrix;
+    // ========================================
+    // FABRIK 求解器
+    // ========================================
+
+    // 返回实际使用的迭代次数
+    static int32 ApplyFABRIKSolver(TArray<FCCDIKChainLink>& Chain,
+                                   const TArray<float>& BoneLengths,
+                                   const FVector& EffectorPosition,
+                                   float Precision, int32 MaxIterations,
+                                   float EarlyStopThreshold, bool bUseDebug) {
+        if (Chain.Num() < 2) {
+            return 0;
+        }
 
-            FQuat ResultQuat(RotationMatrix);
-            return ResultQuat.GetNormalized();
+        if (bUseDebug) {
+            UE_LOG(LogControlRig, Warning,
+                   TEXT("[ApplyFABRIKSolver] Started with Precision=%.6f, "
+                        "MaxIterations=%d, TargetEffectorPos=(%.2f, %.2f, "
+                        "%.2f)"),
+                   Precision, MaxIterations, EffectorPosition.X,
+                   EffectorPosition.Y, EffectorPosition.Z);
         }
 
-        static FQuat CalculateBoneRotation(
-            const FVector& CurrentPosition, const FVector& NextPosition,
-            const FVector& PlaneNormal, const FVector& PrimaryAxis,
-            const FVector& SecondaryAxis, const FVector& MiddlePosition,
-            const FVector& PoleTarget, int32 AlgorithmType, bool bIsLastBone) {
-            FVector WorldPrimaryDir =
-                (NextPosition - CurrentPosition).GetSafeNormal();
+        FVector RootPosition = Chain[0].Transform.GetLocation();
+        const int32 LastLinkIndex = Chain.Num() - 1;
+
+        for (int32 Iter = 0; Iter < MaxIterations; ++Iter) {
+            float CurrentDistance =
+                CalculateEffectorDistance(Chain, EffectorPosition);
+            if (CurrentDistance < Precision) {
+                if (bUseDebug) {
+                    UE_LOG(
+                        LogControlRig, Warning,
+                        TEXT("[ApplyFABRIKSolver] Converged at iteration "
+                             "%d with distance %.6f < precision %.6f"),
+                        Iter, CurrentDistance, Precision);
+                }
+                return Iter;
+            }
 
-            FVector SecondaryAxisPoint = FindSecondaryAxisPointOnPlane(
-                CurrentPosition, PlaneNormal, WorldPrimaryDir, MiddlePosition,
-                PoleTarget, true, 50.0f);
+            const FVector PreviousTipPosition =
+                Chain[LastLinkIndex].Transform.GetLocation();
+            Chain[LastLinkIndex].Transform.SetLocation(EffectorPosition);
 
-            FVector WorldSecondaryDir =
-                (CurrentPosition - SecondaryAxisPoint).GetSafeNormal();
+            for (int32 i = LastLinkIndex - 1; i >= 0; --i) {
+                FVector CurrentPos = Chain[i].Transform.GetLocation();
+                FVector NextPos = Chain[i + 1].Transform.GetLocation();
+                FVector Direction = (CurrentPos - NextPos).GetSafeNormal();
+                FVector NewPos = NextPos + Direction * BoneLengths[i];
+                Chain[i].Transform.SetLocation(NewPos);
+            }
 
-            FQuat Rotation = BuildRotationFromTwoAxes(
-                WorldPrimaryDir, WorldSecondaryDir, PrimaryAxis, SecondaryAxis,
-                PlaneNormal);
+            Chain[0].Transform.SetLocation(RootPosition);
 
-            return Rotation;
-        }
+            for (int32 i = 0; i < LastLinkIndex; ++i) {
+                FVector CurrentPos = Chain[i].Transform.GetLocation();
+                FVector NextPos = Chain[i + 1].Transform.GetLocation();
+                FVector Direction = (NextPos - CurrentPos).GetSafeNormal();
+                FVector NewPos = CurrentPos + Direction * BoneLengths[i];
+                Chain[i + 1].Transform.SetLocation(NewPos);
+            }
 
-        static void RebuildRotationsForChain(
-            TArray<FCCDIKChainLink>& Chain, const TArray<float>& BoneLengths,
-            const FVector& ReferencePlaneNormal, const FVector& PrimaryAxis,
-            const FVector& SecondaryAxis, const FVector& PoleTarget,
-            const FTransform& RootParentTransform, int32 AlgorithmType) {
-            if (Chain.Num() < 1) {
-                return;
+            if (bUseDebug && (Iter % 5 == 0 || Iter == MaxIterations - 1)) {
+                float FinalEffectorDist =
+                    CalculateEffectorDistance(Chain, EffectorPosition);
+                UE_LOG(LogControlRig, Warning,
+                       TEXT("[ApplyFABRIKSolver] Iteration %d: "
+                            "CurrentDistance=%.6f"),
+                       Iter, FinalEffectorDist);
             }
 
-            FVector RootPosition = Chain[0].Transform.GetLocation();
-            FVector EffectorPosition =
-                Chain[Chain.Num() - 1].Transform.GetLocation();
-            FVector MiddlePosition = (RootPosition + EffectorPosition) * 0.5f;
-            float TotalChainLength =
-                CalculateBoneLength(RootPosition, EffectorPosition);
-
-            FVector DirectionToPole =
-                (PoleTarget - MiddlePosition).GetSafeNormal();
-            float PoleOffset = 0.1 * TotalChainLength;
-
-            bool bUseOriginalMiddlePosition = AlgorithmType == 2;
-            FVector AdjustedMiddlePosition =
-                bUseOriginalMiddlePosition
-                    ? MiddlePosition - 0.5f * PoleOffset * DirectionToPole
-                    : MiddlePosition - DirectionToPole * PoleOffset;
-
-            for (int32 i = 0; i < Chain.Num(); ++i) {
-                FVector CurrentPosition = Chain[i].Transform.GetLocation();
-                FVector NextPosition;
-                bool bIsLastBone = (i == Chain.Num() - 1);
-
-                if (i < Chain.Num() - 1) {
-                    NextPosition = Chain[i + 1].Transform.GetLocation();
-                } else {
-                    FVector PrevToCurrent =
-                        (CurrentPosition - Chain[i - 1].Transform.GetLocation())
-                            .GetSafeNormal();
-                    NextPosition = CurrentPosition + PrevToCurrent * 50.0f;
+            // 末端几乎不再移动：继续迭代收益很小，提前结束
+            if (EarlyStopThreshold > 0.0f &&
+                FVector::Dist(PreviousTipPosition,
+                              Chain[LastLinkIndex].Transform.GetLocation()) <
+                    EarlyStopThreshold) {
+                if (bUseDebug) {
+                    UE_LOG(LogControlRig, Warning,
+                           TEXT("[ApplyFABRIKSolver] Early stop at iteration "
+                                "%d"),
+                           Iter);
                 }
+                return Iter + 1;
+            }
+        }
 
-                FQuat NewRotation = CalculateBoneRotation(
-                    CurrentPosition, NextPosition, ReferencePlaneNormal,
-                    PrimaryAxis, SecondaryAxis, AdjustedMiddlePosition,
-                    PoleTarget, AlgorithmType, bIsLastBone);
+        if (bUseDebug) {
+            float FinalDistance =
+                CalculateEffectorDistance(Chain, EffectorPosition);
+            UE_LOG(LogControlRig, Warning,
+                   TEXT("[ApplyFABRIKSolver] Max iterations reached. Final "
+                        "distance: %.6f"),
+                   FinalDistance);
+        }
+        return MaxIterations;
+    }
 
-                Chain[i].Transform.SetRotation(NewRotation);
-            }
+    // 热启动：用上一帧的解（随根骨骼平移）作为FABRIK初值
+    static bool ApplyWarmStart(TArray<FCCDIKChainLink>& Chain,
+                               const TArray<FVector>& SolvedPositions) {
+        if (SolvedPositions.Num() != Chain.Num() || Chain.Num() < 2) {
+            return false;
         }
 
-        // ========================================
-        // FABRIK 求解器
-        // ========================================
+        const FVector RootOffset =
+            Chain[0].Transform.GetLocation() - SolvedPositions[0];
+        for (int32 i = 1; i < Chain.Num(); ++i) {
+            Chain[i].Transform.SetLocation(SolvedPositions[i] + RootOffset);
+        }
+        return true;
+    }
 
-        static void ApplyFABRIKSolver(TArray<FCCDIKChainLink>& Chain,
+    static int32 IterativePhaseFABRIK(TArray<FCCDIKChainLink>& Chain,
                                       const TArray<float>& BoneLengths,
                                       const FVector& EffectorPosition,
+                                      const FVector& PoleTarget,
+                                      const FVector& ReferencePlaneNormal,
                                       float Precision, int32 MaxIterations,
+                                      float EarlyStopThreshold,
                                       bool bUseDebug) {
-            if (Chain.Num() < 2) {
-                return;
-            }
-
+        if (Chain.Num() < 1) {
             if (bUseDebug) {
-                UE_LOG(LogControlRig, Warning,
-                       TEXT("[ApplyFABRIKSolver] Started with Precision=%.6f, "
-                            "MaxIterations=%d, TargetEffectorPos=(%.2f, %.2f, "
-                            "%.2f)"),
-                       Precision, MaxIterations, EffectorPosition.X,
-                       EffectorPosition.Y, EffectorPosition.Z);
+                UE_LOG(LogTemp, Warning,
+                       TEXT("[IterativePhaseFABRIK] Invalid chain"));
             }
+            return 0;
+        }
 
-            FVector RootPosition = Chain[0].Transform.GetLocation();
-            const int32 LastLinkIndex = Chain.Num() - 1;
+        FVector RootPosition = Chain[0].Transform.GetLocation();
 
-            for (int32 Iter = 0; Iter < MaxIterations; ++Iter) {
-                float CurrentDistance =
-                    CalculateEffectorDistance(Chain, EffectorPosition);
-                if (CurrentDistance < Precision) {
-                    if (bUseDebug) {
-                        UE_LOG(
-                            LogControlRig, Warning,
-                            TEXT("[ApplyFABRIKSolver] Converged at iteration "
-                                 "%d with distance %.6f < precision %.6f"),
-                            Iter, CurrentDistance, Precision);
-                    }
-                    return;
-                }
+        FVector RotationAxis = ReferencePlaneNormal.GetSafeNormal();
+        const float RotationAngle = PI / 2.0f;
+        RotateChainAroundAxis(Chain, RootPosition, RotationAxis,
+                              RotationAngle);
 
-                Chain[LastLinkIndex].Transform.SetLocation(EffectorPosition);
+        if (bUseDebug) {
+            FVector EffectorAfterRotate =
+                Chain[Chain.Num() - 1].Transform.GetLocation();
+            UE_LOG(LogControlRig, Warning,
+                   TEXT("[IterativePhaseFABRIK] After rotation, "
+                        "EndEffector at: (%.2f, %.2f, %.2f)"),
+                   EffectorAfterRotate.X, EffectorAfterRotate.Y,
+                   EffectorAfterRotate.Z);
+        }
 
-                for (int32 i = LastLinkIndex - 1; i >= 0; --i) {
-                    FVector CurrentPos = Chain[i].Transform.GetLocation();
-                    FVector NextPos = Chain[i + 1].Transform.GetLocation();
-                    FVector Direction = (CurrentPos - NextPos).GetSafeNormal();
-                    FVector NewPos = NextPos + Direction * BoneLengths[i];
-                    Chain[i].Transform.SetLocation(NewPos);
-                }
+        return ApplyFABRIKSolver(Chain, BoneLengths, EffectorPosition,
+                                 Precision, MaxIterations, EarlyStopThreshold,
+                                 bUseDebug);
+    }
 
-                Chain[0].Transform.SetLocation(RootPosition);
+    // ========================================
+    // 写入层级
+    // ========================================
+
+    static void WriteChainToHierarchy(
+        FControlRigExecuteContext& ExecuteContext,
+        const TArray<FCachedRigElement>& CachedItems,
+        const TArray<FCCDIKChainLink>& Chain, bool bPropagateToChildren,
+        bool bUseDebug) {
+        URigHierarchy* Hierarchy = ExecuteContext.Hierarchy;
+        if (!Hierarchy || CachedItems.Num() != Chain.Num()) {
+            if (bUseDebug && (!Hierarchy)) {
+                UE_LOG(LogControlRig, Error,
+                       TEXT("[WriteChainToHierarchy] Hierarchy is null"));
+            }
+            if (bUseDebug && (CachedItems.Num() != Chain.Num())) {
+                UE_LOG(LogControlRig, Error,
+                       TEXT("[WriteChainToHierarchy] Item count mismatch. "
+                            "CachedItems=%d, Chain=%d"),
+                       CachedItems.Num(), Chain.Num());
+            }
+            return;
+        }
 
-                for (int32 i = 0; i < LastLinkIndex; ++i) {
-                    FVector CurrentPos = Chain[i].Transform.GetLocation();
-                    FVector NextPos = Chain[i + 1].Transform.GetLocation();
-                    FVector Direction = (NextPos - CurrentPos).GetSafeNormal();
-                    FVector NewPos = CurrentPos + Direction * BoneLengths[i];
-                    Chain[i + 1].Transform.SetLocation(NewPos);
-                }
+        if (bUseDebug) {
+            UE_LOG(LogControlRig, Warning,
+                   TEXT("[WriteChainToHierarchy] Writing %d items to "
+                        "hierarchy"),
+                   CachedItems.Num());
+        }
 
-                if (bUseDebug && (Iter % 5 == 0 || Iter == MaxIterations - 1)) {
-                    float FinalEffectorDist =
-                        CalculateEffectorDistance(Chain, EffectorPosition);
+        // 旧位置只在调试时读取
+        if (bUseDebug) {
+            for (int32 i = 0; i < FMath::Min(CachedItems.Num(), 3); ++i) {
+                if (CachedItems[i].IsValid()) {
+                    const FVector OldPos =
+                        Hierarchy->GetGlobalTransform(CachedItems[i].GetIndex())
+                            .GetLocation();
+                    const FVector NewPos = Chain[i].Transform.GetLocation();
                     UE_LOG(LogControlRig, Warning,
-                           TEXT("[ApplyFABRIKSolver] Iteration %d: "
-                                "CurrentDistance=%.6f"),
-                           Iter, FinalEffectorDist);
+                           TEXT("[WriteChainToHierarchy] Bone %d: (%.2f, "
+                                "%.2f, %.2f) -> (%.2f, %.2f, %.2f)"),
+                           i, OldPos.X, OldPos.Y, OldPos.Z, NewPos.X,
+                           NewPos.Y, NewPos.Z);
                 }
             }
-
-            if (bUseDebug) {
-                float FinalDistance =
-                    CalculateEffectorDistance(Chain, EffectorPosition);
-                UE_LOG(LogControlRig, Warning,
-                       TEXT("[ApplyFABRIKSolver] Max iterations reached. Final "
-                            "distance: %.6f"),
-                       FinalDistance);
-            }
         }
 
-        static void IterativePhaseFABRIK(TArray<FCCDIKChainLink>& Chain,
-                                         const TArray<float>& BoneLengths,
-                                         const FVector& EffectorPosition,
-                                         const FVector& PoleTarget,
-                                         const FVector& ReferencePlaneNormal,
-                                         float Precision, int32 MaxIterations,
-                                         bool bUseDebug) {
-            if (Chain.Num() < 1) {
-                if (bUseDebug) {
-                    UE_LOG(LogTemp, Warning,
-                           TEXT("[IterativePhaseFABRIK] Invalid chain"));
-                }
-                return;
-            }
+        PoleTargetIKSolver::WriteChainToHierarchy(Hierarchy, CachedItems, Chain,
+                                                  bPropagateToChildren);
 
-            FVector RootPosition = Chain[0].Transform.GetLocation();
+        if (bUseDebug) {
+            UE_LOG(LogControlRig, Warning,
+                   TEXT("[WriteChainToHierarchy] Write complete"));
+        }
+    }
+};
 
-            FVector RotationAxis = ReferencePlaneNormal.GetSafeNormal();
-            const float RotationAngle = PI / 2.0f;
-            RotateChainAroundAxis(Chain, RootPosition, RotationAxis,
-                                  RotationAngle);
+}  // namespace
 
-            if (bUseDebug) {
-                FVector EffectorAfterRotate =
-                    Chain[Chain.Num() - 1].Transform.GetLocation();
-                UE_LOG(LogControlRig, Warning,
-                       TEXT("[IterativePhaseFABRIK] After rotation, "
-                            "EndEffector at: (%.2f, %.2f, %.2f)"),
-                       EffectorAfterRotate.X, EffectorAfterRotate.Y,
-                       EffectorAfterRotate.Z);
-            }
+bool ArcDistributedIKSolver::SolveArcClosedForm(
+    TArray<FCCDIKChainLink>& Chain, const TArray<float>& BoneLengths,
+    float TotalChainLength, const FVector& EffectorPosition,
+    const FVector& PlaneNormal, float Precision) {
+    return Local::SolveArcClosedForm(Chain, BoneLengths, TotalChainLength,
+                                     EffectorPosition, PlaneNormal,
+                                     Precision);
+}
 
-            ApplyFABRIKSolver(Chain, BoneLengths, EffectorPosition, Precision,
-                              MaxIterations, bUseDebug);
-        }
+int32 ArcDistributedIKSolver::SolveArcFABRIK(
+    TArray<FCCDIKChainLink>& Chain, const TArray<float>& BoneLengths,
+    const FVector& EffectorPosition, const FVector& PoleTarget,
+    const FVector& PlaneNormal, float Precision, int32 MaxIterations,
+    float EarlyStopThreshold) {
+    Local::PreparePhaseStretchChain(Chain, BoneLengths, EffectorPosition);
+    return Local::IterativePhaseFABRIK(
+        Chain, BoneLengths, EffectorPosition, PoleTarget, PlaneNormal,
+        Precision, MaxIterations, EarlyStopThreshold, false);
+}
 
-        // ========================================
-        // 写入层级
-        // ========================================
+bool ArcDistributedIKSolver::BuildChainCache(
+    URigHierarchy* Hierarchy, const TArray<FRigElementKey>& Items,
+    FRigUnit_ArcDistributedIK_WorkData& Cache, bool bUseDebug) {
+    if (!Hierarchy || Items.Num() < 2) {
+        Cache.Reset();
+        return false;
+    }
+    return Local::BuildChainCache(Hierarchy, Items, Cache, bUseDebug);
+}
 
-        static void WriteChainToHierarchy(
-            FControlRigExecuteContext& ExecuteContext,
-            const TArray<FCachedRigElement>& CachedItems,
-            const TArray<FCCDIKChainLink>& Chain, bool bPropagateToChildren,
-            bool bUseDebug) {
-            URigHierarchy* Hierarchy = ExecuteContext.Hierarchy;
-            if (!Hierarchy || CachedItems.Num() != Chain.Num()) {
-                if (bUseDebug && (!Hierarchy)) {
-                    UE_LOG(LogControlRig, Error,
-                           TEXT("[WriteChainToHierarchy] Hierarchy is null"));
-                }
-                if (bUseDebug && (CachedItems.Num() != Chain.Num())) {
-                    UE_LOG(LogControlRig, Error,
-                           TEXT("[WriteChainToHierarchy] Item count mismatch. "
-                                "CachedItems=%d, Chain=%d"),
-                           CachedItems.Num(), Chain.Num());
-                }
-                return;
-            }
+FVector ArcDistributedIKSolver::CalculateReferencePlaneNormal(
+    const FVector& RootPosition, const FVector& EffectorPosition,
+    const FVector& PoleTarget) {
+    return Local::CalculateReferencePlaneNormal(RootPosition,
+                                                EffectorPosition, PoleTarget);
+}
 
-            if (bUseDebug) {
-                UE_LOG(LogControlRig, Warning,
-                       TEXT("[WriteChainToHierarchy] Writing %d items to "
-                            "hierarchy"),
-                       CachedItems.Num());
-            }
+void ArcDistributedIKSolver::StretchChainToEffector(
+    TArray<FCCDIKChainLink>& Chain, const TArray<float>& BoneLengths,
+    const FVector& EffectorPosition) {
+    Local::HandleTooFarCase(Chain, BoneLengths, EffectorPosition);
+}
 
-            for (int32 i = 0; i < CachedItems.Num(); ++i) {
-                const FCachedRigElement& CachedBone = CachedItems[i];
-                if (CachedBone.IsValid()) {
-                    FVector OldPos =
-                        Hierarchy->GetGlobalTransform(CachedBone.GetKey())
-                            .GetLocation();
-                    Hierarchy->SetGlobalTransform(CachedBone.GetKey(),
-                                                  Chain[i].Transform, false,
-                                                  bPropagateToChildren, false);
-                    FVector NewPos = Chain[i].Transform.GetLocation();
-
-                    if (bUseDebug && i < 3) {
-                        UE_LOG(LogControlRig, Warning,
-                               TEXT("[WriteChainToHierarchy] Bone %d: (%.2f, "
-                                    "%.2f, %.2f) -> (%.2f, %.2f, %.2f)"),
-                               i, OldPos.X, OldPos.Y, OldPos.Z, NewPos.X,
-                               NewPos.Y, NewPos.Z);
-                    }
-                }
-            }
+void ArcDistributedIKSolver::PrepareFABRIKChain(
+    TArray<FCCDIKChainLink>& Chain, const TArray<float>& BoneLengths,
+    const FVector& EffectorPosition, const FVector& PlaneNormal) {
+    if (Chain.Num() < 1) {
+        return;
+    }
+    Local::PreparePhaseStretchChain(Chain, BoneLengths, EffectorPosition);
+    Local::RotateChainAroundAxis(Chain, Chain[0].Transform.GetLocation(),
+                                 PlaneNormal.GetSafeNormal(), PI / 2.0f);
+}
 
-            if (bUseDebug) {
-                UE_LOG(LogControlRig, Warning,
-                       TEXT("[WriteChainToHierarchy] Write complete"));
-            }
-        }
-    };
+void ArcDistributedIKSolver::RebuildRotations(
+    TArray<FCCDIKChainLink>& Chain, const FVector& PlaneNormal,
+    const FVector& PrimaryAxis, const FVector& SecondaryAxis,
+    const FVector& PoleTarget, bool bEffectorTooFar) {
+    RebuildRotations(Chain, PlaneNormal,
+                     PoleTargetSolverCore::FLocalAxisBasis(PrimaryAxis,
+                                                           SecondaryAxis),
+                     PoleTarget, bEffectorTooFar);
+}
+
+void ArcDistributedIKSolver::RebuildRotations(
+    TArray<FCCDIKChainLink>& Chain, const FVector& PlaneNormal,
+    const PoleTargetSolverCore::FLocalAxisBasis& LocalBasis,
+    const FVector& PoleTarget, bool bEffectorTooFar) {
+    Local::RebuildRotationsForChain(Chain, PlaneNormal, LocalBasis, PoleTarget,
+                                    bEffectorTooFar ? 1 : 2);
+}
 
+FRigUnit_ArcDistributedIK_Execute() {
     // ============================================================================
     // 执行主逻辑
     // ============================================================================
 
+    IterationsUsed = 0;
     URigHierarchy* Hierarchy = ExecuteContext.Hierarchy;
 
     if (!Hierarchy) {
@@ -528,7 +706,6 @@ FRigUnit_ArcDistributedIK_Execute() {
                TEXT("[ArcDistributedIK] Execution Started - bUseDebug=true"));
     }
 
-    WorkData.CachedItems.Empty();
     if (Items.Num() < 2) {
         if (bUseDebug) {
             UE_LOG(LogControlRig, Error,
@@ -542,21 +719,17 @@ FRigUnit_ArcDistributedIK_Execute() {
                TEXT("[ArcDistributedIK] Items.Num() = %d"), Items.Num());
     }
 
-    WorkData.CachedItems.Reserve(Items.Num());
-    for (int32 i = 0; i < Items.Num(); ++i) {
-        const FRigElementKey& Key = Items[i];
-        FRigBoneElement* Bone = Hierarchy->Find<FRigBoneElement>(Key);
-        if (!Bone) {
-            if (bUseDebug) {
-                UE_LOG(LogControlRig, Error, TEXT("Item %d is not a bone."), i);
-            }
-            return;
-        }
-        FCachedRigElement CachedBone(Key, Hierarchy, true);
-        WorkData.CachedItems.Add(CachedBone);
+    // 缓存只在 Items、层级拓扑或初始姿态变化时重建
+    if (!ArcWorkData.IsValidFor(Items, Hierarchy) &&
+        !Local::BuildChainCache(Hierarchy, Items, ArcWorkData, bUseDebug)) {
+        return;
     }
 
-    int32 NumChainLinks = WorkData.CachedItems.Num();
+    const TArray<FCachedRigElement>& CachedItems = ArcWorkData.CachedItems;
+    const TArray<float>& BoneLengths = ArcWorkData.RestBoneLengths;
+    TArray<FCCDIKChainLink>& Chain = ArcWorkData.Chain;
+
+    int32 NumChainLinks = CachedItems.Num();
     if (NumChainLinks < 2) {
         if (bUseDebug) {
             UE_LOG(LogControlRig, Error,
@@ -572,29 +745,19 @@ FRigUnit_ArcDistributedIK_Execute() {
     }
 
     FTransform RootParentTransform = FTransform::Identity;
-    FRigElementKey RootBoneKey = WorkData.CachedItems[0].GetKey();
-    FRigBoneElement* RootBone = Hierarchy->Find<FRigBoneElement>(RootBoneKey);
-
-    if (RootBone && RootBone->ParentElement) {
-        RootParentTransform = RootBone->ParentElement->GetTransform().Get(
-            ERigTransformType::CurrentGlobal);
+    if (ArcWorkData.CachedRootParent.IsValid()) {
+        RootParentTransform = Hierarchy->GetGlobalTransform(
+            ArcWorkData.CachedRootParent.GetIndex());
     }
 
-    TArray<FCCDIKChainLink> Chain;
-    Chain.SetNum(NumChainLinks);
-
     for (int32 i = 0; i < NumChainLinks; ++i) {
-        const FCachedRigElement& CachedBone = WorkData.CachedItems[i];
         FTransform BoneTransform =
-            Hierarchy->GetGlobalTransform(CachedBone.GetIndex());
+            Hierarchy->GetGlobalTransform(CachedItems[i].GetIndex());
         Chain[i].Transform = BoneTransform;
 
         if (i > 0) {
-            const FCachedRigElement& ParentBone = WorkData.CachedItems[i - 1];
-            FTransform ParentTransform =
-                Hierarchy->GetGlobalTransform(ParentBone.GetIndex());
             Chain[i].LocalTransform =
-                BoneTransform.GetRelativeTransform(ParentTransform);
+                BoneTransform.GetRelativeTransform(Chain[i - 1].Transform);
         } else {
             Chain[i].LocalTransform =
                 BoneTransform.GetRelativeTransform(RootParentTransform);
@@ -623,9 +786,33 @@ FRigUnit_ArcDistributedIK_Execute() {
                SecondAxis.X, SecondAxis.Y, SecondAxis.Z);
     }
 
+    // 链条初始姿态、目标、pole和参数都与上一次相同时直接写回上一次的结果
+    if (bMemoizeUnchangedInputs) {
+        const uint32 SettingsHash =
+            FRigUnit_PoleTargetIK_MemoData::HashSettings(
+                PrimaryAxis, SecondAxis, bUseClosedFormSolver, Precision,
+                MaxIterations, EarlyStopThreshold);
+        if (MemoData.TryRestore(Items, SettingsHash,
+                                EffectorTransform.GetLocation(), PoleTarget,
+                                Chain)) {
+            if (bUseDebug) {
+                UE_LOG(LogControlRig, Warning,
+                       TEXT("[ArcDistributedIK] Inputs unchanged, reusing "
+                            "memoized result"));
+            }
+            Local::WriteChainToHierarchy(ExecuteContext, CachedItems, Chain,
+                                         bPropagateToChildren, bUseDebug);
+            return;
+        }
+        MemoData.CaptureInputs(Items, SettingsHash,
+                               EffectorTransform.GetLocation(), PoleTarget,
+                               Chain);
+    }
+
     // Phase 1: Data gathering
     FArcDistributedIKData Data = Local::GatherChainData(
-        Chain, EffectorTransform.GetLocation(), PoleTarget);
+        Chain, ArcWorkData.RestChainLength, EffectorTransform.GetLocation(),
+        PoleTarget);
 
     if (bUseDebug) {
         UE_LOG(LogControlRig, Warning,
@@ -669,10 +856,10 @@ FRigUnit_ArcDistributedIK_Execute() {
     }
 
     bool bEffectorTooClose = false;
-    if (Chain.Num() >= 2 && Data.BoneLengths.Num() >= 2) {
+    if (Chain.Num() >= 2 && BoneLengths.Num() >= 2) {
         float MaxBoneLength = 0.0f;
-        for (int32 i = 0; i < Data.BoneLengths.Num() - 1; ++i) {
-            MaxBoneLength = FMath::Max(MaxBoneLength, Data.BoneLengths[i]);
+        for (int32 i = 0; i < BoneLengths.Num() - 1; ++i) {
+            MaxBoneLength = FMath::Max(MaxBoneLength, BoneLengths[i]);
         }
 
         float OtherBonesLength = Data.TotalChainLength - MaxBoneLength;
@@ -720,16 +907,44 @@ FRigUnit_ArcDistributedIK_Execute() {
                 LogControlRig, Warning,
                 TEXT("[ArcDistributedIK] Entering Phase 3 - HandleTooFarCase"));
         }
-        Local::HandleTooFarCase(Chain, Data.BoneLengths,
+        Local::HandleTooFarCase(Chain, BoneLengths,
                                 EffectorTransform.GetLocation());
+    } else if (AlgorithmType == 2 && bUseClosedFormSolver &&
+               Local::SolveArcClosedForm(
+                   Chain, BoneLengths, Data.TotalChainLength,
+                   EffectorTransform.GetLocation(), Data.ReferencePlaneNormal,
+                   Precision > 0.f ? Precision : 0.001f)) {
+        if (bUseDebug) {
+            UE_LOG(LogControlRig, Warning,
+                   TEXT("[ArcDistributedIK] Phase 3 - Closed-form arc solved. "
+                        "FinalEffectorDistance: %.4f"),
+                   Local::CalculateEffectorDistance(
+                       Chain, EffectorTransform.GetLocation()));
+        }
+    } else if (AlgorithmType == 2 && bWarmStart &&
+               Local::ApplyWarmStart(Chain, ArcWorkData.SolvedPositions)) {
+        // 从上一帧的解继续迭代，连续帧之间通常1~2次即可收敛
+        IterationsUsed = Local::ApplyFABRIKSolver(
+            Chain, BoneLengths, EffectorTransform.GetLocation(),
+            Precision > 0.f ? Precision : 0.001f,
+            MaxIterations > 0 ? MaxIterations : 10, EarlyStopThreshold,
+            bUseDebug);
+
+        if (bUseDebug) {
+            UE_LOG(LogControlRig, Warning,
+                   TEXT("[ArcDistributedIK] Phase 3 - Warm-started FABRIK, "
+                        "IterationsUsed: %d"),
+                   IterationsUsed);
+        }
     } else if (AlgorithmType == 2) {
+        // 闭式求解不适用（过近/过弯）时回退到FABRIK
         if (bUseDebug) {
             UE_LOG(LogControlRig, Warning,
                    TEXT("[ArcDistributedIK] Entering Phase 3 - "
                         "PreparePhaseStretchChain"));
         }
         float InitialDistance = Local::PreparePhaseStretchChain(
-            Chain, Data.BoneLengths, EffectorTransform.GetLocation());
+            Chain, BoneLengths, EffectorTransform.GetLocation());
 
         if (bUseDebug) {
             UE_LOG(
@@ -740,11 +955,12 @@ FRigUnit_ArcDistributedIK_Execute() {
                 MaxIterations > 0 ? MaxIterations : 10);
         }
 
-        Local::IterativePhaseFABRIK(
-            Chain, Data.BoneLengths, EffectorTransform.GetLocation(),
+        IterationsUsed = Local::IterativePhaseFABRIK(
+            Chain, BoneLengths, EffectorTransform.GetLocation(),
             PoleTarget, Data.ReferencePlaneNormal,
             Precision > 0.f ? Precision : 0.001f,
-            MaxIterations > 0 ? MaxIterations : 10, bUseDebug);
+            MaxIterations > 0 ? MaxIterations : 10, EarlyStopThreshold,
+            bUseDebug);
 
         if (bUseDebug) {
             float FinalDistance = Local::CalculateEffectorDistance(
@@ -756,15 +972,23 @@ FRigUnit_ArcDistributedIK_Execute() {
         }
     }
 
+    // 记录本帧的解，供下一帧热启动
+    ArcWorkData.SolvedPositions.SetNumUninitialized(Chain.Num());
+    for (int32 i = 0; i < Chain.Num(); ++i) {
+        ArcWorkData.SolvedPositions[i] = Chain[i].Transform.GetLocation();
+    }
+
     // Phase 4: Rotation rebuild
     if (bUseDebug) {
         UE_LOG(LogControlRig, Warning,
                TEXT("[ArcDistributedIK] Entering Phase 4 - "
                     "RebuildRotationsForChain"));
     }
+    // 局部轴基只依赖 PrimaryAxis/SecondAxis，整条链共用
     Local::RebuildRotationsForChain(
-        Chain, Data.BoneLengths, Data.ReferencePlaneNormal, PrimaryAxis,
-        SecondAxis, PoleTarget, RootParentTransform, AlgorithmType);
+        Chain, Data.ReferencePlaneNormal,
+        PoleTargetSolverCore::FLocalAxisBasis(PrimaryAxis, SecondAxis),
+        PoleTarget, AlgorithmType);
 
     // Phase 5: Write to hierarchy
     if (bUseDebug) {
@@ -795,8 +1019,12 @@ FRigUnit_ArcDistributedIK_Execute() {
         }
 
         // Check if position has changed from original
+        // (once a change is found, further reads are only needed for logging)
+        if (bPositionsChanged && !bUseDebug) {
+            continue;
+        }
         FVector OriginalPos = Hierarchy->GetGlobalTransform(
-            WorkData.CachedItems[i].GetKey()).GetLocation();
+            CachedItems[i].GetIndex()).GetLocation();
         FVector NewPos = Chain[i].Transform.GetLocation();
         
         if (!OriginalPos.Equals(NewPos, 0.01f)) {
@@ -828,6 +1056,10 @@ FRigUnit_ArcDistributedIK_Execute() {
         return;
     }
 
+    if (bMemoizeUnchangedInputs) {
+        MemoData.StoreResult(Chain);
+    }
+
     if (!bPositionsChanged) {
         if (bUseDebug) {
             UE_LOG(LogControlRig, Warning,
@@ -837,7 +1069,7 @@ FRigUnit_ArcDistributedIK_Execute() {
         return;
     }
 
-    Local::WriteChainToHierarchy(ExecuteContext, WorkData.CachedItems, Chain,
+    Local::WriteChainToHierarchy(ExecuteContext, CachedItems, Chain,
                                  bPropagateToChildren, bUseDebug);
 
     if (bUseDebug) {
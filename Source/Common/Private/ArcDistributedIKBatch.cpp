@@ -0,0 +1,305 @@
+﻿#include "ArcDistributedIKBatch.h"
+
+#include "ControlRig.h"
+#include "Math/VectorRegister.h"
+#include "Rigs/RigHierarchy.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(ArcDistributedIKBatch)
+
+int32 ArcDistributedIKSolver::SolveFABRIKBatch4(
+    TArrayView<TArray<FCCDIKChainLink>*> Chains,
+    TArrayView<const TArray<float>*> BoneLengths,
+    TArrayView<const FVector> EffectorPositions, float Precision,
+    int32 MaxIterations, FRigUnit_ArcDistributedIKBatch_WorkData& Scratch) {
+    const int32 NumLanes = FMath::Min(Chains.Num(), 4);
+    if (NumLanes < 1 || BoneLengths.Num() < NumLanes ||
+        EffectorPositions.Num() < NumLanes) {
+        return 0;
+    }
+
+    const int32 NumLinks = Chains[0]->Num();
+    if (NumLinks < 2) {
+        return 0;
+    }
+    const int32 LastLinkIndex = NumLinks - 1;
+
+    // 填充通道复用第一条链的数据
+    auto LaneOf = [NumLanes](int32 Lane) {
+        return Lane < NumLanes ? Lane : 0;
+    };
+
+    Scratch.PositionX.SetNumUninitialized(NumLinks);
+    Scratch.PositionY.SetNumUninitialized(NumLinks);
+    Scratch.PositionZ.SetNumUninitialized(NumLinks);
+    Scratch.BoneLength.SetNumUninitialized(NumLinks);
+
+    // 以各自的根为原点打包成单精度SoA，避免世界坐标过大损失精度
+    FVector RootPositions[4];
+    for (int32 Lane = 0; Lane < 4; ++Lane) {
+        RootPositions[Lane] =
+            (*Chains[LaneOf(Lane)])[0].Transform.GetLocation();
+    }
+
+    alignas(16) float LaneX[4];
+    alignas(16) float LaneY[4];
+    alignas(16) float LaneZ[4];
+    alignas(16) float LaneLength[4];
+
+    for (int32 i = 0; i < NumLinks; ++i) {
+        for (int32 Lane = 0; Lane < 4; ++Lane) {
+            const int32 Source = LaneOf(Lane);
+            const FVector Relative =
+                (*Chains[Source])[i].Transform.GetLocation() -
+                RootPositions[Lane];
+            LaneX[Lane] = (float)Relative.X;
+            LaneY[Lane] = (float)Relative.Y;
+            LaneZ[Lane] = (float)Relative.Z;
+            LaneLength[Lane] =
+                i < LastLinkIndex ? (*BoneLengths[Source])[i] : 0.0f;
+        }
+        Scratch.PositionX[i] = VectorLoadAligned(LaneX);
+        Scratch.PositionY[i] = VectorLoadAligned(LaneY);
+        Scratch.PositionZ[i] = VectorLoadAligned(LaneZ);
+        Scratch.BoneLength[i] = VectorLoadAligned(LaneLength);
+    }
+
+    for (int32 Lane = 0; Lane < 4; ++Lane) {
+        const FVector Relative =
+            EffectorPositions[LaneOf(Lane)] - RootPositions[Lane];
+        LaneX[Lane] = (float)Relative.X;
+        LaneY[Lane] = (float)Relative.Y;
+        LaneZ[Lane] = (float)Relative.Z;
+    }
+    const VectorRegister4Float TargetX = VectorLoadAligned(LaneX);
+    const VectorRegister4Float TargetY = VectorLoadAligned(LaneY);
+    const VectorRegister4Float TargetZ = VectorLoadAligned(LaneZ);
+
+    const VectorRegister4Float Zero = VectorZeroFloat();
+    const VectorRegister4Float Epsilon = VectorSetFloat1(1.e-12f);
+    const VectorRegister4Float PrecisionSquared =
+        VectorSetFloat1(Precision * Precision);
+
+    VectorRegister4Float* X = Scratch.PositionX.GetData();
+    VectorRegister4Float* Y = Scratch.PositionY.GetData();
+    VectorRegister4Float* Z = Scratch.PositionZ.GetData();
+    const VectorRegister4Float* Length = Scratch.BoneLength.GetData();
+
+    // 把 (X,Y,Z)[To] 放在从 From 指向 To 的方向上、距 From 为 BoneLength 处
+    auto PlaceAtLength = [&](int32 From, int32 To,
+                             const VectorRegister4Float& BoneLength) {
+        const VectorRegister4Float DX = VectorSubtract(X[To], X[From]);
+        const VectorRegister4Float DY = VectorSubtract(Y[To], Y[From]);
+        const VectorRegister4Float DZ = VectorSubtract(Z[To], Z[From]);
+        const VectorRegister4Float LengthSquared = VectorMultiplyAdd(
+            DX, DX, VectorMultiplyAdd(DY, DY, VectorMultiply(DZ, DZ)));
+        const VectorRegister4Float Scale = VectorMultiply(
+            BoneLength,
+            VectorReciprocalSqrt(VectorAdd(LengthSquared, Epsilon)));
+        X[To] = VectorMultiplyAdd(DX, Scale, X[From]);
+        Y[To] = VectorMultiplyAdd(DY, Scale, Y[From]);
+        Z[To] = VectorMultiplyAdd(DZ, Scale, Z[From]);
+    };
+
+    int32 IterationsUsed = 0;
+    for (int32 Iter = 0; Iter < MaxIterations; ++Iter) {
+        const VectorRegister4Float DX = VectorSubtract(X[LastLinkIndex], TargetX);
+        const VectorRegister4Float DY = VectorSubtract(Y[LastLinkIndex], TargetY);
+        const VectorRegister4Float DZ = VectorSubtract(Z[LastLinkIndex], TargetZ);
+        const VectorRegister4Float DistanceSquared = VectorMultiplyAdd(
+            DX, DX, VectorMultiplyAdd(DY, DY, VectorMultiply(DZ, DZ)));
+        if (VectorMaskBits(VectorCompareGE(DistanceSquared,
+                                           PrecisionSquared)) == 0) {
+            break;
+        }
+
+        // 反向：末端贴到目标，向根方向逐节恢复长度
+        X[LastLinkIndex] = TargetX;
+        Y[LastLinkIndex] = TargetY;
+        Z[LastLinkIndex] = TargetZ;
+        for (int32 i = LastLinkIndex - 1; i >= 0; --i) {
+            PlaceAtLength(i + 1, i, Length[i]);
+        }
+
+        // 正向：根回到原点，向末端逐节恢复长度
+        X[0] = Zero;
+        Y[0] = Zero;
+        Z[0] = Zero;
+        for (int32 i = 0; i < LastLinkIndex; ++i) {
+            PlaceAtLength(i, i + 1, Length[i]);
+        }
+
+        IterationsUsed = Iter + 1;
+    }
+
+    // 解包，只写回真实通道
+    for (int32 i = 1; i < NumLinks; ++i) {
+        VectorStoreAligned(X[i], LaneX);
+        VectorStoreAligned(Y[i], LaneY);
+        VectorStoreAligned(Z[i], LaneZ);
+        for (int32 Lane = 0; Lane < NumLanes; ++Lane) {
+            (*Chains[Lane])[i].Transform.SetLocation(
+                RootPositions[Lane] +
+                FVector(LaneX[Lane], LaneY[Lane], LaneZ[Lane]));
+        }
+    }
+
+    return IterationsUsed;
+}
+
+FRigUnit_ArcDistributedIKBatch_Execute() {
+    IterationsUsed = 0;
+    URigHierarchy* Hierarchy = ExecuteContext.Hierarchy;
+    if (!Hierarchy) {
+        return;
+    }
+
+    const int32 NumChains = Chains.Num();
+    WorkData.ChainCaches.SetNum(NumChains);
+    WorkData.PlaneNormals.SetNumUninitialized(NumChains);
+    WorkData.AlgorithmTypes.SetNumZeroed(NumChains);
+    for (TPair<int32, TArray<int32>>& Pending : WorkData.PendingByLinkCount) {
+        Pending.Value.Reset();
+    }
+
+    const float SolverPrecision = Precision > 0.f ? Precision : 0.001f;
+    const int32 SolverMaxIterations = MaxIterations > 0 ? MaxIterations : 10;
+
+    // ========== 1. 逐链读取层级并求解位置 ==========
+    for (int32 ChainIndex = 0; ChainIndex < NumChains; ++ChainIndex) {
+        const FArcDistributedIKBatchChain& Input = Chains[ChainIndex];
+        FRigUnit_ArcDistributedIK_WorkData& Cache =
+            WorkData.ChainCaches[ChainIndex];
+
+        if (!Cache.IsValidFor(Input.Items, Hierarchy) &&
+            !ArcDistributedIKSolver::BuildChainCache(Hierarchy, Input.Items,
+                                                     Cache, bUseDebug)) {
+            continue;
+        }
+
+        TArray<FCCDIKChainLink>& Chain = Cache.Chain;
+        for (int32 i = 0; i < Chain.Num(); ++i) {
+            Chain[i].Transform =
+                Hierarchy->GetGlobalTransform(Cache.CachedItems[i].GetIndex());
+        }
+
+        const FVector RootPosition = Chain[0].Transform.GetLocation();
+        const FVector EffectorPosition = Input.EffectorTransform.GetLocation();
+        const FVector PlaneNormal =
+            ArcDistributedIKSolver::CalculateReferencePlaneNormal(
+                RootPosition, EffectorPosition, Input.PoleTarget);
+        if (PlaneNormal.IsNearlyZero()) {
+            continue;
+        }
+        WorkData.PlaneNormals[ChainIndex] = PlaneNormal;
+
+        const float EffectorDistance =
+            FVector::Dist(RootPosition, EffectorPosition);
+        if (EffectorDistance > Cache.RestChainLength) {
+            ArcDistributedIKSolver::StretchChainToEffector(
+                Chain, Cache.RestBoneLengths, EffectorPosition);
+            WorkData.AlgorithmTypes[ChainIndex] = 1;
+            continue;
+        }
+
+        float MaxBoneLength = 0.0f;
+        for (int32 i = 0; i < Chain.Num() - 1; ++i) {
+            MaxBoneLength = FMath::Max(MaxBoneLength, Cache.RestBoneLengths[i]);
+        }
+        if (EffectorDistance <
+            MaxBoneLength - (Cache.RestChainLength - MaxBoneLength)) {
+            if (bUseDebug) {
+                UE_LOG(LogControlRig, Warning,
+                       TEXT("[ArcDistributedIKBatch] Chain %d: effector too "
+                            "close, skipped"),
+                       ChainIndex);
+            }
+            continue;
+        }
+
+        WorkData.AlgorithmTypes[ChainIndex] = 2;
+        if (bUseClosedFormSolver &&
+            ArcDistributedIKSolver::SolveArcClosedForm(
+                Chain, Cache.RestBoneLengths, Cache.RestChainLength,
+                EffectorPosition, PlaneNormal, SolverPrecision)) {
+            continue;
+        }
+
+        ArcDistributedIKSolver::PrepareFABRIKChain(
+            Chain, Cache.RestBoneLengths, EffectorPosition, PlaneNormal);
+        WorkData.PendingByLinkCount.FindOrAdd(Chain.Num()).Add(ChainIndex);
+    }
+
+    // ========== 2. 同关节数的链以4条为一组SIMD求解 ==========
+    for (const TPair<int32, TArray<int32>>& Pending :
+         WorkData.PendingByLinkCount) {
+        const TArray<int32>& ChainIndices = Pending.Value;
+        for (int32 Start = 0; Start < ChainIndices.Num(); Start += 4) {
+            const int32 NumLanes = FMath::Min(4, ChainIndices.Num() - Start);
+
+            TArray<FCCDIKChainLink>* GroupChains[4];
+            const TArray<float>* GroupBoneLengths[4];
+            FVector GroupEffectors[4];
+            for (int32 Lane = 0; Lane < NumLanes; ++Lane) {
+                const int32 ChainIndex = ChainIndices[Start + Lane];
+                FRigUnit_ArcDistributedIK_WorkData& Cache =
+                    WorkData.ChainCaches[ChainIndex];
+                GroupChains[Lane] = &Cache.Chain;
+                GroupBoneLengths[Lane] = &Cache.RestBoneLengths;
+                GroupEffectors[Lane] =
+                    Chains[ChainIndex].EffectorTransform.GetLocation();
+            }
+
+            const int32 GroupIterations =
+                ArcDistributedIKSolver::SolveFABRIKBatch4(
+                    MakeArrayView(GroupChains, NumLanes),
+                    MakeArrayView(GroupBoneLengths, NumLanes),
+                    MakeArrayView(GroupEffectors, NumLanes), SolverPrecision,
+                    SolverMaxIterations, WorkData);
+            IterationsUsed = FMath::Max(IterationsUsed, GroupIterations);
+        }
+    }
+
+    // ========== 3. 重建旋转 ==========
+    const PoleTargetSolverCore::FLocalAxisBasis LocalBasis(PrimaryAxis,
+                                                           SecondAxis);
+    for (int32 ChainIndex = 0; ChainIndex < NumChains; ++ChainIndex) {
+        const uint8 AlgorithmType = WorkData.AlgorithmTypes[ChainIndex];
+        if (AlgorithmType == 0) {
+            continue;
+        }
+        FRigUnit_ArcDistributedIK_WorkData& Cache =
+            WorkData.ChainCaches[ChainIndex];
+        ArcDistributedIKSolver::RebuildRotations(
+            Cache.Chain, WorkData.PlaneNormals[ChainIndex], LocalBasis,
+            Chains[ChainIndex].PoleTarget, AlgorithmType == 1);
+    }
+
+    // ========== 4. 一次性写回所有链条 ==========
+    for (int32 ChainIndex = 0; ChainIndex < NumChains; ++ChainIndex) {
+        if (WorkData.AlgorithmTypes[ChainIndex] == 0) {
+            continue;
+        }
+        const FRigUnit_ArcDistributedIK_WorkData& Cache =
+            WorkData.ChainCaches[ChainIndex];
+
+        bool bChainValid = true;
+        for (const FCCDIKChainLink& Link : Cache.Chain) {
+            if (Link.Transform.ContainsNaN()) {
+                bChainValid = false;
+                break;
+            }
+        }
+        if (!bChainValid) {
+            if (bUseDebug) {
+                UE_LOG(LogControlRig, Error,
+                       TEXT("[ArcDistributedIKBatch] Chain %d contains NaN "
+                            "values, skipped"),
+                       ChainIndex);
+            }
+            continue;
+        }
+
+        PoleTargetIKSolver::WriteChainToHierarchy(
+            Hierarchy, Cache.CachedItems, Cache.Chain, bPropagateToChildren);
+    }
+}
@@ -0,0 +1,437 @@
+﻿#include "InstrumentAnimSequenceBakeUtility.h"
+
+#include "Animation/AnimSequence.h"
+#include "Animation/SkeletalMeshActor.h"
+#include "Animation/Skeleton.h"
+#include "Animation/AnimData/IAnimationDataController.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Async/ParallelFor.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "ControlRig.h"
+#include "Engine/SkeletalMesh.h"
+#include "ISequencer.h"
+#include "InstrumentAnimationUtility.h"
+#include "InstrumentBase.h"
+#include "InstrumentControlRigUtility.h"
+#include "InstrumentPerformanceCookUtility.h"
+#include "LevelSequence.h"
+#include "Misc/PackageName.h"
+#include "MusicDollPerformanceAsset.h"
+#include "UObject/StrongObjectPtr.h"
+
+namespace InstrumentAnimSequenceBakeHelper {
+/** 每个工作线程至少负责的帧数，过短的分段不值得再初始化一份 Control Rig */
+static constexpr int32 MinFramesPerWorker = 32;
+
+/** 一个变换 Control 与它的采样曲线 */
+struct FTransformBinding {
+    const FMusicDollTransformCurve* Curve = nullptr;
+    int32 ControlIndex = INDEX_NONE;
+    FTransform LocalOffset = FTransform::Identity;
+};
+
+/** 一个浮点 Control 与它的采样曲线 */
+struct FFloatBinding {
+    const FMusicDollCurveChannel* Channel = nullptr;
+    int32 ControlIndex = INDEX_NONE;
+};
+
+/** 一条输出的 Morph Target 曲线：读 Control Rig 曲线元素或直接取浮点通道 */
+struct FMorphCurveSource {
+    FName CurveName;
+    int32 RigCurveIndex = INDEX_NONE;
+    int32 FloatBindingIndex = INDEX_NONE;
+};
+
+/** 查找或创建动画序列资产 */
+UAnimSequence* FindOrCreateAnimSequence(const FString& PackagePath,
+                                        bool& bOutCreated) {
+    const FString AssetName = FPackageName::GetLongPackageAssetName(PackagePath);
+    UAnimSequence* AnimSequence = LoadObject<UAnimSequence>(
+        nullptr, *(PackagePath + TEXT(".") + AssetName), nullptr,
+        LOAD_NoWarn | LOAD_Quiet);
+    bOutCreated = false;
+
+    if (!AnimSequence) {
+        UPackage* Package = CreatePackage(*PackagePath);
+        if (!Package) {
+            return nullptr;
+        }
+
+        AnimSequence = NewObject<UAnimSequence>(
+            Package, *AssetName, RF_Public | RF_Standalone | RF_Transactional);
+        bOutCreated = true;
+    }
+
+    return AnimSequence;
+}
+}  // namespace InstrumentAnimSequenceBakeHelper
+
+int32 UInstrumentAnimSequenceBakeUtility::BakeInstrumentToAnimSequences(
+    AInstrumentBase* Instrument, const FString& PackageDir,
+    bool bIncludeMorphTargetCurves) {
+    if (!Instrument) {
+        UE_LOG(LogTemp, Error,
+               TEXT("BakeInstrumentToAnimSequences: Instrument is null"));
+        return 0;
+    }
+
+    // 未指定目录时放在当前 Level Sequence 旁边
+    FString OutputDir = PackageDir;
+    if (OutputDir.IsEmpty()) {
+        ULevelSequence* LevelSequence = nullptr;
+        TSharedPtr<ISequencer> Sequencer = nullptr;
+        if (!UInstrumentAnimationUtility::GetActiveLevelSequenceAndSequencer(
+                LevelSequence, Sequencer)) {
+            UE_LOG(LogTemp, Error, TEXT("请确保已打开Level Sequence"));
+            return 0;
+        }
+        OutputDir = FPackageName::GetLongPackagePath(
+            LevelSequence->GetOutermost()->GetName());
+    }
+    OutputDir.RemoveFromEnd(TEXT("/"));
+
+    TArray<FInstrumentPlaybackActor> PlaybackActors;
+    Instrument->GetPlaybackActors(PlaybackActors);
+
+    const double StartTime = FPlatformTime::Seconds();
+    int32 NumBaked = 0;
+    for (const FInstrumentPlaybackActor& PlaybackActor : PlaybackActors) {
+        const FString PackagePath =
+            FString::Printf(TEXT("%s/AS_%s_%s"), *OutputDir,
+                            *Instrument->GetActorLabel(),
+                            *PlaybackActor.Role.ToString());
+        if (!FPackageName::IsValidLongPackageName(PackagePath)) {
+            UE_LOG(LogTemp, Error,
+                   TEXT("BakeInstrumentToAnimSequences: Invalid package path "
+                        "'%s'"),
+                   *PackagePath);
+            continue;
+        }
+
+        if (BakeToAnimSequence(PlaybackActor.Actor,
+                               Instrument->bUseTakeSequences,
+                               PlaybackActor.TakeSuffix, PackagePath,
+                               bIncludeMorphTargetCurves)) {
+            ++NumBaked;
+        }
+    }
+
+    UE_LOG(LogTemp, Log,
+           TEXT("BakeInstrumentToAnimSequences: Baked %d/%d animation "
+                "sequences into '%s' (%.1f ms)"),
+           NumBaked, PlaybackActors.Num(), *OutputDir,
+           (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+    return NumBaked;
+}
+
+UAnimSequence* UInstrumentAnimSequenceBakeUtility::BakeToAnimSequence(
+    ASkeletalMeshActor* SkeletalMeshActor, bool bUseTakeSequences,
+    const FString& TakeSuffix, const FString& PackagePath,
+    bool bIncludeMorphTargetCurves, float CurveTolerance) {
+    using namespace InstrumentAnimSequenceBakeHelper;
+
+    if (!SkeletalMeshActor) {
+        return nullptr;
+    }
+
+    USkeletalMeshComponent* MeshComponent =
+        SkeletalMeshActor->GetSkeletalMeshComponent();
+    USkeletalMesh* SkeletalMesh =
+        MeshComponent ? MeshComponent->GetSkeletalMeshAsset() : nullptr;
+    USkeleton* Skeleton = SkeletalMesh ? SkeletalMesh->GetSkeleton() : nullptr;
+    if (!Skeleton) {
+        UE_LOG(LogTemp, Error,
+               TEXT("BakeToAnimSequence: '%s' has no skeletal mesh or "
+                    "skeleton"),
+               *SkeletalMeshActor->GetName());
+        return nullptr;
+    }
+
+    UControlRig* SourceRig = nullptr;
+    UControlRigBlueprint* ControlRigBlueprint = nullptr;
+    if (!FInstrumentControlRigUtility::GetControlRigFromSkeletalMeshActor(
+            SkeletalMeshActor, SourceRig, ControlRigBlueprint) ||
+        !SourceRig->GetHierarchy()) {
+        UE_LOG(LogTemp, Error,
+               TEXT("BakeToAnimSequence: Failed to get Control Rig for '%s'"),
+               *SkeletalMeshActor->GetName());
+        return nullptr;
+    }
+
+    // ========== 1. 按显示帧率采样 Control Rig Section =========
+    // 与运行时播放资产走同一条采样路径；误差为0时只合并精确共线的样本，
+    // 在采样帧上与 Section 的值一致
+    TStrongObjectPtr<UMusicDollPerformanceAsset> Samples(
+        NewObject<UMusicDollPerformanceAsset>(GetTransientPackage()));
+    if (!UInstrumentPerformanceCookUtility::CookControlRigTrack(
+            SkeletalMeshActor, NAME_None, bUseTakeSequences, TakeSuffix, 0.0f,
+            Samples.Get())) {
+        return nullptr;
+    }
+
+    const FMusicDollPerformanceTrack* Track = Samples->FindTrack(NAME_None);
+    const FFrameRate SampleRate = Samples->SampleRate;
+    const int32 NumFrames =
+        FMath::RoundToInt32(SampleRate.AsDecimal() * Samples->Duration) + 1;
+    if (!Track || NumFrames < 2) {
+        UE_LOG(LogTemp, Error,
+               TEXT("BakeToAnimSequence: '%s' has nothing to bake"),
+               *SkeletalMeshActor->GetName());
+        return nullptr;
+    }
+
+    // ========== 2. 每个工作线程一份独立的 Control Rig =========
+    const int32 NumWorkers = FMath::Clamp(
+        FMath::DivideAndRoundUp(NumFrames, MinFramesPerWorker), 1,
+        FTaskGraphInterface::Get().GetNumWorkerThreads() + 1);
+
+    TArray<TStrongObjectPtr<UControlRig>> WorkerRigs;
+    WorkerRigs.Reserve(NumWorkers);
+    for (int32 i = 0; i < NumWorkers; ++i) {
+        UControlRig* WorkerRig = NewObject<UControlRig>(
+            GetTransientPackage(), SourceRig->GetClass(), NAME_None,
+            RF_Transient);
+        WorkerRig->Initialize(true);
+        // 复制源层级的当前姿态，没有关键帧的 Control 保持编辑器中的值
+        WorkerRig->GetHierarchy()->CopyHierarchy(SourceRig->GetHierarchy());
+        WorkerRigs.Emplace(WorkerRig);
+    }
+
+    // 层级是复制出来的，元素下标在所有实例中相同
+    URigHierarchy* LayoutHierarchy = WorkerRigs[0]->GetHierarchy();
+
+    TArray<FTransformBinding> TransformBindings;
+    for (const FMusicDollTransformCurve& Curve : Track->TransformCurves) {
+        const FRigElementKey Key(Curve.ControlName, ERigElementType::Control);
+        const int32 ControlIndex = LayoutHierarchy->GetIndex(Key);
+        if (ControlIndex != INDEX_NONE) {
+            TransformBindings.Add(
+                {&Curve, ControlIndex,
+                 LayoutHierarchy->GetLocalControlOffsetTransform(Key)});
+        }
+    }
+
+    TArray<FFloatBinding> FloatBindings;
+    for (const FMusicDollFloatCurve& Curve : Track->FloatCurves) {
+        FloatBindings.Add({&Curve.Channel,
+                           LayoutHierarchy->GetIndex(FRigElementKey(
+                               Curve.ControlName, ERigElementType::Control))});
+    }
+
+    // 网格参考骨架中的每根骨骼，层级中没有的骨骼保持参考姿态
+    const FReferenceSkeleton& RefSkeleton = SkeletalMesh->GetRefSkeleton();
+    const int32 NumBones = RefSkeleton.GetNum();
+    TArray<int32> BoneIndices;
+    BoneIndices.SetNumUninitialized(NumBones);
+    for (int32 Bone = 0; Bone < NumBones; ++Bone) {
+        BoneIndices[Bone] = LayoutHierarchy->GetIndex(FRigElementKey(
+            RefSkeleton.GetBoneName(Bone), ERigElementType::Bone));
+    }
+
+    // Morph Target 曲线：优先取 Control Rig 输出的曲线元素，其次取同名浮点通道
+    TArray<FMorphCurveSource> MorphCurves;
+    if (bIncludeMorphTargetCurves) {
+        TSet<FName> AddedCurves;
+        LayoutHierarchy->ForEach<FRigCurveElement>(
+            [&](FRigCurveElement* CurveElement) {
+                const FName CurveName = CurveElement->GetKey().Name;
+                if (SkeletalMesh->FindMorphTarget(CurveName)) {
+                    AddedCurves.Add(CurveName);
+                    MorphCurves.Add({CurveName, CurveElement->GetIndex(),
+                                     INDEX_NONE});
+                }
+                return true;
+            });
+
+        for (int32 i = 0; i < Track->FloatCurves.Num(); ++i) {
+            const FName CurveName = Track->FloatCurves[i].CurveName;
+            if (!AddedCurves.Contains(CurveName) &&
+                SkeletalMesh->FindMorphTarget(CurveName)) {
+                AddedCurves.Add(CurveName);
+                MorphCurves.Add({CurveName, INDEX_NONE, i});
+            }
+        }
+    }
+
+    // ========== 3. 分块并行求值 =========
+    // 帧主序：[Frame * NumBones + Bone]、[Frame * NumMorphCurves + Curve]
+    const int32 NumMorphCurves = MorphCurves.Num();
+    TArray<FTransform> BoneTransforms;
+    BoneTransforms.SetNumUninitialized(NumFrames * NumBones);
+    TArray<float> MorphValues;
+    MorphValues.SetNumZeroed(NumFrames * NumMorphCurves);
+
+    const TArray<FTransform>& RefPose = RefSkeleton.GetRefBonePose();
+    const int32 FramesPerWorker = FMath::DivideAndRoundUp(NumFrames, NumWorkers);
+
+    ParallelFor(NumWorkers, [&](int32 WorkerIndex) {
+        UControlRig* WorkerRig = WorkerRigs[WorkerIndex].Get();
+        URigHierarchy* Hierarchy = WorkerRig->GetHierarchy();
+        const int32 FirstFrame = WorkerIndex * FramesPerWorker;
+        const int32 LastFrame =
+            FMath::Min(FirstFrame + FramesPerWorker, NumFrames);
+
+        // 每个分段独立的曲线游标，帧单调递增时只需向前步进
+        TArray<int32> TransformCursors;
+        TransformCursors.SetNumZeroed(TransformBindings.Num() *
+                                      FMusicDollTransformCurve::NumChannels);
+        TArray<int32> FloatCursors;
+        FloatCursors.SetNumZeroed(FloatBindings.Num());
+        TArray<float> FloatValues;
+        FloatValues.SetNumZeroed(FloatBindings.Num());
+
+        for (int32 Frame = FirstFrame; Frame < LastFrame; ++Frame) {
+            const float Time =
+                static_cast<float>(SampleRate.AsSeconds(FFrameTime(Frame)));
+
+            for (int32 i = 0; i < TransformBindings.Num(); ++i) {
+                const FTransformBinding& Binding = TransformBindings[i];
+                float Values[FMusicDollTransformCurve::NumChannels];
+                for (int32 c = 0; c < FMusicDollTransformCurve::NumChannels;
+                     ++c) {
+                    Values[c] = Binding.Curve->Channels[c].Evaluate(
+                        Time, TransformCursors[i * FMusicDollTransformCurve::
+                                                       NumChannels +
+                                               c]);
+                }
+
+                // 旋转通道：X->Roll, Y->Pitch, Z->Yaw
+                const FTransform Value(
+                    FRotator(Values[4], Values[5], Values[3]).Quaternion(),
+                    FVector(Values[0], Values[1], Values[2]));
+                Hierarchy->SetLocalTransform(Binding.ControlIndex,
+                                             Value * Binding.LocalOffset);
+            }
+
+            for (int32 i = 0; i < FloatBindings.Num(); ++i) {
+                const FFloatBinding& Binding = FloatBindings[i];
+                FloatValues[i] =
+                    Binding.Channel->Evaluate(Time, FloatCursors[i]);
+                if (Binding.ControlIndex != INDEX_NONE) {
+                    Hierarchy->SetControlValue(
+                        Binding.ControlIndex,
+                        FRigControlValue::Make<float>(FloatValues[i]),
+                        ERigControlValueType::Current);
+                }
+            }
+
+            WorkerRig->Evaluate_AnyThread();
+
+            FTransform* FrameBones = &BoneTransforms[Frame * NumBones];
+            for (int32 Bone = 0; Bone < NumBones; ++Bone) {
+                FrameBones[Bone] =
+                    BoneIndices[Bone] != INDEX_NONE
+                        ? Hierarchy->GetLocalTransform(BoneIndices[Bone])
+                        : RefPose[Bone];
+            }
+
+            float* FrameMorphs = MorphValues.GetData() + Frame * NumMorphCurves;
+            for (int32 i = 0; i < NumMorphCurves; ++i) {
+                const FMorphCurveSource& Source = MorphCurves[i];
+                FrameMorphs[i] =
+                    Source.RigCurveIndex != INDEX_NONE
+                        ? Hierarchy->GetCurveValue(Source.RigCurveIndex)
+                        : FloatValues[Source.FloatBindingIndex];
+            }
+        }
+    });
+
+    WorkerRigs.Reset();
+
+    // ========== 4. 写入动画序列 =========
+    bool bCreated = false;
+    UAnimSequence* AnimSequence = FindOrCreateAnimSequence(PackagePath, bCreated);
+    if (!AnimSequence) {
+        UE_LOG(LogTemp, Error,
+               TEXT("BakeToAnimSequence: Failed to create package: %s"),
+               *PackagePath);
+        return nullptr;
+    }
+
+    AnimSequence->Modify();
+    AnimSequence->SetSkeleton(Skeleton);
+    AnimSequence->SetPreviewMesh(SkeletalMesh);
+
+    IAnimationDataController& Controller = AnimSequence->GetController();
+    Controller.OpenBracket(
+        NSLOCTEXT("MusicDoll", "BakeAnimSequence", "Bake Animation Sequence"),
+        false);
+    if (bCreated) {
+        Controller.InitializeModel();
+    } else {
+        Controller.ResetModel(false);
+    }
+    Controller.SetFrameRate(SampleRate, false);
+    Controller.SetNumberOfFrames(FFrameNumber(NumFrames - 1), false);
+
+    TArray<FVector3f> Positions;
+    TArray<FQuat4f> Rotations;
+    TArray<FVector3f> Scales;
+    Positions.SetNumUninitialized(NumFrames);
+    Rotations.SetNumUninitialized(NumFrames);
+    Scales.SetNumUninitialized(NumFrames);
+    for (int32 Bone = 0; Bone < NumBones; ++Bone) {
+        for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+            const FTransform& Transform =
+                BoneTransforms[Frame * NumBones + Bone];
+            Positions[Frame] = FVector3f(Transform.GetLocation());
+            Rotations[Frame] = FQuat4f(Transform.GetRotation());
+            Scales[Frame] = FVector3f(Transform.GetScale3D());
+        }
+
+        const FName BoneName = RefSkeleton.GetBoneName(Bone);
+        Controller.AddBoneCurve(BoneName, false);
+        Controller.SetBoneTrackKeys(BoneName, Positions, Rotations, Scales,
+                                    false);
+    }
+
+    // Morph Target 曲线按误差压缩后写为线性关键帧
+    // 曲线元数据会写入骨架资产，需先纳入事务并标记脏
+    if (NumMorphCurves > 0) {
+        Skeleton->Modify();
+    }
+    for (int32 i = 0; i < NumMorphCurves; ++i) {
+        FMusicDollCurveChannel Channel;
+        Channel.Times.Reserve(NumFrames);
+        Channel.Values.Reserve(NumFrames);
+        for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+            Channel.AddSample(
+                static_cast<float>(SampleRate.AsSeconds(FFrameTime(Frame))),
+                MorphValues[Frame * NumMorphCurves + i]);
+        }
+        Channel.Compress(CurveTolerance);
+
+        TArray<FRichCurveKey> Keys;
+        Keys.Reserve(Channel.Times.Num());
+        for (int32 k = 0; k < Channel.Times.Num(); ++k) {
+            FRichCurveKey& Key = Keys.Emplace_GetRef(Channel.Times[k],
+                                                     Channel.Values[k]);
+            Key.InterpMode = RCIM_Linear;
+        }
+
+        const FAnimationCurveIdentifier CurveId(MorphCurves[i].CurveName,
+                                                ERawCurveTrackTypes::RCT_Float);
+        Controller.AddCurve(CurveId, AACF_DefaultCurve, false);
+        Controller.SetCurveKeys(CurveId, Keys, false);
+        Skeleton->AccumulateCurveMetaData(MorphCurves[i].CurveName, false,
+                                          true);
+    }
+
+    // 压缩由序列的骨骼/曲线压缩设置在派生数据中完成
+    Controller.NotifyPopulated();
+    Controller.CloseBracket(false);
+
+    if (bCreated) {
+        FAssetRegistryModule::AssetCreated(AnimSequence);
+    }
+    AnimSequence->MarkPackageDirty();
+
+    UE_LOG(LogTemp, Log,
+           TEXT("BakeToAnimSequence: '%s' -> '%s': %d bones, %d morph "
+                "curves, %d frames on %d workers"),
+           *SkeletalMeshActor->GetName(), *PackagePath, NumBones,
+           NumMorphCurves, NumFrames, NumWorkers);
+    return AnimSequence;
+}
@@ -1,20 +1,27 @@
 ﻿#include "InstrumentAnimationUtility.h"
 
+#include "AssetRegistry/AssetRegistryModule.h"
 #include "Channels/MovieSceneFloatChannel.h"
 #include "Common/Public/InstrumentControlRigUtility.h"
+#include "Compilation/MovieSceneCompiledDataManager.h"
 #include "Dom/JsonObject.h"
 #include "Dom/JsonValue.h"
+#include "Evaluation/MovieSceneSequenceHierarchy.h"
 #include "ISequencer.h"
 #include "ISequencerModule.h"
 #include "LevelEditorSequencerIntegration.h"
 #include "LevelSequence.h"
 #include "LevelSequenceEditorBlueprintLibrary.h"
+#include "Misc/PackageName.h"
 #include "MovieScene.h"
 #include "MovieSceneSequence.h"
+#include "ObjectTools.h"
 #include "Sections/MovieSceneComponentMaterialParameterSection.h"
+#include "Sections/MovieSceneSubSection.h"
 #include "Sequencer/ControlRigSequencerHelpers.h"
 #include "Sequencer/MovieSceneControlRigParameterTrack.h"
 #include "Tracks/MovieSceneMaterialTrack.h"
+#include "Tracks/MovieSceneSubTrack.h"
 
 // ========== Sequencer 集成 ==========
 
@@ -33,14 +40,8 @@ bool UInstrumentAnimationUtility::GetActiveLevelSequenceAndSequencer(
 
     for (const TWeakPtr<ISequencer>& WeakSequencer : WeakSequencers) {
         if (TSharedPtr<ISequencer> CurrentSequencer = WeakSequencer.Pin()) {
-            UMovieSceneSequence* RootSequence =
-                CurrentSequencer->GetRootMovieSceneSequence();
-
-            if (!RootSequence) {
-                continue;
-            }
-
-            ULevelSequence* LevelSequence = Cast<ULevelSequence>(RootSequence);
+            ULevelSequence* LevelSequence =
+                GetGenerationTargetSequence(*CurrentSequencer);
             if (LevelSequence) {
                 OutLevelSequence = LevelSequence;
                 OutSequencer = CurrentSequencer;
@@ -54,6 +55,18 @@ bool UInstrumentAnimationUtility::GetActiveLevelSequenceAndSequencer(
     return false;
 }
 
+ULevelSequence* UInstrumentAnimationUtility::GetGenerationTargetSequence(
+    ISequencer& Sequencer) {
+    // 只有分段子序列作用域会把Sequencer聚焦到要写入的子序列上
+    if (FScopedTakeSequenceGeneration::IsAnyActive()) {
+        if (ULevelSequence* FocusedSequence = Cast<ULevelSequence>(
+                Sequencer.GetFocusedMovieSceneSequence())) {
+            return FocusedSequence;
+        }
+    }
+    return Cast<ULevelSequence>(Sequencer.GetRootMovieSceneSequence());
+}
+
 // ========== Component Material Track 管理 ==========
 
 UMovieSceneComponentMaterialTrack*
@@ -253,9 +266,190 @@ bool UInstrumentAnimationUtility::AddMaterialParameter(
     return true;
 }
 
+int32 UInstrumentAnimationUtility::BulkCreateMaterialParameterTracks(
+    ULevelSequence* LevelSequence, const FGuid& ObjectBindingID,
+    const TArray<FMaterialParameterTrackRequest>& Requests,
+    TSharedPtr<ISequencer> Sequencer, TArray<int32>* OutFailedRequestIndices) {
+    if (OutFailedRequestIndices) {
+        OutFailedRequestIndices->Reset();
+    }
+
+    if (!LevelSequence || !ObjectBindingID.IsValid() || Requests.Num() == 0) {
+        UE_LOG(LogTemp, Error,
+               TEXT("[InstrumentAnimationUtility] Invalid arguments for "
+                    "BulkCreateMaterialParameterTracks"));
+        return 0;
+    }
+
+    UMovieScene* MovieScene = LevelSequence->GetMovieScene();
+    if (!MovieScene) {
+        UE_LOG(LogTemp, Error,
+               TEXT("[InstrumentAnimationUtility] MovieScene is null"));
+        return 0;
+    }
+
+    MovieScene->Modify();
+
+    // 1. 一次性索引绑定上已有的Component Material Track
+    TMap<int32, UMovieSceneComponentMaterialTrack*> TracksBySlotIndex;
+    TMap<FName, UMovieSceneComponentMaterialTrack*> TracksBySlotName;
+    for (UMovieSceneTrack* Track : MovieScene->FindTracks(
+             UMovieSceneComponentMaterialTrack::StaticClass(),
+             ObjectBindingID)) {
+        UMovieSceneComponentMaterialTrack* MaterialTrack =
+            Cast<UMovieSceneComponentMaterialTrack>(Track);
+        if (!MaterialTrack) {
+            continue;
+        }
+
+        const FComponentMaterialInfo& MaterialInfo =
+            MaterialTrack->GetMaterialInfo();
+        TracksBySlotIndex.FindOrAdd(MaterialInfo.MaterialSlotIndex,
+                                    MaterialTrack);
+        if (MaterialInfo.MaterialSlotName != NAME_None) {
+            TracksBySlotName.FindOrAdd(MaterialInfo.MaterialSlotName,
+                                       MaterialTrack);
+        }
+    }
+
+    // 每条轨道的参数Section及其已有参数（每条轨道只扫描一次）
+    struct FTrackParameterState {
+        UMovieSceneComponentMaterialParameterSection* Section = nullptr;
+        TSet<FName> ExistingParameters;
+    };
+    TMap<UMovieSceneComponentMaterialTrack*, FTrackParameterState> TrackStates;
+
+    int32 SuccessCount = 0;
+    int32 CreatedTracks = 0;
+
+    for (int32 RequestIndex = 0; RequestIndex < Requests.Num();
+         ++RequestIndex) {
+        const FMaterialParameterTrackRequest& Request = Requests[RequestIndex];
+
+        auto MarkFailed = [&]() {
+            if (OutFailedRequestIndices) {
+                OutFailedRequestIndices->Add(RequestIndex);
+            }
+        };
+
+        if (Request.ParameterName.IsEmpty()) {
+            MarkFailed();
+            continue;
+        }
+
+        // 2. 查找或创建轨道（匹配规则同FindOrCreateComponentMaterialTrack）
+        UMovieSceneComponentMaterialTrack* MaterialTrack = nullptr;
+        if (Request.MaterialSlotName != NAME_None) {
+            MaterialTrack = TracksBySlotName.FindRef(Request.MaterialSlotName);
+        } else {
+            MaterialTrack =
+                TracksBySlotIndex.FindRef(Request.MaterialSlotIndex);
+        }
+
+        if (!MaterialTrack) {
+            MaterialTrack = Cast<UMovieSceneComponentMaterialTrack>(
+                MovieScene->AddTrack(
+                    UMovieSceneComponentMaterialTrack::StaticClass(),
+                    ObjectBindingID));
+            if (!MaterialTrack) {
+                MarkFailed();
+                continue;
+            }
+
+            FComponentMaterialInfo MaterialInfo;
+            MaterialInfo.MaterialType =
+                EComponentMaterialType::IndexedMaterial;
+            MaterialInfo.MaterialSlotIndex = Request.MaterialSlotIndex;
+            MaterialInfo.MaterialSlotName = Request.MaterialSlotName;
+            MaterialTrack->SetMaterialInfo(MaterialInfo);
+            MaterialTrack->SetDisplayName(FText::FromString(FString::Printf(
+                TEXT("CM_%d_%s"), Request.MaterialSlotIndex,
+                Request.MaterialSlotName != NAME_None
+                    ? *Request.MaterialSlotName.ToString()
+                    : TEXT("Unnamed"))));
+
+            TracksBySlotIndex.FindOrAdd(Request.MaterialSlotIndex,
+                                        MaterialTrack);
+            if (Request.MaterialSlotName != NAME_None) {
+                TracksBySlotName.Add(Request.MaterialSlotName, MaterialTrack);
+            }
+            CreatedTracks++;
+        }
+
+        // 3. 获取或创建参数Section
+        FTrackParameterState* State = TrackStates.Find(MaterialTrack);
+        if (!State) {
+            State = &TrackStates.Add(MaterialTrack);
+            for (UMovieSceneSection* Section : MaterialTrack->GetAllSections()) {
+                UMovieSceneComponentMaterialParameterSection* ParamSection =
+                    Cast<UMovieSceneComponentMaterialParameterSection>(Section);
+                if (!ParamSection) {
+                    continue;
+                }
+                if (!State->Section) {
+                    State->Section = ParamSection;
+                }
+                for (const FScalarMaterialParameterInfoAndCurve& Param :
+                     ParamSection->ScalarParameterInfosAndCurves) {
+                    State->ExistingParameters.Add(Param.ParameterInfo.Name);
+                }
+            }
+
+            if (!State->Section) {
+                UMovieSceneSection* NewSection =
+                    MaterialTrack->CreateNewSection();
+                State->Section =
+                    Cast<UMovieSceneComponentMaterialParameterSection>(
+                        NewSection);
+                if (State->Section) {
+                    MaterialTrack->AddSection(*NewSection);
+                }
+            }
+
+            if (State->Section &&
+                (!State->Section->GetRange().HasLowerBound() ||
+                 !State->Section->GetRange().HasUpperBound())) {
+                State->Section->SetRange(TRange<FFrameNumber>::All());
+            }
+        }
+
+        if (!State->Section) {
+            MarkFailed();
+            continue;
+        }
+
+        // 4. 添加参数（已存在则跳过）
+        const FName ParameterFName(*Request.ParameterName);
+        if (!State->ExistingParameters.Contains(ParameterFName)) {
+            FMaterialParameterInfo ParameterInfo;
+            ParameterInfo.Name = ParameterFName;
+            State->Section->AddScalarParameterKey(
+                ParameterInfo, FFrameNumber(0), Request.InitialValue,
+                TEXT(""), TEXT(""), EMovieSceneKeyInterpolation::Auto);
+            State->ExistingParameters.Add(ParameterFName);
+        }
+
+        SuccessCount++;
+    }
+
+    LevelSequence->MarkPackageDirty();
+    if (Sequencer.IsValid()) {
+        Sequencer->NotifyMovieSceneDataChanged(
+            EMovieSceneDataChangeType::MovieSceneStructureItemsChanged);
+    }
+
+    UE_LOG(LogTemp, Log,
+           TEXT("[InstrumentAnimationUtility] Bulk material parameters: %d/%d "
+                "requests succeeded, %d tracks created"),
+           SuccessCount, Requests.Num(), CreatedTracks);
+
+    return SuccessCount;
+}
+
 int32 UInstrumentAnimationUtility::WriteMaterialParameterKeyframes(
     UMovieSceneComponentMaterialParameterSection* Section,
-    const TArray<FMaterialParameterKeyframeData>& KeyframeData) {
+    const TArray<FMaterialParameterKeyframeData>& KeyframeData,
+    const FAnimationFrameWindow& FrameWindow) {
     if (!Section) {
         UE_LOG(LogTemp, Error,
                TEXT("[InstrumentAnimationUtility] Section is null"));
@@ -268,6 +462,24 @@ int32 UInstrumentAnimationUtility::WriteMaterialParameterKeyframes(
         return 0;
     }
 
+    // 局部重新生成：换算窗口到Tick单位
+    const bool bUseFrameWindow = FrameWindow.IsSet();
+    TRange<FFrameNumber> TickWindow = TRange<FFrameNumber>::Empty();
+    FFrameNumber BlendTicks(0);
+    if (bUseFrameWindow) {
+        UMovieScene* MovieScene = Section->GetTypedOuter<UMovieScene>();
+        if (!MovieScene) {
+            UE_LOG(LogTemp, Error,
+                   TEXT("[InstrumentAnimationUtility] Section has no "
+                        "MovieScene, cannot apply frame window"));
+            return 0;
+        }
+        TickWindow = FrameWindow.ToTickRange(MovieScene->GetTickResolution(),
+                                             MovieScene->GetDisplayRate());
+        BlendTicks = FrameWindow.GetBlendTicks(
+            MovieScene->GetTickResolution(), MovieScene->GetDisplayRate());
+    }
+
     int32 SuccessCount = 0;
 
     for (const FMaterialParameterKeyframeData& Data : KeyframeData) {
@@ -287,6 +499,44 @@ int32 UInstrumentAnimationUtility::WriteMaterialParameterKeyframes(
             continue;
         }
 
+        // 窗口模式：直接替换参数曲线中窗口内的关键帧（窗口内没有新数据时只做清除）
+        if (bUseFrameWindow) {
+            FMovieSceneFloatChannel* ParameterCurve = nullptr;
+            for (FScalarMaterialParameterInfoAndCurve& ExistingParam :
+                 Section->ScalarParameterInfosAndCurves) {
+                if (ExistingParam.ParameterInfo.Name ==
+                    FName(*Data.ParameterName)) {
+                    ParameterCurve = &ExistingParam.ParameterCurve;
+                    break;
+                }
+            }
+
+            if (ParameterCurve) {
+                TArray<FMovieSceneFloatValue> FloatValues;
+                FloatValues.Reserve(Data.Values.Num());
+                for (float Value : Data.Values) {
+                    FMovieSceneFloatValue FloatValue(Value);
+                    FloatValue.InterpMode = RCIM_Linear;
+                    FloatValues.Add(FloatValue);
+                }
+
+                int32 RemovedKeys = ReplaceChannelKeysInWindow(
+                    ParameterCurve, Data.FrameNumbers, FloatValues, TickWindow,
+                    BlendTicks);
+
+                SuccessCount++;
+
+                UE_LOG(LogTemp, Log,
+                       TEXT("[InstrumentAnimationUtility] Replaced %d "
+                            "keyframes with %d for parameter '%s' in window "
+                            "[%d, %d]"),
+                       RemovedKeys, Data.FrameNumbers.Num(),
+                       *Data.ParameterName, FrameWindow.StartFrame,
+                       FrameWindow.EndFrame);
+                continue;
+            }
+        }
+
         if (Data.FrameNumbers.Num() == 0) {
             UE_LOG(LogTemp, Warning,
                    TEXT("[InstrumentAnimationUtility] No keyframes to write "
@@ -581,6 +831,283 @@ bool UInstrumentAnimationUtility::CleanupInstrumentAnimationTracks(
 #endif
 }
 
+// ========== 分段子序列（Take） ==========
+
+ULevelSequence* UInstrumentAnimationUtility::GetOrCreateTakeSequence(
+    ULevelSequence* MasterSequence, const FString& TakeName,
+    UMovieSceneSubSection*& OutSubSection) {
+    OutSubSection = nullptr;
+
+    if (!MasterSequence || TakeName.IsEmpty()) {
+        UE_LOG(LogTemp, Error,
+               TEXT("[InstrumentAnimationUtility] Invalid MasterSequence or "
+                    "TakeName"));
+        return nullptr;
+    }
+
+    UMovieScene* MasterMovieScene = MasterSequence->GetMovieScene();
+    if (!MasterMovieScene) {
+        UE_LOG(LogTemp, Error,
+               TEXT("[InstrumentAnimationUtility] Master MovieScene is null"));
+        return nullptr;
+    }
+
+    // 1. 计算子序列资产路径：<主序列目录>/<主序列名>_Takes/<主序列名>_<TakeName>
+    const FString MasterName = MasterSequence->GetName();
+    const FString AssetName = ObjectTools::SanitizeObjectName(
+        FString::Printf(TEXT("%s_%s"), *MasterName, *TakeName));
+    const FString TakePackageName =
+        FPackageName::GetLongPackagePath(
+            MasterSequence->GetOutermost()->GetName()) /
+        (MasterName + TEXT("_Takes")) / AssetName;
+
+    // 2. 查找或创建子序列资产
+    ULevelSequence* TakeSequence = LoadObject<ULevelSequence>(
+        nullptr, *(TakePackageName + TEXT(".") + AssetName), nullptr,
+        LOAD_NoWarn | LOAD_Quiet);
+
+    if (!TakeSequence) {
+        UPackage* TakePackage = CreatePackage(*TakePackageName);
+        if (!TakePackage) {
+            UE_LOG(LogTemp, Error,
+                   TEXT("[InstrumentAnimationUtility] Failed to create "
+                        "package: %s"),
+                   *TakePackageName);
+            return nullptr;
+        }
+
+        TakeSequence = NewObject<ULevelSequence>(
+            TakePackage, *AssetName,
+            RF_Public | RF_Standalone | RF_Transactional);
+        TakeSequence->Initialize();
+
+        UMovieScene* TakeMovieScene = TakeSequence->GetMovieScene();
+        TakeMovieScene->SetTickResolutionDirectly(
+            MasterMovieScene->GetTickResolution());
+        TakeMovieScene->SetDisplayRate(MasterMovieScene->GetDisplayRate());
+        TakeMovieScene->SetPlaybackRange(MasterMovieScene->GetPlaybackRange());
+
+        FAssetRegistryModule::AssetCreated(TakeSequence);
+        TakePackage->MarkPackageDirty();
+
+        UE_LOG(LogTemp, Log,
+               TEXT("[InstrumentAnimationUtility] Created take sequence: %s"),
+               *TakePackageName);
+    }
+
+    // 3. 查找或创建主序列中的Sub Track
+    UMovieSceneSubTrack* SubTrack = nullptr;
+    for (UMovieSceneTrack* Track : MasterMovieScene->GetTracks()) {
+        if (Track && Track->GetClass() == UMovieSceneSubTrack::StaticClass()) {
+            SubTrack = Cast<UMovieSceneSubTrack>(Track);
+            break;
+        }
+    }
+
+    if (!SubTrack) {
+        MasterMovieScene->Modify();
+        SubTrack = Cast<UMovieSceneSubTrack>(
+            MasterMovieScene->AddTrack(UMovieSceneSubTrack::StaticClass()));
+        if (!SubTrack) {
+            UE_LOG(LogTemp, Error,
+                   TEXT("[InstrumentAnimationUtility] Failed to create Sub "
+                        "Track in master sequence"));
+            return nullptr;
+        }
+    }
+
+    // 4. 查找引用该子序列的Sub Section，没有则新建
+    for (UMovieSceneSection* Section : SubTrack->GetAllSections()) {
+        UMovieSceneSubSection* SubSection = Cast<UMovieSceneSubSection>(Section);
+        if (SubSection && SubSection->GetSequence() == TakeSequence) {
+            OutSubSection = SubSection;
+            return TakeSequence;
+        }
+    }
+
+    const TRange<FFrameNumber> PlaybackRange =
+        TakeSequence->GetMovieScene()->GetPlaybackRange();
+    SubTrack->Modify();
+    OutSubSection = SubTrack->AddSequence(
+        TakeSequence, UE::MovieScene::DiscreteInclusiveLower(PlaybackRange),
+        UE::MovieScene::DiscreteSize(PlaybackRange));
+
+    if (!OutSubSection) {
+        UE_LOG(LogTemp, Error,
+               TEXT("[InstrumentAnimationUtility] Failed to add take '%s' to "
+                    "master sequence"),
+               *AssetName);
+        return nullptr;
+    }
+
+    MasterSequence->MarkPackageDirty();
+    return TakeSequence;
+}
+
+int32 UInstrumentAnimationUtility::MoveActorBindingsToSequence(
+    TSharedPtr<ISequencer> Sequencer, ULevelSequence* SourceSequence,
+    ULevelSequence* TargetSequence, AActor* Actor) {
+    if (!Sequencer.IsValid() || !SourceSequence || !TargetSequence ||
+        !Actor) {
+        return 0;
+    }
+
+    UMovieScene* SourceMovieScene = SourceSequence->GetMovieScene();
+    UMovieScene* TargetMovieScene = TargetSequence->GetMovieScene();
+    if (!SourceMovieScene || !TargetMovieScene) {
+        return 0;
+    }
+
+    const FGuid ActorGuid = Sequencer->GetHandleToObject(Actor, false);
+    if (!ActorGuid.IsValid() || !SourceMovieScene->FindPossessable(ActorGuid)) {
+        return 0;
+    }
+
+    // 收集Actor绑定及其子组件绑定（父绑定放在最前面）
+    TArray<FGuid> GuidsToMove;
+    GuidsToMove.Add(ActorGuid);
+    for (int32 Index = 0; Index < SourceMovieScene->GetPossessableCount();
+         ++Index) {
+        const FMovieScenePossessable& Possessable =
+            SourceMovieScene->GetPossessable(Index);
+        if (Possessable.GetParent() == ActorGuid) {
+            GuidsToMove.Add(Possessable.GetGuid());
+        }
+    }
+
+    SourceSequence->Modify();
+    SourceMovieScene->Modify();
+    TargetSequence->Modify();
+    TargetMovieScene->Modify();
+
+    UObject* PlaybackContext = Sequencer->GetPlaybackContext();
+    int32 MovedCount = 0;
+    int32 SkippedTrackCount = 0;
+
+    for (const FGuid& Guid : GuidsToMove) {
+        const FMovieScenePossessable* Possessable =
+            SourceMovieScene->FindPossessable(Guid);
+        const FMovieSceneBinding* Binding = SourceMovieScene->FindBinding(Guid);
+        if (!Possessable || !Binding) {
+            continue;
+        }
+
+        // 先取出绑定对象，移除绑定后就查不到了
+        TArray<UObject*> BoundObjects;
+        for (const TWeakObjectPtr<UObject>& WeakObject :
+             Sequencer->FindBoundObjects(Guid, MovieSceneSequenceID::Root)) {
+            if (WeakObject.IsValid()) {
+                BoundObjects.Add(WeakObject.Get());
+            }
+        }
+
+        const FMovieScenePossessable PossessableCopy = *Possessable;
+        const FString BindingName = Binding->GetName();
+        const TArray<UMovieSceneTrack*> Tracks = Binding->GetTracks();
+
+        // 子序列中已有同一绑定时合并到已有绑定，不再重复添加绑定和绑定对象
+        const bool bBindingExists =
+            TargetMovieScene->FindPossessable(Guid) != nullptr;
+        if (!bBindingExists) {
+            TargetMovieScene->AddPossessable(
+                PossessableCopy, FMovieSceneBinding(Guid, BindingName));
+        }
+
+        // 轨道换Outer后挂到目标绑定下；子序列中已有同类同名轨道时保留
+        // 子序列的轨道（生成结果写在那里），丢弃主序列中的重复轨道
+        for (UMovieSceneTrack* Track : Tracks) {
+            if (!Track) {
+                continue;
+            }
+            SourceMovieScene->RemoveTrack(*Track);
+            if (bBindingExists &&
+                TargetMovieScene->FindTrack(Track->GetClass(), Guid,
+                                            Track->GetTrackName())) {
+                UE_LOG(LogTemp, Warning,
+                       TEXT("[InstrumentAnimationUtility] Take '%s' already "
+                            "has track '%s' on binding '%s', dropping the "
+                            "master sequence copy"),
+                       *TargetSequence->GetName(),
+                       *Track->GetDisplayName().ToString(), *BindingName);
+                SkippedTrackCount++;
+                continue;
+            }
+            Track->Rename(nullptr, TargetMovieScene,
+                          REN_DontCreateRedirectors | REN_DoNotDirty);
+            TargetMovieScene->AddGivenTrack(Track, Guid);
+        }
+
+        if (!bBindingExists) {
+            UObject* BindingContext = Guid == ActorGuid
+                                          ? PlaybackContext
+                                          : static_cast<UObject*>(Actor);
+            for (UObject* BoundObject : BoundObjects) {
+                TargetSequence->BindPossessableObject(Guid, *BoundObject,
+                                                      BindingContext);
+            }
+        }
+
+        MovedCount++;
+    }
+
+    // 子绑定先于父绑定移除
+    for (int32 Index = GuidsToMove.Num() - 1; Index >= 0; --Index) {
+        SourceSequence->UnbindPossessableObjects(GuidsToMove[Index]);
+        SourceMovieScene->RemovePossessable(GuidsToMove[Index]);
+    }
+
+    SourceSequence->MarkPackageDirty();
+    TargetSequence->MarkPackageDirty();
+    Sequencer->NotifyMovieSceneDataChanged(
+        EMovieSceneDataChangeType::MovieSceneStructureItemsChanged);
+
+    UE_LOG(LogTemp, Log,
+           TEXT("[InstrumentAnimationUtility] Moved %d bindings of '%s' to "
+                "take sequence '%s' (%d duplicate tracks dropped)"),
+           MovedCount, *Actor->GetActorLabel(), *TargetSequence->GetName(),
+           SkippedTrackCount);
+
+    return MovedCount;
+}
+
+void UInstrumentAnimationUtility::UpdateTakeSubSectionRange(
+    UMovieSceneSubSection* SubSection) {
+    if (!SubSection || !SubSection->GetSequence()) {
+        return;
+    }
+
+    UMovieScene* TakeMovieScene = SubSection->GetSequence()->GetMovieScene();
+    if (!TakeMovieScene) {
+        return;
+    }
+
+    TRange<FFrameNumber> ContentRange = TRange<FFrameNumber>::Empty();
+    for (const UMovieSceneSection* Section : TakeMovieScene->GetAllSections()) {
+        if (Section && Section->GetRange().HasLowerBound() &&
+            Section->GetRange().HasUpperBound()) {
+            ContentRange = ContentRange.IsEmpty()
+                               ? Section->GetRange()
+                               : TRange<FFrameNumber>::Hull(
+                                     ContentRange, Section->GetRange());
+        }
+    }
+
+    if (ContentRange.IsEmpty()) {
+        return;
+    }
+
+    // 子序列播放范围与主序列时间一一对应（起点相同、帧率相同）
+    if (TakeMovieScene->GetPlaybackRange() != ContentRange) {
+        TakeMovieScene->SetPlaybackRange(ContentRange);
+    }
+
+    if (SubSection->GetRange() != ContentRange) {
+        SubSection->Modify();
+        SubSection->SetRange(ContentRange);
+        SubSection->Parameters.StartFrameOffset = FFrameNumber(0);
+    }
+}
+
 // ========== 旋转处理 ==========
 
 void UInstrumentAnimationUtility::UnwrapRotationSequence(
@@ -665,6 +1192,113 @@ void UInstrumentAnimationUtility::LogAvailableChannels(
     }
 }
 
+// ========== 局部重新生成 ==========
+
+int32 UInstrumentAnimationUtility::RemoveKeysInRange(
+    FMovieSceneFloatChannel* Channel, const TRange<FFrameNumber>& TickRange) {
+    if (!Channel) {
+        return 0;
+    }
+
+    TMovieSceneChannelData<FMovieSceneFloatValue> ChannelData =
+        Channel->GetData();
+
+    int32 RemovedCount = 0;
+    for (int32 KeyIndex = ChannelData.GetTimes().Num() - 1; KeyIndex >= 0;
+         --KeyIndex) {
+        if (TickRange.Contains(ChannelData.GetTimes()[KeyIndex])) {
+            ChannelData.RemoveKey(KeyIndex);
+            RemovedCount++;
+        }
+    }
+
+    return RemovedCount;
+}
+
+int32 UInstrumentAnimationUtility::ReplaceChannelKeysInWindow(
+    FMovieSceneFloatChannel* Channel, const TArray<FFrameNumber>& Times,
+    TArray<FMovieSceneFloatValue>& Values,
+    const TRange<FFrameNumber>& TickWindow, FFrameNumber BlendTicks,
+    bool bIsRotationChannel) {
+    if (!Channel) {
+        return 0;
+    }
+
+    if (Times.Num() != Values.Num()) {
+        UE_LOG(LogTemp, Error,
+               TEXT("[InstrumentAnimationUtility] Times and Values count "
+                    "mismatch: %d vs %d"),
+               Times.Num(), Values.Num());
+        return 0;
+    }
+
+    const FFrameNumber WindowStart = TickWindow.GetLowerBoundValue();
+    const FFrameNumber WindowEnd = TickWindow.GetUpperBoundValue();
+
+    // 窗口两侧是否还有需要保留的旧关键帧
+    TArrayView<const FFrameNumber> ExistingTimes = Channel->GetTimes();
+    const bool bHasKeysBefore =
+        ExistingTimes.Num() > 0 && ExistingTimes[0] < WindowStart;
+    const bool bHasKeysAfter =
+        ExistingTimes.Num() > 0 && ExistingTimes.Last() > WindowEnd;
+
+    // 1. 旋转通道：整体平移360度的整数倍，避免与窗口外的展开结果产生跳变
+    if (bIsRotationChannel && Values.Num() > 0 &&
+        (bHasKeysBefore || bHasKeysAfter)) {
+        float OldValue = 0.0f;
+        if (Channel->Evaluate(FFrameTime(Times[0]), OldValue)) {
+            const float Offset =
+                360.0f *
+                FMath::RoundToFloat((OldValue - Values[0].Value) / 360.0f);
+            if (!FMath::IsNearlyZero(Offset)) {
+                for (FMovieSceneFloatValue& Value : Values) {
+                    Value.Value += Offset;
+                }
+            }
+        }
+    }
+
+    // 2. 接缝混合：必须在删除旧关键帧之前采样旧曲线
+    if (BlendTicks.Value > 0) {
+        for (int32 KeyIdx = 0; KeyIdx < Times.Num(); ++KeyIdx) {
+            const FFrameNumber Time = Times[KeyIdx];
+            float Weight = 1.0f;
+
+            if (bHasKeysBefore) {
+                Weight = FMath::Min(
+                    Weight, static_cast<float>((Time - WindowStart).Value) /
+                                BlendTicks.Value);
+            }
+            if (bHasKeysAfter) {
+                Weight = FMath::Min(
+                    Weight, static_cast<float>((WindowEnd - Time).Value) /
+                                BlendTicks.Value);
+            }
+
+            Weight = FMath::Clamp(Weight, 0.0f, 1.0f);
+            if (Weight >= 1.0f) {
+                continue;
+            }
+
+            float OldValue = 0.0f;
+            if (Channel->Evaluate(FFrameTime(Time), OldValue)) {
+                Values[KeyIdx].Value =
+                    FMath::Lerp(OldValue, Values[KeyIdx].Value, Weight);
+            }
+        }
+    }
+
+    // 3. 删除窗口内的旧关键帧
+    int32 RemovedCount = RemoveKeysInRange(Channel, TickWindow);
+
+    // 4. 写入新关键帧
+    if (Times.Num() > 0) {
+        Channel->AddKeys(Times, Values);
+    }
+
+    return RemovedCount;
+}
+
 // ========== 轨道验证 ==========
 
 bool UInstrumentAnimationUtility::ValidateNoExistingTracks(
@@ -799,6 +1433,21 @@ void UInstrumentAnimationUtility::BatchInsertControlRigKeys(
     UE_LOG(LogTemp, Warning, TEXT("[COMMON] Total controls to process: %d"),
            ControlKeyframeData.Num());
 
+    // 局部重新生成：只替换窗口内的关键帧
+    const bool bUseFrameWindow = Settings.FrameWindow.IsSet();
+    TRange<FFrameNumber> TickWindow = TRange<FFrameNumber>::Empty();
+    FFrameNumber BlendTicks(0);
+    if (bUseFrameWindow) {
+        TickWindow =
+            Settings.FrameWindow.ToTickRange(TickResolution, DisplayRate);
+        BlendTicks =
+            Settings.FrameWindow.GetBlendTicks(TickResolution, DisplayRate);
+        UE_LOG(LogTemp, Warning,
+               TEXT("[COMMON] Frame window: [%d, %d], blend %d frames"),
+               Settings.FrameWindow.StartFrame, Settings.FrameWindow.EndFrame,
+               Settings.FrameWindow.BlendFrames);
+    }
+
     for (const auto& ControlPair : ControlKeyframeData) {
         const FString& ControlName = ControlPair.Key;
         const TArray<FAnimationKeyframe>& Keyframes = ControlPair.Value;
@@ -845,6 +1494,9 @@ void UInstrumentAnimationUtility::BatchInsertControlRigKeys(
                 (TickResolution.Denominator * DisplayRate.Numerator);
 
             FFrameNumber FrameNum(ScaledFrameNumber);
+            if (bUseFrameWindow && !TickWindow.Contains(FrameNum)) {
+                continue;
+            }
             Times.Add(FrameNum);
 
             if (FrameNum < MinFrame) {
@@ -890,7 +1542,23 @@ void UInstrumentAnimationUtility::BatchInsertControlRigKeys(
             }
         }
 
-        if (bIsSpecialControl && bOnlyInsertXAxis) {
+        if (bUseFrameWindow) {
+            ReplaceChannelKeysInWindow(LocationX, Times, LocationXValues,
+                                       TickWindow, BlendTicks);
+            if (!(bIsSpecialControl && bOnlyInsertXAxis)) {
+                ReplaceChannelKeysInWindow(LocationY, Times, LocationYValues,
+                                           TickWindow, BlendTicks);
+                ReplaceChannelKeysInWindow(LocationZ, Times, LocationZValues,
+                                           TickWindow, BlendTicks);
+
+                ReplaceChannelKeysInWindow(RotationX, Times, RotationXValues,
+                                           TickWindow, BlendTicks, true);
+                ReplaceChannelKeysInWindow(RotationY, Times, RotationYValues,
+                                           TickWindow, BlendTicks, true);
+                ReplaceChannelKeysInWindow(RotationZ, Times, RotationZValues,
+                                           TickWindow, BlendTicks, true);
+            }
+        } else if (bIsSpecialControl && bOnlyInsertXAxis) {
             LocationX->AddKeys(Times, LocationXValues);
             UE_LOG(
                 LogTemp, Warning,
@@ -912,7 +1580,16 @@ void UInstrumentAnimationUtility::BatchInsertControlRigKeys(
     }
 
     if (MinFrame != MAX_int32 && MaxFrame != MIN_int32 &&
-        MinFrame <= MaxFrame) {
+        MinFrame <= MaxFrame && bUseFrameWindow) {
+        // 窗口模式下只扩展Section范围，不裁掉窗口外保留的关键帧
+        Section->SetRange(TRange<FFrameNumber>::Hull(
+            Section->GetRange(),
+            TRange<FFrameNumber>(MinFrame, MaxFrame + Settings.FramePadding)));
+        UE_LOG(LogTemp, Warning,
+               TEXT("[COMMON] Expanded section range to include %d - %d"),
+               MinFrame.Value, (MaxFrame + Settings.FramePadding).Value);
+    } else if (MinFrame != MAX_int32 && MaxFrame != MIN_int32 &&
+               MinFrame <= MaxFrame) {
         Section->SetRange(
             TRange<FFrameNumber>(MinFrame, MaxFrame + Settings.FramePadding));
         UE_LOG(LogTemp, Warning, TEXT("[COMMON] Set section range to %d - %d"),
@@ -1200,3 +1877,168 @@ void UInstrumentAnimationUtility::ProcessControlsContainer(
         OutKeyframesAdded++;
     }
 }
+
+int32 UInstrumentAnimationUtility::ProcessFrameObject(
+    TSharedPtr<FJsonObject> FrameObject, int32 FrameIndex,
+    TMap<FString, TArray<FAnimationKeyframe>>& ControlKeyframeData,
+    const TSet<FString>& ValidControllerNames, int32& OutKeyframesAdded) {
+    if (!FrameObject.IsValid()) {
+        return INDEX_NONE;
+    }
+
+    // StringFlow 的控制器在 hand_infos 中，KeyRipple 的直接位于帧对象中
+    TSharedPtr<FJsonObject> ControlsContainer = FrameObject;
+    int32 FrameNumber = FrameIndex;
+    const TSharedPtr<FJsonObject>* HandInfos = nullptr;
+    if (FrameObject->TryGetObjectField(TEXT("hand_infos"), HandInfos)) {
+        ControlsContainer = *HandInfos;
+        FrameObject->TryGetNumberField(TEXT("frame"), FrameNumber);
+    }
+
+    ProcessControlsContainer(ControlsContainer, FrameNumber,
+                             ControlKeyframeData, ValidControllerNames,
+                             OutKeyframesAdded);
+    return FrameNumber;
+}
+
+// ========== 分段子序列作用域 ==========
+
+int32 FScopedTakeSequenceGeneration::NumActiveScopes = 0;
+
+FScopedTakeSequenceGeneration::FScopedTakeSequenceGeneration(
+    bool bEnabled, ASkeletalMeshActor* BoundActor, const FString& TakeSuffix) {
+    if (!bEnabled || !BoundActor) {
+        return;
+    }
+
+    ULevelSequence* FocusedSequence = nullptr;
+    if (!UInstrumentAnimationUtility::GetActiveLevelSequenceAndSequencer(
+            FocusedSequence, Sequencer)) {
+        return;
+    }
+
+    // 始终以根序列作为主序列；用户原来的聚焦在析构（或失败）时还原
+    SaveOriginalFocus();
+    Sequencer->PopToSequenceInstance(MovieSceneSequenceID::Root);
+    bFocusChanged = true;
+
+    ULevelSequence* MasterSequence =
+        Cast<ULevelSequence>(Sequencer->GetRootMovieSceneSequence());
+    if (!MasterSequence) {
+        UE_LOG(LogTemp, Error,
+               TEXT("[InstrumentAnimationUtility] Root sequence is not a "
+                    "Level Sequence, writing to master sequence"));
+        RestoreOriginalFocus();
+        return;
+    }
+
+    const FString TakeName = FString::Printf(
+        TEXT("%s_%s"), *BoundActor->GetActorLabel(), *TakeSuffix);
+
+    UMovieSceneSubSection* TakeSubSection = nullptr;
+    ULevelSequence* Take = UInstrumentAnimationUtility::GetOrCreateTakeSequence(
+        MasterSequence, TakeName, TakeSubSection);
+    if (!Take || !TakeSubSection) {
+        UE_LOG(LogTemp, Error,
+               TEXT("[InstrumentAnimationUtility] Failed to prepare take '%s', "
+                    "writing to master sequence"),
+               *TakeName);
+        RestoreOriginalFocus();
+        return;
+    }
+
+    // 首次使用时把主序列中已有的绑定（Control Rig轨道、材质轨道）迁移到子序列
+    UInstrumentAnimationUtility::MoveActorBindingsToSequence(
+        Sequencer, MasterSequence, Take, BoundActor);
+
+    Sequencer->FocusSequenceInstance(*TakeSubSection);
+    if (Sequencer->GetFocusedMovieSceneSequence() != Take) {
+        UE_LOG(LogTemp, Error,
+               TEXT("[InstrumentAnimationUtility] Failed to focus take '%s'"),
+               *TakeName);
+        RestoreOriginalFocus();
+        return;
+    }
+
+    TakeSequence = Take;
+    SubSection = TakeSubSection;
+    bActive = true;
+    ++NumActiveScopes;
+
+    UE_LOG(LogTemp, Log,
+           TEXT("[InstrumentAnimationUtility] Writing to take sequence: %s"),
+           *Take->GetPathName());
+}
+
+FScopedTakeSequenceGeneration::~FScopedTakeSequenceGeneration() {
+    if (!bActive) {
+        return;
+    }
+
+    --NumActiveScopes;
+    UInstrumentAnimationUtility::UpdateTakeSubSectionRange(SubSection.Get());
+
+    if (Sequencer.IsValid()) {
+        RestoreOriginalFocus();
+        Sequencer->NotifyMovieSceneDataChanged(
+            EMovieSceneDataChangeType::MovieSceneStructureItemsChanged);
+    }
+}
+
+void FScopedTakeSequenceGeneration::SaveOriginalFocus() {
+    OriginalFocusPath.Reset();
+
+    FMovieSceneSequenceID SequenceID = Sequencer->GetFocusedTemplateID();
+    if (SequenceID == MovieSceneSequenceID::Root) {
+        return;
+    }
+
+    FMovieSceneRootEvaluationTemplateInstance& Template =
+        Sequencer->GetEvaluationTemplate();
+    const FMovieSceneSequenceHierarchy* Hierarchy =
+        Template.GetCompiledDataManager()->FindHierarchy(
+            Template.GetCompiledDataID());
+    if (!Hierarchy) {
+        return;
+    }
+
+    // 从聚焦的子序列沿父节点回到根序列，路径按从根向下的顺序保存
+    while (SequenceID != MovieSceneSequenceID::Root) {
+        UMovieSceneSubSection* FocusedSubSection =
+            Hierarchy->FindSubSection(SequenceID);
+        const FMovieSceneSequenceHierarchyNode* Node =
+            Hierarchy->FindNode(SequenceID);
+        if (!FocusedSubSection || !Node) {
+            UE_LOG(LogTemp, Warning,
+                   TEXT("[InstrumentAnimationUtility] Could not resolve the "
+                        "focused sub-sequence, focus will return to the "
+                        "root sequence"));
+            OriginalFocusPath.Reset();
+            return;
+        }
+        OriginalFocusPath.Insert(FocusedSubSection, 0);
+        SequenceID = Node->ParentID;
+    }
+}
+
+void FScopedTakeSequenceGeneration::RestoreOriginalFocus() {
+    if (!bFocusChanged || !Sequencer.IsValid()) {
+        return;
+    }
+    bFocusChanged = false;
+
+    // 用户原本就聚焦在这个子序列上时保持不动
+    if (bActive && OriginalFocusPath.Num() == 1 &&
+        OriginalFocusPath[0] == SubSection) {
+        return;
+    }
+
+    Sequencer->PopToSequenceInstance(MovieSceneSequenceID::Root);
+    for (const TWeakObjectPtr<UMovieSceneSubSection>& PathSection :
+         OriginalFocusPath) {
+        if (!PathSection.IsValid()) {
+            break;
+        }
+        Sequencer->FocusSequenceInstance(*PathSection.Get());
+    }
+}
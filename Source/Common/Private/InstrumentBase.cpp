@@ -1,5 +1,7 @@
 #include "InstrumentBase.h"
 
+#include "InstrumentSyncSubsystem.h"
+
 AInstrumentBase::AInstrumentBase()
 {
     PrimaryActorTick.bCanEverTick = true;
@@ -13,4 +15,43 @@ void AInstrumentBase::BeginPlay()
 void AInstrumentBase::Tick(float DeltaTime)
 {
     AActor::Tick(DeltaTime);
+}
+
+void AInstrumentBase::PostRegisterAllComponents()
+{
+    Super::PostRegisterAllComponents();
+
+    if (HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+    {
+        return;
+    }
+
+    if (UInstrumentSyncSubsystem* SyncSubsystem = UInstrumentSyncSubsystem::Get(GetWorld()))
+    {
+        SyncSubsystem->RegisterInstrument(this);
+    }
+}
+
+void AInstrumentBase::PostUnregisterAllComponents()
+{
+    if (UInstrumentSyncSubsystem* SyncSubsystem = UInstrumentSyncSubsystem::Get(GetWorld()))
+    {
+        SyncSubsystem->UnregisterInstrument(this);
+    }
+
+    Super::PostUnregisterAllComponents();
+}
+
+void AInstrumentBase::GetPlaybackActors(TArray<FInstrumentPlaybackActor>& OutActors) const
+{
+    if (SkeletalMeshActor)
+    {
+        OutActors.Add({TEXT("Performer"), SkeletalMeshActor, TEXT("Performer")});
+    }
+}
+
+void AInstrumentBase::SyncRealtimeNow()
+{
+    AInstrumentBase* const Instrument = this;
+    UInstrumentSyncSubsystem::SyncInstruments(MakeArrayView(&Instrument, 1));
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 ﻿#include "InstrumentControlRigUtility.h"
 
 #include "Animation/SkeletalMeshActor.h"
+#include "Common/Public/InstrumentAnimationUtility.h"
 #include "ControlRig.h"
 #include "ControlRigBlueprintLegacy.h"
 #include "ControlRigSequencerEditorLibrary.h"
@@ -41,14 +42,10 @@ bool FInstrumentControlRigUtility::GetControlRigFromSkeletalMeshActor(
         }
 
         for (const TSharedPtr<ISequencer>& Sequencer : OpenSequencers) {
-            UMovieSceneSequence* RootSequence =
-                Sequencer->GetRootMovieSceneSequence();
+            LevelSequence =
+                UInstrumentAnimationUtility::GetGenerationTargetSequence(
+                    *Sequencer);
 
-            if (!RootSequence) {
-                continue;
-            }
-
-            LevelSequence = Cast<ULevelSequence>(RootSequence);
             if (LevelSequence) {
                 break;
             }
@@ -156,6 +153,36 @@ bool FInstrumentControlRigUtility::GetControlRigFromSkeletalMeshActor(
     return false;
 }
 
+void FInstrumentControlRigUtility::CollectControlRigBindings(
+    ULevelSequence* LevelSequence, ISequencer& Sequencer,
+    TMap<const ASkeletalMeshActor*, UControlRig*>& OutControlRigs) {
+    if (!LevelSequence) {
+        return;
+    }
+
+    TArray<FControlRigSequencerBindingProxy> RigBindings =
+        UControlRigSequencerEditorLibrary::GetControlRigs(LevelSequence);
+
+    for (const FControlRigSequencerBindingProxy& Proxy : RigBindings) {
+        UControlRig* ControlRigInstance = Proxy.ControlRig;
+        const FGuid BindingID = Proxy.Proxy.BindingID;
+        if (!ControlRigInstance || !BindingID.IsValid()) {
+            continue;
+        }
+
+        TArrayView<TWeakObjectPtr<UObject>> WeakBoundObjects =
+            Sequencer.FindBoundObjects(BindingID,
+                                       Sequencer.GetFocusedTemplateID());
+        for (const TWeakObjectPtr<UObject>& WeakObj : WeakBoundObjects) {
+            const ASkeletalMeshActor* BoundActor =
+                Cast<ASkeletalMeshActor>(WeakObj.Get());
+            if (BoundActor && !OutControlRigs.Contains(BoundActor)) {
+                OutControlRigs.Add(BoundActor, ControlRigInstance);
+            }
+        }
+    }
+}
+
 bool FInstrumentControlRigUtility::GetControlRigControlWorldTransform(
     ASkeletalMeshActor* InSkeletalMeshActor, const FString& ControlName,
     FTransform& OutTransform) {
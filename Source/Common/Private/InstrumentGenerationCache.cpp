@@ -0,0 +1,664 @@
+﻿#include "InstrumentGenerationCache.h"
+
+#include "Animation/SkeletalMeshActor.h"
+#include "Channels/MovieSceneChannelProxy.h"
+#include "Channels/MovieSceneFloatChannel.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "ControlRig.h"
+#include "Editor.h"
+#include "Editor/Transactor.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "InstrumentControlRigUtility.h"
+#include "LevelSequence.h"
+#include "Materials/MaterialInterface.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "MovieSceneSection.h"
+#include "ScopedTransaction.h"
+#include "Sequencer/ControlRigSequencerHelpers.h"
+#include "Sequencer/MovieSceneControlRigParameterTrack.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Tracks/MovieSceneMaterialTrack.h"
+
+namespace InstrumentGenerationCacheHelper {
+/** 缓存文件标识与版本，格式变化时递增版本使旧缓存失效 */
+static constexpr uint32 PayloadMagic = 0x4D444743;  // "MDGC"
+static constexpr int32 PayloadVersion = 2;
+
+static FString GetPayloadPath(const FString& Fingerprint) {
+    return FInstrumentGenerationCache::GetCacheDirectory() /
+           (Fingerprint + TEXT(".bin"));
+}
+
+static FString GetUndoRecordPath(const FString& RecordName) {
+    return FInstrumentGenerationCache::GetUndoRecordDirectory() /
+           (FPaths::MakeValidFileName(RecordName) + TEXT(".bin"));
+}
+
+/** 编辑器事务缓冲区当前占用的字节数 */
+static SIZE_T GetTransactionBufferSize() {
+    return (GEditor && GEditor->Trans) ? GEditor->Trans->GetUndoSize() : 0;
+}
+
+/** 通道名称格式为 "<控制器名>.<属性>"，取第一个点之前的部分 */
+static bool IsChannelOfControls(const FString& ChannelName,
+                                const TSet<FString>& ControlNames) {
+    if (ControlNames.Num() == 0) {
+        return true;
+    }
+
+    FString ControlName = ChannelName;
+    int32 DotIndex = INDEX_NONE;
+    if (ChannelName.FindChar(TCHAR('.'), DotIndex)) {
+        ControlName = ChannelName.Left(DotIndex);
+    }
+    return ControlNames.Contains(ControlName);
+}
+}  // namespace InstrumentGenerationCacheHelper
+
+// ========== 生成结果指纹 ==========
+
+void FGenerationFingerprint::AddFile(const FString& FilePath) {
+    AddString(FilePath);
+
+    FMD5Hash FileHash = FMD5Hash::HashFile(*FilePath);
+    AddString(FileHash.IsValid() ? LexToString(FileHash) : TEXT("missing"));
+}
+
+void FGenerationFingerprint::AddString(const FString& Value) {
+    FMemoryWriter Writer(Buffer, false, true);
+    Writer.Seek(Buffer.Num());
+    FString Copy = Value;
+    Writer << Copy;
+}
+
+void FGenerationFingerprint::AddInt(int64 Value) {
+    FMemoryWriter Writer(Buffer, false, true);
+    Writer.Seek(Buffer.Num());
+    Writer << Value;
+}
+
+void FGenerationFingerprint::AddFrameRate(const FFrameRate& FrameRate) {
+    AddInt(FrameRate.Numerator);
+    AddInt(FrameRate.Denominator);
+}
+
+void FGenerationFingerprint::AddSettings(
+    const FBatchInsertKeyframesSettings& Settings) {
+    AddInt(Settings.FramePadding);
+    AddInt(Settings.bUnwrapRotationInterpolation ? 1 : 0);
+    AddInt(Settings.FrameWindow.StartFrame);
+    AddInt(Settings.FrameWindow.EndFrame);
+    AddInt(Settings.FrameWindow.BlendFrames);
+
+    // TMap遍历顺序不稳定，先排序
+    TArray<FString> RuleKeys;
+    Settings.SpecialControllerRules.GetKeys(RuleKeys);
+    RuleKeys.Sort();
+    for (const FString& RuleKey : RuleKeys) {
+        AddString(RuleKey);
+        AddInt(Settings.SpecialControllerRules[RuleKey] ? 1 : 0);
+    }
+}
+
+void FGenerationFingerprint::AddControlRigHierarchy(UControlRig* ControlRig) {
+    URigHierarchy* Hierarchy = ControlRig ? ControlRig->GetHierarchy() : nullptr;
+    if (!Hierarchy) {
+        AddString(TEXT("NoHierarchy"));
+        return;
+    }
+
+    const TArray<FRigElementKey> AllKeys = Hierarchy->GetAllKeys();
+    AddInt(AllKeys.Num());
+
+    for (const FRigElementKey& Key : AllKeys) {
+        AddString(Key.Name.ToString());
+        AddInt(static_cast<int64>(Key.Type));
+
+        // 位置精确到0.001，旋转精确到四元数分量0.0001，避免浮点噪声影响指纹
+        const FTransform Initial = Hierarchy->GetInitialGlobalTransform(Key);
+        const FVector Location = Initial.GetLocation();
+        const FQuat Rotation = Initial.GetRotation();
+        AddInt(FMath::RoundToInt64(Location.X * 1000.0));
+        AddInt(FMath::RoundToInt64(Location.Y * 1000.0));
+        AddInt(FMath::RoundToInt64(Location.Z * 1000.0));
+        AddInt(FMath::RoundToInt64(Rotation.X * 10000.0));
+        AddInt(FMath::RoundToInt64(Rotation.Y * 10000.0));
+        AddInt(FMath::RoundToInt64(Rotation.Z * 10000.0));
+        AddInt(FMath::RoundToInt64(Rotation.W * 10000.0));
+    }
+}
+
+void FGenerationFingerprint::AddMaterialSlots(
+    USkeletalMeshComponent* MeshComponent) {
+    if (!MeshComponent) {
+        AddString(TEXT("NoMesh"));
+        return;
+    }
+
+    const TArray<FName> SlotNames = MeshComponent->GetMaterialSlotNames();
+    AddInt(SlotNames.Num());
+    for (int32 SlotIndex = 0; SlotIndex < SlotNames.Num(); ++SlotIndex) {
+        UMaterialInterface* Material = MeshComponent->GetMaterial(SlotIndex);
+        AddString(SlotNames[SlotIndex].ToString());
+        AddString(Material ? Material->GetPathName() : TEXT("None"));
+    }
+}
+
+FString FGenerationFingerprint::ToString() const {
+    return FMD5::HashBytes(Buffer.GetData(), Buffer.Num());
+}
+
+// ========== 生成结果缓存 ==========
+
+FString FInstrumentGenerationCache::GetCacheDirectory() {
+    return FPaths::ProjectSavedDir() / TEXT("MusicDoll") /
+           TEXT("DerivedDataCache");
+}
+
+bool FInstrumentGenerationCache::StoreSectionChannels(
+    const FString& Fingerprint, UMovieSceneSection* Section,
+    const TSet<FString>& ControlNames) {
+    if (!Section) {
+        return false;
+    }
+    return StoreSectionChannels(
+        Fingerprint, TArray<UMovieSceneSection*>{Section}, ControlNames);
+}
+
+bool FInstrumentGenerationCache::StoreSectionChannels(
+    const FString& Fingerprint, const TArray<UMovieSceneSection*>& Sections,
+    const TSet<FString>& ControlNames) {
+    if (Fingerprint.IsEmpty() || Sections.Num() == 0) {
+        return false;
+    }
+
+    const FString PayloadPath =
+        InstrumentGenerationCacheHelper::GetPayloadPath(Fingerprint);
+    if (!WriteSectionChannels(PayloadPath, Sections, ControlNames)) {
+        return false;
+    }
+
+    TrimCacheDirectory(PayloadPath);
+    return true;
+}
+
+bool FInstrumentGenerationCache::WriteSectionChannels(
+    const FString& PayloadPath, const TArray<UMovieSceneSection*>& Sections,
+    const TSet<FString>& ControlNames) {
+    if (Sections.Num() == 0 || Sections.Contains(nullptr)) {
+        return false;
+    }
+
+    TArray<uint8> Payload;
+    FMemoryWriter Writer(Payload, true);
+
+    uint32 Magic = InstrumentGenerationCacheHelper::PayloadMagic;
+    int32 Version = InstrumentGenerationCacheHelper::PayloadVersion;
+    int32 SectionCount = Sections.Num();
+    Writer << Magic;
+    Writer << Version;
+    Writer << SectionCount;
+
+    int32 TotalChannels = 0;
+    for (UMovieSceneSection* Section : Sections) {
+        TRange<FFrameNumber> SectionRange = Section->GetRange();
+        Writer << SectionRange;
+
+        FMovieSceneChannelProxy& ChannelProxy = Section->GetChannelProxy();
+        TArrayView<FMovieSceneFloatChannel*> Channels =
+            ChannelProxy.GetChannels<FMovieSceneFloatChannel>();
+        TArrayView<const FMovieSceneChannelMetaData> MetaData =
+            ChannelProxy.GetMetaData<FMovieSceneFloatChannel>();
+
+        // 先统计要保存的通道，再写入数量
+        TArray<int32> ChannelIndices;
+        for (int32 Index = 0; Index < Channels.Num() && Index < MetaData.Num();
+             ++Index) {
+            if (Channels[Index] &&
+                InstrumentGenerationCacheHelper::IsChannelOfControls(
+                    MetaData[Index].Name.ToString(), ControlNames)) {
+                ChannelIndices.Add(Index);
+            }
+        }
+
+        int32 ChannelCount = ChannelIndices.Num();
+        Writer << ChannelCount;
+        TotalChannels += ChannelCount;
+
+        for (int32 Index : ChannelIndices) {
+            FString ChannelName = MetaData[Index].Name.ToString();
+            TArray<FFrameNumber> Times(Channels[Index]->GetTimes());
+            TArray<FMovieSceneFloatValue> Values(Channels[Index]->GetValues());
+            Writer << ChannelName;
+            Writer << Times;
+            Writer << Values;
+        }
+    }
+
+    if (!FFileHelper::SaveArrayToFile(Payload, *PayloadPath)) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("[InstrumentGenerationCache] Failed to write cache: %s"),
+               *PayloadPath);
+        return false;
+    }
+
+    UE_LOG(LogTemp, Log,
+           TEXT("[InstrumentGenerationCache] Stored %d channels in %d "
+                "sections (%d bytes) to %s"),
+           TotalChannels, SectionCount, Payload.Num(), *PayloadPath);
+    return true;
+}
+
+int32 FInstrumentGenerationCache::TrimCacheDirectory(const FString& KeepPath) {
+    struct FCacheEntry {
+        FString Path;
+        FDateTime LastUsed;
+        int64 Size = 0;
+    };
+
+    IFileManager& FileManager = IFileManager::Get();
+    TArray<FCacheEntry> Entries;
+    int64 TotalBytes = 0;
+    FileManager.IterateDirectoryStat(
+        *GetCacheDirectory(),
+        [&Entries, &TotalBytes](const TCHAR* Path,
+                                const FFileStatData& StatData) {
+            if (!StatData.bIsDirectory &&
+                FPaths::GetExtension(Path) == TEXT("bin")) {
+                Entries.Add({Path, StatData.ModificationTime,
+                             StatData.FileSize});
+                TotalBytes += StatData.FileSize;
+            }
+            return true;
+        });
+
+    // 最久未使用的排在前面
+    Entries.Sort([](const FCacheEntry& A, const FCacheEntry& B) {
+        return A.LastUsed < B.LastUsed;
+    });
+
+    const FDateTime OldestAllowed =
+        FDateTime::UtcNow() - FTimespan::FromDays(MaxCacheAgeDays);
+    int32 NumDeleted = 0;
+    for (const FCacheEntry& Entry : Entries) {
+        const bool bTooOld = Entry.LastUsed < OldestAllowed;
+        if (!bTooOld && TotalBytes <= MaxCacheBytes) {
+            break;
+        }
+        if (Entry.Path == KeepPath) {
+            continue;
+        }
+        if (FileManager.Delete(*Entry.Path, false, false, true)) {
+            TotalBytes -= Entry.Size;
+            ++NumDeleted;
+        }
+    }
+
+    if (NumDeleted > 0) {
+        UE_LOG(LogTemp, Log,
+               TEXT("[InstrumentGenerationCache] Evicted %d cache files, "
+                    "%.2f MB remaining"),
+               NumDeleted, TotalBytes / (1024.0 * 1024.0));
+    }
+    return NumDeleted;
+}
+
+bool FInstrumentGenerationCache::RestoreSectionChannels(
+    const FString& Fingerprint, UMovieSceneSection* Section) {
+    if (!Section) {
+        return false;
+    }
+    return RestoreSectionChannels(Fingerprint,
+                                  TArray<UMovieSceneSection*>{Section});
+}
+
+bool FInstrumentGenerationCache::RestoreSectionChannels(
+    const FString& Fingerprint, const TArray<UMovieSceneSection*>& Sections) {
+    if (Fingerprint.IsEmpty() || Sections.Num() == 0) {
+        return false;
+    }
+
+    const FString PayloadPath =
+        InstrumentGenerationCacheHelper::GetPayloadPath(Fingerprint);
+    if (!ReadSectionChannels(PayloadPath, Sections)) {
+        return false;
+    }
+
+    // 刷新时间戳，作为最近使用时间参与淘汰
+    IFileManager::Get().SetTimeStamp(*PayloadPath, FDateTime::UtcNow());
+    return true;
+}
+
+bool FInstrumentGenerationCache::ReadSectionChannels(
+    const FString& PayloadPath, const TArray<UMovieSceneSection*>& Sections) {
+    if (Sections.Num() == 0 || Sections.Contains(nullptr) ||
+        !IFileManager::Get().FileExists(*PayloadPath)) {
+        return false;
+    }
+
+    TArray<uint8> Payload;
+    if (!FFileHelper::LoadFileToArray(Payload, *PayloadPath)) {
+        return false;
+    }
+
+    FMemoryReader Reader(Payload, true);
+
+    uint32 Magic = 0;
+    int32 Version = 0;
+    int32 SectionCount = 0;
+    Reader << Magic;
+    Reader << Version;
+    if (Magic != InstrumentGenerationCacheHelper::PayloadMagic ||
+        Version != InstrumentGenerationCacheHelper::PayloadVersion) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("[InstrumentGenerationCache] Ignoring stale cache: %s"),
+               *PayloadPath);
+        return false;
+    }
+
+    Reader << SectionCount;
+    if (SectionCount != Sections.Num()) {
+        // Section数量不同说明轨道结构已变化，视为未命中
+        UE_LOG(LogTemp, Warning,
+               TEXT("[InstrumentGenerationCache] Cache has %d sections, "
+                    "expected %d, cache miss"),
+               SectionCount, Sections.Num());
+        return false;
+    }
+
+    struct FSectionPayload {
+        TRange<FFrameNumber> Range;
+        TArray<FMovieSceneFloatChannel*> Channels;
+        TArray<TArray<FFrameNumber>> Times;
+        TArray<TArray<FMovieSceneFloatValue>> Values;
+    };
+
+    // 先完整读取并校验所有Section，避免写入一半时失败
+    TArray<FSectionPayload> SectionPayloads;
+    SectionPayloads.SetNum(SectionCount);
+    int32 TotalChannels = 0;
+    for (int32 SectionIndex = 0; SectionIndex < SectionCount; ++SectionIndex) {
+        FSectionPayload& SectionPayload = SectionPayloads[SectionIndex];
+        int32 ChannelCount = 0;
+        Reader << SectionPayload.Range;
+        Reader << ChannelCount;
+        if (Reader.IsError() || ChannelCount < 0) {
+            break;
+        }
+
+        TArray<FString> ChannelNames;
+        ChannelNames.SetNum(ChannelCount);
+        SectionPayload.Times.SetNum(ChannelCount);
+        SectionPayload.Values.SetNum(ChannelCount);
+        for (int32 Index = 0; Index < ChannelCount && !Reader.IsError();
+             ++Index) {
+            Reader << ChannelNames[Index];
+            Reader << SectionPayload.Times[Index];
+            Reader << SectionPayload.Values[Index];
+        }
+        if (Reader.IsError()) {
+            break;
+        }
+
+        FMovieSceneChannelProxy& ChannelProxy =
+            Sections[SectionIndex]->GetChannelProxy();
+        SectionPayload.Channels.Reserve(ChannelCount);
+        for (const FString& ChannelName : ChannelNames) {
+            FMovieSceneFloatChannel* Channel =
+                ChannelProxy
+                    .GetChannelByName<FMovieSceneFloatChannel>(
+                        FName(*ChannelName))
+                    .Get();
+            if (!Channel) {
+                // 通道不存在说明Rig或材质参数已变化，视为未命中
+                UE_LOG(LogTemp, Warning,
+                       TEXT("[InstrumentGenerationCache] Channel '%s' not "
+                            "found, cache miss"),
+                       *ChannelName);
+                return false;
+            }
+            SectionPayload.Channels.Add(Channel);
+        }
+        TotalChannels += ChannelCount;
+    }
+
+    if (Reader.IsError()) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("[InstrumentGenerationCache] Corrupted cache: %s"),
+               *PayloadPath);
+        return false;
+    }
+
+    for (int32 SectionIndex = 0; SectionIndex < SectionCount; ++SectionIndex) {
+        UMovieSceneSection* Section = Sections[SectionIndex];
+        const FSectionPayload& SectionPayload = SectionPayloads[SectionIndex];
+        Section->Modify();
+        for (int32 Index = 0; Index < SectionPayload.Channels.Num(); ++Index) {
+            SectionPayload.Channels[Index]->Set(SectionPayload.Times[Index],
+                                                SectionPayload.Values[Index]);
+        }
+        Section->SetRange(SectionPayload.Range);
+    }
+
+    UE_LOG(LogTemp, Log,
+           TEXT("[InstrumentGenerationCache] Restored %d channels in %d "
+                "sections from %s"),
+           TotalChannels, SectionCount, *PayloadPath);
+    return true;
+}
+
+bool FInstrumentGenerationCache::CollectInstrumentSections(
+    ASkeletalMeshActor* Instrument, bool bIncludeMaterialTracks,
+    TArray<UMovieSceneSection*>& OutSections) {
+    OutSections.Reset();
+
+    UControlRig* ControlRigInstance = nullptr;
+    UControlRigBlueprint* ControlRigBlueprint = nullptr;
+    if (!FInstrumentControlRigUtility::GetControlRigFromSkeletalMeshActor(
+            Instrument, ControlRigInstance, ControlRigBlueprint)) {
+        return false;
+    }
+
+    ULevelSequence* LevelSequence = nullptr;
+    TSharedPtr<ISequencer> Sequencer = nullptr;
+    if (!UInstrumentAnimationUtility::GetActiveLevelSequenceAndSequencer(
+            LevelSequence, Sequencer)) {
+        return false;
+    }
+
+    UMovieSceneSection* ControlRigSection =
+        FindControlRigSection(LevelSequence, ControlRigInstance);
+    if (!ControlRigSection) {
+        return false;
+    }
+    OutSections.Add(ControlRigSection);
+
+    if (!bIncludeMaterialTracks) {
+        return true;
+    }
+
+    // 只查找现有绑定，不存在时说明还没有生成过材质轨道
+    const FGuid BindingID = Sequencer->GetHandleToObject(
+        Instrument->GetSkeletalMeshComponent(), false);
+    if (!BindingID.IsValid()) {
+        return true;
+    }
+
+    TArray<UMovieSceneComponentMaterialTrack*> MaterialTracks;
+    for (UMovieSceneTrack* Track : LevelSequence->GetMovieScene()->FindTracks(
+             UMovieSceneComponentMaterialTrack::StaticClass(), BindingID)) {
+        UMovieSceneComponentMaterialTrack* MaterialTrack =
+            Cast<UMovieSceneComponentMaterialTrack>(Track);
+        if (MaterialTrack && MaterialTrack->GetAllSections().Num() > 0) {
+            MaterialTracks.Add(MaterialTrack);
+        }
+    }
+
+    MaterialTracks.Sort([](const UMovieSceneComponentMaterialTrack& A,
+                           const UMovieSceneComponentMaterialTrack& B) {
+        return A.GetMaterialInfo().MaterialSlotIndex <
+               B.GetMaterialInfo().MaterialSlotIndex;
+    });
+    for (UMovieSceneComponentMaterialTrack* MaterialTrack : MaterialTracks) {
+        OutSections.Add(MaterialTrack->GetAllSections()[0]);
+    }
+    return true;
+}
+
+bool FInstrumentGenerationCache::StoreInstrumentSections(
+    const FString& Fingerprint, ASkeletalMeshActor* Instrument,
+    bool bIncludeMaterialTracks) {
+    if (Fingerprint.IsEmpty()) {
+        return false;
+    }
+
+    TArray<UMovieSceneSection*> Sections;
+    if (!CollectInstrumentSections(Instrument, bIncludeMaterialTracks,
+                                   Sections)) {
+        return false;
+    }
+    return StoreSectionChannels(Fingerprint, Sections);
+}
+
+UMovieSceneSection* FInstrumentGenerationCache::FindControlRigSection(
+    ULevelSequence* LevelSequence, UControlRig* ControlRigInstance) {
+    if (!LevelSequence || !ControlRigInstance) {
+        return nullptr;
+    }
+
+    UMovieSceneControlRigParameterTrack* ControlRigTrack =
+        FControlRigSequencerHelpers::FindControlRigTrack(LevelSequence,
+                                                         ControlRigInstance);
+    if (!ControlRigTrack) {
+        return nullptr;
+    }
+
+    const TArray<UMovieSceneSection*>& Sections =
+        ControlRigTrack->GetAllSections();
+    return Sections.Num() > 0 ? Sections[0] : nullptr;
+}
+
+FString FInstrumentGenerationCache::GetUndoRecordDirectory() {
+    return FPaths::ProjectSavedDir() / TEXT("MusicDoll") / TEXT("UndoRecords");
+}
+
+bool FInstrumentGenerationCache::RestorePreviousGeneration(
+    ASkeletalMeshActor* SkeletalMeshActor, const FString& RecordName) {
+    UControlRig* ControlRigInstance = nullptr;
+    UControlRigBlueprint* ControlRigBlueprint = nullptr;
+    if (!FInstrumentControlRigUtility::GetControlRigFromSkeletalMeshActor(
+            SkeletalMeshActor, ControlRigInstance, ControlRigBlueprint)) {
+        return false;
+    }
+
+    ULevelSequence* LevelSequence = nullptr;
+    TSharedPtr<ISequencer> Sequencer = nullptr;
+    if (!UInstrumentAnimationUtility::GetActiveLevelSequenceAndSequencer(
+            LevelSequence, Sequencer)) {
+        return false;
+    }
+
+    UMovieSceneSection* Section =
+        FindControlRigSection(LevelSequence, ControlRigInstance);
+    if (!Section ||
+        !ReadSectionChannels(
+            InstrumentGenerationCacheHelper::GetUndoRecordPath(RecordName),
+            TArray<UMovieSceneSection*>{Section})) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("[InstrumentGenerationCache] No previous generation "
+                    "record for '%s'"),
+               *RecordName);
+        return false;
+    }
+
+    LevelSequence->MarkPackageDirty();
+    return true;
+}
+
+// ========== 生成撤销模式 ==========
+
+FScopedGenerationUndoMode::FScopedGenerationUndoMode(
+    EGenerationUndoMode InMode, const FString& InRecordName)
+    : Mode(InMode), RecordName(InRecordName) {
+    UndoSizeBefore = InstrumentGenerationCacheHelper::GetTransactionBufferSize();
+    UsedPhysicalBefore = FPlatformMemory::GetStats().UsedPhysical;
+
+    if (Mode != EGenerationUndoMode::Full &&
+        (GUndo || (GEditor && GEditor->IsTransactionActive()))) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("[InstrumentGenerationCache] A transaction is already "
+                    "active, '%s' falls back to Full undo mode"),
+               *RecordName);
+        Mode = EGenerationUndoMode::Full;
+    }
+
+    // 只有Full模式打开事务；Light/Disabled模式下GUndo为空，
+    // 作用域内的Modify()不会产生对象快照
+    if (Mode == EGenerationUndoMode::Full) {
+        Transaction = MakeUnique<FScopedTransaction>(FText::Format(
+            NSLOCTEXT("MusicDoll", "GenerateAnimation", "Generate {0}"),
+            FText::FromString(RecordName)));
+    }
+}
+
+FScopedGenerationUndoMode::~FScopedGenerationUndoMode() = default;
+
+void FScopedGenerationUndoMode::RecordPreviousSection(
+    UMovieSceneSection* Section, const TSet<FString>& ControlNames) {
+    if (Mode != EGenerationUndoMode::Light || !Section || bRecorded) {
+        return;
+    }
+
+    bRecorded = FInstrumentGenerationCache::WriteSectionChannels(
+        InstrumentGenerationCacheHelper::GetUndoRecordPath(RecordName),
+        TArray<UMovieSceneSection*>{Section}, ControlNames);
+}
+
+void FScopedGenerationUndoMode::RecordPreviousInstrumentSection(
+    ASkeletalMeshActor* Instrument) {
+    if (Mode != EGenerationUndoMode::Light || !Instrument || bRecorded) {
+        return;
+    }
+
+    UControlRig* ControlRigInstance = nullptr;
+    UControlRigBlueprint* ControlRigBlueprint = nullptr;
+    if (!FInstrumentControlRigUtility::GetControlRigFromSkeletalMeshActor(
+            Instrument, ControlRigInstance, ControlRigBlueprint)) {
+        return;
+    }
+
+    ULevelSequence* LevelSequence = nullptr;
+    TSharedPtr<ISequencer> Sequencer = nullptr;
+    if (!UInstrumentAnimationUtility::GetActiveLevelSequenceAndSequencer(
+            LevelSequence, Sequencer)) {
+        return;
+    }
+
+    // 乐器Section只包含琴键/琴弦曲线，保存全部浮点通道
+    RecordPreviousSection(FInstrumentGenerationCache::FindControlRigSection(
+                              LevelSequence, ControlRigInstance),
+                          TSet<FString>());
+}
+
+void FScopedGenerationUndoMode::LogMemoryReport() const {
+    const int64 UndoDelta =
+        static_cast<int64>(
+            InstrumentGenerationCacheHelper::GetTransactionBufferSize()) -
+        static_cast<int64>(UndoSizeBefore);
+    const int64 PhysicalDelta =
+        static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical) -
+        static_cast<int64>(UsedPhysicalBefore);
+
+    static const TCHAR* ModeNames[] = {TEXT("Full"), TEXT("Light"),
+                                       TEXT("Disabled")};
+    UE_LOG(LogTemp, Warning, TEXT("Undo mode: %s%s"),
+           ModeNames[static_cast<uint8>(Mode)],
+           bRecorded ? TEXT(" (previous section saved to disk)") : TEXT(""));
+    UE_LOG(LogTemp, Warning, TEXT("Transaction buffer change: %+.2f MB"),
+           UndoDelta / (1024.0 * 1024.0));
+    UE_LOG(LogTemp, Warning, TEXT("Process memory change: %+.2f MB"),
+           PhysicalDelta / (1024.0 * 1024.0));
+}
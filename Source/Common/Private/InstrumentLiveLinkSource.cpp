@@ -0,0 +1,402 @@
+﻿#include "InstrumentLiveLinkSource.h"
+
+#include "Dom/JsonObject.h"
+#include "Features/IModularFeatures.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/RunnableThread.h"
+#include "ILiveLinkClient.h"
+#include "ISequencer.h"
+#include "InstrumentAnimationUtility.h"
+#include "LevelSequence.h"
+#include "MovieScene.h"
+#include "Roles/LiveLinkAnimationRole.h"
+#include "Roles/LiveLinkAnimationTypes.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+#define LOCTEXT_NAMESPACE "InstrumentLiveLinkSource"
+
+namespace InstrumentLiveLinkHelper {
+/** 每个流缓冲的帧数，读取线程超前游戏线程太多时等待 */
+static constexpr uint32 FrameBufferCapacity = 256;
+
+/** 单次最多读取的字节数 */
+static constexpr int64 MaxReadChunkSize = 64 * 1024;
+
+/** 文件没有新内容时的轮询间隔（秒） */
+static constexpr float PollInterval = 0.02f;
+
+/** StartPreview 添加的源，按源名称索引（仅游戏线程访问） */
+static TMap<FString, FGuid>& GetPreviewSources() {
+    static TMap<FString, FGuid> PreviewSources;
+    return PreviewSources;
+}
+
+static ILiveLinkClient* GetLiveLinkClient() {
+    IModularFeatures& ModularFeatures = IModularFeatures::Get();
+    if (!ModularFeatures.IsModularFeatureAvailable(
+            ILiveLinkClient::ModularFeatureName)) {
+        return nullptr;
+    }
+    return &ModularFeatures.GetModularFeature<ILiveLinkClient>(
+        ILiveLinkClient::ModularFeatureName);
+}
+}  // namespace InstrumentLiveLinkHelper
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FInstrumentJsonObjectScanner
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FInstrumentJsonObjectScanner::Append(const uint8* Data, int32 Num) {
+    Buffer.Append(Data, Num);
+}
+
+bool FInstrumentJsonObjectScanner::PopObject(FString& OutJson) {
+    for (; ScanOffset < Buffer.Num(); ++ScanOffset) {
+        const uint8 Char = Buffer[ScanOffset];
+
+        if (bInString) {
+            if (bEscape) {
+                bEscape = false;
+            } else if (Char == '\\') {
+                bEscape = true;
+            } else if (Char == '"') {
+                bInString = false;
+            }
+            continue;
+        }
+
+        if (Char == '"') {
+            bInString = Depth > 0;
+        } else if (Char == '{') {
+            if (Depth++ == 0) {
+                ObjectStart = ScanOffset;
+            }
+        } else if (Char == '}' && Depth > 0 && --Depth == 0) {
+            const int32 ObjectEnd = ScanOffset + 1;
+            OutJson = FString(FUTF8ToTCHAR(
+                reinterpret_cast<const ANSICHAR*>(Buffer.GetData() +
+                                                  ObjectStart),
+                ObjectEnd - ObjectStart));
+
+            // 丢弃已取出的部分
+            Buffer.RemoveAt(0, ObjectEnd, EAllowShrinking::No);
+            ScanOffset = 0;
+            ObjectStart = INDEX_NONE;
+            return true;
+        }
+    }
+
+    // 对象之外的内容不需要保留
+    if (Depth == 0 && Buffer.Num() > 0) {
+        Buffer.Reset();
+        ScanOffset = 0;
+    }
+    return false;
+}
+
+void FInstrumentJsonObjectScanner::Reset() {
+    Buffer.Reset();
+    ScanOffset = 0;
+    ObjectStart = INDEX_NONE;
+    Depth = 0;
+    bInString = false;
+    bEscape = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FInstrumentLiveLinkSource
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FInstrumentLiveLinkSource::FInstrumentLiveLinkSource(
+    const FString& InSourceName, TArray<FInstrumentLiveLinkStream> InStreams,
+    FFrameRate InFrameRate)
+    : SourceName(InSourceName), FrameRate(InFrameRate) {
+    using namespace InstrumentLiveLinkHelper;
+
+    Streams.Reserve(InStreams.Num());
+    for (FInstrumentLiveLinkStream& Stream : InStreams) {
+        FStreamState& State = Streams.AddDefaulted_GetRef();
+        State.Stream = MoveTemp(Stream);
+        State.Frames = MakeUnique<
+            TInstrumentFrameRingBuffer<FInstrumentLiveLinkFrame>>(
+            FrameBufferCapacity);
+
+        // 手部旋转数据合并到 H_L / H_R 中，不单独作为骨骼
+        TArray<FString> ControllerNames = State.Stream.ControllerNames.Array();
+        ControllerNames.RemoveAll([](const FString& Name) {
+            return Name == TEXT("H_rotation_L") || Name == TEXT("H_rotation_R");
+        });
+        ControllerNames.Sort();
+
+        for (const FString& Name : ControllerNames) {
+            State.BoneIndices.Add(Name, State.BoneNames.Add(FName(*Name)));
+        }
+        State.LatestTransforms.Init(FTransform::Identity,
+                                    State.BoneNames.Num());
+
+        for (const FString& FilePath : State.Stream.FilePaths) {
+            State.Files.AddDefaulted_GetRef().FilePath = FilePath;
+        }
+    }
+}
+
+FInstrumentLiveLinkSource::~FInstrumentLiveLinkSource() {
+    RequestSourceShutdown();
+}
+
+bool FInstrumentLiveLinkSource::StartPreview(
+    const FString& SourceName, TArray<FInstrumentLiveLinkStream> Streams) {
+    using namespace InstrumentLiveLinkHelper;
+
+    ILiveLinkClient* LiveLinkClient = GetLiveLinkClient();
+    if (!LiveLinkClient) {
+        UE_LOG(LogTemp, Error,
+               TEXT("StartPreview: Live Link client is not available, please "
+                    "enable the Live Link plugin"));
+        return false;
+    }
+
+    if (Streams.Num() == 0) {
+        UE_LOG(LogTemp, Error, TEXT("StartPreview: No streams for '%s'"),
+               *SourceName);
+        return false;
+    }
+
+    // 帧号与生成动画时一样按 Level Sequence 的显示帧率解释
+    FFrameRate FrameRate(30, 1);
+    ULevelSequence* LevelSequence = nullptr;
+    TSharedPtr<ISequencer> Sequencer = nullptr;
+    if (UInstrumentAnimationUtility::GetActiveLevelSequenceAndSequencer(
+            LevelSequence, Sequencer) &&
+        LevelSequence->GetMovieScene()) {
+        FrameRate = LevelSequence->GetMovieScene()->GetDisplayRate();
+    } else {
+        UE_LOG(LogTemp, Warning,
+               TEXT("StartPreview: No active Level Sequence, assuming %s"),
+               *FrameRate.ToPrettyText().ToString());
+    }
+
+    StopPreview(SourceName);
+
+    const FGuid SourceGuid = LiveLinkClient->AddSource(
+        MakeShared<FInstrumentLiveLinkSource>(SourceName, MoveTemp(Streams),
+                                              FrameRate));
+    if (!SourceGuid.IsValid()) {
+        return false;
+    }
+
+    GetPreviewSources().Add(SourceName, SourceGuid);
+    UE_LOG(LogTemp, Log, TEXT("StartPreview: Live Link source '%s' added"),
+           *SourceName);
+    return true;
+}
+
+bool FInstrumentLiveLinkSource::StopPreview(const FString& SourceName) {
+    using namespace InstrumentLiveLinkHelper;
+
+    FGuid SourceGuid;
+    if (!GetPreviewSources().RemoveAndCopyValue(SourceName, SourceGuid)) {
+        return false;
+    }
+
+    if (ILiveLinkClient* LiveLinkClient = GetLiveLinkClient()) {
+        LiveLinkClient->RemoveSource(SourceGuid);
+    }
+    return true;
+}
+
+bool FInstrumentLiveLinkSource::ParseFrame(
+    const TSharedPtr<FJsonObject>& FrameObject, int32 FrameIndex,
+    const TSet<FString>& ControllerNames,
+    const TMap<FString, int32>& ControllerIndices,
+    FInstrumentLiveLinkFrame& OutFrame) {
+    // 与生成关键帧走同一个解析方法，得到的值与写入 Level Sequence 的一致
+    TMap<FString, TArray<FAnimationKeyframe>> ControlKeyframeData;
+    int32 KeyframesAdded = 0;
+    const int32 FrameNumber = UInstrumentAnimationUtility::ProcessFrameObject(
+        FrameObject, FrameIndex, ControlKeyframeData, ControllerNames,
+        KeyframesAdded);
+    if (FrameNumber == INDEX_NONE) {
+        return false;
+    }
+
+    OutFrame.FrameNumber = FrameNumber;
+    OutFrame.Controls.Reset(ControlKeyframeData.Num());
+    for (const auto& Pair : ControlKeyframeData) {
+        const int32* Index = ControllerIndices.Find(Pair.Key);
+        if (!Index || Pair.Value.Num() == 0) {
+            continue;
+        }
+
+        const FAnimationKeyframe& Keyframe = Pair.Value.Last();
+        OutFrame.Controls.Emplace(
+            *Index, FTransform(Keyframe.Rotation, Keyframe.Translation));
+    }
+    return true;
+}
+
+void FInstrumentLiveLinkSource::ReceiveClient(ILiveLinkClient* InClient,
+                                              FGuid InSourceGuid) {
+    Client = InClient;
+    SourceGuid = InSourceGuid;
+
+    for (FStreamState& State : Streams) {
+        State.SubjectKey =
+            FLiveLinkSubjectKey(SourceGuid, State.Stream.SubjectName);
+
+        FLiveLinkStaticDataStruct StaticData(
+            FLiveLinkSkeletonStaticData::StaticStruct());
+        FLiveLinkSkeletonStaticData* SkeletonData =
+            StaticData.Cast<FLiveLinkSkeletonStaticData>();
+        SkeletonData->SetBoneNames(State.BoneNames);
+
+        TArray<int32> BoneParents;
+        BoneParents.Init(INDEX_NONE, State.BoneNames.Num());
+        SkeletonData->SetBoneParents(BoneParents);
+
+        Client->PushSubjectStaticData_AnyThread(
+            State.SubjectKey, ULiveLinkAnimationRole::StaticClass(),
+            MoveTemp(StaticData));
+    }
+
+    ReaderThread.Reset(FRunnableThread::Create(
+        this, *FString::Printf(TEXT("InstrumentLiveLinkReader_%s"),
+                               *SourceName),
+        0, TPri_BelowNormal));
+}
+
+void FInstrumentLiveLinkSource::Update() {
+    if (!Client) {
+        return;
+    }
+
+    FInstrumentLiveLinkFrame Frame;
+    for (FStreamState& State : Streams) {
+        while (State.Frames->Pop(Frame)) {
+            for (const TPair<int32, FTransform>& Control : Frame.Controls) {
+                State.LatestTransforms[Control.Key] = Control.Value;
+            }
+
+            FLiveLinkFrameDataStruct FrameData(
+                FLiveLinkAnimationFrameData::StaticStruct());
+            FLiveLinkAnimationFrameData* AnimationData =
+                FrameData.Cast<FLiveLinkAnimationFrameData>();
+            AnimationData->Transforms = State.LatestTransforms;
+            AnimationData->WorldTime = FPlatformTime::Seconds();
+            AnimationData->MetaData.SceneTime =
+                FQualifiedFrameTime(FFrameTime(Frame.FrameNumber), FrameRate);
+
+            Client->PushSubjectFrameData_AnyThread(State.SubjectKey,
+                                                   MoveTemp(FrameData));
+        }
+    }
+}
+
+bool FInstrumentLiveLinkSource::IsSourceStillValid() const {
+    return ReaderThread.IsValid() && !bStopRequested.load();
+}
+
+bool FInstrumentLiveLinkSource::RequestSourceShutdown() {
+    bStopRequested = true;
+    if (ReaderThread) {
+        ReaderThread->WaitForCompletion();
+        ReaderThread.Reset();
+    }
+    Client = nullptr;
+    return true;
+}
+
+FText FInstrumentLiveLinkSource::GetSourceType() const {
+    return LOCTEXT("SourceType", "MusicDoll Performance");
+}
+
+FText FInstrumentLiveLinkSource::GetSourceMachineName() const {
+    return FText::FromString(SourceName);
+}
+
+FText FInstrumentLiveLinkSource::GetSourceStatus() const {
+    return FText::Format(LOCTEXT("SourceStatus", "{0} frames read"),
+                         FText::AsNumber(NumFramesRead.load()));
+}
+
+uint32 FInstrumentLiveLinkSource::Run() {
+    using namespace InstrumentLiveLinkHelper;
+
+    while (!bStopRequested) {
+        bool bReadAny = false;
+        for (FStreamState& State : Streams) {
+            for (FFileCursor& File : State.Files) {
+                bReadAny |= PollFile(State, File);
+            }
+        }
+
+        if (!bReadAny) {
+            FPlatformProcess::Sleep(PollInterval);
+        }
+    }
+    return 0;
+}
+
+void FInstrumentLiveLinkSource::Stop() { bStopRequested = true; }
+
+bool FInstrumentLiveLinkSource::PollFile(FStreamState& State,
+                                         FFileCursor& File) {
+    using namespace InstrumentLiveLinkHelper;
+
+    // 外部工具仍在写入，以允许写入的方式打开
+    TUniquePtr<IFileHandle> FileHandle(
+        FPlatformFileManager::Get().GetPlatformFile().OpenRead(
+            *File.FilePath, true));
+    if (!FileHandle) {
+        return false;
+    }
+
+    const int64 FileSize = FileHandle->Size();
+    if (FileSize < File.ReadOffset) {
+        // 文件被重新写入
+        File.ReadOffset = 0;
+        File.NumFramesParsed = 0;
+        File.Scanner.Reset();
+    }
+    if (FileSize == File.ReadOffset) {
+        return false;
+    }
+
+    TArray<uint8> Chunk;
+    Chunk.SetNumUninitialized(
+        static_cast<int32>(FMath::Min(FileSize - File.ReadOffset,
+                                      MaxReadChunkSize)));
+    if (!FileHandle->Seek(File.ReadOffset) ||
+        !FileHandle->Read(Chunk.GetData(), Chunk.Num())) {
+        return false;
+    }
+    File.ReadOffset += Chunk.Num();
+    File.Scanner.Append(Chunk.GetData(), Chunk.Num());
+
+    FString FrameJson;
+    while (File.Scanner.PopObject(FrameJson)) {
+        TSharedPtr<FJsonObject> FrameObject;
+        TSharedRef<TJsonReader<>> Reader =
+            TJsonReaderFactory<>::Create(FrameJson);
+        FInstrumentLiveLinkFrame Frame;
+        const int32 FrameIndex = File.NumFramesParsed++;
+        if (!FJsonSerializer::Deserialize(Reader, FrameObject) ||
+            !ParseFrame(FrameObject, FrameIndex, State.Stream.ControllerNames,
+                        State.BoneIndices, Frame)) {
+            continue;
+        }
+
+        // 缓冲区已满时等待游戏线程取走
+        while (!State.Frames->Push(MoveTemp(Frame))) {
+            if (bStopRequested) {
+                return true;
+            }
+            FPlatformProcess::Sleep(PollInterval);
+        }
+        ++NumFramesRead;
+    }
+    return true;
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -220,7 +220,8 @@ int32 UInstrumentMorphTargetUtility::AddAnimationChannels(
 bool UInstrumentMorphTargetUtility::ProcessMorphTargetKeyframeData(
     const TArray<TSharedPtr<FJsonValue>>& KeyDataArray,
     TArray<FMorphTargetKeyframeData>& OutKeyframeData,
-    FFrameRate TickResolution, FFrameRate DisplayRate) {
+    FFrameRate TickResolution, FFrameRate DisplayRate,
+    const FAnimationFrameWindow& FrameWindow) {
     OutKeyframeData.Empty();
 
     if (KeyDataArray.Num() == 0) {
@@ -266,6 +267,11 @@ bool UInstrumentMorphTargetUtility::ProcessMorphTargetKeyframeData(
                 float Value =
                     KeyframeObj->GetNumberField(TEXT("shape_key_value"));
 
+                // 局部重新生成：跳过窗口外的关键帧
+                if (!FrameWindow.Contains(FMath::FloorToInt32(Frame))) {
+                    continue;
+                }
+
                 // 转换帧数
                 float ScaledFrameNumberFloat =
                     Frame * TickResolution.Numerator * DisplayRate.Denominator /
@@ -320,7 +326,8 @@ bool UInstrumentMorphTargetUtility::ProcessMorphTargetKeyframeData(
 
 int32 UInstrumentMorphTargetUtility::WriteMorphTargetKeyframes(
     UMovieSceneSection* Section,
-    const TArray<FMorphTargetKeyframeData>& KeyframeData) {
+    const TArray<FMorphTargetKeyframeData>& KeyframeData,
+    const FAnimationFrameWindow& FrameWindow) {
     if (!Section) {
         UE_LOG(LogTemp, Error,
                TEXT("[InstrumentMorphTargetUtility] Section is null"));
@@ -336,6 +343,24 @@ int32 UInstrumentMorphTargetUtility::WriteMorphTargetKeyframes(
     FMovieSceneChannelProxy& ChannelProxy = Section->GetChannelProxy();
     int32 SuccessCount = 0;
 
+    // 局部重新生成：换算窗口到Tick单位
+    const bool bUseFrameWindow = FrameWindow.IsSet();
+    TRange<FFrameNumber> TickWindow = TRange<FFrameNumber>::Empty();
+    FFrameNumber BlendTicks(0);
+    if (bUseFrameWindow) {
+        UMovieScene* MovieScene = Section->GetTypedOuter<UMovieScene>();
+        if (!MovieScene) {
+            UE_LOG(LogTemp, Error,
+                   TEXT("[InstrumentMorphTargetUtility] Section has no "
+                        "MovieScene, cannot apply frame window"));
+            return 0;
+        }
+        TickWindow = FrameWindow.ToTickRange(MovieScene->GetTickResolution(),
+                                             MovieScene->GetDisplayRate());
+        BlendTicks = FrameWindow.GetBlendTicks(
+            MovieScene->GetTickResolution(), MovieScene->GetDisplayRate());
+    }
+
     for (const FMorphTargetKeyframeData& Data : KeyframeData) {
         if (Data.MorphTargetName.IsEmpty()) {
             UE_LOG(LogTemp, Warning,
@@ -353,7 +378,8 @@ int32 UInstrumentMorphTargetUtility::WriteMorphTargetKeyframes(
             continue;
         }
 
-        if (Data.FrameNumbers.Num() == 0) {
+        // 窗口模式下允许空数据：用于清除窗口内的旧关键帧
+        if (Data.FrameNumbers.Num() == 0 && !bUseFrameWindow) {
             UE_LOG(LogTemp, Warning,
                    TEXT("[InstrumentMorphTargetUtility] No keyframes to write "
                         "for '%s'"),
@@ -384,7 +410,13 @@ int32 UInstrumentMorphTargetUtility::WriteMorphTargetKeyframes(
         }
 
         // 批量写入关键帧
-        FloatChannel->AddKeys(Data.FrameNumbers, FloatValues);
+        if (bUseFrameWindow) {
+            UInstrumentAnimationUtility::ReplaceChannelKeysInWindow(
+                FloatChannel, Data.FrameNumbers, FloatValues, TickWindow,
+                BlendTicks);
+        } else {
+            FloatChannel->AddKeys(Data.FrameNumbers, FloatValues);
+        }
 
         SuccessCount++;
 
@@ -405,7 +437,8 @@ int32 UInstrumentMorphTargetUtility::WriteMorphTargetKeyframes(
 int32 UInstrumentMorphTargetUtility::WriteMorphTargetAnimationToControlRig(
     class ASkeletalMeshActor* Instrument,
     const TArray<FMorphTargetKeyframeData>& KeyframeData,
-    class ULevelSequence* LevelSequence, const FString& RootControlName) {
+    class ULevelSequence* LevelSequence, const FString& RootControlName,
+    const FAnimationFrameWindow& FrameWindow) {
     if (!Instrument) {
         UE_LOG(LogTemp, Error,
                TEXT("[InstrumentMorphTargetUtility] Instrument is null"));
@@ -475,28 +508,34 @@ int32 UInstrumentMorphTargetUtility::WriteMorphTargetAnimationToControlRig(
         return 0;
     }
 
-    // 清理所有现有Section
     TArray<UMovieSceneSection*> AllExistingSections =
         ControlRigTrack->GetAllSections();
+    const bool bUseFrameWindow = FrameWindow.IsSet();
+
+    UMovieSceneSection* Section = nullptr;
+    if (bUseFrameWindow && AllExistingSections.Num() > 0) {
+        // 局部重新生成：保留现有Section，只替换窗口内的关键帧
+        Section = AllExistingSections[0];
+    } else {
+        // 清理所有现有Section
+        for (UMovieSceneSection* ExistingSection : AllExistingSections) {
+            if (ExistingSection) {
+                ControlRigTrack->RemoveSection(*ExistingSection);
+            }
+        }
 
-    for (UMovieSceneSection* ExistingSection : AllExistingSections) {
-        if (ExistingSection) {
-            ControlRigTrack->RemoveSection(*ExistingSection);
+        // 创建新的Section
+        Section = ControlRigTrack->CreateNewSection();
+        if (!Section) {
+            UE_LOG(LogTemp, Error,
+                   TEXT("[InstrumentMorphTargetUtility] Failed to create new "
+                        "Section for Morph Target animation"));
+            return 0;
         }
-    }
 
-    // 创建新的Section
-    UMovieSceneSection* Section = ControlRigTrack->CreateNewSection();
-    if (!Section) {
-        UE_LOG(
-            LogTemp, Error,
-            TEXT("[InstrumentMorphTargetUtility] Failed to create new Section "
-                 "for Morph Target animation"));
-        return 0;
+        ControlRigTrack->AddSection(*Section);
     }
 
-    ControlRigTrack->AddSection(*Section);
-
     // 计算帧数范围
     FFrameNumber MinFrame(MAX_int32);
     FFrameNumber MaxFrame(MIN_int32);
@@ -515,10 +554,14 @@ int32 UInstrumentMorphTargetUtility::WriteMorphTargetAnimationToControlRig(
     }
 
     // 写入关键帧
-    int32 WrittenTargets = WriteMorphTargetKeyframes(Section, KeyframeData);
-
-    // 更新Section范围
-    if (bHasFrames) {
+    int32 WrittenTargets =
+        WriteMorphTargetKeyframes(Section, KeyframeData, FrameWindow);
+
+    // 更新Section范围（窗口模式下只扩展，不裁掉窗口外的关键帧）
+    if (bHasFrames && bUseFrameWindow) {
+        Section->SetRange(TRange<FFrameNumber>::Hull(
+            Section->GetRange(), TRange<FFrameNumber>(MinFrame, MaxFrame + 1)));
+    } else if (bHasFrames) {
         Section->SetRange(TRange<FFrameNumber>(MinFrame, MaxFrame + 1));
         UE_LOG(LogTemp, Warning,
                TEXT("[InstrumentMorphTargetUtility] Set section range to [%d, "
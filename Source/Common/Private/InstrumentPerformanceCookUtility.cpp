@@ -0,0 +1,256 @@
+﻿#include "InstrumentPerformanceCookUtility.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Channels/MovieSceneFloatChannel.h"
+#include "ControlRig.h"
+#include "ISequencer.h"
+#include "InstrumentAnimationUtility.h"
+#include "InstrumentBase.h"
+#include "InstrumentControlRigUtility.h"
+#include "InstrumentGenerationCache.h"
+#include "LevelSequence.h"
+#include "Misc/PackageName.h"
+#include "MovieScene.h"
+#include "MovieSceneSection.h"
+#include "MusicDollPerformanceAsset.h"
+
+namespace InstrumentPerformanceCookHelper {
+/** 与 Control Rig Section 中变换 Control 的通道顺序一致 */
+static const TCHAR* const TransformChannelSuffixes
+    [FMusicDollTransformCurve::NumChannels] = {
+        TEXT(".Location.X"), TEXT(".Location.Y"), TEXT(".Location.Z"),
+        TEXT(".Rotation.X"), TEXT(".Rotation.Y"), TEXT(".Rotation.Z")};
+
+/** 一条要采样的 Section 通道和它的输出位置 */
+struct FChannelSource {
+    FMovieSceneFloatChannel* Channel = nullptr;
+    FMusicDollCurveChannel* Target = nullptr;
+};
+
+FMovieSceneFloatChannel* FindChannel(UMovieSceneSection* Section,
+                                     const FString& ChannelName) {
+    return Section->GetChannelProxy()
+        .GetChannelByName<FMovieSceneFloatChannel>(*ChannelName)
+        .Get();
+}
+}  // namespace InstrumentPerformanceCookHelper
+
+UMusicDollPerformanceAsset*
+UInstrumentPerformanceCookUtility::CookInstrumentPerformance(
+    AInstrumentBase* Instrument, const FString& PackagePath,
+    float Tolerance) {
+    if (!Instrument) {
+        UE_LOG(LogTemp, Error,
+               TEXT("CookInstrumentPerformance: Instrument is null"));
+        return nullptr;
+    }
+
+    if (!FPackageName::IsValidLongPackageName(PackagePath)) {
+        UE_LOG(LogTemp, Error,
+               TEXT("CookInstrumentPerformance: Invalid package path '%s'"),
+               *PackagePath);
+        return nullptr;
+    }
+
+    TArray<FInstrumentPlaybackActor> PlaybackActors;
+    Instrument->GetPlaybackActors(PlaybackActors);
+    if (PlaybackActors.Num() == 0) {
+        UE_LOG(LogTemp, Error,
+               TEXT("CookInstrumentPerformance: No actors to cook"));
+        return nullptr;
+    }
+
+    // ========== 查找或创建资产 =========
+    const FString AssetName = FPackageName::GetLongPackageAssetName(PackagePath);
+    UMusicDollPerformanceAsset* Asset = LoadObject<UMusicDollPerformanceAsset>(
+        nullptr, *(PackagePath + TEXT(".") + AssetName), nullptr,
+        LOAD_NoWarn | LOAD_Quiet);
+
+    if (!Asset) {
+        UPackage* Package = CreatePackage(*PackagePath);
+        if (!Package) {
+            UE_LOG(LogTemp, Error,
+                   TEXT("CookInstrumentPerformance: Failed to create package: "
+                        "%s"),
+                   *PackagePath);
+            return nullptr;
+        }
+
+        Asset = NewObject<UMusicDollPerformanceAsset>(
+            Package, *AssetName, RF_Public | RF_Standalone | RF_Transactional);
+        FAssetRegistryModule::AssetCreated(Asset);
+    }
+
+    // ========== 逐个角色烘焙 =========
+    Asset->Modify();
+    Asset->Duration = 0.0f;
+
+    const double StartTime = FPlatformTime::Seconds();
+    int32 NumCooked = 0;
+    for (const FInstrumentPlaybackActor& PlaybackActor : PlaybackActors) {
+        if (CookControlRigTrack(PlaybackActor.Actor, PlaybackActor.Role,
+                                Instrument->bUseTakeSequences,
+                                PlaybackActor.TakeSuffix, Tolerance, Asset)) {
+            ++NumCooked;
+        }
+    }
+
+    Asset->MarkPackageDirty();
+
+    UE_LOG(LogTemp, Log,
+           TEXT("CookInstrumentPerformance: Cooked %d/%d roles into '%s' "
+                "(%.1f ms)"),
+           NumCooked, PlaybackActors.Num(), *PackagePath,
+           (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+    return NumCooked > 0 ? Asset : nullptr;
+}
+
+bool UInstrumentPerformanceCookUtility::CookControlRigTrack(
+    ASkeletalMeshActor* SkeletalMeshActor, FName Role, bool bUseTakeSequences,
+    const FString& TakeSuffix, float Tolerance,
+    UMusicDollPerformanceAsset* Asset) {
+    using namespace InstrumentPerformanceCookHelper;
+
+    if (!SkeletalMeshActor || !Asset) {
+        return false;
+    }
+
+    FScopedTakeSequenceGeneration TakeScope(bUseTakeSequences,
+                                            SkeletalMeshActor, TakeSuffix);
+
+    ULevelSequence* LevelSequence = nullptr;
+    TSharedPtr<ISequencer> Sequencer = nullptr;
+    if (!UInstrumentAnimationUtility::GetActiveLevelSequenceAndSequencer(
+            LevelSequence, Sequencer)) {
+        UE_LOG(LogTemp, Error, TEXT("请确保已打开Level Sequence"));
+        return false;
+    }
+
+    UControlRig* ControlRig = nullptr;
+    UControlRigBlueprint* ControlRigBlueprint = nullptr;
+    if (!FInstrumentControlRigUtility::GetControlRigFromSkeletalMeshActor(
+            SkeletalMeshActor, ControlRig, ControlRigBlueprint)) {
+        UE_LOG(LogTemp, Error,
+               TEXT("CookControlRigTrack: Failed to get Control Rig for '%s'"),
+               *SkeletalMeshActor->GetName());
+        return false;
+    }
+
+    URigHierarchy* Hierarchy = ControlRig->GetHierarchy();
+    UMovieSceneSection* Section =
+        FInstrumentGenerationCache::FindControlRigSection(LevelSequence,
+                                                          ControlRig);
+    UMovieScene* MovieScene = LevelSequence->GetMovieScene();
+    if (!Hierarchy || !Section || !MovieScene) {
+        UE_LOG(LogTemp, Error,
+               TEXT("CookControlRigTrack: No Control Rig section for '%s'"),
+               *SkeletalMeshActor->GetName());
+        return false;
+    }
+
+    // ========== 1. 重建该角色的轨道，收集要采样的通道 =========
+    FMusicDollPerformanceTrack& Track = Asset->FindOrAddTrack(Role);
+    Track.ControlRigClass = ControlRig->GetClass();
+    Track.TransformCurves.Reset();
+    Track.FloatCurves.Reset();
+
+    // 先确定曲线数量，避免收集通道时数组扩容使 Target 指针失效
+    TArray<FRigControlElement*> Controls = Hierarchy->GetControls();
+    TArray<FRigControlElement*> TransformControls;
+    TArray<TPair<FRigControlElement*, FMovieSceneFloatChannel*>> FloatControls;
+    for (FRigControlElement* Control : Controls) {
+        const FString ControlName = Control->GetKey().Name.ToString();
+        if (Control->IsAnimationChannel() ||
+            Control->Settings.ControlType == ERigControlType::Float) {
+            // 动画通道在 Section 中以显示名命名
+            FMovieSceneFloatChannel* Channel =
+                FindChannel(Section, Control->GetDisplayName().ToString());
+            if (!Channel) {
+                Channel = FindChannel(Section, ControlName);
+            }
+            if (Channel) {
+                FloatControls.Emplace(Control, Channel);
+            }
+        } else if (FindChannel(Section,
+                               ControlName + TransformChannelSuffixes[0])) {
+            TransformControls.Add(Control);
+        }
+    }
+
+    TArray<FChannelSource> Sources;
+    Track.TransformCurves.SetNum(TransformControls.Num());
+    for (int32 i = 0; i < TransformControls.Num(); ++i) {
+        const FString ControlName =
+            TransformControls[i]->GetKey().Name.ToString();
+        FMusicDollTransformCurve& Curve = Track.TransformCurves[i];
+        Curve.ControlName = TransformControls[i]->GetKey().Name;
+        for (int32 c = 0; c < FMusicDollTransformCurve::NumChannels; ++c) {
+            FChannelSource& Source = Sources.AddDefaulted_GetRef();
+            Source.Channel =
+                FindChannel(Section, ControlName + TransformChannelSuffixes[c]);
+            Source.Target = &Curve.Channels[c];
+        }
+    }
+
+    Track.FloatCurves.SetNum(FloatControls.Num());
+    for (int32 i = 0; i < FloatControls.Num(); ++i) {
+        FMusicDollFloatCurve& Curve = Track.FloatCurves[i];
+        Curve.ControlName = FloatControls[i].Key->GetKey().Name;
+        Curve.CurveName = FloatControls[i].Key->GetDisplayName();
+        Sources.Add({FloatControls[i].Value, &Curve.Channel});
+    }
+
+    // ========== 2. 按显示帧率采样播放范围 =========
+    const FFrameRate TickResolution = MovieScene->GetTickResolution();
+    const FFrameRate DisplayRate = MovieScene->GetDisplayRate();
+    const TRange<FFrameNumber> PlaybackRange = MovieScene->GetPlaybackRange();
+    const int32 StartFrame =
+        FFrameRate::TransformTime(
+            FFrameTime(PlaybackRange.GetLowerBoundValue()), TickResolution,
+            DisplayRate)
+            .FloorToFrame()
+            .Value;
+    const int32 EndFrame =
+        FFrameRate::TransformTime(
+            FFrameTime(PlaybackRange.GetUpperBoundValue()), TickResolution,
+            DisplayRate)
+            .CeilToFrame()
+            .Value;
+    const int32 NumFrames = FMath::Max(EndFrame - StartFrame, 1);
+
+    for (FChannelSource& Source : Sources) {
+        if (!Source.Channel) {
+            continue;
+        }
+
+        Source.Target->Times.Reserve(NumFrames);
+        Source.Target->Values.Reserve(NumFrames);
+        Source.Target->DefaultValue =
+            Source.Channel->GetDefault().Get(0.0f);
+
+        for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+            const FFrameTime TickTime = FFrameRate::TransformTime(
+                FFrameTime(StartFrame + Frame), DisplayRate, TickResolution);
+            float Value = Source.Target->DefaultValue;
+            Source.Channel->Evaluate(TickTime, Value);
+            Source.Target->AddSample(
+                static_cast<float>(DisplayRate.AsSeconds(FFrameTime(Frame))),
+                Value);
+        }
+
+        Source.Target->Compress(Tolerance);
+    }
+
+    Asset->SampleRate = DisplayRate;
+    Asset->Duration = FMath::Max(
+        Asset->Duration,
+        static_cast<float>(DisplayRate.AsSeconds(FFrameTime(NumFrames - 1))));
+
+    UE_LOG(LogTemp, Log,
+           TEXT("CookControlRigTrack: '%s' -> role '%s': %d transform, %d "
+                "float curves, %d frames"),
+           *SkeletalMeshActor->GetName(), *Role.ToString(),
+           Track.TransformCurves.Num(), Track.FloatCurves.Num(), NumFrames);
+    return true;
+}
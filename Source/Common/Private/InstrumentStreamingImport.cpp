@@ -0,0 +1,374 @@
+﻿#include "InstrumentStreamingImport.h"
+
+#include "Animation/SkeletalMeshActor.h"
+#include "ControlRig.h"
+#include "Dom/JsonObject.h"
+#include "HAL/RunnableThread.h"
+#include "ISequencer.h"
+#include "InstrumentControlRigUtility.h"
+#include "LevelSequence.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+namespace InstrumentStreamingImportHelper {
+/** 缓冲的帧数，读取线程超前游戏线程太多时等待 */
+static constexpr uint32 FrameBufferCapacity = 1024;
+
+/** 单次接收的字节数 */
+static constexpr int32 ReceiveBufferSize = 64 * 1024;
+
+/** 连接失败后的重试间隔（秒） */
+static constexpr float ReconnectInterval = 0.5f;
+
+/** 等待数据的超时，用于及时响应停止请求 */
+static const FTimespan ReceiveWaitTime = FTimespan::FromMilliseconds(100);
+
+/** 正在运行的会话，按会话名称索引（仅游戏线程访问） */
+static TMap<FString, TSharedPtr<FInstrumentStreamingImportSession>>&
+GetSessions() {
+    static TMap<FString, TSharedPtr<FInstrumentStreamingImportSession>>
+        Sessions;
+    return Sessions;
+}
+
+/** 在（可选的）分段子序列中取得演奏者的 Level Sequence 和 Control Rig */
+static bool ResolveTarget(ASkeletalMeshActor* PerformerActor,
+                          ULevelSequence*& OutLevelSequence,
+                          UControlRig*& OutControlRig) {
+    TSharedPtr<ISequencer> Sequencer = nullptr;
+    if (!UInstrumentAnimationUtility::GetActiveLevelSequenceAndSequencer(
+            OutLevelSequence, Sequencer)) {
+        UE_LOG(LogTemp, Error, TEXT("请确保已打开Level Sequence"));
+        return false;
+    }
+
+    UControlRigBlueprint* ControlRigBlueprint = nullptr;
+    if (!FInstrumentControlRigUtility::GetControlRigFromSkeletalMeshActor(
+            PerformerActor, OutControlRig, ControlRigBlueprint) ||
+        !OutControlRig) {
+        UE_LOG(LogTemp, Error,
+               TEXT("StreamingImport: Failed to get Control Rig from "
+                    "SkeletalMeshActor"));
+        return false;
+    }
+    return true;
+}
+}  // namespace InstrumentStreamingImportHelper
+
+FInstrumentStreamingImportSession::FInstrumentStreamingImportSession(
+    FInstrumentStreamingImportSettings InSettings)
+    : Settings(MoveTemp(InSettings)),
+      Frames(InstrumentStreamingImportHelper::FrameBufferCapacity) {}
+
+FInstrumentStreamingImportSession::~FInstrumentStreamingImportSession() {
+    bStopRequested = true;
+    if (ReaderThread) {
+        ReaderThread->WaitForCompletion();
+        ReaderThread.Reset();
+    }
+    if (TickerHandle.IsValid()) {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+    }
+}
+
+bool FInstrumentStreamingImportSession::StartSession(
+    FInstrumentStreamingImportSettings Settings) {
+    using namespace InstrumentStreamingImportHelper;
+
+    const FString SessionName = Settings.SessionName;
+    StopSession(SessionName);
+
+    TSharedPtr<FInstrumentStreamingImportSession> Session =
+        MakeShared<FInstrumentStreamingImportSession>(MoveTemp(Settings));
+    if (!Session->Begin()) {
+        return false;
+    }
+
+    GetSessions().Add(SessionName, Session);
+    return true;
+}
+
+bool FInstrumentStreamingImportSession::StopSession(
+    const FString& SessionName) {
+    using namespace InstrumentStreamingImportHelper;
+
+    TSharedPtr<FInstrumentStreamingImportSession> Session;
+    if (!GetSessions().RemoveAndCopyValue(SessionName, Session)) {
+        return false;
+    }
+
+    // 停止读取后写入已经到达的帧
+    Session->bStopRequested = true;
+    if (Session->ReaderThread) {
+        Session->ReaderThread->WaitForCompletion();
+        Session->ReaderThread.Reset();
+    }
+    Session->Tick(0.0f);
+    return true;
+}
+
+bool FInstrumentStreamingImportSession::IsSessionRunning(
+    const FString& SessionName) {
+    return InstrumentStreamingImportHelper::GetSessions().Contains(
+        SessionName);
+}
+
+bool FInstrumentStreamingImportSession::Begin() {
+    using namespace InstrumentStreamingImportHelper;
+
+    ASkeletalMeshActor* PerformerActor = Settings.PerformerActor.Get();
+    if (!PerformerActor) {
+        UE_LOG(LogTemp, Error, TEXT("StreamingImport: PerformerActor is null"));
+        return false;
+    }
+
+    // 与完整生成一样，开始前清空旧关键帧
+    {
+        FScopedTakeSequenceGeneration TakeScope(
+            Settings.bUseTakeSequences, PerformerActor, Settings.TakeSuffix);
+
+        ULevelSequence* LevelSequence = nullptr;
+        UControlRig* ControlRig = nullptr;
+        if (!ResolveTarget(PerformerActor, LevelSequence, ControlRig)) {
+            return false;
+        }
+
+        UInstrumentAnimationUtility::ValidateNoExistingTracks(
+            LevelSequence, ControlRig, true);
+        UInstrumentAnimationUtility::ClearControlRigKeyframes(
+            LevelSequence, ControlRig, Settings.ControllerNamesToClean);
+    }
+
+    StartTime = FPlatformTime::Seconds();
+    LastFlushTime = StartTime;
+
+    ReaderThread.Reset(FRunnableThread::Create(
+        this,
+        *FString::Printf(TEXT("InstrumentStreamingImport_%s"),
+                         *Settings.SessionName),
+        0, TPri_BelowNormal));
+    if (!ReaderThread) {
+        return false;
+    }
+
+    TickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateSP(this, &FInstrumentStreamingImportSession::Tick));
+
+    UE_LOG(LogTemp, Log,
+           TEXT("StreamingImport: '%s' waiting for frames on port %d"),
+           *Settings.SessionName, Settings.Port);
+    return true;
+}
+
+bool FInstrumentStreamingImportSession::Tick(float DeltaTime) {
+    using namespace InstrumentStreamingImportHelper;
+
+    // 会话可能在本函数中被移除
+    TSharedRef<FInstrumentStreamingImportSession> KeepAlive = AsShared();
+
+    // 先读结束标记：之后取出的帧一定包含读取线程写入的全部帧
+    const bool bReaderDone = bReaderFinished.load();
+
+    FStreamedFrame Frame;
+    while (Frames.Pop(Frame)) {
+        for (TPair<FString, TArray<FAnimationKeyframe>>& Control :
+             Frame.Controls) {
+            KeyframeStore.FindOrAdd(Control.Key).Append(Control.Value);
+        }
+        PendingStartFrame = FMath::Min(PendingStartFrame, Frame.FrameNumber);
+        PendingEndFrame = FMath::Max(PendingEndFrame, Frame.FrameNumber);
+        ++NumFramesImported;
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    const bool bHasPending = PendingStartFrame <= PendingEndFrame;
+    if (bHasPending &&
+        (bReaderDone || Now - LastFlushTime >= Settings.FlushInterval)) {
+        Flush();
+        LastFlushTime = Now;
+    }
+
+    if (!bReaderDone) {
+        return true;
+    }
+
+    UE_LOG(LogTemp, Log,
+           TEXT("StreamingImport: '%s' finished, %d frames imported, first "
+                "frames written after %.2f s, total %.2f s"),
+           *Settings.SessionName, NumFramesImported,
+           FirstFlushTime > 0.0 ? FirstFlushTime - StartTime : 0.0,
+           Now - StartTime);
+
+    // StopSession 直接调用时也要注销，在 Ticker 回调中注销是安全的
+    if (TickerHandle.IsValid()) {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+        TickerHandle.Reset();
+    }
+    const TSharedPtr<FInstrumentStreamingImportSession>* Registered =
+        GetSessions().Find(Settings.SessionName);
+    if (Registered && Registered->Get() == this) {
+        GetSessions().Remove(Settings.SessionName);
+    }
+    return false;
+}
+
+void FInstrumentStreamingImportSession::Flush() {
+    using namespace InstrumentStreamingImportHelper;
+
+    ASkeletalMeshActor* PerformerActor = Settings.PerformerActor.Get();
+    if (!PerformerActor) {
+        return;
+    }
+
+    FScopedTakeSequenceGeneration TakeScope(
+        Settings.bUseTakeSequences, PerformerActor, Settings.TakeSuffix);
+
+    ULevelSequence* LevelSequence = nullptr;
+    UControlRig* ControlRig = nullptr;
+    if (!ResolveTarget(PerformerActor, LevelSequence, ControlRig)) {
+        return;
+    }
+
+    // 只写入上次写入之后到达的关键帧
+    TMap<FString, TArray<FAnimationKeyframe>> NewKeyframes;
+    for (const TPair<FString, TArray<FAnimationKeyframe>>& Control :
+         KeyframeStore) {
+        int32& FlushedCount = FlushedKeyframeCounts.FindOrAdd(Control.Key);
+        if (FlushedCount < Control.Value.Num()) {
+            NewKeyframes.Add(Control.Key,
+                             TArray<FAnimationKeyframe>(
+                                 Control.Value.GetData() + FlushedCount,
+                                 Control.Value.Num() - FlushedCount));
+            FlushedCount = Control.Value.Num();
+        }
+    }
+
+    // 窗口模式：只替换新时间范围内的关键帧，旋转与已写入的曲线对齐
+    FBatchInsertKeyframesSettings InsertSettings = Settings.InsertSettings;
+    InsertSettings.FrameWindow =
+        FAnimationFrameWindow(PendingStartFrame, PendingEndFrame);
+
+    UInstrumentAnimationUtility::BatchInsertControlRigKeys(
+        LevelSequence, ControlRig, NewKeyframes, InsertSettings);
+
+    if (FirstFlushTime == 0.0) {
+        FirstFlushTime = FPlatformTime::Seconds();
+    }
+    PendingStartFrame = MAX_int32;
+    PendingEndFrame = MIN_int32;
+}
+
+uint32 FInstrumentStreamingImportSession::Run() {
+    using namespace InstrumentStreamingImportHelper;
+
+    ISocketSubsystem* SocketSubsystem =
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr();
+    Address->SetLoopbackAddress();
+    Address->SetPort(Settings.Port);
+
+    // 1. 连接外部工具，未启动时重试
+    FSocket* Socket = nullptr;
+    while (!bStopRequested) {
+        Socket = SocketSubsystem->CreateSocket(
+            NAME_Stream, TEXT("MusicDollStreamingImport"),
+            Address->GetProtocolType());
+        if (Socket && Socket->Connect(*Address)) {
+            break;
+        }
+        if (Socket) {
+            SocketSubsystem->DestroySocket(Socket);
+            Socket = nullptr;
+        }
+        FPlatformProcess::Sleep(ReconnectInterval);
+    }
+
+    // 2. 接收消息直到结束消息、连接断开或停止
+    if (Socket) {
+        FInstrumentStreamMessageDecoder Decoder;
+        TArray<uint8> ReceiveBuffer;
+        ReceiveBuffer.SetNumUninitialized(ReceiveBufferSize);
+        InstrumentStreamingProtocol::EMessageType Type;
+        TArray<uint8> Payload;
+        bool bEndOfStream = false;
+
+        while (!bStopRequested && !bEndOfStream) {
+            if (!Socket->Wait(ESocketWaitConditions::WaitForRead,
+                              ReceiveWaitTime)) {
+                if (Socket->GetConnectionState() != SCS_Connected) {
+                    break;
+                }
+                continue;
+            }
+
+            int32 BytesRead = 0;
+            if (!Socket->Recv(ReceiveBuffer.GetData(), ReceiveBuffer.Num(),
+                              BytesRead) ||
+                BytesRead == 0) {
+                break;
+            }
+
+            Decoder.Append(ReceiveBuffer.GetData(), BytesRead);
+            while (!bEndOfStream && Decoder.PopMessage(Type, Payload)) {
+                bEndOfStream = HandleMessage(Type, Payload);
+            }
+
+            if (Decoder.HasError()) {
+                UE_LOG(LogTemp, Error,
+                       TEXT("StreamingImport: Invalid message header, "
+                            "closing connection"));
+                break;
+            }
+        }
+
+        Socket->Close();
+        SocketSubsystem->DestroySocket(Socket);
+    }
+
+    bReaderFinished = true;
+    return 0;
+}
+
+void FInstrumentStreamingImportSession::Stop() { bStopRequested = true; }
+
+bool FInstrumentStreamingImportSession::HandleMessage(
+    InstrumentStreamingProtocol::EMessageType Type,
+    const TArray<uint8>& Payload) {
+    using namespace InstrumentStreamingImportHelper;
+
+    if (Type == InstrumentStreamingProtocol::EMessageType::End) {
+        return true;
+    }
+
+    const FString FrameJson(FUTF8ToTCHAR(
+        reinterpret_cast<const ANSICHAR*>(Payload.GetData()), Payload.Num()));
+    TSharedPtr<FJsonObject> FrameObject;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(FrameJson);
+    if (!FJsonSerializer::Deserialize(Reader, FrameObject)) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("StreamingImport: Frame %d is not a valid JSON object"),
+               NumFramesReceived);
+        ++NumFramesReceived;
+        return false;
+    }
+
+    FStreamedFrame Frame;
+    int32 KeyframesAdded = 0;
+    Frame.FrameNumber = UInstrumentAnimationUtility::ProcessFrameObject(
+        FrameObject, NumFramesReceived++, Frame.Controls,
+        Settings.ControllerNames, KeyframesAdded);
+    if (Frame.FrameNumber == INDEX_NONE) {
+        return false;
+    }
+
+    // 缓冲区已满时等待游戏线程取走
+    while (!Frames.Push(MoveTemp(Frame))) {
+        if (bStopRequested) {
+            return true;
+        }
+        FPlatformProcess::Sleep(0.01f);
+    }
+    return false;
+}
@@ -0,0 +1,243 @@
+﻿#include "InstrumentStreamingProtocol.h"
+
+#include "Common/TcpSocketBuilder.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/RunnableThread.h"
+#include "InstrumentLiveLinkSource.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Misc/FileHelper.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+namespace InstrumentStreamingProtocol {
+void EncodeMessage(EMessageType Type, TConstArrayView<uint8> Payload,
+                   TArray<uint8>& OutBytes) {
+    const uint32 PayloadSize = static_cast<uint32>(Payload.Num());
+    OutBytes.Reserve(OutBytes.Num() + HeaderSize + Payload.Num());
+    OutBytes.Add(static_cast<uint8>(PayloadSize & 0xFF));
+    OutBytes.Add(static_cast<uint8>((PayloadSize >> 8) & 0xFF));
+    OutBytes.Add(static_cast<uint8>((PayloadSize >> 16) & 0xFF));
+    OutBytes.Add(static_cast<uint8>((PayloadSize >> 24) & 0xFF));
+    OutBytes.Add(static_cast<uint8>(Type));
+    OutBytes.Append(Payload.GetData(), Payload.Num());
+}
+
+void EncodeFrameMessage(const FString& FrameJson, TArray<uint8>& OutBytes) {
+    const FTCHARToUTF8 Utf8(*FrameJson);
+    EncodeMessage(EMessageType::Frame,
+                  MakeArrayView(reinterpret_cast<const uint8*>(Utf8.Get()),
+                                Utf8.Length()),
+                  OutBytes);
+}
+}  // namespace InstrumentStreamingProtocol
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FInstrumentStreamMessageDecoder
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FInstrumentStreamMessageDecoder::Append(const uint8* Data, int32 Num) {
+    // 已取出的消息较多时再整理缓冲区，避免每条消息都搬移数据
+    if (ReadOffset > 0 && ReadOffset >= Buffer.Num() / 2) {
+        Buffer.RemoveAt(0, ReadOffset, EAllowShrinking::No);
+        ReadOffset = 0;
+    }
+    Buffer.Append(Data, Num);
+}
+
+bool FInstrumentStreamMessageDecoder::PopMessage(
+    InstrumentStreamingProtocol::EMessageType& OutType,
+    TArray<uint8>& OutPayload) {
+    using namespace InstrumentStreamingProtocol;
+
+    if (bError || Buffer.Num() - ReadOffset < HeaderSize) {
+        return false;
+    }
+
+    const uint8* Header = Buffer.GetData() + ReadOffset;
+    const uint32 PayloadSize = static_cast<uint32>(Header[0]) |
+                               (static_cast<uint32>(Header[1]) << 8) |
+                               (static_cast<uint32>(Header[2]) << 16) |
+                               (static_cast<uint32>(Header[3]) << 24);
+    const uint8 Type = Header[4];
+
+    if (PayloadSize > MaxPayloadSize ||
+        (Type != static_cast<uint8>(EMessageType::Frame) &&
+         Type != static_cast<uint8>(EMessageType::End))) {
+        bError = true;
+        return false;
+    }
+
+    if (static_cast<uint32>(Buffer.Num() - ReadOffset - HeaderSize) <
+        PayloadSize) {
+        return false;
+    }
+
+    OutType = static_cast<EMessageType>(Type);
+    OutPayload.Reset(PayloadSize);
+    OutPayload.Append(Header + HeaderSize, PayloadSize);
+    ReadOffset += HeaderSize + PayloadSize;
+    return true;
+}
+
+void FInstrumentStreamMessageDecoder::Reset() {
+    Buffer.Reset();
+    ReadOffset = 0;
+    bError = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FInstrumentStreamReplayServer
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FInstrumentStreamReplayServer::FInstrumentStreamReplayServer(
+    const FString& InFilePath, int32 InPort, float InFramesPerSecond)
+    : FilePath(InFilePath), Port(InPort), FramesPerSecond(InFramesPerSecond) {}
+
+FInstrumentStreamReplayServer::~FInstrumentStreamReplayServer() {
+    Stop();
+    if (Thread) {
+        Thread->WaitForCompletion();
+        Thread.Reset();
+    }
+    if (ListenSocket) {
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)
+            ->DestroySocket(ListenSocket);
+        ListenSocket = nullptr;
+    }
+}
+
+bool FInstrumentStreamReplayServer::Start() {
+    ListenSocket = FTcpSocketBuilder(TEXT("MusicDollStreamReplay"))
+                       .AsReusable()
+                       .BoundToEndpoint(
+                           FIPv4Endpoint(FIPv4Address::InternalLoopback, Port))
+                       .Listening(1)
+                       .Build();
+    if (!ListenSocket) {
+        UE_LOG(LogTemp, Error,
+               TEXT("StreamReplay: Failed to listen on port %d"), Port);
+        return false;
+    }
+
+    Thread.Reset(FRunnableThread::Create(this, TEXT("InstrumentStreamReplay"),
+                                         0, TPri_BelowNormal));
+    return Thread.IsValid();
+}
+
+uint32 FInstrumentStreamReplayServer::Run() {
+    using namespace InstrumentStreamingProtocol;
+
+    ISocketSubsystem* SocketSubsystem =
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+
+    // 1. 等待客户端连接
+    FSocket* ClientSocket = nullptr;
+    while (!bStopRequested && !ClientSocket) {
+        bool bHasPendingConnection = false;
+        if (ListenSocket->WaitForPendingConnection(
+                bHasPendingConnection, FTimespan::FromMilliseconds(100)) &&
+            bHasPendingConnection) {
+            ClientSocket =
+                ListenSocket->Accept(TEXT("MusicDollStreamReplayClient"));
+        }
+    }
+
+    // 2. 逐帧发送
+    FString FileContent;
+    if (ClientSocket && FFileHelper::LoadFileToString(FileContent, *FilePath)) {
+        const FTCHARToUTF8 Utf8(*FileContent);
+        FInstrumentJsonObjectScanner Scanner;
+        Scanner.Append(reinterpret_cast<const uint8*>(Utf8.Get()),
+                       Utf8.Length());
+
+        const double FrameInterval =
+            FramesPerSecond > 0.0f ? 1.0 / FramesPerSecond : 0.0;
+        double NextSendTime = FPlatformTime::Seconds();
+
+        FString FrameJson;
+        TArray<uint8> Message;
+        while (!bStopRequested && Scanner.PopObject(FrameJson)) {
+            if (FrameInterval > 0.0) {
+                const double Wait = NextSendTime - FPlatformTime::Seconds();
+                if (Wait > 0.0) {
+                    FPlatformProcess::Sleep(static_cast<float>(Wait));
+                }
+                NextSendTime += FrameInterval;
+            }
+
+            Message.Reset();
+            EncodeFrameMessage(FrameJson, Message);
+            if (!SendAll(ClientSocket, Message)) {
+                break;
+            }
+            ++NumFramesSent;
+        }
+
+        Message.Reset();
+        EncodeMessage(EMessageType::End, {}, Message);
+        SendAll(ClientSocket, Message);
+    } else if (ClientSocket) {
+        UE_LOG(LogTemp, Error, TEXT("StreamReplay: Failed to load file: %s"),
+               *FilePath);
+    }
+
+    if (ClientSocket) {
+        ClientSocket->Close();
+        SocketSubsystem->DestroySocket(ClientSocket);
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("StreamReplay: Sent %d frames from %s"),
+           NumFramesSent.load(), *FilePath);
+    bFinished = true;
+    return 0;
+}
+
+void FInstrumentStreamReplayServer::Stop() { bStopRequested = true; }
+
+bool FInstrumentStreamReplayServer::SendAll(FSocket* Socket,
+                                            const TArray<uint8>& Bytes) {
+    int32 Offset = 0;
+    while (Offset < Bytes.Num() && !bStopRequested) {
+        int32 BytesSent = 0;
+        if (!Socket->Send(Bytes.GetData() + Offset, Bytes.Num() - Offset,
+                          BytesSent)) {
+            return false;
+        }
+        Offset += BytesSent;
+    }
+    return Offset == Bytes.Num();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// 控制台命令
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace InstrumentStreamReplayHelper {
+static TUniquePtr<FInstrumentStreamReplayServer> ActiveReplayServer;
+
+static FAutoConsoleCommand StreamReplayCommand(
+    TEXT("MusicDoll.StreamReplay"),
+    TEXT("回放演奏动画文件作为流式导入的数据源。")
+        TEXT("用法：MusicDoll.StreamReplay <文件路径> [端口] [帧率]；")
+        TEXT("不带参数时停止回放"),
+    FConsoleCommandWithArgsDelegate::CreateLambda(
+        [](const TArray<FString>& Args) {
+            ActiveReplayServer.Reset();
+            if (Args.Num() == 0) {
+                return;
+            }
+
+            const int32 Port =
+                Args.IsValidIndex(1)
+                    ? FCString::Atoi(*Args[1])
+                    : InstrumentStreamingProtocol::DefaultPort;
+            const float FramesPerSecond =
+                Args.IsValidIndex(2) ? FCString::Atof(*Args[2]) : 30.0f;
+
+            ActiveReplayServer = MakeUnique<FInstrumentStreamReplayServer>(
+                Args[0], Port, FramesPerSecond);
+            if (!ActiveReplayServer->Start()) {
+                ActiveReplayServer.Reset();
+            }
+        }));
+}  // namespace InstrumentStreamReplayHelper
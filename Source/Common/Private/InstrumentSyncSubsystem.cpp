@@ -0,0 +1,155 @@
+﻿#include "InstrumentSyncSubsystem.h"
+
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "ISequencer.h"
+#include "InstrumentBase.h"
+#include "InstrumentControlRigUtility.h"
+#include "LevelEditorSequencerIntegration.h"
+#include "LevelSequence.h"
+#include "Modules/ModuleManager.h"
+
+namespace InstrumentSyncSubsystemHelper {
+/** 乐器数量少于该值时不值得分发到工作线程 */
+constexpr int32 MinInstrumentsForParallelCompute = 4;
+}  // namespace InstrumentSyncSubsystemHelper
+
+// ========== FInstrumentSyncFrameContext ==========
+
+void FInstrumentSyncFrameContext::Initialize() {
+    LevelSequence = nullptr;
+    Sequencer.Reset();
+    GlobalTime = FQualifiedFrameTime();
+    bControlRigsCollected = false;
+    ControlRigs.Reset();
+
+    if (!FModuleManager::Get().IsModuleLoaded(TEXT("LevelEditor"))) {
+        return;
+    }
+
+    for (const TWeakPtr<ISequencer>& WeakSequencer :
+         FLevelEditorSequencerIntegration::Get().GetSequencers()) {
+        TSharedPtr<ISequencer> CurrentSequencer = WeakSequencer.Pin();
+        if (!CurrentSequencer.IsValid()) {
+            continue;
+        }
+
+        // 优先使用聚焦的序列（分段子序列生成时聚焦在子序列上）
+        ULevelSequence* CurrentLevelSequence = Cast<ULevelSequence>(
+            CurrentSequencer->GetFocusedMovieSceneSequence());
+        if (!CurrentLevelSequence) {
+            CurrentLevelSequence = Cast<ULevelSequence>(
+                CurrentSequencer->GetRootMovieSceneSequence());
+        }
+
+        if (CurrentLevelSequence) {
+            LevelSequence = CurrentLevelSequence;
+            Sequencer = CurrentSequencer;
+            GlobalTime = CurrentSequencer->GetGlobalTime();
+            return;
+        }
+    }
+}
+
+UControlRig* FInstrumentSyncFrameContext::FindControlRig(
+    const ASkeletalMeshActor* SkeletalMeshActor) const {
+    if (!SkeletalMeshActor || !Sequencer.IsValid()) {
+        return nullptr;
+    }
+
+    if (!bControlRigsCollected) {
+        bControlRigsCollected = true;
+        FInstrumentControlRigUtility::CollectControlRigBindings(
+            LevelSequence, *Sequencer, ControlRigs);
+    }
+
+    UControlRig* const* Found = ControlRigs.Find(SkeletalMeshActor);
+    return Found ? *Found : nullptr;
+}
+
+// ========== UInstrumentSyncSubsystem ==========
+
+UInstrumentSyncSubsystem* UInstrumentSyncSubsystem::Get(const UWorld* World) {
+    return World ? World->GetSubsystem<UInstrumentSyncSubsystem>() : nullptr;
+}
+
+void UInstrumentSyncSubsystem::RegisterInstrument(
+    AInstrumentBase* Instrument) {
+    if (Instrument) {
+        Instruments.AddUnique(Instrument);
+    }
+}
+
+void UInstrumentSyncSubsystem::UnregisterInstrument(
+    AInstrumentBase* Instrument) {
+    Instruments.RemoveAll(
+        [Instrument](const TWeakObjectPtr<AInstrumentBase>& WeakInstrument) {
+            return !WeakInstrument.IsValid() || WeakInstrument.Get() == Instrument;
+        });
+}
+
+int32 UInstrumentSyncSubsystem::GetNumRegisteredInstruments() const {
+    return Instruments.Num();
+}
+
+void UInstrumentSyncSubsystem::SyncInstruments(
+    TArrayView<AInstrumentBase* const> InInstruments) {
+    if (InInstruments.Num() == 0) {
+        return;
+    }
+
+    // ========== 1. 共享数据只解析一次 =========
+    FInstrumentSyncFrameContext Context;
+    Context.Initialize();
+
+    // ========== 2. 游戏线程读取输入 =========
+    for (AInstrumentBase* Instrument : InInstruments) {
+        Instrument->GatherRealtimeSync(Context);
+    }
+
+    // ========== 3. 纯数学计算，乐器之间互不依赖 =========
+    ParallelFor(
+        InInstruments.Num(),
+        [&InInstruments](int32 Index) {
+            InInstruments[Index]->ComputeRealtimeSync();
+        },
+        InInstruments.Num() <
+                InstrumentSyncSubsystemHelper::MinInstrumentsForParallelCompute
+            ? EParallelForFlags::ForceSingleThread
+            : EParallelForFlags::None);
+
+    // ========== 4. 游戏线程写回 =========
+    for (AInstrumentBase* Instrument : InInstruments) {
+        Instrument->ApplyRealtimeSync();
+    }
+}
+
+void UInstrumentSyncSubsystem::Tick(float DeltaTime) {
+    Super::Tick(DeltaTime);
+
+    PendingInstruments.Reset();
+    for (int32 i = Instruments.Num() - 1; i >= 0; --i) {
+        AInstrumentBase* Instrument = Instruments[i].Get();
+        if (!Instrument) {
+            Instruments.RemoveAtSwap(i);
+            continue;
+        }
+        if (Instrument->NeedsRealtimeSync()) {
+            PendingInstruments.Add(Instrument);
+        }
+    }
+
+    // 空闲时不解析任何共享数据
+    SyncInstruments(PendingInstruments);
+}
+
+TStatId UInstrumentSyncSubsystem::GetStatId() const {
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UInstrumentSyncSubsystem,
+                                    STATGROUP_Tickables);
+}
+
+bool UInstrumentSyncSubsystem::DoesSupportWorldType(
+    const EWorldType::Type WorldType) const {
+    return WorldType == EWorldType::Editor || WorldType == EWorldType::PIE ||
+           WorldType == EWorldType::Game;
+}
@@ -6,81 +6,55 @@
 #include "ControlRig.h"
 #include "Math/UnrealMathSSE.h"
 #include "Math/Vector.h"
+#include "PoleTargetSolverCore.h"
 #include "RigVMDeveloper/Public/RigVMModel/RigVMFunctionLibrary.h"
 #include "Rigs/RigHierarchy.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(PoleTargetFABRIK)
 
 // --- 只对根骨骼做pole平面修正 ---
-static void ApplyPolePlaneCorrection_RootOnly(
-    TArray<FVector>& BonePositions, const FVector& PoleTarget,
-    URigHierarchy* Hierarchy, const TArray<FCachedRigElement>& CachedItems,
-    float Weight, bool bPropagateToChildren) {
-    int32 NumChainLinks = BonePositions.Num();
+// 根骨骼绕 根->末端 轴旋转，其余骨骼保持相对根骨骼的变换随之转动
+static void ApplyPolePlaneCorrection_RootOnly(TArray<FCCDIKChainLink>& Chain,
+                                              const FVector& PoleTarget,
+                                              float Weight) {
+    int32 NumChainLinks = Chain.Num();
     if (NumChainLinks < 3) return;  // 至少3个骨骼
     int32 MiddleIndex = FMath::RoundToInt((NumChainLinks - 1) / 2.0f);
-    FVector StartPos = BonePositions[0];
-    FVector EndPos = BonePositions.Last();
-    FVector MiddlePos = BonePositions[MiddleIndex];
-    FVector ChainAxis = (EndPos - StartPos).GetSafeNormal();
-    // 计算目标平面法线
-    FVector PlaneNormal =
-        FVector::CrossProduct(EndPos - StartPos, PoleTarget - StartPos)
-            .GetSafeNormal();
-    // middle bone到平面的投影
-    float PlaneD = -FVector::DotProduct(PlaneNormal, PoleTarget);
-    float DistToPlane = FVector::DotProduct(MiddlePos, PlaneNormal) + PlaneD;
-    FVector MiddleToPlane = -DistToPlane * PlaneNormal;
-    FVector MiddleTarget = MiddlePos + MiddleToPlane;
-    FVector MiddleVec = (MiddlePos - StartPos);
-    FVector TargetVec = (MiddleTarget - StartPos);
-    float Angle =
-        FMath::Acos(FMath::Clamp(FVector::DotProduct(MiddleVec.GetSafeNormal(),
-                                                     TargetVec.GetSafeNormal()),
-                                 -1.f, 1.f));
-    float Sign = FVector::DotProduct(
-                     ChainAxis, FVector::CrossProduct(MiddleVec, TargetVec)) < 0
-                     ? -1.f
-                     : 1.f;
-    float FinalAngle = Angle * Sign;
-    const float SideThreshold = 0.01f;
-    FVector ToPoleTarget = (PoleTarget - MiddleTarget).GetSafeNormal();
-    FVector ToMiddle = (MiddlePos - MiddleTarget).GetSafeNormal();
-    if (FVector::DotProduct(ToPoleTarget, ToMiddle) < -SideThreshold) {
-        FinalAngle += PI;
+    FQuat RotQuat = PoleTargetSolverCore::FRootPoleCorrectionSolver::
+        CalculateRootPoleCorrection(
+            Chain[0].Transform.GetLocation(),
+            Chain[MiddleIndex].Transform.GetLocation(),
+            Chain.Last().Transform.GetLocation(), PoleTarget);
+    if (RotQuat.IsIdentity()) {
+        return;
     }
-    if (FMath::Abs(FinalAngle) > KINDA_SMALL_NUMBER) {
-        FQuat RotQuat(ChainAxis, FinalAngle);
-        // 只对根骨骼做旋转
-        const FCachedRigElement& RootBone = CachedItems[0];
-        if (RootBone.IsValid()) {
-            FTransform OrigTransform =
-                Hierarchy->GetGlobalTransform(RootBone.GetIndex());
-            FTransform NewTransform = OrigTransform;
-            NewTransform.SetRotation(
-                (RotQuat * OrigTransform.GetRotation()).GetNormalized());
-            if (Weight >= 1.f) {
-                Hierarchy->SetGlobalTransform(RootBone.GetKey(), NewTransform,
-                                              false, true,
-                                              bPropagateToChildren);
-            } else {
-                FTransform InterpTransform;
-                InterpTransform.Blend(OrigTransform, NewTransform, Weight);
-                Hierarchy->SetGlobalTransform(RootBone.GetKey(),
-                                              InterpTransform, false, true,
-                                              bPropagateToChildren);
-            }
-        }
+
+    const FTransform OrigRootTransform = Chain[0].Transform;
+    FTransform NewRootTransform = OrigRootTransform;
+    NewRootTransform.SetRotation(
+        (RotQuat * OrigRootTransform.GetRotation()).GetNormalized());
+    if (Weight < 1.f) {
+        FTransform InterpTransform;
+        InterpTransform.Blend(OrigRootTransform, NewRootTransform, Weight);
+        NewRootTransform = InterpTransform;
+    }
+
+    for (int32 i = 1; i < NumChainLinks; ++i) {
+        Chain[i].Transform =
+            Chain[i].Transform.GetRelativeTransform(OrigRootTransform) *
+            NewRootTransform;
     }
+    Chain[0].Transform = NewRootTransform;
 }
 
 FRigUnit_FABRIKWithPole_Execute() {
+    IterationsUsed = 0;
     URigHierarchy* Hierarchy = ExecuteContext.Hierarchy;
     if (!Hierarchy) {
         return;
     }
-    // 骨骼链准备
-    WorkData.CachedItems.Empty();
+    // 骨骼链准备（WorkData中的数组跨帧保留容量）
+    WorkData.CachedItems.Reset();
     if (Items.Num() < 2) {
         return;
     }
@@ -99,71 +73,66 @@ FRigUnit_FABRIKWithPole_Execute() {
         return;
     }
     // 构造CCDIK链
-    TArray<FCCDIKChainLink> CCDIKChain;
-    CCDIKChain.SetNum(NumChainLinks);  // 保证成员初始化
+    TArray<FCCDIKChainLink>& CCDIKChain = WorkData.Chain;
+    CCDIKChain.SetNum(NumChainLinks);
     for (int32 i = 0; i < NumChainLinks; ++i) {
         const FCachedRigElement& CachedBone = WorkData.CachedItems[i];
         FTransform BoneTransform =
             Hierarchy->GetGlobalTransform(CachedBone.GetIndex());
         CCDIKChain[i].Transform = BoneTransform;
         if (i > 0) {
-            const FCachedRigElement& ParentBone = WorkData.CachedItems[i - 1];
-            FTransform ParentTransform =
-                Hierarchy->GetGlobalTransform(ParentBone.GetIndex());
-            CCDIKChain[i].LocalTransform =
-                BoneTransform.GetRelativeTransform(ParentTransform);
+            // 父骨骼刚读过，不再重复查询层级
+            CCDIKChain[i].LocalTransform = BoneTransform.GetRelativeTransform(
+                CCDIKChain[i - 1].Transform);
         } else {
             CCDIKChain[i].LocalTransform = BoneTransform;
         }
         CCDIKChain[i].CurrentAngleDelta = 0.0;
     }
-    // Rotation limits
-    TArray<float> RotationLimitsPerJoint;
-    RotationLimitsPerJoint.SetNum(NumChainLinks);
-    for (int32 i = 0; i < NumChainLinks; ++i) {
-        RotationLimitsPerJoint[i] = BaseRotationLimit;
-    }
-    // CCDIK算法主流程（官方实现）
-    AnimationCore::SolveCCDIK(CCDIKChain, EffectorTransform.GetLocation(),
-                              Precision > 0.f ? Precision : 0.001f,
-                              MaxIterations > 0 ? MaxIterations : 10,
-                              bStartFromTail,
-                              false,  // bEnableRotationLimit
-                              RotationLimitsPerJoint);
-    // 先将CCDIK结果写回Hierarchy（位置+旋转）
-    for (int32 i = 0; i < NumChainLinks; ++i) {
-        const FCachedRigElement& CachedBone = WorkData.CachedItems[i];
-        if (CachedBone.IsValid()) {
-            Hierarchy->SetGlobalTransform(CachedBone.GetKey(),
-                                          CCDIKChain[i].Transform, false, true,
-                                          bPropagateToChildren);
+    // 输入与上一次求解相同时直接复用CCDIK结果，跳过迭代
+    bool bMemoHit = false;
+    uint32 SettingsHash = 0;
+    if (bMemoizeUnchangedInputs) {
+        SettingsHash = FRigUnit_PoleTargetIK_MemoData::HashSettings(
+            Precision, MaxIterations, EarlyStopThreshold, bStartFromTail,
+            BaseRotationLimit);
+        bMemoHit = MemoData.TryRestore(Items, SettingsHash,
+                                       EffectorTransform.GetLocation(),
+                                       PoleTarget, CCDIKChain);
+        if (!bMemoHit) {
+            MemoData.CaptureInputs(Items, SettingsHash,
+                                   EffectorTransform.GetLocation(), PoleTarget,
+                                   CCDIKChain);
         }
     }
-    // CCDIK结果写回BonePositions用于pole修正
-    TArray<FVector> BonePositions;
-    BonePositions.SetNum(NumChainLinks);
-    for (int32 i = 0; i < NumChainLinks; ++i) {
-        BonePositions[i] = CCDIKChain[i].Transform.GetLocation();
-    }
-    // CCD IK后，pole target平面修正
-    FVector RootPosition = BonePositions[0];
-    FVector PlaneNormal =
-        FVector::CrossProduct(EffectorTransform.GetLocation() - RootPosition,
-                              PoleTarget - RootPosition)
-            .GetSafeNormal();
-    if (PlaneNormal.IsZero()) {
-        FVector BaseVector =
-            (EffectorTransform.GetLocation() - RootPosition).GetSafeNormal();
-        if (FMath::Abs(BaseVector.Z) < 0.9f) {
-            PlaneNormal = FVector::CrossProduct(BaseVector, FVector(0, 0, 1))
-                              .GetSafeNormal();
-        } else {
-            PlaneNormal = FVector::CrossProduct(BaseVector, FVector(1, 0, 0))
-                              .GetSafeNormal();
+    if (!bMemoHit) {
+        // Rotation limits
+        TArray<float>& RotationLimitsPerJoint = WorkData.RotationLimitsPerItem;
+        RotationLimitsPerJoint.SetNum(NumChainLinks);
+        for (int32 i = 0; i < NumChainLinks; ++i) {
+            RotationLimitsPerJoint[i] = BaseRotationLimit;
+        }
+        // 热启动：从上一帧的解开始迭代
+        if (bWarmStart) {
+            WarmStartData.Apply(Items, CCDIKChain);
+        }
+        // CCDIK算法主流程（官方实现，带迭代预算）
+        IterationsUsed = PoleTargetIKSolver::SolveCCDIKWithBudget(
+            CCDIKChain, EffectorTransform.GetLocation(),
+            Precision > 0.f ? Precision : 0.001f,
+            MaxIterations > 0 ? MaxIterations : 10, EarlyStopThreshold,
+            bStartFromTail, RotationLimitsPerJoint);
+        if (bWarmStart) {
+            WarmStartData.Store(Items, CCDIKChain);
+        }
+        if (bMemoizeUnchangedInputs) {
+            MemoData.StoreResult(CCDIKChain);
         }
     }
+    // CCD IK后，pole target平面修正（在链条上完成，和CCDIK结果一起写回）
+    ApplyPolePlaneCorrection_RootOnly(CCDIKChain, PoleTarget, Weight);
 
-    ApplyPolePlaneCorrection_RootOnly(BonePositions, PoleTarget, Hierarchy,
-                                      WorkData.CachedItems, Weight,
-                                      bPropagateToChildren);
+    // 一次性写回Hierarchy（位置+旋转），与 IKWithPole 一样始终带动子骨骼
+    PoleTargetIKSolver::WriteChainToHierarchy(Hierarchy, WorkData.CachedItems,
+                                              CCDIKChain, true);
 }
\ No newline at end of file
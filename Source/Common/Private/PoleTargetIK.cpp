@@ -5,129 +5,220 @@
 #include "ControlRig.h"
 #include "Math/UnrealMathSSE.h"
 #include "Math/Vector.h"
+#include "PoleTargetSolverCore.h"
 #include "RigVMDeveloper/Public/RigVMModel/RigVMFunctionLibrary.h"
 #include "Rigs/RigHierarchy.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(PoleTargetIK)
 
-// 辅助方法：在平面上找到与primary axis垂直的点
-static FVector FindPointOnPlanePerpendicularToAxis(
-    const FVector& PointOnPlane,    // 当前关节位置
-    const FVector& PlaneNormal,     // 平面法线
-    const FVector& PrimaryAxisDir,  // primary axis方向（指向下一个关节）
-    const FVector& PoleTarget,      // pole target位置
-    float Distance = 100.0f)        // 偏移距离
-{
-    // 确保primary axis方向与平面法线不平行
-    FVector PrimaryDirNormalized = PrimaryAxisDir.GetSafeNormal();
-
-    // 计算一个在平面内且垂直于primary axis的方向
-    // 方法：平面法线 × primary axis方向
-    FVector PerpendicularInPlane =
-        FVector::CrossProduct(PlaneNormal, PrimaryDirNormalized);
-    PerpendicularInPlane.Normalize();
-
-    // 检查这个方向是否朝向pole target所在的一侧
-    FVector ToPoleTarget = (PoleTarget - PointOnPlane).GetSafeNormal();
-    float DotWithTarget =
-        FVector::DotProduct(PerpendicularInPlane, ToPoleTarget);
-
-    // 如果点积为负，说明方向相反，需要翻转
-    if (DotWithTarget < 0) {
-        PerpendicularInPlane = -PerpendicularInPlane;
+bool FRigUnit_PoleTargetIK_WarmStartData::Apply(
+    const TArray<FRigElementKey>& InItems,
+    TArray<FCCDIKChainLink>& Chain) const {
+    if (SolvedTransforms.Num() != Chain.Num() || Chain.Num() < 2 ||
+        SolvedKeys != InItems) {
+        return false;
     }
 
-    // 在平面上沿垂直方向移动指定距离，得到second axis点
-    return PointOnPlane + PerpendicularInPlane * Distance;
+    // 根骨骼位置保持当前帧的值，其余关节随根骨骼平移
+    const FVector RootOffset =
+        Chain[0].Transform.GetLocation() - SolvedTransforms[0].GetLocation();
+    for (int32 i = 0; i < Chain.Num(); ++i) {
+        FTransform WarmTransform = SolvedTransforms[i];
+        WarmTransform.AddToTranslation(RootOffset);
+        Chain[i].Transform = WarmTransform;
+        Chain[i].LocalTransform =
+            i > 0 ? WarmTransform.GetRelativeTransform(Chain[i - 1].Transform)
+                  : WarmTransform;
+        Chain[i].CurrentAngleDelta = 0.0;
+    }
+    return true;
+}
+
+void FRigUnit_PoleTargetIK_WarmStartData::Store(
+    const TArray<FRigElementKey>& InItems,
+    const TArray<FCCDIKChainLink>& Chain) {
+    if (SolvedKeys != InItems) {
+        SolvedKeys = InItems;
+    }
+    SolvedTransforms.SetNumUninitialized(Chain.Num());
+    for (int32 i = 0; i < Chain.Num(); ++i) {
+        SolvedTransforms[i] = Chain[i].Transform;
+    }
+}
+
+void FRigUnit_PoleTargetIK_WarmStartData::Reset() {
+    SolvedKeys.Reset();
+    SolvedTransforms.Reset();
 }
 
-// 辅助方法：计算参考平面法线（基于根、末端和pole target）
-static FVector CalculateReferencePlaneNormalOld(const FVector& RootPosition,
-                                                const FVector& EffectorPosition,
-                                                const FVector& PoleTarget) {
-    // 计算平面法线： (末端-根) × (pole target-根)
-    FVector PlaneNormal =
-        FVector::CrossProduct((EffectorPosition - RootPosition).GetSafeNormal(),
-                              (PoleTarget - RootPosition).GetSafeNormal());
-
-    // 如果叉积结果太小（共线），使用备用方案
-    if (PlaneNormal.IsNearlyZero(KINDA_SMALL_NUMBER)) {
-        FVector RootToEffector =
-            (EffectorPosition - RootPosition).GetSafeNormal();
-
-        // 尝试与上向量叉积
-        PlaneNormal = FVector::CrossProduct(RootToEffector, FVector::UpVector);
-
-        // 如果还是太小，尝试与前向量叉积
-        if (PlaneNormal.IsNearlyZero(KINDA_SMALL_NUMBER)) {
-            PlaneNormal =
-                FVector::CrossProduct(RootToEffector, FVector::ForwardVector);
+bool FRigUnit_PoleTargetIK_MemoData::TryRestore(
+    const TArray<FRigElementKey>& InItems, uint32 InSettingsHash,
+    const FVector& InEffectorPosition, const FVector& InPoleTarget,
+    TArray<FCCDIKChainLink>& Chain) const {
+    if (!bHasResult || SettingsHash != InSettingsHash ||
+        InputTransforms.Num() != Chain.Num() ||
+        OutputTransforms.Num() != Chain.Num() ||
+        !EffectorPosition.Equals(InEffectorPosition, KINDA_SMALL_NUMBER) ||
+        !PoleTarget.Equals(InPoleTarget, KINDA_SMALL_NUMBER) ||
+        Keys != InItems) {
+        return false;
+    }
+    for (int32 i = 0; i < Chain.Num(); ++i) {
+        if (!InputTransforms[i].Equals(Chain[i].Transform,
+                                       KINDA_SMALL_NUMBER)) {
+            return false;
         }
     }
 
-    return PlaneNormal.GetSafeNormal();
+    for (int32 i = 0; i < Chain.Num(); ++i) {
+        Chain[i].Transform = OutputTransforms[i];
+        if (i > 0) {
+            Chain[i].LocalTransform = OutputTransforms[i].GetRelativeTransform(
+                OutputTransforms[i - 1]);
+        }
+    }
+    return true;
+}
+
+void FRigUnit_PoleTargetIK_MemoData::CaptureInputs(
+    const TArray<FRigElementKey>& InItems, uint32 InSettingsHash,
+    const FVector& InEffectorPosition, const FVector& InPoleTarget,
+    const TArray<FCCDIKChainLink>& Chain) {
+    if (Keys != InItems) {
+        Keys = InItems;
+    }
+    SettingsHash = InSettingsHash;
+    EffectorPosition = InEffectorPosition;
+    PoleTarget = InPoleTarget;
+    InputTransforms.SetNumUninitialized(Chain.Num());
+    for (int32 i = 0; i < Chain.Num(); ++i) {
+        InputTransforms[i] = Chain[i].Transform;
+    }
+    bHasResult = false;
+}
+
+void FRigUnit_PoleTargetIK_MemoData::StoreResult(
+    const TArray<FCCDIKChainLink>& Chain) {
+    if (InputTransforms.Num() != Chain.Num()) {
+        return;
+    }
+    OutputTransforms.SetNumUninitialized(Chain.Num());
+    for (int32 i = 0; i < Chain.Num(); ++i) {
+        OutputTransforms[i] = Chain[i].Transform;
+    }
+    bHasResult = true;
+}
+
+void FRigUnit_PoleTargetIK_MemoData::Reset() {
+    Keys.Reset();
+    InputTransforms.Reset();
+    OutputTransforms.Reset();
+    bHasResult = false;
 }
 
-static FTransform BuildTransformFromAxisDirections(
-    const FVector& Origin, const FVector& PrimaryAxisPoint,
-    const FVector& SecondaryAxisPoint, const FVector& PrimaryAxis,
-    const FVector& SecondaryAxis) {
-    // 计算世界空间方向
-    FVector WorldPrimaryDir = (PrimaryAxisPoint - Origin).GetSafeNormal();
-    FVector WorldSecondaryDir = (SecondaryAxisPoint - Origin).GetSafeNormal();
-
-    // 正交化世界方向
-    float Dot = FVector::DotProduct(WorldPrimaryDir, WorldSecondaryDir);
-    WorldSecondaryDir =
-        (WorldSecondaryDir - WorldPrimaryDir * Dot).GetSafeNormal();
-
-    // 使用UE的RotationFromXZ或类似函数
-    // 但更通用的是：
-
-    // 1. 先对齐主轴
-    FQuat Rotation =
-        FQuat::FindBetweenNormals(PrimaryAxis.GetSafeNormal(), WorldPrimaryDir);
-
-    // 2. 检查次轴对齐情况
-    FVector CurrentSecondary =
-        Rotation.RotateVector(SecondaryAxis.GetSafeNormal());
-    float Alignment = FVector::DotProduct(CurrentSecondary, WorldSecondaryDir);
-
-    // 如果对齐度不够好，可以尝试优化
-    if (Alignment < 0.99f) {
-        // 可以应用一个额外的绕主轴的小旋转来改进
-        float Angle = FMath::Acos(FMath::Clamp(Alignment, -1.0f, 1.0f));
-        FQuat AdditionalRotation = FQuat(WorldPrimaryDir, Angle);
-        Rotation = AdditionalRotation * Rotation;
+int32 PoleTargetIKSolver::SolveCCDIKWithBudget(
+    TArray<FCCDIKChainLink>& Chain, const FVector& TargetPosition,
+    float Precision, int32 MaxIterations, float EarlyStopThreshold,
+    bool bStartFromTail, const TArray<float>& RotationLimitsPerJoint) {
+    if (Chain.Num() < 2) {
+        return 0;
+    }
+
+    int32 Iterations = 0;
+    FVector PreviousTipPosition = Chain.Last().Transform.GetLocation();
+    while (Iterations < MaxIterations &&
+           FVector::Dist(PreviousTipPosition, TargetPosition) > Precision) {
+        // 每次只跑一轮，便于统计迭代次数和提前结束
+        AnimationCore::SolveCCDIK(Chain, TargetPosition, Precision, 1,
+                                  bStartFromTail,
+                                  false,  // bEnableRotationLimit
+                                  RotationLimitsPerJoint);
+        ++Iterations;
+
+        const FVector TipPosition = Chain.Last().Transform.GetLocation();
+        const bool bStalled =
+            EarlyStopThreshold > 0.0f &&
+            FVector::Dist(TipPosition, PreviousTipPosition) <
+                EarlyStopThreshold;
+        PreviousTipPosition = TipPosition;
+        if (bStalled) {
+            break;
+        }
+    }
+    return Iterations;
+}
+
+void PoleTargetIKSolver::WriteChainToHierarchy(
+    URigHierarchy* Hierarchy, TArrayView<const FCachedRigElement> CachedItems,
+    TArrayView<const FCCDIKChainLink> Chain, bool bPropagateToChildren) {
+    const int32 NumLinks = FMath::Min(CachedItems.Num(), Chain.Num());
+    if (!Hierarchy || NumLinks == 0) {
+        return;
+    }
+
+    // 不传播：子元素保持全局变换，从根到末端依次写入即可
+    if (!bPropagateToChildren) {
+        for (int32 i = 0; i < NumLinks; ++i) {
+            if (CachedItems[i].IsValid()) {
+                Hierarchy->SetGlobalTransform(CachedItems[i].GetIndex(),
+                                              Chain[i].Transform, false,
+                                              false);
+            }
+        }
+        return;
     }
 
-    FTransform Result;
-    Result.SetLocation(Origin);
-    Result.SetRotation(Rotation.GetNormalized());
+    bool bDirectParentChain = CachedItems[0].IsValid();
+    for (int32 i = 1; i < NumLinks && bDirectParentChain; ++i) {
+        bDirectParentChain =
+            CachedItems[i].IsValid() &&
+            Hierarchy->GetFirstParent(CachedItems[i].GetIndex()) ==
+                CachedItems[i - 1].GetIndex();
+    }
+
+    if (!bDirectParentChain) {
+        for (int32 i = 0; i < NumLinks; ++i) {
+            if (CachedItems[i].IsValid()) {
+                Hierarchy->SetGlobalTransform(CachedItems[i].GetIndex(),
+                                              Chain[i].Transform, false, true);
+            }
+        }
+        return;
+    }
 
-    return Result;
+    // 链内骨骼只写相对上一节的局部变换，最后写根骨骼全局变换，
+    // 整条链和链外后代在下次读取时统一重算
+    for (int32 i = NumLinks - 1; i > 0; --i) {
+        Hierarchy->SetLocalTransform(
+            CachedItems[i].GetIndex(),
+            Chain[i].Transform.GetRelativeTransform(Chain[i - 1].Transform),
+            false, true);
+    }
+    Hierarchy->SetGlobalTransform(CachedItems[0].GetIndex(),
+                                  Chain[0].Transform, false, true);
 }
 
 // 主修正方法
-static void ApplySecondaryAxisCorrection(
+void PoleTargetIKSolver::ApplySecondaryAxisCorrection(
     TArray<FCCDIKChainLink>& Chain, const FVector& EffectorPosition,
     const FVector& PoleTarget,
     const FVector& PrimaryAxis,    // 主轴方向，如(1,0,0)
     const FVector& SecondaryAxis,  // 次轴方向，如(0,1,0)
-    float CorrectionWeight = 1.0f, float SecondaryAxisDistance = 50.0f) {
+    float CorrectionWeight) {
     if (Chain.Num() < 2 || CorrectionWeight < KINDA_SMALL_NUMBER) return;
 
     FVector RootPosition = Chain[0].Transform.GetLocation();
 
     // 1. 计算参考平面法线
-    FVector PlaneNormal = CalculateReferencePlaneNormalOld(
+    FVector PlaneNormal = PoleTargetSolverCore::CalculateReferencePlaneNormal(
         RootPosition, EffectorPosition, PoleTarget);
 
     if (PlaneNormal.IsNearlyZero()) return;
 
-    // 2. 保存原始位置和缩放
-    TArray<FVector> OriginalPositions;
-    TArray<FVector> OriginalScales;
+    // 2. 保存原始位置和缩放（临时数组使用内联存储）
+    using PoleTargetSolverCore::TChainScratchArray;
+    TChainScratchArray<FVector> OriginalPositions;
+    TChainScratchArray<FVector> OriginalScales;
     OriginalPositions.SetNum(Chain.Num());
     OriginalScales.SetNum(Chain.Num());
 
@@ -137,49 +228,18 @@ static void ApplySecondaryAxisCorrection(
     }
 
     // 3. 为每个关节计算目标Transform
-    TArray<FTransform> TargetTransforms;
+    TChainScratchArray<FTransform> TargetTransforms;
     TargetTransforms.SetNum(Chain.Num());
 
+    // 主轴指向下一个关节，次轴在平面内朝向pole target
+    using FSolver = PoleTargetSolverCore::FSecondaryAxisSolver;
+    const PoleTargetSolverCore::FLocalAxisBasis LocalBasis(PrimaryAxis,
+                                                           SecondaryAxis);
     for (int32 i = 0; i < Chain.Num(); ++i) {
-        FVector CurrentPosition = OriginalPositions[i];
-
-        // 确定primary axis方向点
-        FVector PrimaryAxisPoint;
-
-        if (i < Chain.Num() - 1) {
-            // 有下一个关节：primary axis指向下一个关节
-            PrimaryAxisPoint = OriginalPositions[i + 1];
-        } else {
-            // 最后一个关节：使用前一个关节的方向
-            if (i > 0) {
-                FVector PrevToCurrent =
-                    (CurrentPosition - OriginalPositions[i - 1])
-                        .GetSafeNormal();
-                PrimaryAxisPoint =
-                    CurrentPosition + PrevToCurrent * 50.0f;  // 虚拟点
-            } else {
-                // 只有一个关节的情况（不应该发生）
-                TargetTransforms[i] = Chain[i].Transform;
-                continue;
-            }
-        }
-
-        // 计算secondary axis方向点
-        // 首先计算主轴在世界空间中的方向
-        FVector WorldPrimaryDir =
-            (PrimaryAxisPoint - CurrentPosition).GetSafeNormal();
-
-        // 在平面上找到与主轴垂直且朝向pole target的方向
-        FVector SecondaryAxisPoint = FindPointOnPlanePerpendicularToAxis(
-            CurrentPosition, PlaneNormal, WorldPrimaryDir, PoleTarget,
-            SecondaryAxisDistance);
-
-        // 使用新的方法构建Transform
-        TargetTransforms[i] = BuildTransformFromAxisDirections(
-            CurrentPosition, PrimaryAxisPoint, SecondaryAxisPoint,
-            PrimaryAxis,   // 传入的主轴参数
-            SecondaryAxis  // 传入的次轴参数
-        );
+        TargetTransforms[i].SetLocation(OriginalPositions[i]);
+        TargetTransforms[i].SetRotation(FSolver::SolveJointRotation(
+            OriginalPositions[i], FSolver::GetPrimaryAxisPoint(Chain, i),
+            PlaneNormal, PoleTarget, LocalBasis));
 
         // 保持原始缩放
         TargetTransforms[i].SetScale3D(OriginalScales[i]);
@@ -246,12 +306,13 @@ static void ApplySecondaryAxisCorrection(
 }
 
 FRigUnit_IKWithPole_Execute() {
+    IterationsUsed = 0;
     URigHierarchy* Hierarchy = ExecuteContext.Hierarchy;
     if (!Hierarchy) {
         return;
     }
-    // 骨骼链准备
-    WorkData.CachedItems.Empty();
+    // 骨骼链准备（WorkData中的数组跨帧保留容量）
+    WorkData.CachedItems.Reset();
     if (Items.Num() < 2) {
         return;
     }
@@ -270,7 +331,7 @@ FRigUnit_IKWithPole_Execute() {
         return;
     }
     // 构造CCDIK链
-    TArray<FCCDIKChainLink> CCDIKChain;
+    TArray<FCCDIKChainLink>& CCDIKChain = WorkData.Chain;
     CCDIKChain.SetNum(NumChainLinks);
     for (int32 i = 0; i < NumChainLinks; ++i) {
         const FCachedRigElement& CachedBone = WorkData.CachedItems[i];
@@ -278,63 +339,65 @@ FRigUnit_IKWithPole_Execute() {
             Hierarchy->GetGlobalTransform(CachedBone.GetIndex());
         CCDIKChain[i].Transform = BoneTransform;
         if (i > 0) {
-            const FCachedRigElement& ParentBone = WorkData.CachedItems[i - 1];
-            FTransform ParentTransform =
-                Hierarchy->GetGlobalTransform(ParentBone.GetIndex());
-            CCDIKChain[i].LocalTransform =
-                BoneTransform.GetRelativeTransform(ParentTransform);
+            // 父骨骼刚读过，不再重复查询层级
+            CCDIKChain[i].LocalTransform = BoneTransform.GetRelativeTransform(
+                CCDIKChain[i - 1].Transform);
         } else {
             CCDIKChain[i].LocalTransform = BoneTransform;
         }
         CCDIKChain[i].CurrentAngleDelta = 0.0;
     }
-    // Rotation limits
-    TArray<float> RotationLimitsPerJoint;
-    RotationLimitsPerJoint.SetNum(NumChainLinks);
-    for (int32 i = 0; i < NumChainLinks; ++i) {
-        RotationLimitsPerJoint[i] = BaseRotationLimit;
-    }
-    // CCDIK算法主流程（官方实现）
-    AnimationCore::SolveCCDIK(CCDIKChain, EffectorTransform.GetLocation(),
-                              Precision > 0.f ? Precision : 0.001f,
-                              MaxIterations > 0 ? MaxIterations : 10,
-                              bStartFromTail,
-                              false,  // bEnableRotationLimit
-                              RotationLimitsPerJoint);
-    // CCDIK结果写回BonePositions
-    TArray<FVector> BonePositions;
-    BonePositions.SetNum(NumChainLinks);
-    for (int32 i = 0; i < NumChainLinks; ++i) {
-        BonePositions[i] = CCDIKChain[i].Transform.GetLocation();
-    }
-
-    if (bUseSecondaryAxisCorrection) {
-        ApplySecondaryAxisCorrection(
-            CCDIKChain, EffectorTransform.GetLocation(), PoleTarget,
-            PrimaryAxis, SecondAxis, Weight);
+    // 输入与上一次求解相同时直接复用结果，跳过迭代
+    bool bMemoHit = false;
+    uint32 SettingsHash = 0;
+    if (bMemoizeUnchangedInputs) {
+        SettingsHash = FRigUnit_PoleTargetIK_MemoData::HashSettings(
+            PrimaryAxis, SecondAxis, bUseSecondaryAxisCorrection, Weight,
+            Precision, MaxIterations, EarlyStopThreshold, bStartFromTail,
+            BaseRotationLimit);
+        bMemoHit = MemoData.TryRestore(Items, SettingsHash,
+                                       EffectorTransform.GetLocation(),
+                                       PoleTarget, CCDIKChain);
+        if (!bMemoHit) {
+            MemoData.CaptureInputs(Items, SettingsHash,
+                                   EffectorTransform.GetLocation(), PoleTarget,
+                                   CCDIKChain);
+        }
     }
+    if (!bMemoHit) {
+        // Rotation limits
+        TArray<float>& RotationLimitsPerJoint = WorkData.RotationLimitsPerItem;
+        RotationLimitsPerJoint.SetNum(NumChainLinks);
+        for (int32 i = 0; i < NumChainLinks; ++i) {
+            RotationLimitsPerJoint[i] = BaseRotationLimit;
+        }
+        // 热启动：从上一帧的解开始迭代
+        if (bWarmStart) {
+            WarmStartData.Apply(Items, CCDIKChain);
+        }
+        // CCDIK算法主流程（官方实现，带迭代预算）
+        IterationsUsed = PoleTargetIKSolver::SolveCCDIKWithBudget(
+            CCDIKChain, EffectorTransform.GetLocation(),
+            Precision > 0.f ? Precision : 0.001f,
+            MaxIterations > 0 ? MaxIterations : 10, EarlyStopThreshold,
+            bStartFromTail, RotationLimitsPerJoint);
+        if (bWarmStart) {
+            WarmStartData.Store(Items, CCDIKChain);
+        }
 
-    // 写回Hierarchy
-    for (int32 i = 0; i < NumChainLinks; ++i) {
-        const FCachedRigElement& CachedBone = WorkData.CachedItems[i];
-        if (CachedBone.IsValid()) {
-            // 检查这个骨骼是否在我们的链中（防止传播到外部）
-            bool bIsInOurChain = false;
-            for (int32 j = 0; j < WorkData.CachedItems.Num(); ++j) {
-                if (WorkData.CachedItems[j].GetKey() == CachedBone.GetKey()) {
-                    bIsInOurChain = true;
-                    break;
-                }
-            }
+        if (bUseSecondaryAxisCorrection) {
+            PoleTargetIKSolver::ApplySecondaryAxisCorrection(
+                CCDIKChain, EffectorTransform.GetLocation(), PoleTarget,
+                PrimaryAxis, SecondAxis, Weight);
+        }
 
-            if (bIsInOurChain) {
-                // 对于链内的骨骼，不需要传播，因为我们会按顺序设置
-                Hierarchy->SetGlobalTransform(
-                    CachedBone.GetKey(), CCDIKChain[i].Transform,
-                    false,   // bInitial
-                    true,    // bAffectChildren
-                    false);  // bPropagateToChildren - 设为false!
-            }
+        if (bMemoizeUnchangedInputs) {
+            MemoData.StoreResult(CCDIKChain);
         }
     }
+
+    // 写回Hierarchy（始终带动子骨骼；基类的 bPropagateToChildren 默认为
+    // false，此节点一直忽略它，保持已有资产的结果不变）
+    PoleTargetIKSolver::WriteChainToHierarchy(Hierarchy, WorkData.CachedItems,
+                                              CCDIKChain, true);
 }
\ No newline at end of file
@@ -2,9 +2,19 @@
 
 #include "ArcDistributedIK.h"
 
+#include "ArcDistributedIKBatch.h"
+#include "ControlRig.h"
 #include "ControlRig/Public/Units/Highlevel/Hierarchy/RigUnit_CCDIK.h"
 #include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
 #include "Misc/AutomationTest.h"
+#include "PoleTargetIK.h"
+#include "PoleTargetSolverCore.h"
+#include "Rigs/RigHierarchy.h"
+#include "Rigs/RigHierarchyController.h"
+#include "ScopedAllocationCounter.h"
+#include "UObject/StrongObjectPtr.h"
 
 #if WITH_AUTOMATION_TESTS
 
@@ -1238,4 +1248,664 @@ bool FArcDistributedIK_SolveOptimalAngleWithNewton::RunTest(
     return true;
 }
 
+/**
+ * 测试：闭式圆弧求解 vs FABRIK
+ * 对3~4节的手指链在可达范围内随机取目标，比较末端误差、骨骼长度保持和耗时
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+    FArcDistributedIK_ClosedFormVsFABRIK,
+    "MusicDoll.IK.ArcDistributed.ClosedFormVsFABRIK",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FArcDistributedIK_ClosedFormVsFABRIK::RunTest(const FString& Parameters) {
+    const int32 NumCases = 500;
+    const float Precision = 0.001f;
+    const int32 MaxIterations = 10;
+    FRandomStream Random(20240601);
+
+    int32 SolvedCount = 0;
+    double MaxClosedFormError = 0.0;
+    double MaxFABRIKError = 0.0;
+    double MaxLengthError = 0.0;
+    uint64 ClosedFormCycles = 0;
+    uint64 FABRIKCycles = 0;
+
+    for (int32 CaseIndex = 0; CaseIndex < NumCases; ++CaseIndex) {
+        const int32 NumLinks = Random.RandRange(3, 4);
+
+        // 初始姿态：沿X轴伸直
+        TArray<FCCDIKChainLink> Chain;
+        TArray<float> BoneLengths;
+        float TotalChainLength = 0.0f;
+        FVector Position = FVector::ZeroVector;
+        for (int32 i = 0; i < NumLinks; ++i) {
+            FCCDIKChainLink Link;
+            Link.Transform.SetLocation(Position);
+            Chain.Add(Link);
+
+            const float Length =
+                (i < NumLinks - 1) ? Random.FRandRange(2.5f, 4.5f) : 0.0f;
+            BoneLengths.Add(Length);
+            TotalChainLength += Length;
+            Position += FVector(Length, 0.0f, 0.0f);
+        }
+
+        // 目标在pole平面内、可达范围内
+        const float TargetDistance =
+            TotalChainLength * Random.FRandRange(0.4f, 0.95f);
+        const float TargetAngle =
+            FMath::DegreesToRadians(Random.FRandRange(-60.0f, 60.0f));
+        const FVector EffectorPosition =
+            FVector(FMath::Cos(TargetAngle), 0.0f, FMath::Sin(TargetAngle)) *
+            TargetDistance;
+        const FVector PoleTarget =
+            EffectorPosition * 0.5f + FVector(0.0f, 10.0f, 0.0f);
+        const FVector PlaneNormal =
+            FVector::CrossProduct(EffectorPosition.GetSafeNormal(),
+                                  PoleTarget.GetSafeNormal())
+                .GetSafeNormal();
+
+        TArray<FCCDIKChainLink> ClosedFormChain = Chain;
+        uint64 StartCycles = FPlatformTime::Cycles64();
+        const bool bSolved = ArcDistributedIKSolver::SolveArcClosedForm(
+            ClosedFormChain, BoneLengths, TotalChainLength, EffectorPosition,
+            PlaneNormal, Precision);
+        ClosedFormCycles += FPlatformTime::Cycles64() - StartCycles;
+
+        TArray<FCCDIKChainLink> FABRIKChain = Chain;
+        StartCycles = FPlatformTime::Cycles64();
+        ArcDistributedIKSolver::SolveArcFABRIK(
+            FABRIKChain, BoneLengths, EffectorPosition, PoleTarget,
+            PlaneNormal, Precision, MaxIterations);
+        FABRIKCycles += FPlatformTime::Cycles64() - StartCycles;
+
+        MaxFABRIKError = FMath::Max(
+            MaxFABRIKError,
+            FVector::Dist(FABRIKChain.Last().Transform.GetLocation(),
+                          EffectorPosition));
+
+        if (!bSolved) {
+            continue;
+        }
+        SolvedCount++;
+
+        MaxClosedFormError = FMath::Max(
+            MaxClosedFormError,
+            FVector::Dist(ClosedFormChain.Last().Transform.GetLocation(),
+                          EffectorPosition));
+
+        for (int32 i = 0; i < NumLinks - 1; ++i) {
+            const double Length =
+                FVector::Dist(ClosedFormChain[i].Transform.GetLocation(),
+                              ClosedFormChain[i + 1].Transform.GetLocation());
+            MaxLengthError =
+                FMath::Max(MaxLengthError, FMath::Abs(Length - BoneLengths[i]));
+        }
+
+        // 圆弧应与FABRIK路径弯向同一侧（pole一侧）
+        const FVector BendDir =
+            FVector::CrossProduct(PlaneNormal, EffectorPosition.GetSafeNormal());
+        TestTrue(TEXT("闭式解应弯向pole一侧"),
+                 FVector::DotProduct(
+                     ClosedFormChain[1].Transform.GetLocation(), BendDir) >
+                     0.0);
+    }
+
+    const double ClosedFormNs =
+        FPlatformTime::ToMilliseconds64(ClosedFormCycles) * 1.0e6 / NumCases;
+    const double FABRIKNs =
+        FPlatformTime::ToMilliseconds64(FABRIKCycles) * 1.0e6 / NumCases;
+
+    AddInfo(FString::Printf(
+        TEXT("Closed-form: %d/%d solved, max error %.6f, max length error "
+             "%.6f, %.1f ns/solve"),
+        SolvedCount, NumCases, MaxClosedFormError, MaxLengthError,
+        ClosedFormNs));
+    AddInfo(FString::Printf(TEXT("FABRIK: max error %.6f, %.1f ns/solve"),
+                            MaxFABRIKError, FABRIKNs));
+
+    // 两节且长度差异较大的链在目标很近时需要超过半圆的弦，交给FABRIK
+    TestTrue(TEXT("手指范围内的目标绝大多数应由闭式解求得"),
+             SolvedCount >= NumCases * 95 / 100);
+    TestTrue(TEXT("闭式解末端误差应小于Precision"),
+             MaxClosedFormError <= Precision);
+    TestTrue(TEXT("闭式解应保持骨骼长度"), MaxLengthError < 1.0e-3);
+    TestTrue(TEXT("闭式解精度不应低于FABRIK"),
+             MaxClosedFormError <= MaxFABRIKError + KINDA_SMALL_NUMBER);
+
+    return true;
+}
+
+/**
+ * 测试：求解核心的策略分支
+ * 次轴修正策略的次轴朝向pole，圆弧策略的次轴背离参考点，两者主轴都精确对齐
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPoleTargetSolverCore_PolicyAxes,
+                                 "MusicDoll.IK.SolverCore.PolicyAxes",
+                                 EAutomationTestFlags::EditorContext |
+                                     EAutomationTestFlags::EngineFilter)
+
+bool FPoleTargetSolverCore_PolicyAxes::RunTest(const FString& Parameters) {
+    using namespace PoleTargetSolverCore;
+
+    const FVector LocalPrimary(1.0f, 0.0f, 0.0f);
+    const FVector LocalSecondary(0.0f, 1.0f, 0.0f);
+    const FLocalAxisBasis LocalBasis(LocalPrimary, LocalSecondary);
+    const float Tolerance = 1.0e-3f;
+
+    FRandomStream Random(20240611);
+    bool bAllPrimaryAligned = true;
+    bool bAllTowardPole = true;
+    bool bAllAwayFromReference = true;
+    bool bAllInPlane = true;
+
+    for (int32 Case = 0; Case < 200; ++Case) {
+        const FVector Root = Random.GetUnitVector() * 5.0f;
+        const FVector Effector = Root + Random.GetUnitVector() * 8.0f;
+        const FVector Pole = (Root + Effector) * 0.5f +
+                             Random.GetUnitVector() * 6.0f;
+        const FVector PlaneNormal =
+            CalculateReferencePlaneNormal(Root, Effector, Pole);
+        const FVector Middle = (Root + Effector) * 0.5f;
+
+        const FQuat IKRotation = FSecondaryAxisSolver::SolveJointRotation(
+            Root, Middle, PlaneNormal, Pole, LocalBasis);
+        const FQuat ArcRotation = FArcDistributionSolver::SolveJointRotation(
+            Root, Middle, PlaneNormal, Pole, LocalBasis);
+
+        const FVector WorldPrimary = (Middle - Root).GetSafeNormal();
+        const FVector IKSecondary = IKRotation.RotateVector(LocalSecondary);
+        const FVector ArcSecondary = ArcRotation.RotateVector(LocalSecondary);
+
+        bAllPrimaryAligned &=
+            IKRotation.RotateVector(LocalPrimary).Equals(WorldPrimary,
+                                                         Tolerance) &&
+            ArcRotation.RotateVector(LocalPrimary).Equals(WorldPrimary,
+                                                          Tolerance);
+        bAllInPlane &=
+            FMath::Abs(FVector::DotProduct(IKSecondary, PlaneNormal)) <
+                Tolerance &&
+            FMath::Abs(FVector::DotProduct(ArcSecondary, PlaneNormal)) <
+                Tolerance;
+        bAllTowardPole &= FVector::DotProduct(IKSecondary, Pole - Root) >= 0.0f;
+        bAllAwayFromReference &=
+            FVector::DotProduct(ArcSecondary, Pole - Root) <= 0.0f;
+    }
+
+    TestTrue(TEXT("两种策略的主轴都应精确指向下一个关节"), bAllPrimaryAligned);
+    TestTrue(TEXT("次轴应位于参考平面内"), bAllInPlane);
+    TestTrue(TEXT("次轴修正策略的次轴应朝向pole"), bAllTowardPole);
+    TestTrue(TEXT("圆弧策略的次轴应背离参考点"), bAllAwayFromReference);
+
+    return true;
+}
+
+/**
+ * 测试：逐次求解不产生堆分配
+ * 链条和骨骼长度由调用方预先分配（RigUnit中保存在WorkData里跨帧复用），
+ * 求解过程中的临时数组都应落在内联存储中
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPoleTargetIK_ZeroAllocationSolve,
+                                 "MusicDoll.IK.SolverCore.ZeroAllocationSolve",
+                                 EAutomationTestFlags::EditorContext |
+                                     EAutomationTestFlags::EngineFilter)
+
+bool FPoleTargetIK_ZeroAllocationSolve::RunTest(const FString& Parameters) {
+    const int32 NumLinks = 4;
+    const float Precision = 0.001f;
+    const int32 MaxIterations = 10;
+    const FVector PrimaryAxis(1.0f, 0.0f, 0.0f);
+    const FVector SecondaryAxis(0.0f, 1.0f, 0.0f);
+
+    TArray<FCCDIKChainLink> RestChain;
+    TArray<float> BoneLengths;
+    TArray<float> RotationLimits;
+    float TotalChainLength = 0.0f;
+    for (int32 i = 0; i < NumLinks; ++i) {
+        FCCDIKChainLink Link;
+        Link.Transform.SetLocation(FVector(TotalChainLength, 0.0f, 0.0f));
+        RestChain.Add(Link);
+        const float Length = (i < NumLinks - 1) ? 3.0f : 0.0f;
+        BoneLengths.Add(Length);
+        RotationLimits.Add(30.0f);
+        TotalChainLength += Length;
+    }
+    TArray<FCCDIKChainLink> Chain = RestChain;
+
+    FRandomStream Random(20240612);
+    int32 AllocationCount = 0;
+    {
+        FScopedAllocationCounter Counter;
+        for (int32 Case = 0; Case < 100; ++Case) {
+            const float TargetAngle =
+                FMath::DegreesToRadians(Random.FRandRange(-60.0f, 60.0f));
+            const FVector EffectorPosition =
+                FVector(FMath::Cos(TargetAngle), 0.0f,
+                        FMath::Sin(TargetAngle)) *
+                TotalChainLength * Random.FRandRange(0.4f, 0.95f);
+            const FVector PoleTarget =
+                EffectorPosition * 0.5f + FVector(0.0f, 10.0f, 0.0f);
+            const FVector PlaneNormal =
+                ArcDistributedIKSolver::CalculateReferencePlaneNormal(
+                    FVector::ZeroVector, EffectorPosition, PoleTarget);
+
+            // ArcDistributedIK：闭式解 + FABRIK回退 + 旋转重建
+            for (int32 i = 0; i < NumLinks; ++i) {
+                Chain[i] = RestChain[i];
+            }
+            ArcDistributedIKSolver::SolveArcClosedForm(
+                Chain, BoneLengths, TotalChainLength, EffectorPosition,
+                PlaneNormal, Precision);
+            ArcDistributedIKSolver::SolveArcFABRIK(
+                Chain, BoneLengths, EffectorPosition, PoleTarget,
+                PlaneNormal, Precision, MaxIterations);
+            ArcDistributedIKSolver::RebuildRotations(
+                Chain, PlaneNormal, PrimaryAxis, SecondaryAxis, PoleTarget,
+                false);
+
+            // IKWithPole：CCDIK + 次轴修正
+            for (int32 i = 0; i < NumLinks; ++i) {
+                Chain[i] = RestChain[i];
+            }
+            PoleTargetIKSolver::SolveCCDIKWithBudget(
+                Chain, EffectorPosition, Precision, MaxIterations, 0.0f, true,
+                RotationLimits);
+            PoleTargetIKSolver::ApplySecondaryAxisCorrection(
+                Chain, EffectorPosition, PoleTarget, PrimaryAxis,
+                SecondaryAxis);
+
+            // FABRIKWithPole：根骨骼pole修正
+            PoleTargetSolverCore::FRootPoleCorrectionSolver::
+                CalculateRootPoleCorrection(
+                    Chain[0].Transform.GetLocation(),
+                    Chain[NumLinks / 2].Transform.GetLocation(),
+                    Chain.Last().Transform.GetLocation(), PoleTarget);
+        }
+        AllocationCount = Counter.GetAllocationCount();
+    }
+
+    AddInfo(FString::Printf(TEXT("Heap allocations during 100 solves: %d"),
+                            AllocationCount));
+    TestEqual(TEXT("求解过程中不应产生堆分配"), AllocationCount, 0);
+
+    return true;
+}
+
+/**
+ * 测试：四元数基构造 vs 矩阵求逆
+ * 对随机的局部轴和世界正交基，比较 BuildRotationFromTwoAxes 与原先
+ * LocalAxisMatrix.Inverse() * LocalToWorldMatrix 的结果
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+    FPoleTargetSolverCore_QuatBasisVsMatrix,
+    "MusicDoll.IK.SolverCore.QuatBasisVsMatrix",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FPoleTargetSolverCore_QuatBasisVsMatrix::RunTest(
+    const FString& Parameters) {
+    using namespace PoleTargetSolverCore;
+
+    // 原实现：每骨骼构造两个矩阵并求逆
+    auto BuildRotationWithMatrix = [](const FVector& WorldX,
+                                      const FVector& WorldY,
+                                      const FVector& WorldZ,
+                                      const FVector& LocalX,
+                                      const FVector& LocalY) {
+        const FVector LocalZ =
+            FVector::CrossProduct(LocalX, LocalY).GetSafeNormal();
+        const FMatrix LocalToWorldMatrix(
+            FPlane(WorldX.X, WorldX.Y, WorldX.Z, 0.0f),
+            FPlane(WorldY.X, WorldY.Y, WorldY.Z, 0.0f),
+            FPlane(WorldZ.X, WorldZ.Y, WorldZ.Z, 0.0f),
+            FPlane(0.0f, 0.0f, 0.0f, 1.0f));
+        const FMatrix LocalAxisMatrix(
+            FPlane(LocalX.X, LocalX.Y, LocalX.Z, 0.0f),
+            FPlane(LocalY.X, LocalY.Y, LocalY.Z, 0.0f),
+            FPlane(LocalZ.X, LocalZ.Y, LocalZ.Z, 0.0f),
+            FPlane(0.0f, 0.0f, 0.0f, 1.0f));
+        return FQuat(LocalAxisMatrix.Inverse() * LocalToWorldMatrix)
+            .GetNormalized();
+    };
+
+    const int32 NumCases = 2000;
+    FRandomStream Random(20240613);
+    double MaxAngleError = 0.0;
+    double MaxAxisError = 0.0;
+    uint64 MatrixCycles = 0;
+    uint64 QuatCycles = 0;
+
+    for (int32 Case = 0; Case < NumCases; ++Case) {
+        // 局部轴：前几组使用常见的轴向组合，其余随机正交
+        FVector LocalX;
+        FVector LocalY;
+        switch (Case % 4) {
+            case 0:
+                LocalX = FVector(1.0f, 0.0f, 0.0f);
+                LocalY = FVector(0.0f, 1.0f, 0.0f);
+                break;
+            case 1:
+                LocalX = FVector(0.0f, 0.0f, 1.0f);
+                LocalY = FVector(-1.0f, 0.0f, 0.0f);
+                break;
+            case 2:
+                LocalX = FVector(0.0f, -1.0f, 0.0f);
+                LocalY = FVector(0.0f, 0.0f, 1.0f);
+                break;
+            default:
+                LocalX = Random.GetUnitVector();
+                LocalY = FVector::CrossProduct(LocalX, Random.GetUnitVector())
+                             .GetSafeNormal();
+                break;
+        }
+
+        const FVector WorldX = Random.GetUnitVector();
+        const FVector WorldY =
+            FVector::CrossProduct(WorldX, Random.GetUnitVector())
+                .GetSafeNormal();
+        const FVector WorldZ = FVector::CrossProduct(WorldX, WorldY);
+
+        uint64 StartCycles = FPlatformTime::Cycles64();
+        const FQuat MatrixRotation =
+            BuildRotationWithMatrix(WorldX, WorldY, WorldZ, LocalX, LocalY);
+        MatrixCycles += FPlatformTime::Cycles64() - StartCycles;
+
+        const FLocalAxisBasis LocalBasis(LocalX, LocalY);
+        StartCycles = FPlatformTime::Cycles64();
+        const FQuat QuatRotation =
+            BuildRotationFromTwoAxes(WorldX, WorldY, LocalBasis);
+        QuatCycles += FPlatformTime::Cycles64() - StartCycles;
+
+        MaxAngleError = FMath::Max(
+            MaxAngleError, (double)MatrixRotation.AngularDistance(QuatRotation));
+        MaxAxisError = FMath::Max(
+            MaxAxisError,
+            (double)FMath::Max(
+                FVector::Dist(QuatRotation.RotateVector(LocalX), WorldX),
+                FVector::Dist(QuatRotation.RotateVector(LocalY), WorldY)));
+    }
+
+    AddInfo(FString::Printf(
+        TEXT("Max angular difference %.3e rad, max axis error %.3e, "
+             "matrix %.1f ns, quat %.1f ns"),
+        MaxAngleError, MaxAxisError,
+        FPlatformTime::ToMilliseconds64(MatrixCycles) * 1.0e6 / NumCases,
+        FPlatformTime::ToMilliseconds64(QuatCycles) * 1.0e6 / NumCases));
+
+    TestTrue(TEXT("四元数构造应与矩阵求逆结果一致"), MaxAngleError < 1.0e-4);
+    TestTrue(TEXT("局部主/次轴应精确转到世界主/次轴"), MaxAxisError < 1.0e-4);
+
+    return true;
+}
+
+/**
+ * 测试：输入记忆
+ * 输入完全相同时恢复上一次的结果；末端、pole、链条初始姿态或参数任一变化都应重新求解
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPoleTargetIK_MemoData,
+                                 "MusicDoll.IK.SolverCore.MemoData",
+                                 EAutomationTestFlags::EditorContext |
+                                     EAutomationTestFlags::EngineFilter)
+
+bool FPoleTargetIK_MemoData::RunTest(const FString& Parameters) {
+    TArray<FRigElementKey> Items;
+    TArray<FCCDIKChainLink> InputChain;
+    for (int32 i = 0; i < 3; ++i) {
+        Items.Add(FRigElementKey(*FString::Printf(TEXT("finger_%02d"), i),
+                                 ERigElementType::Bone));
+        FCCDIKChainLink Link;
+        Link.Transform.SetLocation(FVector(3.0f * i, 0.0f, 0.0f));
+        InputChain.Add(Link);
+    }
+    const FVector EffectorPosition(4.0f, 0.0f, 2.0f);
+    const FVector PoleTarget(3.0f, 10.0f, 0.0f);
+    const uint32 SettingsHash = FRigUnit_PoleTargetIK_MemoData::HashSettings(
+        FVector(1.0f, 0.0f, 0.0f), FVector(0.0f, 1.0f, 0.0f), 0.001f, 10);
+
+    // 模拟一次求解：记录输入，改写链条后记录结果
+    FRigUnit_PoleTargetIK_MemoData MemoData;
+    TArray<FCCDIKChainLink> Chain = InputChain;
+    TestFalse(TEXT("没有结果时不应命中"),
+              MemoData.TryRestore(Items, SettingsHash, EffectorPosition,
+                                  PoleTarget, Chain));
+    MemoData.CaptureInputs(Items, SettingsHash, EffectorPosition, PoleTarget,
+                           Chain);
+    Chain[1].Transform.SetLocation(FVector(2.0f, 0.0f, 2.0f));
+    Chain[2].Transform.SetLocation(EffectorPosition);
+    MemoData.StoreResult(Chain);
+
+    Chain = InputChain;
+    TestTrue(TEXT("输入相同时应命中"),
+             MemoData.TryRestore(Items, SettingsHash, EffectorPosition,
+                                 PoleTarget, Chain));
+    TestTrue(TEXT("命中后链条应为上一次的结果"),
+             Chain[2].Transform.GetLocation().Equals(EffectorPosition));
+
+    Chain = InputChain;
+    TestFalse(TEXT("末端变化时不应命中"),
+              MemoData.TryRestore(Items, SettingsHash,
+                                  EffectorPosition + FVector(0.1f, 0.0f, 0.0f),
+                                  PoleTarget, Chain));
+    TestFalse(TEXT("pole变化时不应命中"),
+              MemoData.TryRestore(Items, SettingsHash, EffectorPosition,
+                                  PoleTarget + FVector(0.0f, 0.0f, 1.0f),
+                                  Chain));
+    TestFalse(TEXT("参数变化时不应命中"),
+              MemoData.TryRestore(Items, SettingsHash + 1, EffectorPosition,
+                                  PoleTarget, Chain));
+
+    Chain[0].Transform.SetLocation(FVector(0.0f, 0.5f, 0.0f));
+    TestFalse(TEXT("根骨骼移动时不应命中"),
+              MemoData.TryRestore(Items, SettingsHash, EffectorPosition,
+                                  PoleTarget, Chain));
+    TestTrue(TEXT("未命中时不应改写链条"),
+             Chain[2].Transform.GetLocation().Equals(
+                 InputChain[2].Transform.GetLocation()));
+
+    return true;
+}
+
+/**
+ * 测试：批量SIMD FABRIK与逐链标量FABRIK结果一致
+ * 关闭闭式求解，使所有可达的链都走 SolveFABRIKBatch4；同一批放入3~8节的链，
+ * 其中4节的链有5条（一组满4条加一组只有1条、其余通道填充）。
+ * 2节的链在节点中总会被拉直或跳过，单独直接调用 SolveFABRIKBatch4 覆盖
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+    FArcDistributedIK_BatchMatchesScalar,
+    "MusicDoll.IK.ArcDistributed.BatchMatchesScalar",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+namespace ArcDistributedIKBatchTest {
+
+constexpr float BoneLength = 3.0f;
+constexpr float Precision = 0.001f;
+constexpr int32 MaxIterations = 30;
+
+/**
+ * 位置容差：批量求解要等同组4条链都收敛才停止，先收敛的链会多迭代几次，
+ * 关节位置的偏移在 Precision 量级；单精度SoA的舍入误差远小于此
+ */
+constexpr float Tolerance = 0.01f;
+
+/** 末端在链长的 40%~95% 之间（可达，不会拉直），pole偏离根到末端的连线 */
+static void RandomTarget(FRandomStream& Random, const FVector& Root,
+                         int32 NumLinks, FVector& OutEffector,
+                         FVector& OutPole) {
+    const float ChainLength = BoneLength * (NumLinks - 1);
+    do {
+        OutEffector = Root + Random.GetUnitVector() * ChainLength *
+                                 Random.FRandRange(0.4f, 0.95f);
+        OutPole =
+            (Root + OutEffector) * 0.5f + Random.GetUnitVector() * ChainLength;
+    } while (ArcDistributedIKSolver::CalculateReferencePlaneNormal(
+                 Root, OutEffector, OutPole)
+                 .IsNearlyZero());
+}
+
+/** 沿X轴伸直的链 */
+static TArray<FCCDIKChainLink> MakeStraightChain(const FVector& Root,
+                                                 int32 NumLinks) {
+    TArray<FCCDIKChainLink> Chain;
+    Chain.SetNum(NumLinks);
+    for (int32 i = 0; i < NumLinks; ++i) {
+        Chain[i].Transform.SetLocation(Root +
+                                       FVector(BoneLength * i, 0.0f, 0.0f));
+    }
+    return Chain;
+}
+
+/** 标量参考：在链条副本上运行 SolveArcFABRIK */
+static TArray<FCCDIKChainLink> SolveScalar(
+    const TArray<FCCDIKChainLink>& InputChain,
+    const TArray<float>& BoneLengths, const FVector& Effector,
+    const FVector& Pole) {
+    TArray<FCCDIKChainLink> Chain = InputChain;
+    const FVector PlaneNormal =
+        ArcDistributedIKSolver::CalculateReferencePlaneNormal(
+            Chain[0].Transform.GetLocation(), Effector, Pole);
+    ArcDistributedIKSolver::SolveArcFABRIK(Chain, BoneLengths, Effector, Pole,
+                                           PlaneNormal, Precision,
+                                           MaxIterations);
+    return Chain;
+}
+
+}  // namespace ArcDistributedIKBatchTest
+
+bool FArcDistributedIK_BatchMatchesScalar::RunTest(const FString& Parameters) {
+    using namespace ArcDistributedIKBatchTest;
+
+    FRandomStream Random(20240601);
+
+    // ========== 1. 节点：不同关节数的链放在同一批 ==========
+    const TArray<int32> LinkCounts = {3, 4, 5, 6, 7, 8, 4, 4, 4, 4};
+
+    TStrongObjectPtr<URigHierarchy> Hierarchy(
+        NewObject<URigHierarchy>(GetTransientPackage()));
+    URigHierarchyController* Controller = Hierarchy->GetController(true);
+    const FRigElementKey HandKey = Controller->AddBone(
+        TEXT("hand"), FRigElementKey(), FTransform::Identity, true,
+        ERigBoneType::User, false);
+
+    FRigUnit_ArcDistributedIKBatch Unit;
+    Unit.bUseClosedFormSolver = false;
+    Unit.Precision = Precision;
+    Unit.MaxIterations = MaxIterations;
+    Unit.Chains.SetNum(LinkCounts.Num());
+
+    for (int32 ChainIndex = 0; ChainIndex < LinkCounts.Num(); ++ChainIndex) {
+        const FVector Root(0.0f, ChainIndex * 2.0f, 0.0f);
+        FArcDistributedIKBatchChain& Input = Unit.Chains[ChainIndex];
+
+        FRigElementKey ParentKey = HandKey;
+        for (int32 i = 0; i < LinkCounts[ChainIndex]; ++i) {
+            ParentKey = Controller->AddBone(
+                *FString::Printf(TEXT("finger_%d_%02d"), ChainIndex, i),
+                ParentKey,
+                FTransform(Root + FVector(BoneLength * i, 0.0f, 0.0f)), true,
+                ERigBoneType::User, false);
+            Input.Items.Add(ParentKey);
+        }
+
+        FVector Effector;
+        RandomTarget(Random, Root, LinkCounts[ChainIndex], Effector,
+                     Input.PoleTarget);
+        Input.EffectorTransform = FTransform(Effector);
+    }
+
+    // 标量参考从执行前的姿态开始
+    TArray<TArray<FCCDIKChainLink>> Expected;
+    for (const FArcDistributedIKBatchChain& Input : Unit.Chains) {
+        FRigUnit_ArcDistributedIK_WorkData Cache;
+        if (!TestTrue(TEXT("应该能为链建立骨骼缓存"),
+                      ArcDistributedIKSolver::BuildChainCache(
+                          Hierarchy.Get(), Input.Items, Cache))) {
+            return false;
+        }
+        for (int32 i = 0; i < Cache.Chain.Num(); ++i) {
+            Cache.Chain[i].Transform =
+                Hierarchy->GetGlobalTransform(Input.Items[i]);
+        }
+        Expected.Add(SolveScalar(Cache.Chain, Cache.RestBoneLengths,
+                                 Input.EffectorTransform.GetLocation(),
+                                 Input.PoleTarget));
+    }
+
+    FRigVMExtendedExecuteContext Context(
+        FControlRigExecuteContext::StaticStruct());
+    Context.GetPublicData<FControlRigExecuteContext>().Hierarchy =
+        Hierarchy.Get();
+    Unit.Execute(Context.GetPublicData<FControlRigExecuteContext>());
+
+    TestTrue(TEXT("关闭闭式求解后应该运行FABRIK迭代"), Unit.IterationsUsed > 0);
+
+    for (int32 ChainIndex = 0; ChainIndex < LinkCounts.Num(); ++ChainIndex) {
+        const TArray<FRigElementKey>& Items = Unit.Chains[ChainIndex].Items;
+        for (int32 i = 0; i < Items.Num(); ++i) {
+            const FVector Batched =
+                Hierarchy->GetGlobalTransform(Items[i]).GetLocation();
+            const FVector Scalar =
+                Expected[ChainIndex][i].Transform.GetLocation();
+            TestTrue(FString::Printf(TEXT("节点：链%d（%d节）关节%d 批量 %s "
+                                          "与标量 %s 应该一致"),
+                                     ChainIndex, LinkCounts[ChainIndex], i,
+                                     *Batched.ToString(), *Scalar.ToString()),
+                     Batched.Equals(Scalar, Tolerance));
+        }
+    }
+
+    // ========== 2. 求解器：2~8节，每组3条链（含填充通道） ==========
+    constexpr int32 NumLanes = 3;
+    FRigUnit_ArcDistributedIKBatch_WorkData Scratch;
+    for (int32 NumLinks = 2; NumLinks <= 8; ++NumLinks) {
+        TArray<float> BoneLengths;
+        BoneLengths.Init(BoneLength, NumLinks - 1);
+
+        TArray<TArray<FCCDIKChainLink>> Chains;
+        TArray<FVector> Effectors;
+        TArray<TArray<FCCDIKChainLink>> ScalarChains;
+        for (int32 Lane = 0; Lane < NumLanes; ++Lane) {
+            const FVector Root(0.0f, Lane * 2.0f, 0.0f);
+            FVector Effector;
+            FVector Pole;
+            RandomTarget(Random, Root, NumLinks, Effector, Pole);
+
+            TArray<FCCDIKChainLink>& Chain =
+                Chains.Add_GetRef(MakeStraightChain(Root, NumLinks));
+            ScalarChains.Add(SolveScalar(Chain, BoneLengths, Effector, Pole));
+            ArcDistributedIKSolver::PrepareFABRIKChain(
+                Chain, BoneLengths, Effector,
+                ArcDistributedIKSolver::CalculateReferencePlaneNormal(
+                    Root, Effector, Pole));
+            Effectors.Add(Effector);
+        }
+
+        TArray<FCCDIKChainLink>* LaneChains[NumLanes];
+        const TArray<float>* LaneBoneLengths[NumLanes];
+        for (int32 Lane = 0; Lane < NumLanes; ++Lane) {
+            LaneChains[Lane] = &Chains[Lane];
+            LaneBoneLengths[Lane] = &BoneLengths;
+        }
+        ArcDistributedIKSolver::SolveFABRIKBatch4(
+            MakeArrayView(LaneChains, NumLanes),
+            MakeArrayView(LaneBoneLengths, NumLanes), Effectors, Precision,
+            MaxIterations, Scratch);
+
+        for (int32 Lane = 0; Lane < NumLanes; ++Lane) {
+            for (int32 i = 0; i < NumLinks; ++i) {
+                const FVector Batched = Chains[Lane][i].Transform.GetLocation();
+                const FVector Scalar =
+                    ScalarChains[Lane][i].Transform.GetLocation();
+                TestTrue(FString::Printf(TEXT("求解器：%d节 通道%d 关节%d "
+                                              "批量 %s 与标量 %s 应该一致"),
+                                         NumLinks, Lane, i,
+                                         *Batched.ToString(),
+                                         *Scalar.ToString()),
+                         Batched.Equals(Scalar, Tolerance));
+            }
+        }
+    }
+
+    return true;
+}
+
 #endif  // WITH_AUTOMATION_TESTS
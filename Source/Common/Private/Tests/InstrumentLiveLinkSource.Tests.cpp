@@ -0,0 +1,141 @@
+﻿#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+#include "InstrumentFrameRingBuffer.h"
+#include "InstrumentLiveLinkSource.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+#if WITH_AUTOMATION_TESTS
+
+// ============================================================================
+// 自动化测试
+// ============================================================================
+
+/**
+ * 测试：环形缓冲区先进先出、满时拒绝写入、回绕后继续可用
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInstrumentLiveLink_RingBuffer,
+                                 "MusicDoll.LiveLink.RingBuffer",
+                                 EAutomationTestFlags::EditorContext |
+                                     EAutomationTestFlags::EngineFilter)
+
+bool FInstrumentLiveLink_RingBuffer::RunTest(const FString& Parameters) {
+    TInstrumentFrameRingBuffer<int32> RingBuffer(3);
+    TestEqual(TEXT("容量向上取整为2的幂"), RingBuffer.GetCapacity(), 4u);
+
+    for (int32 Round = 0; Round < 3; ++Round) {
+        for (int32 i = 0; i < 4; ++i) {
+            int32 Value = Round * 10 + i;
+            TestTrue(TEXT("未满时可以写入"), RingBuffer.Push(MoveTemp(Value)));
+        }
+
+        int32 Overflow = -1;
+        TestFalse(TEXT("已满时拒绝写入"), RingBuffer.Push(MoveTemp(Overflow)));
+        TestEqual(TEXT("元素数量"), RingBuffer.Num(), 4u);
+
+        for (int32 i = 0; i < 4; ++i) {
+            int32 Value = -1;
+            TestTrue(TEXT("非空时可以取出"), RingBuffer.Pop(Value));
+            TestEqual(TEXT("先进先出"), Value, Round * 10 + i);
+        }
+
+        int32 Value = -1;
+        TestFalse(TEXT("为空时取出失败"), RingBuffer.Pop(Value));
+    }
+
+    return true;
+}
+
+/**
+ * 测试：JSON对象分段到达时只在对象完整后取出，字符串中的花括号不影响配对
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInstrumentLiveLink_JsonObjectScanner,
+                                 "MusicDoll.LiveLink.JsonObjectScanner",
+                                 EAutomationTestFlags::EditorContext |
+                                     EAutomationTestFlags::EngineFilter)
+
+bool FInstrumentLiveLink_JsonObjectScanner::RunTest(
+    const FString& Parameters) {
+    const FTCHARToUTF8 Content(
+        TEXT("[{\"frame\": 0, \"name\": \"a}\\\"{\"},\n {\"frame\": 1, "
+             "\"nested\": {\"x\": [1, 2]}}]"));
+
+    FInstrumentJsonObjectScanner Scanner;
+    TArray<FString> Objects;
+    FString Json;
+
+    // 逐字节追加，模拟外部工具写入过程中的任意截断位置
+    for (int32 i = 0; i < Content.Length(); ++i) {
+        Scanner.Append(reinterpret_cast<const uint8*>(Content.Get()) + i, 1);
+        while (Scanner.PopObject(Json)) {
+            Objects.Add(Json);
+        }
+    }
+
+    TestEqual(TEXT("取出两个对象"), Objects.Num(), 2);
+    if (Objects.Num() == 2) {
+        TestEqual(TEXT("第一个对象"), Objects[0],
+                  FString(TEXT("{\"frame\": 0, \"name\": \"a}\\\"{\"}")));
+        TestEqual(TEXT("第二个对象"), Objects[1],
+                  FString(TEXT("{\"frame\": 1, \"nested\": {\"x\": [1, 2]}}")));
+    }
+
+    return true;
+}
+
+/**
+ * 测试：帧解析合并手部旋转，忽略无效控制器
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInstrumentLiveLink_ParseFrame,
+                                 "MusicDoll.LiveLink.ParseFrame",
+                                 EAutomationTestFlags::EditorContext |
+                                     EAutomationTestFlags::EngineFilter)
+
+bool FInstrumentLiveLink_ParseFrame::RunTest(const FString& Parameters) {
+    const FString FrameJson = TEXT(
+        "{\"frame\": 12, \"hand_infos\": {\"H_L\": [1, 2, 3], "
+        "\"H_rotation_L\": [1, 0, 0, 0], \"Unknown\": [4, 5, 6]}}");
+
+    TSharedPtr<FJsonObject> FrameObject;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(FrameJson);
+    TestTrue(TEXT("JSON解析成功"),
+             FJsonSerializer::Deserialize(Reader, FrameObject));
+
+    const TSet<FString> ControllerNames = {TEXT("H_L"), TEXT("H_rotation_L")};
+    const TMap<FString, int32> ControllerIndices = {{TEXT("H_L"), 0}};
+
+    // 无效控制器由通用解析方法报错
+    AddExpectedError(TEXT("INVALID CONTROLLER"),
+                     EAutomationExpectedErrorFlags::Contains, 1);
+
+    FInstrumentLiveLinkFrame Frame;
+    TestTrue(TEXT("帧解析成功"),
+             FInstrumentLiveLinkSource::ParseFrame(
+                 FrameObject, 3, ControllerNames, ControllerIndices, Frame));
+    TestEqual(TEXT("帧号"), Frame.FrameNumber, 12);
+    TestEqual(TEXT("只有H_L"), Frame.Controls.Num(), 1);
+    if (Frame.Controls.Num() == 1) {
+        TestEqual(TEXT("控制器下标"), Frame.Controls[0].Key, 0);
+        TestTrue(TEXT("位置"), Frame.Controls[0].Value.GetLocation().Equals(
+                                   FVector(1.0, 2.0, 3.0)));
+    }
+
+    // KeyRipple 结构：控制器直接位于帧对象中，帧号取文件中的序号
+    TSharedPtr<FJsonObject> KeyRippleFrameObject;
+    TSharedRef<TJsonReader<>> KeyRippleReader =
+        TJsonReaderFactory<>::Create(TEXT("{\"H_L\": [4, 5, 6]}"));
+    TestTrue(TEXT("JSON解析成功"),
+             FJsonSerializer::Deserialize(KeyRippleReader,
+                                          KeyRippleFrameObject));
+    TestTrue(TEXT("帧解析成功"),
+             FInstrumentLiveLinkSource::ParseFrame(KeyRippleFrameObject, 3,
+                                                   ControllerNames,
+                                                   ControllerIndices, Frame));
+    TestEqual(TEXT("帧号取序号"), Frame.FrameNumber, 3);
+    TestEqual(TEXT("只有H_L"), Frame.Controls.Num(), 1);
+
+    return true;
+}
+
+#endif  // WITH_AUTOMATION_TESTS
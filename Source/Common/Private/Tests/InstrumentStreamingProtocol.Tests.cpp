@@ -0,0 +1,163 @@
+﻿#include "CoreMinimal.h"
+#include "HAL/FileManager.h"
+#include "InstrumentStreamingProtocol.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+#if WITH_AUTOMATION_TESTS
+
+// ============================================================================
+// 自动化测试
+// ============================================================================
+
+/**
+ * 测试：消息逐字节到达时只在完整后取出，未知类型视为数据损坏
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInstrumentStreaming_MessageDecoder,
+                                 "MusicDoll.Streaming.MessageDecoder",
+                                 EAutomationTestFlags::EditorContext |
+                                     EAutomationTestFlags::EngineFilter)
+
+bool FInstrumentStreaming_MessageDecoder::RunTest(const FString& Parameters) {
+    using namespace InstrumentStreamingProtocol;
+
+    TArray<uint8> Bytes;
+    EncodeFrameMessage(TEXT("{\"frame\": 0}"), Bytes);
+    EncodeFrameMessage(TEXT("{\"frame\": 1, \"名称\": \"弓\"}"), Bytes);
+    EncodeMessage(EMessageType::End, {}, Bytes);
+
+    FInstrumentStreamMessageDecoder Decoder;
+    TArray<EMessageType> Types;
+    TArray<FString> Payloads;
+    EMessageType Type;
+    TArray<uint8> Payload;
+
+    for (int32 i = 0; i < Bytes.Num(); ++i) {
+        Decoder.Append(Bytes.GetData() + i, 1);
+        while (Decoder.PopMessage(Type, Payload)) {
+            Types.Add(Type);
+            Payloads.Add(FString(FUTF8ToTCHAR(
+                reinterpret_cast<const ANSICHAR*>(Payload.GetData()),
+                Payload.Num())));
+        }
+    }
+
+    TestFalse(TEXT("没有错误"), Decoder.HasError());
+    TestEqual(TEXT("取出三条消息"), Types.Num(), 3);
+    if (Types.Num() == 3) {
+        TestTrue(TEXT("第一条为帧"), Types[0] == EMessageType::Frame);
+        TestEqual(TEXT("第一帧内容"), Payloads[0],
+                  FString(TEXT("{\"frame\": 0}")));
+        TestEqual(TEXT("非ASCII内容"), Payloads[1],
+                  FString(TEXT("{\"frame\": 1, \"名称\": \"弓\"}")));
+        TestTrue(TEXT("最后一条为结束"), Types[2] == EMessageType::End);
+        TestEqual(TEXT("结束消息没有负载"), Payloads[2], FString());
+    }
+
+    // 未知类型
+    const uint8 BadHeader[HeaderSize] = {0, 0, 0, 0, 7};
+    Decoder.Reset();
+    Decoder.Append(BadHeader, HeaderSize);
+    TestFalse(TEXT("未知类型不取出"), Decoder.PopMessage(Type, Payload));
+    TestTrue(TEXT("未知类型报告错误"), Decoder.HasError());
+
+    return true;
+}
+
+/**
+ * 测试：回放服务器把文件中的每一帧作为一条消息发送，最后发送结束消息
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInstrumentStreaming_ReplayServer,
+                                 "MusicDoll.Streaming.ReplayServer",
+                                 EAutomationTestFlags::EditorContext |
+                                     EAutomationTestFlags::EngineFilter)
+
+bool FInstrumentStreaming_ReplayServer::RunTest(const FString& Parameters) {
+    using namespace InstrumentStreamingProtocol;
+
+    static constexpr int32 NumFrames = 50;
+    static constexpr int32 Port = DefaultPort + 1;
+
+    FString Content = TEXT("[");
+    for (int32 i = 0; i < NumFrames; ++i) {
+        Content += FString::Printf(
+            TEXT("%s{\"frame\": %d, \"hand_infos\": {}}"),
+            i > 0 ? TEXT(",\n") : TEXT(""), i);
+    }
+    Content += TEXT("]");
+
+    const FString FilePath = FPaths::Combine(
+        FPaths::AutomationTransientDir(), TEXT("StreamReplayTest.json"));
+    if (!TestTrue(TEXT("写入测试文件"),
+                  FFileHelper::SaveStringToFile(
+                      Content, *FilePath,
+                      FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))) {
+        return false;
+    }
+
+    FInstrumentStreamReplayServer Server(FilePath, Port, 0.0f);
+    if (!TestTrue(TEXT("开始监听"), Server.Start())) {
+        return false;
+    }
+
+    ISocketSubsystem* SocketSubsystem =
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr();
+    Address->SetLoopbackAddress();
+    Address->SetPort(Port);
+
+    FSocket* Socket = SocketSubsystem->CreateSocket(
+        NAME_Stream, TEXT("StreamReplayTestClient"),
+        Address->GetProtocolType());
+    if (!TestTrue(TEXT("连接回放服务器"),
+                  Socket && Socket->Connect(*Address))) {
+        if (Socket) {
+            SocketSubsystem->DestroySocket(Socket);
+        }
+        return false;
+    }
+
+    FInstrumentStreamMessageDecoder Decoder;
+    TArray<uint8> Buffer;
+    Buffer.SetNumUninitialized(4096);
+    EMessageType Type;
+    TArray<uint8> Payload;
+    int32 NumFrameMessages = 0;
+    bool bEndReceived = false;
+
+    const double Deadline = FPlatformTime::Seconds() + 10.0;
+    while (!bEndReceived && FPlatformTime::Seconds() < Deadline) {
+        if (!Socket->Wait(ESocketWaitConditions::WaitForRead,
+                          FTimespan::FromMilliseconds(100))) {
+            continue;
+        }
+        int32 BytesRead = 0;
+        if (!Socket->Recv(Buffer.GetData(), Buffer.Num(), BytesRead) ||
+            BytesRead == 0) {
+            break;
+        }
+        Decoder.Append(Buffer.GetData(), BytesRead);
+        while (Decoder.PopMessage(Type, Payload)) {
+            if (Type == EMessageType::End) {
+                bEndReceived = true;
+                break;
+            }
+            ++NumFrameMessages;
+        }
+    }
+
+    Socket->Close();
+    SocketSubsystem->DestroySocket(Socket);
+    IFileManager::Get().Delete(*FilePath);
+
+    TestTrue(TEXT("收到结束消息"), bEndReceived);
+    TestEqual(TEXT("每帧一条消息"), NumFrameMessages, NumFrames);
+    TestEqual(TEXT("服务器发送的帧数"), Server.GetNumFramesSent(), NumFrames);
+
+    return true;
+}
+
+#endif  // WITH_AUTOMATION_TESTS
@@ -0,0 +1,399 @@
+﻿// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ArcDistributedIK.h"
+#include "ArcDistributedIKBatch.h"
+#include "ControlRig.h"
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "PoleTargetFABRIK.h"
+#include "PoleTargetIK.h"
+#include "Rigs/RigHierarchy.h"
+#include "Rigs/RigHierarchyController.h"
+#include "ScopedAllocationCounter.h"
+#include "UObject/StrongObjectPtr.h"
+
+#if WITH_AUTOMATION_TESTS
+
+// ============================================================================
+// Pole Target IK 性能基准（MusicDoll.Perf.IK.*）
+//
+// 为 2~8 节的合成骨骼链随机扫描末端和pole位置，统计每次求解的耗时、
+// 迭代次数、末端残差和堆分配次数，结果写入 Saved/MusicDoll/Perf/ 下的CSV，
+// 用于比较不同求解器以及在IK代码修改后发现性能回退
+// ============================================================================
+
+namespace IKBenchmark {
+
+constexpr int32 MinLinks = 2;
+constexpr int32 MaxLinks = 8;
+constexpr int32 NumSamples = 200;
+constexpr int32 NumBatchChains = 4;
+constexpr float BoneLength = 3.0f;
+
+/** 一组（求解器, 关节数）的统计结果 */
+struct FRow {
+    FString UnitName;
+    int32 NumLinks = 0;
+    int32 NumChains = 1;
+    int32 NumSamples = 0;
+    double NsPerSolve = 0.0;
+    double MeanIterations = 0.0;
+    double MeanResidual = 0.0;
+    double MaxResidual = 0.0;
+    double AllocationsPerSolve = 0.0;
+};
+
+/** 合成层级：根骨骼下挂 NumChains 条沿X轴伸直的链，链间沿Y轴错开 */
+struct FSyntheticRig {
+    TStrongObjectPtr<URigHierarchy> Hierarchy;
+    TArray<TArray<FRigElementKey>> Chains;
+    TArray<FVector> RootPositions;
+};
+
+static FSyntheticRig BuildSyntheticRig(int32 NumChains, int32 NumLinks) {
+    FSyntheticRig Rig;
+    Rig.Hierarchy.Reset(NewObject<URigHierarchy>(GetTransientPackage()));
+    URigHierarchyController* Controller = Rig.Hierarchy->GetController(true);
+
+    const FRigElementKey HandKey =
+        Controller->AddBone(TEXT("hand"), FRigElementKey(), FTransform::Identity,
+                            true, ERigBoneType::User, false);
+
+    for (int32 ChainIndex = 0; ChainIndex < NumChains; ++ChainIndex) {
+        TArray<FRigElementKey>& Chain = Rig.Chains.AddDefaulted_GetRef();
+        const FVector RootPosition(0.0f, ChainIndex * 2.0f, 0.0f);
+        Rig.RootPositions.Add(RootPosition);
+
+        FRigElementKey ParentKey = HandKey;
+        for (int32 i = 0; i < NumLinks; ++i) {
+            const FName BoneName(
+                *FString::Printf(TEXT("finger_%d_%02d"), ChainIndex, i));
+            ParentKey = Controller->AddBone(
+                BoneName, ParentKey,
+                FTransform(RootPosition + FVector(BoneLength * i, 0.0f, 0.0f)),
+                true, ERigBoneType::User, false);
+            Chain.Add(ParentKey);
+        }
+
+        // 链外子骨骼，用于覆盖向子元素传播的开销
+        Controller->AddBone(
+            *FString::Printf(TEXT("finger_%d_end"), ChainIndex), ParentKey,
+            FTransform(RootPosition +
+                       FVector(BoneLength * NumLinks, 0.0f, 0.0f)),
+            true, ERigBoneType::User, false);
+    }
+    return Rig;
+}
+
+/** 末端在链长的 30%~110% 之间随机（包含少量够不到的情况） */
+static FVector RandomEffector(FRandomStream& Random, const FVector& Root,
+                              int32 NumLinks) {
+    const float ChainLength = BoneLength * (NumLinks - 1);
+    return Root +
+           Random.GetUnitVector() * ChainLength * Random.FRandRange(0.3f, 1.1f);
+}
+
+/** pole 在根与末端中点附近随机偏移 */
+static FVector RandomPole(FRandomStream& Random, const FVector& Root,
+                          const FVector& Effector, int32 NumLinks) {
+    return (Root + Effector) * 0.5f +
+           Random.GetUnitVector() * BoneLength * FMath::Max(NumLinks, 2);
+}
+
+/** Control Rig 执行上下文（每组基准只创建一次，不计入单次求解） */
+struct FUnitExecutor {
+    FRigVMExtendedExecuteContext Context;
+
+    explicit FUnitExecutor(URigHierarchy* Hierarchy)
+        : Context(FControlRigExecuteContext::StaticStruct()) {
+        Context.GetPublicData<FControlRigExecuteContext>().Hierarchy =
+            Hierarchy;
+    }
+
+    template <typename UnitType>
+    void Execute(UnitType& Unit) {
+        Unit.Execute(Context.GetPublicData<FControlRigExecuteContext>());
+    }
+};
+
+/**
+ * 单链 RigUnit 基准
+ * @param ConfigureUnit 每个采样前设置 Items/EffectorTransform/PoleTarget
+ */
+template <typename UnitType, typename ConfigureFunc>
+static FRow RunSingleChain(const TCHAR* UnitName, int32 NumLinks,
+                           FRandomStream& Random, ConfigureFunc ConfigureUnit) {
+    FSyntheticRig Rig = BuildSyntheticRig(1, NumLinks);
+    URigHierarchy* Hierarchy = Rig.Hierarchy.Get();
+    const TArray<FRigElementKey>& Items = Rig.Chains[0];
+
+    UnitType Unit;
+    FRow Row;
+    Row.UnitName = UnitName;
+    Row.NumLinks = NumLinks;
+
+    // 预热：建立缓存并让跨帧数组分配到位
+    ConfigureUnit(Unit, Items, FTransform(Rig.RootPositions[0]),
+                  FVector(0.0f, 10.0f, 0.0f));
+    FUnitExecutor Executor(Hierarchy);
+    Executor.Execute(Unit);
+
+    uint64 TotalCycles = 0;
+    int64 TotalIterations = 0;
+    int64 TotalAllocations = 0;
+    double TotalResidual = 0.0;
+    for (int32 Sample = 0; Sample < NumSamples; ++Sample) {
+        Hierarchy->ResetPoseToInitial(ERigElementType::Bone);
+
+        const FVector Effector =
+            RandomEffector(Random, Rig.RootPositions[0], NumLinks);
+        const FVector Pole =
+            RandomPole(Random, Rig.RootPositions[0], Effector, NumLinks);
+        ConfigureUnit(Unit, Items, FTransform(Effector), Pole);
+
+        int32 Allocations = 0;
+        {
+            FScopedAllocationCounter Counter;
+            const uint64 StartCycles = FPlatformTime::Cycles64();
+            Executor.Execute(Unit);
+            TotalCycles += FPlatformTime::Cycles64() - StartCycles;
+            Allocations = Counter.GetAllocationCount();
+        }
+
+        // 够不到的目标按可达的最近点计算残差
+        const FVector Root = Rig.RootPositions[0];
+        const float ChainLength = BoneLength * (NumLinks - 1);
+        const FVector ReachableEffector =
+            Root + (Effector - Root).GetClampedToMaxSize(ChainLength);
+        const double Residual = FVector::Dist(
+            Hierarchy->GetGlobalTransform(Items.Last()).GetLocation(),
+            ReachableEffector);
+
+        TotalIterations += Unit.IterationsUsed;
+        TotalAllocations += Allocations;
+        TotalResidual += Residual;
+        Row.MaxResidual = FMath::Max(Row.MaxResidual, Residual);
+    }
+
+    Row.NumSamples = NumSamples;
+    Row.NsPerSolve =
+        FPlatformTime::ToMilliseconds64(TotalCycles) * 1.0e6 / NumSamples;
+    Row.MeanIterations = (double)TotalIterations / NumSamples;
+    Row.MeanResidual = TotalResidual / NumSamples;
+    Row.AllocationsPerSolve = (double)TotalAllocations / NumSamples;
+    return Row;
+}
+
+/** 批量 RigUnit 基准：NumBatchChains 条链一次求解，耗时按单链折算 */
+static FRow RunBatch(int32 NumLinks, FRandomStream& Random) {
+    FSyntheticRig Rig = BuildSyntheticRig(NumBatchChains, NumLinks);
+    URigHierarchy* Hierarchy = Rig.Hierarchy.Get();
+
+    FRigUnit_ArcDistributedIKBatch Unit;
+    Unit.Chains.SetNum(NumBatchChains);
+    for (int32 ChainIndex = 0; ChainIndex < NumBatchChains; ++ChainIndex) {
+        Unit.Chains[ChainIndex].Items = Rig.Chains[ChainIndex];
+        Unit.Chains[ChainIndex].EffectorTransform =
+            FTransform(Rig.RootPositions[ChainIndex]);
+        Unit.Chains[ChainIndex].PoleTarget =
+            Rig.RootPositions[ChainIndex] + FVector(0.0f, 0.0f, 10.0f);
+    }
+    FUnitExecutor Executor(Hierarchy);
+    Executor.Execute(Unit);
+
+    FRow Row;
+    Row.UnitName = TEXT("ArcDistributedIKBatch");
+    Row.NumLinks = NumLinks;
+    Row.NumChains = NumBatchChains;
+
+    uint64 TotalCycles = 0;
+    int64 TotalIterations = 0;
+    int64 TotalAllocations = 0;
+    double TotalResidual = 0.0;
+    TArray<FVector, TInlineAllocator<NumBatchChains>> Effectors;
+    Effectors.SetNum(NumBatchChains);
+    for (int32 Sample = 0; Sample < NumSamples; ++Sample) {
+        Hierarchy->ResetPoseToInitial(ERigElementType::Bone);
+
+        for (int32 ChainIndex = 0; ChainIndex < NumBatchChains; ++ChainIndex) {
+            const FVector Root = Rig.RootPositions[ChainIndex];
+            Effectors[ChainIndex] = RandomEffector(Random, Root, NumLinks);
+            Unit.Chains[ChainIndex].EffectorTransform =
+                FTransform(Effectors[ChainIndex]);
+            Unit.Chains[ChainIndex].PoleTarget =
+                RandomPole(Random, Root, Effectors[ChainIndex], NumLinks);
+        }
+
+        int32 Allocations = 0;
+        {
+            FScopedAllocationCounter Counter;
+            const uint64 StartCycles = FPlatformTime::Cycles64();
+            Executor.Execute(Unit);
+            TotalCycles += FPlatformTime::Cycles64() - StartCycles;
+            Allocations = Counter.GetAllocationCount();
+        }
+
+        for (int32 ChainIndex = 0; ChainIndex < NumBatchChains; ++ChainIndex) {
+            const FVector Root = Rig.RootPositions[ChainIndex];
+            const FVector ReachableEffector =
+                Root + (Effectors[ChainIndex] - Root)
+                           .GetClampedToMaxSize(BoneLength * (NumLinks - 1));
+            const double Residual = FVector::Dist(
+                Hierarchy->GetGlobalTransform(Rig.Chains[ChainIndex].Last())
+                    .GetLocation(),
+                ReachableEffector);
+            TotalResidual += Residual;
+            Row.MaxResidual = FMath::Max(Row.MaxResidual, Residual);
+        }
+        TotalIterations += Unit.IterationsUsed;
+        TotalAllocations += Allocations;
+    }
+
+    const int32 NumSolves = NumSamples * NumBatchChains;
+    Row.NumSamples = NumSamples;
+    Row.NsPerSolve =
+        FPlatformTime::ToMilliseconds64(TotalCycles) * 1.0e6 / NumSolves;
+    Row.MeanIterations = (double)TotalIterations / NumSamples;
+    Row.MeanResidual = TotalResidual / NumSolves;
+    Row.AllocationsPerSolve = (double)TotalAllocations / NumSolves;
+    return Row;
+}
+
+/** 写入 Saved/MusicDoll/Perf/<FileName>.csv */
+static bool WriteCsv(const FString& FileName, const TArray<FRow>& Rows,
+                     FString& OutPath) {
+    OutPath = FPaths::ProjectSavedDir() / TEXT("MusicDoll") / TEXT("Perf") /
+              (FileName + TEXT(".csv"));
+
+    FString Csv = TEXT(
+        "Unit,Links,Chains,Samples,NsPerSolve,MeanIterations,MeanResidual,"
+        "MaxResidual,AllocationsPerSolve\n");
+    for (const FRow& Row : Rows) {
+        Csv += FString::Printf(TEXT("%s,%d,%d,%d,%.1f,%.2f,%.6f,%.6f,%.2f\n"),
+                               *Row.UnitName, Row.NumLinks, Row.NumChains,
+                               Row.NumSamples, Row.NsPerSolve,
+                               Row.MeanIterations, Row.MeanResidual,
+                               Row.MaxResidual, Row.AllocationsPerSolve);
+    }
+    return FFileHelper::SaveStringToFile(Csv, *OutPath);
+}
+
+/** 汇报结果并写CSV；残差出现NaN视为失败 */
+static bool Report(FAutomationTestBase& Test, const FString& FileName,
+                   const TArray<FRow>& Rows) {
+    bool bAllFinite = true;
+    for (const FRow& Row : Rows) {
+        Test.AddInfo(FString::Printf(
+            TEXT("%s links=%d: %.1f ns/solve, %.2f iterations, residual "
+                 "mean %.5f max %.5f, %.2f allocations/solve"),
+            *Row.UnitName, Row.NumLinks, Row.NsPerSolve, Row.MeanIterations,
+            Row.MeanResidual, Row.MaxResidual, Row.AllocationsPerSolve));
+        bAllFinite &= FMath::IsFinite(Row.MeanResidual) &&
+                      FMath::IsFinite(Row.MaxResidual);
+    }
+
+    FString CsvPath;
+    if (WriteCsv(FileName, Rows, CsvPath)) {
+        Test.AddInfo(FString::Printf(TEXT("CSV written to %s"), *CsvPath));
+    } else {
+        Test.AddWarning(
+            FString::Printf(TEXT("Failed to write CSV to %s"), *CsvPath));
+    }
+
+    Test.TestTrue(TEXT("所有求解的末端残差都应为有限值"), bAllFinite);
+    return true;
+}
+
+}  // namespace IKBenchmark
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPoleTargetIKBenchmark_ArcDistributed,
+                                 "MusicDoll.Perf.IK.ArcDistributed",
+                                 EAutomationTestFlags::EditorContext |
+                                     EAutomationTestFlags::PerfFilter)
+
+bool FPoleTargetIKBenchmark_ArcDistributed::RunTest(
+    const FString& Parameters) {
+    FRandomStream Random(20240620);
+    TArray<IKBenchmark::FRow> Rows;
+    for (int32 NumLinks = IKBenchmark::MinLinks;
+         NumLinks <= IKBenchmark::MaxLinks; ++NumLinks) {
+        Rows.Add(IKBenchmark::RunSingleChain<FRigUnit_ArcDistributedIK>(
+            TEXT("ArcDistributedIK"), NumLinks, Random,
+            [](FRigUnit_ArcDistributedIK& Unit,
+               const TArray<FRigElementKey>& Items,
+               const FTransform& Effector, const FVector& Pole) {
+                Unit.Items = Items;
+                Unit.EffectorTransform = Effector;
+                Unit.PoleTarget = Pole;
+            }));
+    }
+    return IKBenchmark::Report(*this, TEXT("IK_ArcDistributed"), Rows);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPoleTargetIKBenchmark_ArcDistributedBatch,
+                                 "MusicDoll.Perf.IK.ArcDistributedBatch",
+                                 EAutomationTestFlags::EditorContext |
+                                     EAutomationTestFlags::PerfFilter)
+
+bool FPoleTargetIKBenchmark_ArcDistributedBatch::RunTest(
+    const FString& Parameters) {
+    FRandomStream Random(20240621);
+    TArray<IKBenchmark::FRow> Rows;
+    for (int32 NumLinks = IKBenchmark::MinLinks;
+         NumLinks <= IKBenchmark::MaxLinks; ++NumLinks) {
+        Rows.Add(IKBenchmark::RunBatch(NumLinks, Random));
+    }
+    return IKBenchmark::Report(*this, TEXT("IK_ArcDistributedBatch"), Rows);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPoleTargetIKBenchmark_IKWithPole,
+                                 "MusicDoll.Perf.IK.IKWithPole",
+                                 EAutomationTestFlags::EditorContext |
+                                     EAutomationTestFlags::PerfFilter)
+
+bool FPoleTargetIKBenchmark_IKWithPole::RunTest(const FString& Parameters) {
+    FRandomStream Random(20240622);
+    TArray<IKBenchmark::FRow> Rows;
+    for (int32 NumLinks = IKBenchmark::MinLinks;
+         NumLinks <= IKBenchmark::MaxLinks; ++NumLinks) {
+        Rows.Add(IKBenchmark::RunSingleChain<FRigUnit_IKWithPole>(
+            TEXT("IKWithPole"), NumLinks, Random,
+            [](FRigUnit_IKWithPole& Unit, const TArray<FRigElementKey>& Items,
+               const FTransform& Effector, const FVector& Pole) {
+                Unit.Items = Items;
+                Unit.EffectorTransform = Effector;
+                Unit.PoleTarget = Pole;
+            }));
+    }
+    return IKBenchmark::Report(*this, TEXT("IK_IKWithPole"), Rows);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPoleTargetIKBenchmark_FABRIKWithPole,
+                                 "MusicDoll.Perf.IK.FABRIKWithPole",
+                                 EAutomationTestFlags::EditorContext |
+                                     EAutomationTestFlags::PerfFilter)
+
+bool FPoleTargetIKBenchmark_FABRIKWithPole::RunTest(
+    const FString& Parameters) {
+    FRandomStream Random(20240623);
+    TArray<IKBenchmark::FRow> Rows;
+    for (int32 NumLinks = IKBenchmark::MinLinks;
+         NumLinks <= IKBenchmark::MaxLinks; ++NumLinks) {
+        Rows.Add(IKBenchmark::RunSingleChain<FRigUnit_FABRIKWithPole>(
+            TEXT("FABRIKWithPole"), NumLinks, Random,
+            [](FRigUnit_FABRIKWithPole& Unit,
+               const TArray<FRigElementKey>& Items,
+               const FTransform& Effector, const FVector& Pole) {
+                Unit.Items = Items;
+                Unit.EffectorTransform = Effector;
+                Unit.PoleTarget = Pole;
+            }));
+    }
+    return IKBenchmark::Report(*this, TEXT("IK_FABRIKWithPole"), Rows);
+}
+
+#endif  // WITH_AUTOMATION_TESTS
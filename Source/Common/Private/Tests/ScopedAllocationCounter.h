@@ -0,0 +1,106 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/MemoryBase.h"
+
+#if WITH_AUTOMATION_TESTS
+
+/**
+ * 统计作用域内当前线程的堆分配次数（测试专用）
+ * 第一次使用时把 GMalloc 换成转发到原分配器的计数代理，之后不再替换或恢复，
+ * 其它线程任何时候看到的 GMalloc 都是有效的分配器。
+ * 计数通过线程局部的计数器指针进行，只有打开了计数作用域的线程才会计数，
+ * 作用域可以嵌套（内层作用域的分配只计入内层）。
+ */
+class FScopedAllocationCounter {
+   public:
+    FScopedAllocationCounter() : PreviousCount(ActiveCount()) {
+        CountingMalloc();
+        ActiveCount() = &Count;
+    }
+
+    ~FScopedAllocationCounter() { ActiveCount() = PreviousCount; }
+
+    FScopedAllocationCounter(const FScopedAllocationCounter&) = delete;
+    FScopedAllocationCounter& operator=(const FScopedAllocationCounter&) =
+        delete;
+
+    int32 GetAllocationCount() const { return Count; }
+
+   private:
+    class FCountingMalloc final : public FMalloc {
+       public:
+        explicit FCountingMalloc(FMalloc* InInner) : Inner(InInner) {}
+
+        virtual void* Malloc(SIZE_T Size, uint32 Alignment) override {
+            Record();
+            return Inner->Malloc(Size, Alignment);
+        }
+
+        virtual void* Realloc(void* Original, SIZE_T Size,
+                              uint32 Alignment) override {
+            if (Size > 0) {
+                Record();
+            }
+            return Inner->Realloc(Original, Size, Alignment);
+        }
+
+        virtual void Free(void* Original) override { Inner->Free(Original); }
+
+        virtual SIZE_T QuantizeSize(SIZE_T Size, uint32 Alignment) override {
+            return Inner->QuantizeSize(Size, Alignment);
+        }
+
+        virtual bool GetAllocationSize(void* Original,
+                                       SIZE_T& SizeOut) override {
+            return Inner->GetAllocationSize(Original, SizeOut);
+        }
+
+        virtual void Trim(bool bTrimThreadCaches) override {
+            Inner->Trim(bTrimThreadCaches);
+        }
+
+        virtual bool IsInternallyThreadSafe() const override {
+            return Inner->IsInternallyThreadSafe();
+        }
+
+        virtual const TCHAR* GetDescriptiveName() override {
+            return TEXT("AllocationCounter");
+        }
+
+       private:
+        static void Record() {
+            if (int32* Counter = ActiveCount()) {
+                ++*Counter;
+            }
+        }
+
+        FMalloc* Inner;
+    };
+
+    /** 当前线程正在计数的作用域（没有时为nullptr） */
+    static int32*& ActiveCount() {
+        static thread_local int32* Counter = nullptr;
+        return Counter;
+    }
+
+    /**
+     * 静态生命周期的计数代理，由函数内静态变量的线程安全初始化保证只安装一次；
+     * 从不卸载，之前由原分配器分配的内存仍通过代理转发释放
+     */
+    static FCountingMalloc& CountingMalloc() {
+        static FCountingMalloc& Instance = Install();
+        return Instance;
+    }
+
+    static FCountingMalloc& Install() {
+        static FCountingMalloc Proxy(GMalloc);
+        GMalloc = &Proxy;
+        return Proxy;
+    }
+
+    int32 Count = 0;
+    int32* PreviousCount;
+};
+
+#endif  // WITH_AUTOMATION_TESTS
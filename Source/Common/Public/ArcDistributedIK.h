@@ -2,9 +2,63 @@
 
 #include "ControlRig/Public/Units/Highlevel/Hierarchy/RigUnit_CCDIK.h"
 #include "CoreMinimal.h"
+#include "PoleTargetIK.h"
+#include "PoleTargetSolverCore.h"
 #include "RigVM/Public/RigVMCore/RigVMStruct.h"
 #include "ArcDistributedIK.generated.h"
 
+/**
+ * ArcDistributedIK 跨帧持久缓存
+ * 仅在 Items、层级拓扑版本或初始姿态变化时重建，避免每帧重新查找骨骼、
+ * 重新计算骨骼长度和重新分配链条缓冲
+ */
+USTRUCT()
+struct COMMON_API FRigUnit_ArcDistributedIK_WorkData {
+    GENERATED_BODY()
+
+    /** 构建缓存时的 Items（用于检测输入变化） */
+    UPROPERTY()
+    TArray<FRigElementKey> CachedKeys;
+
+    /** 构建缓存时的层级拓扑版本 */
+    UPROPERTY()
+    int32 TopologyVersion = INDEX_NONE;
+
+    /** 已解析的骨骼元素 */
+    UPROPERTY()
+    TArray<FCachedRigElement> CachedItems;
+
+    /** 根骨骼的父元素（无父元素时无效） */
+    UPROPERTY()
+    FCachedRigElement CachedRootParent;
+
+    /**
+     * 构建缓存时各骨骼的初始全局位置
+     * 层级没有公开初始姿态的版本号，逐骨骼比较初始位置来检测初始姿态变化
+     */
+    UPROPERTY()
+    TArray<FVector> RestPositions;
+
+    /** 静止姿态下的骨骼长度（最后一节为0） */
+    UPROPERTY()
+    TArray<float> RestBoneLengths;
+
+    /** 静止姿态下的总链长 */
+    UPROPERTY()
+    float RestChainLength = 0.0f;
+
+    /** 复用的链条缓冲 */
+    TArray<FCCDIKChainLink> Chain;
+
+    /** 上一次求解得到的关节位置（热启动用） */
+    TArray<FVector> SolvedPositions;
+
+    bool IsValidFor(const TArray<FRigElementKey>& InItems,
+                    const URigHierarchy* InHierarchy) const;
+
+    void Reset();
+};
+
 USTRUCT(meta = (DisplayName = "Arc Distributed IK With Pole Target",
                 Category = "Hierarchy", Keywords = "N-Bone,IK,Pole,Arc",
                 Version = "5.7"))
@@ -23,6 +77,32 @@ struct COMMON_API FRigUnit_ArcDistributedIK : public FRigUnit_CCDIKItemArray {
     UPROPERTY(meta = (Input))
     bool bUseDebug = false;
 
+    /** 目标在可达范围内时使用闭式圆弧求解，失败时回退到FABRIK */
+    UPROPERTY(meta = (Input))
+    bool bUseClosedFormSolver = true;
+
+    /** FABRIK从上一帧的解开始迭代（按根骨骼位移平移），而不是重新拉直链条 */
+    UPROPERTY(meta = (Input))
+    bool bWarmStart = false;
+
+    /** 单次迭代末端移动小于该值时提前结束（0为关闭） */
+    UPROPERTY(meta = (Input))
+    float EarlyStopThreshold = 0.0f;
+
+    /** 链条初始姿态、目标、pole和参数都与上一次相同时直接写回上一次的结果 */
+    UPROPERTY(meta = (Input))
+    bool bMemoizeUnchangedInputs = false;
+
+    /** 本次求解实际使用的FABRIK迭代次数（闭式解为0） */
+    UPROPERTY(meta = (Output))
+    int32 IterationsUsed = 0;
+
+    UPROPERTY(transient)
+    FRigUnit_ArcDistributedIK_WorkData ArcWorkData;
+
+    UPROPERTY(transient)
+    FRigUnit_PoleTargetIK_MemoData MemoData;
+
     FRigUnit_ArcDistributedIK()
         : PoleTarget(FVector::ZeroVector),
           SecondAxis(FVector(0.0f, 1.0f, 0.0f)) {}
@@ -30,3 +110,70 @@ struct COMMON_API FRigUnit_ArcDistributedIK : public FRigUnit_CCDIKItemArray {
     RIGVM_METHOD()
     virtual void Execute() override;
 };
+
+/**
+ * ArcDistributedIK 位置求解（供 RigUnit 和自动化测试共用）
+ * 两者都只改写 Chain[1..] 的位置，根位置保持不变
+ */
+namespace ArcDistributedIKSolver {
+/**
+ * 闭式圆弧求解：二分圆弧曲率使首尾弦长等于根到目标的距离
+ * @return 目标不可达或无法收敛时返回false，此时链条保持不变
+ */
+COMMON_API bool SolveArcClosedForm(TArray<FCCDIKChainLink>& Chain,
+                                   const TArray<float>& BoneLengths,
+                                   float TotalChainLength,
+                                   const FVector& EffectorPosition,
+                                   const FVector& PlaneNormal,
+                                   float Precision);
+
+/**
+ * 迭代求解：沿目标方向拉直，绕平面法线旋转90度后运行FABRIK
+ * @return 实际使用的迭代次数
+ */
+COMMON_API int32 SolveArcFABRIK(TArray<FCCDIKChainLink>& Chain,
+                                const TArray<float>& BoneLengths,
+                                const FVector& EffectorPosition,
+                                const FVector& PoleTarget,
+                                const FVector& PlaneNormal, float Precision,
+                                int32 MaxIterations,
+                                float EarlyStopThreshold = 0.0f);
+
+// ===== 批量求解（FRigUnit_ArcDistributedIKBatch）共用的单链步骤 =====
+
+/** 解析骨骼并计算静止姿态骨骼长度，写入 Cache */
+COMMON_API bool BuildChainCache(URigHierarchy* Hierarchy,
+                                const TArray<FRigElementKey>& Items,
+                                FRigUnit_ArcDistributedIK_WorkData& Cache,
+                                bool bUseDebug = false);
+
+/** 由根、目标和pole计算参考平面法线 */
+COMMON_API FVector CalculateReferencePlaneNormal(
+    const FVector& RootPosition, const FVector& EffectorPosition,
+    const FVector& PoleTarget);
+
+/** 目标超出链长：沿根->目标方向拉直 */
+COMMON_API void StretchChainToEffector(TArray<FCCDIKChainLink>& Chain,
+                                       const TArray<float>& BoneLengths,
+                                       const FVector& EffectorPosition);
+
+/** FABRIK初值：拉直后绕平面法线旋转90度 */
+COMMON_API void PrepareFABRIKChain(TArray<FCCDIKChainLink>& Chain,
+                                   const TArray<float>& BoneLengths,
+                                   const FVector& EffectorPosition,
+                                   const FVector& PlaneNormal);
+
+/** 根据关节位置和参考平面重建每节骨骼的旋转 */
+COMMON_API void RebuildRotations(TArray<FCCDIKChainLink>& Chain,
+                                 const FVector& PlaneNormal,
+                                 const FVector& PrimaryAxis,
+                                 const FVector& SecondaryAxis,
+                                 const FVector& PoleTarget,
+                                 bool bEffectorTooFar);
+
+/** 同上，局部轴基由调用方预先构造（多条链共用） */
+COMMON_API void RebuildRotations(
+    TArray<FCCDIKChainLink>& Chain, const FVector& PlaneNormal,
+    const PoleTargetSolverCore::FLocalAxisBasis& LocalBasis,
+    const FVector& PoleTarget, bool bEffectorTooFar);
+}  // namespace ArcDistributedIKSolver
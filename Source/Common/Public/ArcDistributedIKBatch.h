@@ -0,0 +1,116 @@
+﻿#pragma once
+
+#include "ArcDistributedIK.h"
+#include "ControlRig/Public/Units/Highlevel/RigUnit_HighlevelBase.h"
+#include "CoreMinimal.h"
+#include "RigVM/Public/RigVMCore/RigVMStruct.h"
+#include "ArcDistributedIKBatch.generated.h"
+
+/**
+ * 批量求解中的单条链（一根手指）
+ */
+USTRUCT(BlueprintType)
+struct COMMON_API FArcDistributedIKBatchChain {
+    GENERATED_BODY()
+
+    /** 从根到末端的骨骼 */
+    UPROPERTY(EditAnywhere, Category = "Chain")
+    TArray<FRigElementKey> Items;
+
+    UPROPERTY(EditAnywhere, Category = "Chain")
+    FTransform EffectorTransform = FTransform::Identity;
+
+    UPROPERTY(EditAnywhere, Category = "Chain")
+    FVector PoleTarget = FVector::ZeroVector;
+};
+
+/**
+ * 批量求解的跨帧数据
+ */
+USTRUCT()
+struct COMMON_API FRigUnit_ArcDistributedIKBatch_WorkData {
+    GENERATED_BODY()
+
+    /** 每条链各自的骨骼缓存（与 Chains 一一对应） */
+    UPROPERTY()
+    TArray<FRigUnit_ArcDistributedIK_WorkData> ChainCaches;
+
+    /** 每条链本帧的参考平面法线 */
+    TArray<FVector> PlaneNormals;
+
+    /** 每条链本帧的求解状态（0=跳过, 1=过远拉直, 2=正常） */
+    TArray<uint8> AlgorithmTypes;
+
+    /** 等待SIMD FABRIK求解的链下标，按关节数分组 */
+    TMap<int32, TArray<int32>> PendingByLinkCount;
+
+    /** SoA 求解缓冲：每个关节一个4路寄存器 */
+    TArray<VectorRegister4Float> PositionX;
+    TArray<VectorRegister4Float> PositionY;
+    TArray<VectorRegister4Float> PositionZ;
+    TArray<VectorRegister4Float> BoneLength;
+};
+
+/**
+ * 多链批量 ArcDistributedIK
+ * 一个节点求解一只手的所有手指：逐链读取层级，闭式圆弧求解失败的链
+ * 按关节数分组，以4条链为一组用SIMD寄存器（SoA布局）同时运行FABRIK，
+ * 最后一次性写回全部链条
+ */
+USTRUCT(meta = (DisplayName = "Arc Distributed IK With Pole Target (Batched)",
+                Category = "Hierarchy",
+                Keywords = "N-Bone,IK,Pole,Arc,Batch,Finger",
+                Version = "5.7"))
+struct COMMON_API FRigUnit_ArcDistributedIKBatch
+    : public FRigUnit_HighlevelBaseMutable {
+    GENERATED_BODY()
+
+    UPROPERTY(meta = (Input))
+    TArray<FArcDistributedIKBatchChain> Chains;
+
+    UPROPERTY(meta = (Input))
+    FVector PrimaryAxis = FVector(1.0f, 0.0f, 0.0f);
+
+    UPROPERTY(meta = (Input))
+    FVector SecondAxis = FVector(0.0f, 1.0f, 0.0f);
+
+    UPROPERTY(meta = (Input))
+    float Precision = 0.001f;
+
+    UPROPERTY(meta = (Input))
+    int32 MaxIterations = 10;
+
+    /** 目标在可达范围内时先尝试闭式圆弧求解 */
+    UPROPERTY(meta = (Input))
+    bool bUseClosedFormSolver = true;
+
+    UPROPERTY(meta = (Input))
+    bool bPropagateToChildren = true;
+
+    UPROPERTY(meta = (Input))
+    bool bUseDebug = false;
+
+    /** 所有SIMD分组中使用的最大FABRIK迭代次数 */
+    UPROPERTY(meta = (Output))
+    int32 IterationsUsed = 0;
+
+    UPROPERTY(transient)
+    FRigUnit_ArcDistributedIKBatch_WorkData WorkData;
+
+    RIGVM_METHOD()
+    virtual void Execute() override;
+};
+
+namespace ArcDistributedIKSolver {
+/**
+ * 4条关节数相同的链同时运行FABRIK（SoA + 4路SIMD）
+ * Chains/BoneLengths/EffectorPositions 不足4条时用第一条填充，填充通道的结果丢弃
+ *
+ * @return 实际使用的迭代次数（4条链都收敛才提前结束）
+ */
+COMMON_API int32 SolveFABRIKBatch4(
+    TArrayView<TArray<FCCDIKChainLink>*> Chains,
+    TArrayView<const TArray<float>*> BoneLengths,
+    TArrayView<const FVector> EffectorPositions, float Precision,
+    int32 MaxIterations, FRigUnit_ArcDistributedIKBatch_WorkData& Scratch);
+}  // namespace ArcDistributedIKSolver
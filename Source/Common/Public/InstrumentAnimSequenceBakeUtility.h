@@ -0,0 +1,56 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "InstrumentAnimSequenceBakeUtility.generated.h"
+
+class AInstrumentBase;
+class ASkeletalMeshActor;
+class UAnimSequence;
+
+/**
+ * 动画序列烘焙工具
+ * 把 Level Sequence 中生成的 Control Rig 演奏逐帧求值为骨骼动画，
+ * 写成 UAnimSequence（可选附带 Morph Target 曲线），播放时不再运行 Control Rig
+ *
+ * 求值分块并行：每个工作线程持有一份独立的 Control Rig 实例，
+ * 负责一段连续的帧，互不共享层级和VM内存
+ *
+ * @note 每段的第一帧从源 Control Rig 的当前姿态开始求值，
+ *       IK 的热启动与输入记忆在段边界处重新开始
+ */
+UCLASS()
+class COMMON_API UInstrumentAnimSequenceBakeUtility : public UObject {
+    GENERATED_BODY()
+
+   public:
+    /**
+     * 烘焙乐器的所有角色（由 AInstrumentBase::GetPlaybackActors 提供）
+     * 资产命名为 AS_<乐器名>_<角色名>
+     *
+     * @param Instrument 乐器Actor
+     * @param PackageDir 资产目录，为空时使用当前 Level Sequence 所在目录
+     * @param bIncludeMorphTargetCurves 是否写入 Morph Target 曲线
+     * @return 成功烘焙的资产数量
+     */
+    UFUNCTION(BlueprintCallable, Category = "MusicDoll|Playback")
+    static int32 BakeInstrumentToAnimSequences(
+        AInstrumentBase* Instrument, const FString& PackageDir,
+        bool bIncludeMorphTargetCurves = true);
+
+    /**
+     * 烘焙一个骨骼网格Actor的 Control Rig Section 为动画序列
+     *
+     * @param SkeletalMeshActor 绑定了 Control Rig 的骨骼网格Actor
+     * @param bUseTakeSequences 是否从分段子序列中读取
+     * @param TakeSuffix 分段子序列后缀（Performer、Keys、Strings、Bow）
+     * @param PackagePath 资产的包路径，已存在时覆盖其中的动画数据
+     * @param bIncludeMorphTargetCurves 是否写入 Morph Target 曲线
+     * @param CurveTolerance Morph Target 曲线压缩允许的误差
+     * @return 创建或更新的动画序列，失败时返回nullptr
+     */
+    static UAnimSequence* BakeToAnimSequence(
+        ASkeletalMeshActor* SkeletalMeshActor, bool bUseTakeSequences,
+        const FString& TakeSuffix, const FString& PackagePath,
+        bool bIncludeMorphTargetCurves, float CurveTolerance = 0.001f);
+};
@@ -82,6 +82,93 @@ struct COMMON_API FRotationData
     }
 };
 
+/**
+ * 动画生成时的撤销记录方式
+ */
+UENUM(BlueprintType)
+enum class EGenerationUndoMode : uint8 {
+    /** 完整撤销：按引擎默认方式记录对象快照 */
+    Full = 0 UMETA(DisplayName = "Full"),
+    /** 轻量撤销：不记录对象快照，只把生成前的Section数据保存到磁盘 */
+    Light = 1 UMETA(DisplayName = "Light (on-disk record)"),
+    /** 不记录撤销 */
+    Disabled = 2 UMETA(DisplayName = "Disabled")
+};
+
+/**
+ * 局部重新生成的帧窗口
+ * 用于只重新生成 [StartFrame, EndFrame] 范围内的动画，窗口外的关键帧保持不变
+ *
+ * @note 帧号基于源文件的帧（即显示帧率），写入时再换算为 TickResolution
+ * @note StartFrame/EndFrame 小于0时表示未设置，处理整个片段
+ */
+USTRUCT(BlueprintType)
+struct COMMON_API FAnimationFrameWindow
+{
+    GENERATED_BODY()
+
+    /** 起始帧（包含） */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Frame Window")
+    int32 StartFrame;
+
+    /** 结束帧（包含） */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Frame Window")
+    int32 EndFrame;
+
+    /** 接缝混合帧数：窗口两端在该帧数内从旧曲线过渡到新数据 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Frame Window",
+              meta = (ClampMin = "0"))
+    int32 BlendFrames;
+
+    FAnimationFrameWindow()
+        : StartFrame(-1)
+        , EndFrame(-1)
+        , BlendFrames(0)
+    {
+    }
+
+    FAnimationFrameWindow(int32 InStartFrame, int32 InEndFrame, int32 InBlendFrames = 0)
+        : StartFrame(InStartFrame)
+        , EndFrame(InEndFrame)
+        , BlendFrames(InBlendFrames)
+    {
+    }
+
+    /** 是否设置了有效的窗口 */
+    bool IsSet() const
+    {
+        return StartFrame >= 0 && EndFrame >= StartFrame;
+    }
+
+    /** 帧是否在窗口内（未设置窗口时总是返回true） */
+    bool Contains(int32 Frame) const
+    {
+        return !IsSet() || (Frame >= StartFrame && Frame <= EndFrame);
+    }
+
+    /** 换算为 Tick 单位的闭区间 */
+    TRange<FFrameNumber> ToTickRange(FFrameRate TickResolution, FFrameRate DisplayRate) const
+    {
+        return TRange<FFrameNumber>::Inclusive(
+            ScaleFrame(StartFrame, TickResolution, DisplayRate),
+            ScaleFrame(EndFrame, TickResolution, DisplayRate));
+    }
+
+    /** 换算为 Tick 单位的混合长度 */
+    FFrameNumber GetBlendTicks(FFrameRate TickResolution, FFrameRate DisplayRate) const
+    {
+        return ScaleFrame(FMath::Max(BlendFrames, 0), TickResolution, DisplayRate);
+    }
+
+private:
+    static FFrameNumber ScaleFrame(int32 Frame, FFrameRate TickResolution, FFrameRate DisplayRate)
+    {
+        return FFrameNumber(static_cast<int32>(
+            static_cast<int64>(Frame) * TickResolution.Numerator * DisplayRate.Denominator /
+            (static_cast<int64>(TickResolution.Denominator) * DisplayRate.Numerator)));
+    }
+};
+
 /**
  * 批量插入关键帧的配置参数
  */
@@ -96,6 +183,9 @@ struct COMMON_API FBatchInsertKeyframesSettings
     /** 是否启用旋转插值优化 */
     bool bUnwrapRotationInterpolation;
 
+    /** 局部重新生成窗口（设置后只替换窗口内的关键帧，并保留Section原有范围） */
+    FAnimationFrameWindow FrameWindow;
+
     FBatchInsertKeyframesSettings()
         : FramePadding(1)
         , bUnwrapRotationInterpolation(true)
@@ -135,6 +225,50 @@ struct COMMON_API FMaterialParameterKeyframeData
     }
 };
 
+/**
+ * 材质参数轨道创建请求
+ * 用于批量创建Component Material Track及其标量参数
+ */
+USTRUCT(BlueprintType)
+struct COMMON_API FMaterialParameterTrackRequest
+{
+    GENERATED_BODY()
+
+    /** 材质槽索引 */
+    UPROPERTY()
+    int32 MaterialSlotIndex;
+
+    /** 材质槽名称（可选，提供时优先按名称匹配已有轨道） */
+    UPROPERTY()
+    FName MaterialSlotName;
+
+    /** 参数名称（如 "Pressed", "Vibration"） */
+    UPROPERTY()
+    FString ParameterName;
+
+    /** 初始值（写在Frame 0） */
+    UPROPERTY()
+    float InitialValue;
+
+    FMaterialParameterTrackRequest()
+        : MaterialSlotIndex(INDEX_NONE)
+        , MaterialSlotName(NAME_None)
+        , InitialValue(0.0f)
+    {
+    }
+
+    FMaterialParameterTrackRequest(int32 InSlotIndex,
+                                   const FString& InParameterName,
+                                   float InInitialValue = 0.0f,
+                                   FName InSlotName = NAME_None)
+        : MaterialSlotIndex(InSlotIndex)
+        , MaterialSlotName(InSlotName)
+        , ParameterName(InParameterName)
+        , InitialValue(InInitialValue)
+    {
+    }
+};
+
 // ========== 通用动画处理工具类 ==========
 
 /**
@@ -152,7 +286,8 @@ public:
 
     /**
      * 获取当前打开的 Level Sequence 和 Sequencer
-     * @param OutLevelSequence 输出：Level Sequence
+     * @param OutLevelSequence 输出：生成写入的 Level Sequence
+     * （分段子序列作用域内为聚焦的子序列，其它时候为根序列）
      * @param OutSequencer 输出：Sequencer
      * @return 是否成功获取
      */
@@ -160,6 +295,12 @@ public:
         ULevelSequence*& OutLevelSequence,
         TSharedPtr<ISequencer>& OutSequencer);
 
+    /**
+     * 生成写入的序列：分段子序列作用域内为聚焦的子序列，其它时候为根序列
+     * （用户进入子序列查看时，非分段生成仍写入根序列）
+     */
+    static ULevelSequence* GetGenerationTargetSequence(ISequencer& Sequencer);
+
     // ===== Control Rig 轨道操作 =====
 
     /**
@@ -241,6 +382,27 @@ public:
         const FString& ParameterName,
         float InitialValue = 0.0f);
 
+    /**
+     * 批量创建Component Material Track及材质参数
+     *
+     * 与逐槽调用FindOrCreateComponentMaterialTrack + AddMaterialParameter
+     * 的结果相同，但只扫描一次绑定上的已有轨道、只Modify一次MovieScene，
+     * 并在全部创建完成后只刷新一次Sequencer。
+     *
+     * @param LevelSequence Level Sequence
+     * @param ObjectBindingID 绑定的对象GUID（通常是SkeletalMeshComponent的绑定）
+     * @param Requests 创建请求列表（同一槽可以出现多次以添加多个参数）
+     * @param Sequencer 用于最终刷新的Sequencer（可为空）
+     * @param OutFailedRequestIndices 输出：失败的请求下标（可选）
+     * @return 成功的请求数量（参数已存在也计为成功）
+     */
+    static int32 BulkCreateMaterialParameterTracks(
+        ULevelSequence* LevelSequence,
+        const FGuid& ObjectBindingID,
+        const TArray<FMaterialParameterTrackRequest>& Requests,
+        TSharedPtr<ISequencer> Sequencer = nullptr,
+        TArray<int32>* OutFailedRequestIndices = nullptr);
+
     /**
      * 批量写入材质参数关键帧
      * 
@@ -254,10 +416,12 @@ public:
      * @note 使用AddScalarParameterKey逐个写入关键帧
      * 
      * @warning Section必须是UMovieSceneComponentMaterialParameterSection类型
+     * @note 设置FrameWindow时只替换窗口内的关键帧，窗口外的保留
      */
     static int32 WriteMaterialParameterKeyframes(
         UMovieSceneComponentMaterialParameterSection* Section,
-        const TArray<FMaterialParameterKeyframeData>& KeyframeData);
+        const TArray<FMaterialParameterKeyframeData>& KeyframeData,
+        const FAnimationFrameWindow& FrameWindow = FAnimationFrameWindow());
 
     // ===== 绑定查找与管理 =====
 
@@ -352,6 +516,87 @@ public:
      */
     static void LogAvailableChannels(UMovieSceneSection* Section);
 
+    // ===== 局部重新生成 =====
+
+    /**
+     * 删除通道中位于指定范围内的关键帧
+     *
+     * @param Channel 浮点通道
+     * @param TickRange Tick单位的范围
+     * @return 删除的关键帧数量
+     */
+    static int32 RemoveKeysInRange(FMovieSceneFloatChannel* Channel,
+                                   const TRange<FFrameNumber>& TickRange);
+
+    /**
+     * 用新关键帧替换通道中窗口内的关键帧，并在窗口两端做接缝混合
+     *
+     * 流程：
+     * 1. 旋转通道先整体平移360度的整数倍，与窗口外的旧曲线对齐
+     * 2. 在删除旧关键帧之前采样旧曲线，对距窗口边界BlendTicks内的新值做线性混合
+     * 3. 删除窗口内的旧关键帧
+     * 4. 写入新关键帧
+     *
+     * @param Channel 浮点通道
+     * @param Times 新关键帧时间（Tick单位）
+     * @param Values 新关键帧值（会被混合修改）
+     * @param TickWindow Tick单位的替换窗口
+     * @param BlendTicks Tick单位的混合长度
+     * @param bIsRotationChannel 是否为欧拉角旋转通道
+     * @return 删除的旧关键帧数量
+     *
+     * @note 只有窗口外存在旧关键帧的一侧才会混合
+     */
+    static int32 ReplaceChannelKeysInWindow(
+        FMovieSceneFloatChannel* Channel, const TArray<FFrameNumber>& Times,
+        TArray<FMovieSceneFloatValue>& Values,
+        const TRange<FFrameNumber>& TickWindow, FFrameNumber BlendTicks,
+        bool bIsRotationChannel = false);
+
+    // ===== 分段子序列（Take） =====
+
+    /**
+     * 查找或创建主序列下的分段子序列资产，并确保主序列的Sub Track引用它
+     *
+     * 子序列资产保存在主序列同目录的 "<主序列名>_Takes" 文件夹中，
+     * 命名为 "<主序列名>_<TakeName>"，帧率与主序列一致。
+     *
+     * @note Sub Section 对子序列是硬引用，打开主序列时仍会加载所有子序列；
+     *       分段只减少每次生成需要保存和提交的资产，不能延迟加载
+     *
+     * @param MasterSequence 主序列
+     * @param TakeName 分段名称（如 "Pianist_Performer"）
+     * @param OutSubSection 输出：主序列中引用该子序列的Sub Section
+     * @return 子序列，失败返回nullptr
+     */
+    static ULevelSequence* GetOrCreateTakeSequence(
+        ULevelSequence* MasterSequence, const FString& TakeName,
+        class UMovieSceneSubSection*& OutSubSection);
+
+    /**
+     * 将Actor及其子组件的绑定和轨道从源序列移动到目标序列
+     * 用于首次启用分段子序列时迁移已有的Control Rig轨道和材质轨道
+     * 目标序列已有同一绑定时合并到已有绑定，已有同类同名轨道时保留目标轨道
+     *
+     * @param Sequencer 当前Sequencer（必须聚焦在根序列上）
+     * @param SourceSequence 源序列
+     * @param TargetSequence 目标序列
+     * @param Actor 要迁移绑定的Actor
+     * @return 迁移的绑定数量
+     */
+    static int32 MoveActorBindingsToSequence(TSharedPtr<ISequencer> Sequencer,
+                                             ULevelSequence* SourceSequence,
+                                             ULevelSequence* TargetSequence,
+                                             AActor* Actor);
+
+    /**
+     * 根据子序列中所有Section的范围更新子序列播放范围和Sub Section范围
+     *
+     * @param SubSection 主序列中引用子序列的Sub Section
+     */
+    static void UpdateTakeSubSectionRange(
+        class UMovieSceneSubSection* SubSection);
+
     // ===== 旋转处理 =====
 
     /**
@@ -411,6 +656,25 @@ public:
         const TSet<FString>& ValidControllerNames,
         int32& OutKeyframesAdded);
 
+    /**
+     * 处理一个演奏动画帧对象（文件追踪和流式导入逐帧到达时使用）
+     * 支持 { "frame": N, "hand_infos": {...} }（StringFlow）和
+     * 控制器直接位于帧对象中、以帧序号为帧号（KeyRipple）两种结构
+     *
+     * @param FrameObject 帧对象
+     * @param FrameIndex 帧在流中的序号，没有 hand_infos 时作为帧号
+     * @param ControlKeyframeData 输出：关键帧数据Map
+     * @param ValidControllerNames 有效控制器名称集合
+     * @param OutKeyframesAdded 输出：添加的关键帧数
+     * @return 帧号，帧对象无效时返回 INDEX_NONE
+     */
+    static int32 ProcessFrameObject(
+        TSharedPtr<FJsonObject> FrameObject,
+        int32 FrameIndex,
+        TMap<FString, TArray<FAnimationKeyframe>>& ControlKeyframeData,
+        const TSet<FString>& ValidControllerNames,
+        int32& OutKeyframesAdded);
+
     /**
      * 提前提取旋转数据（通用方法）
      * 从控件容器中提取 H_rotation_L 和 H_rotation_R
@@ -466,3 +730,52 @@ public:
         UInstrumentAnimationUtility::LogAvailableChannels(Section);
     }
 };
+
+// ========== 分段子序列作用域 ==========
+
+/**
+ * 分段子序列生成作用域
+ *
+ * 启用时在构造中查找或创建该Actor对应的分段子序列，首次创建时把Actor已有的
+ * 绑定和轨道从主序列迁移过去，然后让Sequencer聚焦到子序列。作用域内
+ * GetActiveLevelSequenceAndSequencer 返回的就是子序列，所有写入只修改子序列资产；
+ * 析构时更新Sub Section范围，并还原用户原来聚焦的序列（包括嵌套的子序列）。
+ *
+ * 未启用时不做任何事情，保持写入主序列的原有行为。
+ */
+class COMMON_API FScopedTakeSequenceGeneration
+{
+public:
+    FScopedTakeSequenceGeneration(bool bEnabled, ASkeletalMeshActor* BoundActor,
+                                  const FString& TakeSuffix);
+    ~FScopedTakeSequenceGeneration();
+
+    FScopedTakeSequenceGeneration(const FScopedTakeSequenceGeneration&) = delete;
+    FScopedTakeSequenceGeneration& operator=(
+        const FScopedTakeSequenceGeneration&) = delete;
+
+    /** 是否已聚焦到分段子序列 */
+    bool IsActive() const { return bActive; }
+
+    /** 分段子序列，未启用时为nullptr */
+    ULevelSequence* GetTakeSequence() const { return TakeSequence.Get(); }
+
+    /** 是否有任一作用域正聚焦在分段子序列上（只在游戏线程访问） */
+    static bool IsAnyActive() { return NumActiveScopes > 0; }
+
+private:
+    /** 记录用户当前聚焦的子序列路径（从根序列向下的Sub Section） */
+    void SaveOriginalFocus();
+
+    /** 回到根序列后按记录的路径重新聚焦 */
+    void RestoreOriginalFocus();
+
+    TSharedPtr<ISequencer> Sequencer;
+    TWeakObjectPtr<ULevelSequence> TakeSequence;
+    TWeakObjectPtr<class UMovieSceneSubSection> SubSection;
+    TArray<TWeakObjectPtr<class UMovieSceneSubSection>> OriginalFocusPath;
+    bool bFocusChanged = false;
+    bool bActive = false;
+
+    static int32 NumActiveScopes;
+};
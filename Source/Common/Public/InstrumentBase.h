@@ -3,10 +3,26 @@
 #include "Animation/SkeletalMeshActor.h"
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "InstrumentAnimationUtility.h"
 #include "InstrumentBase.generated.h"
 
 // 前置声明
 class FInstrumentControlRigUtility;
+struct FInstrumentSyncFrameContext;
+
+/**
+ * 运行时播放中的一个角色（演奏者、钢琴、小提琴、琴弓……）
+ */
+struct FInstrumentPlaybackActor {
+    /** 演奏资产中的角色名 */
+    FName Role;
+
+    /** 绑定了 Control Rig 的骨骼网格Actor */
+    ASkeletalMeshActor* Actor = nullptr;
+
+    /** 分段子序列后缀（与生成动画时一致） */
+    FString TakeSuffix;
+};
 
 /**
  * 乐器通用基类，用于统一处理各种乐器相关的功能
@@ -24,6 +40,33 @@ class COMMON_API AInstrumentBase : public AActor {
    public:
     virtual void Tick(float DeltaTime) override;
 
+    /** 注册到 UInstrumentSyncSubsystem，由子系统统一调度实时同步 */
+    virtual void PostRegisterAllComponents() override;
+    virtual void PostUnregisterAllComponents() override;
+
+    // ========== 实时同步（由 UInstrumentSyncSubsystem 调度） ==========
+
+    /** 本帧是否需要同步 */
+    virtual bool NeedsRealtimeSync() const { return false; }
+
+    /** 游戏线程：从共享数据中读取本帧需要的 Control Rig 和变换 */
+    virtual void GatherRealtimeSync(const FInstrumentSyncFrameContext& Context) {}
+
+    /** 工作线程：只做数学计算，不得访问UObject */
+    virtual void ComputeRealtimeSync() {}
+
+    /** 游戏线程：把计算结果写回 Control Rig */
+    virtual void ApplyRealtimeSync() {}
+
+    /** 立即同步这件乐器，不等待子系统的下一次Tick */
+    void SyncRealtimeNow();
+
+    /**
+     * 烘焙运行时演奏资产时需要导出的角色
+     * 基类只提供演奏者，各乐器追加自己的乐器Actor
+     */
+    virtual void GetPlaybackActors(TArray<FInstrumentPlaybackActor>& OutActors) const;
+
     /** 演奏者的骨骼 */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Basic Properties")
     ASkeletalMeshActor* SkeletalMeshActor;
@@ -35,4 +78,23 @@ class COMMON_API AInstrumentBase : public AActor {
     /** 动画文件路径 */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IO Configuration")
     FString AnimationFilePath;
+
+    /** 局部重新生成窗口（显示帧），未设置时整体重新生成动画 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite,
+              Category = "Animation Generation")
+    FAnimationFrameWindow RegenerationWindow;
+
+    /**
+     * 分段子序列模式：每个生成结果（演奏者、琴键/琴弦及材质）写入独立的
+     * Level Sequence资产，主序列只通过Sub Track引用
+     * （Sub Track 是硬引用，打开主序列时子序列仍会一起加载）
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite,
+              Category = "Animation Generation")
+    bool bUseTakeSequences = false;
+
+    /** 生成动画时的撤销记录方式，大批量导入时用Light或Disabled限制事务缓冲区内存 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite,
+              Category = "Animation Generation")
+    EGenerationUndoMode GenerationUndoMode = EGenerationUndoMode::Full;
 };
\ No newline at end of file
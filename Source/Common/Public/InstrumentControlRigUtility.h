@@ -3,6 +3,8 @@
 #include "Animation/SkeletalMeshActor.h"
 #include "CoreMinimal.h"
 
+class ISequencer;
+class ULevelSequence;
 class UControlRig;
 class UControlRigBlueprint;
 
@@ -31,6 +33,21 @@ class COMMON_API FInstrumentControlRigUtility {
         UControlRig*& OutControlRigInstance,
         UControlRigBlueprint*& OutControlRigBlueprint);
 
+    /**
+     * 一次遍历序列中的全部 Control Rig 绑定，收集每个骨骼网格Actor对应的实例
+     * 多个Actor都需要查找 Control Rig 时代替逐个调用
+     * GetControlRigFromSkeletalMeshActor
+     *
+     * @param LevelSequence 要查询的 Level Sequence
+     * @param Sequencer 打开该序列的 Sequencer（用于解析绑定对象）
+     * @param OutControlRigs 输出参数：Actor -> Control Rig 实例
+     *
+     * @note 同一个Actor有多个绑定时保留第一个，与 GetControlRigFromSkeletalMeshActor 一致
+     */
+    static void CollectControlRigBindings(
+        ULevelSequence* LevelSequence, ISequencer& Sequencer,
+        TMap<const ASkeletalMeshActor*, UControlRig*>& OutControlRigs);
+
     /**
      * 从 Control Rig 中获取指定 Control 的世界变換
      *
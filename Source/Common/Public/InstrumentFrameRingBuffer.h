@@ -0,0 +1,66 @@
+﻿#pragma once
+
+#include <atomic>
+
+#include "CoreMinimal.h"
+
+/**
+ * 单生产者单消费者的无锁环形缓冲区
+ * 用于读取线程向游戏线程传递演奏帧：生产者只写 Tail，消费者只写 Head，
+ * 两端各自在自己的线程上调用，不需要加锁
+ *
+ * @note 容量向上取整为2的幂，实际可存放 Capacity 个元素
+ */
+template <typename ElementType>
+class TInstrumentFrameRingBuffer {
+   public:
+    explicit TInstrumentFrameRingBuffer(uint32 InCapacity)
+        : Mask(FMath::RoundUpToPowerOfTwo(FMath::Max<uint32>(InCapacity, 2)) -
+               1) {
+        Slots.SetNum(Mask + 1);
+    }
+
+    TInstrumentFrameRingBuffer(const TInstrumentFrameRingBuffer&) = delete;
+    TInstrumentFrameRingBuffer& operator=(const TInstrumentFrameRingBuffer&) =
+        delete;
+
+    /** 生产者线程：写入一个元素，缓冲区已满时返回false且不移动元素 */
+    bool Push(ElementType&& Element) {
+        const uint32 CurrentTail = Tail.load(std::memory_order_relaxed);
+        if (CurrentTail - Head.load(std::memory_order_acquire) > Mask) {
+            return false;
+        }
+
+        Slots[CurrentTail & Mask] = MoveTemp(Element);
+        Tail.store(CurrentTail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** 消费者线程：取出最早的元素，缓冲区为空时返回false */
+    bool Pop(ElementType& OutElement) {
+        const uint32 CurrentHead = Head.load(std::memory_order_relaxed);
+        if (CurrentHead == Tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        OutElement = MoveTemp(Slots[CurrentHead & Mask]);
+        Head.store(CurrentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** 任意线程：当前元素数量的近似值 */
+    uint32 Num() const {
+        return Tail.load(std::memory_order_acquire) -
+               Head.load(std::memory_order_acquire);
+    }
+
+    uint32 GetCapacity() const { return Mask + 1; }
+
+   private:
+    const uint32 Mask;
+    TArray<ElementType> Slots;
+
+    // 分开缓存行，避免生产者和消费者互相使对方的缓存行失效
+    alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> Head{0};
+    alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> Tail{0};
+};
@@ -0,0 +1,204 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "InstrumentAnimationUtility.h"
+
+class FScopedTransaction;
+class UControlRig;
+class ULevelSequence;
+class USkeletalMeshComponent;
+class UMovieSceneSection;
+
+/**
+ * 生成结果指纹
+ * 按顺序累积所有影响生成结果的输入（源文件内容、Rig层级、插入设置、帧率、
+ * Actor参数），输入完全相同时得到相同的指纹
+ */
+class COMMON_API FGenerationFingerprint {
+   public:
+    /** 累积文件内容的MD5（文件不存在时只累积路径） */
+    void AddFile(const FString& FilePath);
+
+    void AddString(const FString& Value);
+
+    void AddInt(int64 Value);
+
+    void AddFrameRate(const FFrameRate& FrameRate);
+
+    /** 累积批量插入设置（帧填充、特殊控制器规则、旋转展开、局部窗口） */
+    void AddSettings(const FBatchInsertKeyframesSettings& Settings);
+
+    /** 累积Control Rig层级：所有元素的名称、类型和初始全局变换 */
+    void AddControlRigHierarchy(UControlRig* ControlRig);
+
+    /** 累积材质槽：槽名称和当前材质（决定哪些槽生成材质参数轨道） */
+    void AddMaterialSlots(USkeletalMeshComponent* MeshComponent);
+
+    /** 返回十六进制指纹字符串 */
+    FString ToString() const;
+
+   private:
+    TArray<uint8> Buffer;
+};
+
+/**
+ * 生成结果缓存
+ * 以指纹为键，把生成后的Section浮点通道数据保存到本地派生数据目录
+ * （Saved/MusicDoll/DerivedDataCache）。输入没有变化时直接从缓存恢复
+ * 通道数据，跳过JSON解析、数据转换和逐通道写入。
+ *
+ * 命中时刷新文件时间戳；每次写入后删除超过 MaxCacheAge 未使用的文件，
+ * 总大小超过 MaxCacheBytes 时再按最近最少使用的顺序删除。
+ */
+class COMMON_API FInstrumentGenerationCache {
+   public:
+    /** 缓存目录的总大小上限 */
+    static constexpr int64 MaxCacheBytes = 512ll * 1024 * 1024;
+
+    /** 缓存文件未被使用的最长天数 */
+    static constexpr int32 MaxCacheAgeDays = 30;
+
+    /** 缓存目录 */
+    static FString GetCacheDirectory();
+
+    /**
+     * 按年龄和总大小清理缓存目录
+     *
+     * @param KeepPath 不删除的文件（刚写入的缓存）
+     * @return 删除的文件数量
+     */
+    static int32 TrimCacheDirectory(const FString& KeepPath = FString());
+
+    /**
+     * 保存Section中属于指定控制器的浮点通道
+     *
+     * @param Fingerprint 生成指纹
+     * @param Section 已写入关键帧的Section
+     * @param ControlNames 控制器名称集合，为空时保存所有浮点通道
+     * @return 是否保存成功
+     */
+    static bool StoreSectionChannels(const FString& Fingerprint,
+                                     UMovieSceneSection* Section,
+                                     const TSet<FString>& ControlNames);
+
+    /**
+     * 从缓存恢复Section的浮点通道和范围
+     *
+     * @param Fingerprint 生成指纹
+     * @param Section 目标Section
+     * @return 命中并恢复成功返回true
+     */
+    static bool RestoreSectionChannels(const FString& Fingerprint,
+                                       UMovieSceneSection* Section);
+
+    /**
+     * 把多个Section的浮点通道保存到同一个缓存文件（按数组顺序）
+     * 用于乐器生成：Control Rig Section 和由它派生的材质参数Section一起缓存
+     */
+    static bool StoreSectionChannels(
+        const FString& Fingerprint, const TArray<UMovieSceneSection*>& Sections,
+        const TSet<FString>& ControlNames = TSet<FString>());
+
+    /**
+     * 按保存时的顺序恢复多个Section，Section数量或通道不一致时视为未命中，
+     * 此时不修改任何Section
+     */
+    static bool RestoreSectionChannels(
+        const FString& Fingerprint, const TArray<UMovieSceneSection*>& Sections);
+
+    /**
+     * 收集乐器生成写入的Section：乐器Control Rig Section，以及可选的组件
+     * 材质参数Section（按材质槽顺序，每条轨道取第一个Section）
+     *
+     * @return Control Rig Section 不存在时返回false
+     */
+    static bool CollectInstrumentSections(
+        ASkeletalMeshActor* Instrument, bool bIncludeMaterialTracks,
+        TArray<UMovieSceneSection*>& OutSections);
+
+    /**
+     * 生成完成后把乐器Section（见 CollectInstrumentSections）保存到缓存
+     * 指纹为空（局部重新生成）时不做任何事情
+     */
+    static bool StoreInstrumentSections(const FString& Fingerprint,
+                                        ASkeletalMeshActor* Instrument,
+                                        bool bIncludeMaterialTracks);
+
+    /** 查找Control Rig轨道的第一个Section（与BatchInsertControlRigKeys一致） */
+    static UMovieSceneSection* FindControlRigSection(
+        ULevelSequence* LevelSequence, UControlRig* ControlRigInstance);
+
+    /**
+     * 把Section中属于指定控制器的浮点通道写到指定文件（不参与缓存淘汰）
+     * @return 是否写入成功
+     */
+    static bool WriteSectionChannels(
+        const FString& PayloadPath, const TArray<UMovieSceneSection*>& Sections,
+        const TSet<FString>& ControlNames);
+
+    /**
+     * 从指定文件恢复Section的浮点通道和范围
+     * @return 文件存在且恢复成功返回true
+     */
+    static bool ReadSectionChannels(
+        const FString& PayloadPath, const TArray<UMovieSceneSection*>& Sections);
+
+    /**
+     * 轻量撤销记录目录（Saved/MusicDoll/UndoRecords）
+     * 与缓存目录分开，TrimCacheDirectory 不会淘汰撤销记录；
+     * 每个记录名称只保留最近一次生成前的数据
+     */
+    static FString GetUndoRecordDirectory();
+
+    /**
+     * 恢复轻量撤销模式下保存的生成前数据
+     *
+     * @param SkeletalMeshActor 绑定了Control Rig的骨骼网格Actor
+     * @param RecordName 生成时使用的记录名称
+     * @return 是否恢复成功
+     */
+    static bool RestorePreviousGeneration(ASkeletalMeshActor* SkeletalMeshActor,
+                                          const FString& RecordName);
+};
+
+/**
+ * 生成撤销模式作用域
+ *
+ * Full 模式在作用域内打开一个事务，生成过程中的修改作为一次撤销记录进入
+ * 编辑器事务缓冲区。Light 和 Disabled 模式不打开事务，对象快照不进入缓冲区；
+ * Light 模式额外把生成前的Section数据写到磁盘作为唯一的撤销记录，可通过
+ * FInstrumentGenerationCache::RestorePreviousGeneration 恢复。
+ *
+ * 外层已有活动事务时修改总会进入外层事务，此时退回 Full 模式。
+ */
+class COMMON_API FScopedGenerationUndoMode {
+   public:
+    FScopedGenerationUndoMode(EGenerationUndoMode InMode,
+                              const FString& InRecordName);
+    ~FScopedGenerationUndoMode();
+
+    FScopedGenerationUndoMode(const FScopedGenerationUndoMode&) = delete;
+    FScopedGenerationUndoMode& operator=(const FScopedGenerationUndoMode&) =
+        delete;
+
+    /** Light模式下保存Section中指定控制器的生成前数据，其它模式不做任何事情 */
+    void RecordPreviousSection(UMovieSceneSection* Section,
+                               const TSet<FString>& ControlNames);
+
+    /**
+     * Light模式下保存乐器Control Rig Section的全部浮点通道（琴键/琴弦曲线）
+     * @note 材质参数轨道不在记录内，恢复后需重新生成材质动画
+     */
+    void RecordPreviousInstrumentSection(ASkeletalMeshActor* Instrument);
+
+    /** 输出事务缓冲区和进程内存在生成前后的变化 */
+    void LogMemoryReport() const;
+
+   private:
+    EGenerationUndoMode Mode;
+    FString RecordName;
+    TUniquePtr<FScopedTransaction> Transaction;
+    SIZE_T UndoSizeBefore = 0;
+    uint64 UsedPhysicalBefore = 0;
+    bool bRecorded = false;
+};
@@ -0,0 +1,172 @@
+﻿#pragma once
+
+#include <atomic>
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "ILiveLinkSource.h"
+#include "InstrumentFrameRingBuffer.h"
+#include "LiveLinkTypes.h"
+
+class FRunnableThread;
+class ILiveLinkClient;
+
+/**
+ * 从分段到达的字节流中切出完整的顶层JSON对象
+ * 只按花括号配对（跳过字符串内容），对象之间的 '['、','、']' 和空白被忽略，
+ * 因此正在写入的JSON数组文件和每行一个对象的文件都可以直接读取
+ */
+class COMMON_API FInstrumentJsonObjectScanner {
+   public:
+    /** 追加新读到的UTF-8字节 */
+    void Append(const uint8* Data, int32 Num);
+
+    /** 取出下一个完整的对象，没有完整对象时返回false */
+    bool PopObject(FString& OutJson);
+
+    void Reset();
+
+   private:
+    TArray<uint8> Buffer;
+    int32 ScanOffset = 0;
+    int32 ObjectStart = INDEX_NONE;
+    int32 Depth = 0;
+    bool bInString = false;
+    bool bEscape = false;
+};
+
+/**
+ * 演奏流中的一帧
+ * Controls 中的下标对应 Live Link Subject 的骨骼（控制器）顺序，
+ * 本帧没有数据的控制器保持上一帧的值
+ */
+struct FInstrumentLiveLinkFrame {
+    int32 FrameNumber = 0;
+    TArray<TPair<int32, FTransform>> Controls;
+};
+
+/**
+ * 一个 Live Link Subject 对应的演奏动画流
+ */
+struct FInstrumentLiveLinkStream {
+    /** Subject 名称 */
+    FName SubjectName;
+
+    /**
+     * 外部工具正在写入的演奏动画文件（结构与生成动画时读取的文件相同）
+     * 多个文件（如左右手）的帧合并到同一个 Subject
+     */
+    TArray<FString> FilePaths;
+
+    /** 有效的控制器名称，作为 Subject 的骨骼名 */
+    TSet<FString> ControllerNames;
+};
+
+/**
+ * 演奏动画 Live Link 源
+ *
+ * 读取线程持续追踪外部工具正在写入的演奏动画文件，把新出现的帧解析为控制器变换，
+ * 经无锁环形缓冲区交给游戏线程，在 Update() 中按帧推送给 Live Link
+ * （Animation 角色，每个控制器一根无父级的骨骼，变换为 Control 的值）
+ *
+ * 用于在外部工具生成过程中实时预览，不需要先把关键帧写入 Level Sequence；
+ * Control Rig 中用 Live Link 节点读取 Subject 的变换并设置到同名 Control
+ *
+ * @note 文件变短时视为重新开始写入，从头读取
+ */
+class COMMON_API FInstrumentLiveLinkSource : public ILiveLinkSource,
+                                             public FRunnable {
+   public:
+    FInstrumentLiveLinkSource(const FString& InSourceName,
+                              TArray<FInstrumentLiveLinkStream> InStreams,
+                              FFrameRate InFrameRate);
+    virtual ~FInstrumentLiveLinkSource();
+
+    /**
+     * 添加（或替换同名的）预览源，帧率取当前 Level Sequence 的显示帧率
+     *
+     * @param SourceName 源名称（通常为乐器Actor的标签）
+     * @param Streams 要追踪的演奏动画流
+     * @return Live Link 插件可用且源已添加时返回true
+     */
+    static bool StartPreview(const FString& SourceName,
+                             TArray<FInstrumentLiveLinkStream> Streams);
+
+    /**
+     * 移除 StartPreview 添加的同名预览源
+     * @return 是否存在并移除了该源
+     */
+    static bool StopPreview(const FString& SourceName);
+
+    /**
+     * 把一个帧对象解析为控制器变换
+     * 支持 { "frame": N, "hand_infos": {...} }（StringFlow）和
+     * 控制器直接位于帧对象中、以帧在文件中的序号为帧号（KeyRipple）两种结构
+     *
+     * @param FrameObject 帧对象
+     * @param FrameIndex 帧在文件中的序号，没有 "frame" 字段时作为帧号
+     * @param ControllerNames 有效控制器名称
+     * @param ControllerIndices 控制器名称到 Subject 骨骼下标的映射
+     * @param OutFrame [out] 解析结果
+     * @return 帧对象是否有效
+     */
+    static bool ParseFrame(const TSharedPtr<class FJsonObject>& FrameObject,
+                           int32 FrameIndex,
+                           const TSet<FString>& ControllerNames,
+                           const TMap<FString, int32>& ControllerIndices,
+                           FInstrumentLiveLinkFrame& OutFrame);
+
+    // ========== ILiveLinkSource =========
+    virtual void ReceiveClient(ILiveLinkClient* InClient,
+                               FGuid InSourceGuid) override;
+    virtual void Update() override;
+    virtual bool IsSourceStillValid() const override;
+    virtual bool RequestSourceShutdown() override;
+    virtual FText GetSourceType() const override;
+    virtual FText GetSourceMachineName() const override;
+    virtual FText GetSourceStatus() const override;
+
+    // ========== FRunnable =========
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+   private:
+    /** 读取线程对一个文件的追踪位置 */
+    struct FFileCursor {
+        FString FilePath;
+        int64 ReadOffset = 0;
+        int32 NumFramesParsed = 0;
+        FInstrumentJsonObjectScanner Scanner;
+    };
+
+    /** 一个流在两个线程上的状态 */
+    struct FStreamState {
+        FInstrumentLiveLinkStream Stream;
+        TArray<FName> BoneNames;
+        TMap<FString, int32> BoneIndices;
+        FLiveLinkSubjectKey SubjectKey;
+
+        /** 读取线程 -> 游戏线程 */
+        TUniquePtr<TInstrumentFrameRingBuffer<FInstrumentLiveLinkFrame>> Frames;
+
+        // 仅读取线程访问
+        TArray<FFileCursor> Files;
+
+        // 仅游戏线程访问
+        TArray<FTransform> LatestTransforms;
+    };
+
+    /** 读取线程：读取文件新增的内容并解析出完整的帧，返回是否读到了新数据 */
+    bool PollFile(FStreamState& State, FFileCursor& File);
+
+    FString SourceName;
+    FFrameRate FrameRate;
+    TArray<FStreamState> Streams;
+
+    ILiveLinkClient* Client = nullptr;
+    FGuid SourceGuid;
+
+    TUniquePtr<FRunnableThread> ReaderThread;
+    std::atomic<bool> bStopRequested{false};
+    std::atomic<int32> NumFramesRead{0};
+};
@@ -2,6 +2,7 @@
 
 #include "CoreMinimal.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "InstrumentAnimationUtility.h"
 #include "MovieSceneSection.h"
 #include "Rigs/RigHierarchy.h"
 #include "UObject/NoExportTypes.h"
@@ -147,11 +148,14 @@ class COMMON_API UInstrumentMorphTargetUtility : public UObject {
      * @note 帧数转换公式: ScaledFrame = Frame * TickRes.Num * DisplayRate.Den /
      * (TickRes.Den * DisplayRate.Num)
      * @note 如果同一个Morph Target在数据中出现多次，关键帧会被追加（不会覆盖）
+     * @note 设置FrameWindow时只保留窗口内的关键帧；窗口内没有关键帧的Morph
+     * Target也会保留空条目，以便写入时清除窗口内的旧关键帧
      */
     static bool ProcessMorphTargetKeyframeData(
         const TArray<TSharedPtr<FJsonValue>>& KeyDataArray,
         TArray<FMorphTargetKeyframeData>& OutKeyframeData,
-        FFrameRate TickResolution, FFrameRate DisplayRate);
+        FFrameRate TickResolution, FFrameRate DisplayRate,
+        const FAnimationFrameWindow& FrameWindow = FAnimationFrameWindow());
 
     /**
      * 批量写入Morph Target关键帧到Control Rig Section
@@ -167,10 +171,12 @@ class COMMON_API UInstrumentMorphTargetUtility : public UObject {
      * @note 如果找不到对应的通道，会输出警告并跳过
      *
      * @warning Section必须属于Control Rig Parameter Track
+     * @note 设置FrameWindow时只替换窗口内的关键帧，窗口外的保留
      */
     static int32 WriteMorphTargetKeyframes(
         UMovieSceneSection* Section,
-        const TArray<FMorphTargetKeyframeData>& KeyframeData);
+        const TArray<FMorphTargetKeyframeData>& KeyframeData,
+        const FAnimationFrameWindow& FrameWindow = FAnimationFrameWindow());
 
     /**
      * 通用的Morph Target动画写入完整流程
@@ -189,11 +195,13 @@ class COMMON_API UInstrumentMorphTargetUtility : public UObject {
      * @param LevelSequence 关卡序列
      * @param RootControlName Root Control名称 (如 "piano_key_root" 或
      * "violin_root")
+     * @param FrameWindow 局部重新生成窗口，设置后保留现有Section，只替换窗口内的关键帧
      * @return 成功写入的Morph Target数量，失败返回0
      */
     static int32 WriteMorphTargetAnimationToControlRig(
         class ASkeletalMeshActor* Instrument,
         const TArray<FMorphTargetKeyframeData>& KeyframeData,
         class ULevelSequence* LevelSequence,
-        const FString& RootControlName = TEXT("piano_key_root"));
+        const FString& RootControlName = TEXT("piano_key_root"),
+        const FAnimationFrameWindow& FrameWindow = FAnimationFrameWindow());
 };
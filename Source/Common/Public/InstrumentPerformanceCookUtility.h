@@ -0,0 +1,54 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "InstrumentPerformanceCookUtility.generated.h"
+
+class AInstrumentBase;
+class ASkeletalMeshActor;
+class UMusicDollPerformanceAsset;
+
+/**
+ * 演奏烘焙工具
+ * 把 Level Sequence 中 Control Rig Section 的曲线按显示帧率采样、压缩后写入
+ * UMusicDollPerformanceAsset，供 MusicDollRuntime 模块的
+ * UMusicDollPlaybackComponent 在打包后的游戏中直接播放（不需要 Sequencer）
+ *
+ * 变换 Control 写为6通道曲线，动画通道（琴键、琴弦 Morph Target 等）写为浮点曲线
+ *
+ * @note 材质参数轨道不在烘焙范围内
+ */
+UCLASS()
+class COMMON_API UInstrumentPerformanceCookUtility : public UObject {
+    GENERATED_BODY()
+
+   public:
+    /**
+     * 烘焙乐器的整场演奏（演奏者和乐器由 AInstrumentBase::GetPlaybackActors 提供）
+     *
+     * @param Instrument 乐器Actor
+     * @param PackagePath 资产的包路径，如 /Game/Performances/PA_Violin
+     * @param Tolerance 压缩允许的误差（厘米/度/通道值）
+     * @return 创建或更新的资产，失败时返回nullptr
+     */
+    UFUNCTION(BlueprintCallable, Category = "MusicDoll|Playback")
+    static UMusicDollPerformanceAsset* CookInstrumentPerformance(
+        AInstrumentBase* Instrument, const FString& PackagePath,
+        float Tolerance = 0.001f);
+
+    /**
+     * 烘焙一个骨骼网格Actor的 Control Rig Section 到资产中的一个角色
+     *
+     * @param SkeletalMeshActor 绑定了 Control Rig 的骨骼网格Actor
+     * @param Role 资产中的角色名
+     * @param bUseTakeSequences 是否从分段子序列中读取
+     * @param TakeSuffix 分段子序列后缀（Performer、Keys、Strings、Bow）
+     * @param Tolerance 压缩允许的误差
+     * @param Asset 目标资产，同名角色的轨道会被替换
+     * @return 是否成功
+     */
+    static bool CookControlRigTrack(ASkeletalMeshActor* SkeletalMeshActor,
+                                    FName Role, bool bUseTakeSequences,
+                                    const FString& TakeSuffix, float Tolerance,
+                                    UMusicDollPerformanceAsset* Asset);
+};
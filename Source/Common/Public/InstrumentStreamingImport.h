@@ -0,0 +1,125 @@
+﻿#pragma once
+
+#include <atomic>
+
+#include "Containers/Ticker.h"
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "InstrumentAnimationUtility.h"
+#include "InstrumentFrameRingBuffer.h"
+#include "InstrumentStreamingProtocol.h"
+
+class ASkeletalMeshActor;
+class FRunnableThread;
+
+/**
+ * 流式导入的配置
+ */
+struct FInstrumentStreamingImportSettings {
+    /** 会话名称（通常为乐器Actor的标签），同名会话会被替换 */
+    FString SessionName;
+
+    /** 外部工具监听的本地端口 */
+    int32 Port = InstrumentStreamingProtocol::DefaultPort;
+
+    /** 写入关键帧的演奏者 */
+    TWeakObjectPtr<ASkeletalMeshActor> PerformerActor;
+
+    /** 是否写入分段子序列，以及子序列后缀（与生成动画时一致） */
+    bool bUseTakeSequences = false;
+    FString TakeSuffix = TEXT("Performer");
+
+    /** 有效的控制器名称 */
+    TSet<FString> ControllerNames;
+
+    /** 开始导入前清空这些控制器的关键帧 */
+    TSet<FString> ControllerNamesToClean;
+
+    /** 批量插入设置（FrameWindow 由每次写入的时间范围决定） */
+    FBatchInsertKeyframesSettings InsertSettings;
+
+    /** 把新到达的帧写入 Level Sequence 的间隔（秒） */
+    float FlushInterval = 0.5f;
+};
+
+/**
+ * 流式导入会话
+ *
+ * 读取线程连接外部工具的本地端口（InstrumentStreamingProtocol），把收到的帧
+ * 解析为关键帧，经无锁环形缓冲区交给游戏线程追加到内存中的关键帧存储；
+ * 游戏线程每隔 FlushInterval 把新到达的时间范围用 BatchInsertControlRigKeys
+ * 写入 Level Sequence（窗口模式，只替换新范围内的关键帧）
+ *
+ * 外部工具不需要先写完整个JSON文件，生成开始几秒后即可在 Sequencer 中看到结果
+ *
+ * @note 外部工具尚未启动时每隔一段时间重试连接
+ */
+class COMMON_API FInstrumentStreamingImportSession
+    : public FRunnable,
+      public TSharedFromThis<FInstrumentStreamingImportSession> {
+   public:
+    explicit FInstrumentStreamingImportSession(
+        FInstrumentStreamingImportSettings InSettings);
+    virtual ~FInstrumentStreamingImportSession();
+
+    /**
+     * 开始（或替换同名的）流式导入会话
+     * 清空 ControllerNamesToClean 的关键帧后开始连接
+     * @return 演奏者的 Control Rig 轨道可用且读取线程已启动时返回true
+     */
+    static bool StartSession(FInstrumentStreamingImportSettings Settings);
+
+    /**
+     * 停止同名会话，已到达的帧会先写入 Level Sequence
+     * @return 是否存在该会话
+     */
+    static bool StopSession(const FString& SessionName);
+
+    /** 同名会话是否仍在运行 */
+    static bool IsSessionRunning(const FString& SessionName);
+
+    // ========== FRunnable =========
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+   private:
+    /** 一帧解析后的关键帧（每个控制器一个） */
+    struct FStreamedFrame {
+        int32 FrameNumber = 0;
+        TMap<FString, TArray<FAnimationKeyframe>> Controls;
+    };
+
+    /** 游戏线程：清空旧关键帧并启动读取线程 */
+    bool Begin();
+
+    /** 游戏线程：取出新帧，按间隔写入 Level Sequence，读取结束后移除会话 */
+    bool Tick(float DeltaTime);
+
+    /** 游戏线程：把还没写入的关键帧写入 Level Sequence */
+    void Flush();
+
+    /** 读取线程：处理一条消息，返回是否为结束消息 */
+    bool HandleMessage(InstrumentStreamingProtocol::EMessageType Type,
+                       const TArray<uint8>& Payload);
+
+    FInstrumentStreamingImportSettings Settings;
+
+    TInstrumentFrameRingBuffer<FStreamedFrame> Frames;
+    TUniquePtr<FRunnableThread> ReaderThread;
+    std::atomic<bool> bStopRequested{false};
+    std::atomic<bool> bReaderFinished{false};
+
+    // 仅读取线程访问
+    int32 NumFramesReceived = 0;
+
+    // 仅游戏线程访问
+    FTSTicker::FDelegateHandle TickerHandle;
+    TMap<FString, TArray<FAnimationKeyframe>> KeyframeStore;
+    TMap<FString, int32> FlushedKeyframeCounts;
+    int32 PendingStartFrame = MAX_int32;
+    int32 PendingEndFrame = MIN_int32;
+    double LastFlushTime = 0.0;
+    double StartTime = 0.0;
+    double FirstFlushTime = 0.0;
+    int32 NumFramesImported = 0;
+};
@@ -0,0 +1,115 @@
+﻿#pragma once
+
+#include <atomic>
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+
+class FRunnableThread;
+class FSocket;
+
+/**
+ * 本地流式导入协议
+ *
+ * 外部工具（服务端）在 localhost TCP 端口上逐帧发送消息，插件作为客户端连接。
+ * 每条消息为：
+ *
+ *   uint32 PayloadSize（小端） | uint8 MessageType | Payload（PayloadSize 字节）
+ *
+ * Frame 消息的 Payload 是一个UTF-8编码的帧对象，结构与演奏动画文件中的帧相同；
+ * End 消息没有 Payload，表示本次生成已结束
+ */
+namespace InstrumentStreamingProtocol {
+/** 默认端口 */
+static constexpr int32 DefaultPort = 47810;
+
+/** 消息头字节数 */
+static constexpr int32 HeaderSize = 5;
+
+/** 单条消息 Payload 的上限，超过时视为数据损坏 */
+static constexpr uint32 MaxPayloadSize = 16 * 1024 * 1024;
+
+enum class EMessageType : uint8 {
+    Frame = 1,
+    End = 2,
+};
+
+/** 把一条消息编码后追加到 OutBytes */
+COMMON_API void EncodeMessage(EMessageType Type, TConstArrayView<uint8> Payload,
+                              TArray<uint8>& OutBytes);
+
+/** 把一个帧对象的JSON编码为 Frame 消息后追加到 OutBytes */
+COMMON_API void EncodeFrameMessage(const FString& FrameJson,
+                                   TArray<uint8>& OutBytes);
+}  // namespace InstrumentStreamingProtocol
+
+/**
+ * 从分段到达的字节流中切出完整的消息
+ */
+class COMMON_API FInstrumentStreamMessageDecoder {
+   public:
+    /** 追加收到的字节 */
+    void Append(const uint8* Data, int32 Num);
+
+    /**
+     * 取出下一条完整的消息
+     * @return 没有完整消息或数据损坏时返回false
+     */
+    bool PopMessage(InstrumentStreamingProtocol::EMessageType& OutType,
+                    TArray<uint8>& OutPayload);
+
+    /** 消息头无效（类型未知或长度超过上限） */
+    bool HasError() const { return bError; }
+
+    void Reset();
+
+   private:
+    TArray<uint8> Buffer;
+    int32 ReadOffset = 0;
+    bool bError = false;
+};
+
+/**
+ * 回放服务器：把一个演奏动画文件按指定帧率逐帧发送给连接上来的客户端
+ * 作为外部工具的替身，用于测试和演示流式导入
+ *
+ * 控制台命令：MusicDoll.StreamReplay <文件路径> [端口] [帧率]
+ */
+class COMMON_API FInstrumentStreamReplayServer : public FRunnable {
+   public:
+    /**
+     * @param InFilePath 演奏动画JSON文件（帧对象数组）
+     * @param InPort 监听的本地端口
+     * @param InFramesPerSecond 发送帧率，小于等于0时不限速
+     */
+    FInstrumentStreamReplayServer(const FString& InFilePath, int32 InPort,
+                                  float InFramesPerSecond);
+    virtual ~FInstrumentStreamReplayServer();
+
+    /** 开始监听，端口被占用时返回false */
+    bool Start();
+
+    /** 是否已发送完毕（或已停止） */
+    bool IsFinished() const { return bFinished; }
+
+    /** 已发送的帧数 */
+    int32 GetNumFramesSent() const { return NumFramesSent; }
+
+    // ========== FRunnable =========
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+   private:
+    /** 阻塞发送全部字节 */
+    bool SendAll(FSocket* Socket, const TArray<uint8>& Bytes);
+
+    FString FilePath;
+    int32 Port;
+    float FramesPerSecond;
+
+    FSocket* ListenSocket = nullptr;
+    TUniquePtr<FRunnableThread> Thread;
+    std::atomic<bool> bStopRequested{false};
+    std::atomic<bool> bFinished{false};
+    std::atomic<int32> NumFramesSent{0};
+};
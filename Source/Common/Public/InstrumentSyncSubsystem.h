@@ -0,0 +1,96 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/QualifiedFrameTime.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "InstrumentSyncSubsystem.generated.h"
+
+class AInstrumentBase;
+class ASkeletalMeshActor;
+class ISequencer;
+class UControlRig;
+class ULevelSequence;
+
+/**
+ * 一帧内所有乐器共享的实时同步数据
+ * 当前打开的 Sequencer、求值时间和 Control Rig 实例每帧只解析一次，
+ * 同一演奏者被多件乐器引用时也不再重复查找
+ *
+ * @note 保存的指针只在同一帧内有效
+ */
+struct COMMON_API FInstrumentSyncFrameContext {
+    /** 当前打开的 Level Sequence，没有打开时为空 */
+    ULevelSequence* LevelSequence = nullptr;
+
+    /** 打开 LevelSequence 的 Sequencer */
+    TSharedPtr<ISequencer> Sequencer;
+
+    /** Sequencer 当前的求值时间 */
+    FQualifiedFrameTime GlobalTime;
+
+    /** 解析当前打开的 Sequencer 和求值时间（没有打开时不输出日志） */
+    void Initialize();
+
+    /**
+     * 查找绑定到指定Actor的 Control Rig 实例
+     * 第一次调用时一次遍历序列中的全部绑定，之后只查表
+     */
+    UControlRig* FindControlRig(const ASkeletalMeshActor* SkeletalMeshActor) const;
+
+   private:
+    mutable bool bControlRigsCollected = false;
+    mutable TMap<const ASkeletalMeshActor*, UControlRig*> ControlRigs;
+};
+
+/**
+ * 乐器实时同步子系统
+ * 统一调度世界中所有 AInstrumentBase 的实时同步，取代每个Actor各自注册Tick：
+ *
+ * 1. 收集本帧需要同步的乐器（NeedsRealtimeSync）
+ * 2. 解析一次共享数据（FInstrumentSyncFrameContext）
+ * 3. 游戏线程依次 GatherRealtimeSync：读取 Control Rig 和Actor变换
+ * 4. 并行 ComputeRealtimeSync：只做数学计算，不访问UObject
+ * 5. 游戏线程依次 ApplyRealtimeSync：写回 Control Rig
+ *
+ * 编辑器世界、PIE和游戏世界各有一个实例
+ */
+UCLASS()
+class COMMON_API UInstrumentSyncSubsystem : public UTickableWorldSubsystem {
+    GENERATED_BODY()
+
+   public:
+    /** 获取指定世界的子系统，世界不支持时返回nullptr */
+    static UInstrumentSyncSubsystem* Get(const UWorld* World);
+
+    void RegisterInstrument(AInstrumentBase* Instrument);
+
+    void UnregisterInstrument(AInstrumentBase* Instrument);
+
+    /** 已注册的乐器数量（包括本帧不需要同步的） */
+    int32 GetNumRegisteredInstruments() const;
+
+    /**
+     * 同步一组乐器，不检查 NeedsRealtimeSync
+     * Tick 和 AInstrumentBase::SyncRealtimeNow 共用
+     */
+    static void SyncInstruments(TArrayView<AInstrumentBase* const> InInstruments);
+
+    // ========== FTickableGameObject 接口实现 ==========
+
+    virtual void Tick(float DeltaTime) override;
+
+    virtual TStatId GetStatId() const override;
+
+    virtual bool IsTickableInEditor() const override { return true; }
+
+   protected:
+    virtual bool DoesSupportWorldType(
+        const EWorldType::Type WorldType) const override;
+
+   private:
+    /** 已注册的乐器 */
+    TArray<TWeakObjectPtr<AInstrumentBase>> Instruments;
+
+    /** 本帧需要同步的乐器（复用数组避免每帧分配） */
+    TArray<AInstrumentBase*> PendingInstruments;
+};
@@ -2,6 +2,7 @@
 
 #include "ControlRig/Public/Units/Highlevel/Hierarchy/RigUnit_CCDIK.h"
 #include "CoreMinimal.h"
+#include "PoleTargetIK.h"
 #include "RigVM/Public/RigVMCore/RigVMStruct.h"
 #include "PoleTargetFABRIK.generated.h"
 
@@ -16,6 +17,27 @@ struct COMMON_API FRigUnit_FABRIKWithPole : public FRigUnit_CCDIKItemArray {
     UPROPERTY(meta = (Input))
     FVector SecondAxis;
 
+    /** 从上一帧的解开始迭代 */
+    UPROPERTY(meta = (Input))
+    bool bWarmStart = false;
+
+    /** 单次迭代末端移动小于该值时提前结束（0为关闭） */
+    UPROPERTY(meta = (Input))
+    float EarlyStopThreshold = 0.0f;
+
+    /** 输入与上一次相同时复用CCDIK结果，不再迭代（pole修正照常执行） */
+    UPROPERTY(meta = (Input))
+    bool bMemoizeUnchangedInputs = false;
+
+    UPROPERTY(meta = (Output))
+    int32 IterationsUsed = 0;
+
+    UPROPERTY(transient)
+    FRigUnit_PoleTargetIK_WarmStartData WarmStartData;
+
+    UPROPERTY(transient)
+    FRigUnit_PoleTargetIK_MemoData MemoData;
+
     FRigUnit_FABRIKWithPole()
         : PoleTarget(FVector::ZeroVector), SecondAxis(FVector::UpVector) {}
 
@@ -5,6 +5,119 @@
 #include "RigVM/Public/RigVMCore/RigVMStruct.h"
 #include "PoleTargetIK.generated.h"
 
+/**
+ * PoleTarget IK 热启动数据
+ * 保存上一帧求解后的链条全局变换，下一帧按根骨骼位移平移后作为CCDIK初值
+ */
+USTRUCT()
+struct COMMON_API FRigUnit_PoleTargetIK_WarmStartData {
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TArray<FRigElementKey> SolvedKeys;
+
+    UPROPERTY()
+    TArray<FTransform> SolvedTransforms;
+
+    /** 用上一帧的解覆盖链条初值，Items变化或没有上一帧的解时返回false */
+    bool Apply(const TArray<FRigElementKey>& InItems,
+               TArray<FCCDIKChainLink>& Chain) const;
+
+    void Store(const TArray<FRigElementKey>& InItems,
+               const TArray<FCCDIKChainLink>& Chain);
+
+    void Reset();
+};
+
+/**
+ * PoleTarget IK 输入记忆
+ * 记录上一次求解的输入（链条初始全局变换、末端、pole和求解参数哈希）与结果，
+ * 输入未变化时（编辑器空闲、来回拖动时间轴、只有另一只手在动）直接复用结果
+ */
+USTRUCT()
+struct COMMON_API FRigUnit_PoleTargetIK_MemoData {
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TArray<FRigElementKey> Keys;
+
+    UPROPERTY()
+    uint32 SettingsHash = 0;
+
+    UPROPERTY()
+    FVector EffectorPosition = FVector::ZeroVector;
+
+    UPROPERTY()
+    FVector PoleTarget = FVector::ZeroVector;
+
+    UPROPERTY()
+    TArray<FTransform> InputTransforms;
+
+    UPROPERTY()
+    TArray<FTransform> OutputTransforms;
+
+    UPROPERTY()
+    bool bHasResult = false;
+
+    /** 输入与上一次求解相同时用缓存结果覆盖链条并返回true */
+    bool TryRestore(const TArray<FRigElementKey>& InItems,
+                    uint32 InSettingsHash, const FVector& InEffectorPosition,
+                    const FVector& InPoleTarget,
+                    TArray<FCCDIKChainLink>& Chain) const;
+
+    /** 求解前记录输入，旧结果作废 */
+    void CaptureInputs(const TArray<FRigElementKey>& InItems,
+                       uint32 InSettingsHash,
+                       const FVector& InEffectorPosition,
+                       const FVector& InPoleTarget,
+                       const TArray<FCCDIKChainLink>& Chain);
+
+    /** 求解成功后记录结果 */
+    void StoreResult(const TArray<FCCDIKChainLink>& Chain);
+
+    void Reset();
+
+    /** 影响求解结果的其它输入（轴向、精度、开关等）合成一个哈希 */
+    template <typename... ArgTypes>
+    static uint32 HashSettings(const ArgTypes&... Args) {
+        uint32 Hash = 0;
+        ((Hash = HashCombine(Hash, GetTypeHash(Args))), ...);
+        return Hash;
+    }
+};
+
+namespace PoleTargetIKSolver {
+/**
+ * 带迭代预算的CCDIK：逐次迭代，已收敛或单次迭代末端移动小于
+ * EarlyStopThreshold（大于0时生效）时提前结束
+ * @return 实际使用的迭代次数
+ */
+COMMON_API int32 SolveCCDIKWithBudget(
+    TArray<FCCDIKChainLink>& Chain, const FVector& TargetPosition,
+    float Precision, int32 MaxIterations, float EarlyStopThreshold,
+    bool bStartFromTail, const TArray<float>& RotationLimitsPerJoint);
+
+/**
+ * 次轴修正：保持关节位置，使每节骨骼的次轴位于参考平面内并朝向pole，
+ * 随后沿修正后的主轴恢复骨骼长度
+ * 链条不超过 PoleTargetSolverCore::InlineChainCapacity 节时不产生堆分配
+ */
+COMMON_API void ApplySecondaryAxisCorrection(
+    TArray<FCCDIKChainLink>& Chain, const FVector& EffectorPosition,
+    const FVector& PoleTarget, const FVector& PrimaryAxis,
+    const FVector& SecondaryAxis, float CorrectionWeight = 1.0f);
+
+/**
+ * 把求解后的链条一次性写回层级（按缓存的元素下标）
+ * bPropagateToChildren 为true时链内骨骼只写局部变换，最后写入根骨骼的
+ * 全局变换，由根骨骼统一让整棵子树失效重算；链条不是逐级父子关系时
+ * 退回到逐骨骼写入全局变换
+ */
+COMMON_API void WriteChainToHierarchy(
+    URigHierarchy* Hierarchy, TArrayView<const FCachedRigElement> CachedItems,
+    TArrayView<const FCCDIKChainLink> Chain, bool bPropagateToChildren);
+}  // namespace PoleTargetIKSolver
+
 USTRUCT(meta = (DisplayName = "IK Solver With Pole Target",
                 Category = "Hierarchy", Keywords = "N-Bone,IK,Pole",
                 Version = "5.7"))
@@ -23,6 +136,24 @@ struct COMMON_API FRigUnit_IKWithPole : public FRigUnit_CCDIKItemArray {
     UPROPERTY(meta = (Input))
     bool bUseSecondaryAxisCorrection = true; // 新增布尔值，默认开启次轴修正
 
+    UPROPERTY(meta = (Input))
+    bool bWarmStart = false; // 从上一帧的解开始迭代
+
+    UPROPERTY(meta = (Input))
+    float EarlyStopThreshold = 0.0f; // 单次迭代末端移动小于该值时提前结束（0为关闭）
+
+    UPROPERTY(meta = (Input))
+    bool bMemoizeUnchangedInputs = false; // 输入与上一次相同时复用结果，不再迭代
+
+    UPROPERTY(meta = (Output))
+    int32 IterationsUsed = 0;
+
+    UPROPERTY(transient)
+    FRigUnit_PoleTargetIK_WarmStartData WarmStartData;
+
+    UPROPERTY(transient)
+    FRigUnit_PoleTargetIK_MemoData MemoData;
+
     FRigUnit_IKWithPole()
         : PoleTarget(FVector::ZeroVector), SecondAxis(FVector::UpVector), bUseSecondaryAxisCorrection(true) {}
 
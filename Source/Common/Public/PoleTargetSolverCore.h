@@ -0,0 +1,286 @@
+﻿#pragma once
+
+#include "CCDIK.h"
+#include "CoreMinimal.h"
+
+/**
+ * Pole Target IK 求解核心（仅头文件）
+ *
+ * ArcDistributedIK / IKWithPole / FABRIKWithPole 共用的平面法线、
+ * 次轴方向和旋转重建逻辑。各 RigUnit 通过策略类型在编译期选择行为，
+ * 生成无运行时分支的专用内核：
+ *
+ * - FArcDistributionPolicy:      圆弧分布，次轴背离参考点
+ * - FSecondaryAxisPolicy:        次轴修正，次轴指向pole
+ * - FRootPoleCorrectionPolicy:   只旋转根骨骼，把链条中点转到pole平面内
+ */
+namespace PoleTargetSolverCore {
+
+/** 手指/手臂链条的常见关节数上限，逐次求解的临时数组在此范围内不走堆分配 */
+constexpr int32 InlineChainCapacity = 8;
+
+template <typename ElementType>
+using TChainScratchArray =
+    TArray<ElementType, TInlineAllocator<InlineChainCapacity>>;
+
+// ========== 基础几何 ==========
+
+/**
+ * 参考平面法线：(根->末端) x (根->pole)
+ * 共线时依次退回到与 Up / Forward 向量的叉积
+ */
+FORCEINLINE FVector CalculateReferencePlaneNormal(
+    const FVector& RootPosition, const FVector& EffectorPosition,
+    const FVector& PoleTarget) {
+    const FVector RootToEffector =
+        (EffectorPosition - RootPosition).GetSafeNormal();
+    const FVector RootToPole = (PoleTarget - RootPosition).GetSafeNormal();
+
+    FVector PlaneNormal = FVector::CrossProduct(RootToEffector, RootToPole);
+    if (PlaneNormal.IsNearlyZero(KINDA_SMALL_NUMBER)) {
+        PlaneNormal = FVector::CrossProduct(RootToEffector, FVector::UpVector);
+        if (PlaneNormal.IsNearlyZero(KINDA_SMALL_NUMBER)) {
+            PlaneNormal =
+                FVector::CrossProduct(RootToEffector, FVector::ForwardVector);
+        }
+    }
+    return PlaneNormal.GetSafeNormal();
+}
+
+/**
+ * 平面内与主轴垂直、朝向参考点一侧的单位方向
+ * 主轴与平面法线平行时退回到与世界轴的叉积
+ */
+FORCEINLINE FVector FindPerpendicularOnPlane(const FVector& PlaneNormal,
+                                             const FVector& PrimaryDirection,
+                                             const FVector& Origin,
+                                             const FVector& ReferencePoint) {
+    FVector Perpendicular = FVector::CrossProduct(
+        PlaneNormal, PrimaryDirection.GetSafeNormal());
+    if (Perpendicular.IsNearlyZero()) {
+        Perpendicular = FMath::Abs(PrimaryDirection.X) < 0.9f
+                            ? FVector::CrossProduct(PrimaryDirection,
+                                                    FVector::RightVector)
+                            : FVector::CrossProduct(PrimaryDirection,
+                                                    FVector::ForwardVector);
+    }
+    Perpendicular.Normalize();
+
+    const FVector ToReference = ReferencePoint - Origin;
+    if (ToReference.Length() > KINDA_SMALL_NUMBER &&
+        FVector::DotProduct(Perpendicular, ToReference.GetSafeNormal()) < 0) {
+        Perpendicular = -Perpendicular;
+    }
+    return Perpendicular;
+}
+
+/**
+ * 正交基 -> 四元数（Shepperd方法，直接由基向量分量构造，不经过矩阵求逆）
+ * 返回的旋转把世界X/Y/Z轴分别转到 X/Y/Z
+ */
+FORCEINLINE FQuat QuatFromOrthonormalBasis(const FVector& X, const FVector& Y,
+                                           const FVector& Z) {
+    const double Trace = X.X + Y.Y + Z.Z;
+    if (Trace > 0.0) {
+        const double S = 0.5 / FMath::Sqrt(Trace + 1.0);
+        return FQuat((Y.Z - Z.Y) * S, (Z.X - X.Z) * S, (X.Y - Y.X) * S,
+                     0.25 / S);
+    }
+    if (X.X > Y.Y && X.X > Z.Z) {
+        const double S = 2.0 * FMath::Sqrt(1.0 + X.X - Y.Y - Z.Z);
+        return FQuat(0.25 * S, (Y.X + X.Y) / S, (Z.X + X.Z) / S,
+                     (Y.Z - Z.Y) / S);
+    }
+    if (Y.Y > Z.Z) {
+        const double S = 2.0 * FMath::Sqrt(1.0 + Y.Y - X.X - Z.Z);
+        return FQuat((Y.X + X.Y) / S, 0.25 * S, (Z.Y + Y.Z) / S,
+                     (Z.X - X.Z) / S);
+    }
+    const double S = 2.0 * FMath::Sqrt(1.0 + Z.Z - X.X - Y.Y);
+    return FQuat((Z.X + X.Z) / S, (Z.Y + Y.Z) / S, 0.25 * S,
+                 (X.Y - Y.X) / S);
+}
+
+/**
+ * 局部主/次轴构成的正交基
+ * 只依赖 RigUnit 的 PrimaryAxis/SecondAxis，每次求解前构造一次，逐骨骼复用其逆旋转
+ */
+struct FLocalAxisBasis {
+    /** 局部基 -> 世界X/Y/Z轴 的旋转 */
+    FQuat InverseRotation = FQuat::Identity;
+
+    FLocalAxisBasis() = default;
+
+    FLocalAxisBasis(const FVector& LocalPrimary,
+                    const FVector& LocalSecondary) {
+        const FVector LocalX = LocalPrimary.GetSafeNormal();
+        FVector LocalY =
+            (LocalSecondary - LocalX * FVector::DotProduct(LocalSecondary,
+                                                           LocalX))
+                .GetSafeNormal();
+        FVector LocalZ;
+        if (LocalY.IsNearlyZero()) {
+            // 主次轴平行时任取一组垂直轴
+            LocalX.FindBestAxisVectors(LocalY, LocalZ);
+        } else {
+            LocalZ = FVector::CrossProduct(LocalX, LocalY);
+        }
+        InverseRotation =
+            QuatFromOrthonormalBasis(LocalX, LocalY, LocalZ).Inverse();
+    }
+};
+
+/**
+ * 由世界空间主/次轴构造旋转：
+ * 旋转后 LocalPrimary -> WorldPrimary, LocalSecondary -> WorldSecondary
+ * WorldSecondary 需已与 WorldPrimary 垂直，第三轴取两者叉积
+ */
+FORCEINLINE FQuat BuildRotationFromTwoAxes(const FVector& WorldPrimary,
+                                           const FVector& WorldSecondary,
+                                           const FLocalAxisBasis& LocalBasis) {
+    const FVector WorldX = WorldPrimary.GetSafeNormal();
+    const FVector WorldY = WorldSecondary.GetSafeNormal();
+    const FVector WorldZ = FVector::CrossProduct(WorldX, WorldY);
+    return (QuatFromOrthonormalBasis(WorldX, WorldY, WorldZ) *
+            LocalBasis.InverseRotation)
+        .GetNormalized();
+}
+
+// ========== 策略 ==========
+
+struct FArcDistributionPolicy {
+    static constexpr bool bSecondaryAxisCorrection = true;
+    static constexpr bool bSecondaryAwayFromReference = true;
+    static constexpr bool bPoleCorrection = false;
+};
+
+struct FSecondaryAxisPolicy {
+    static constexpr bool bSecondaryAxisCorrection = true;
+    static constexpr bool bSecondaryAwayFromReference = false;
+    static constexpr bool bPoleCorrection = false;
+};
+
+struct FRootPoleCorrectionPolicy {
+    static constexpr bool bSecondaryAxisCorrection = false;
+    static constexpr bool bSecondaryAwayFromReference = false;
+    static constexpr bool bPoleCorrection = true;
+};
+
+// ========== 专用内核 ==========
+
+template <typename Policy>
+struct TPoleTargetSolver {
+    /** 末端骨骼没有子关节时沿上一节方向外推的距离 */
+    static constexpr float TipExtrapolation = 50.0f;
+
+    /**
+     * 单个关节的目标旋转
+     * @param ReferencePoint 次轴朝向判断用的参考点（圆弧为偏移后的中点，次轴修正为pole）
+     */
+    static FQuat SolveJointRotation(const FVector& CurrentPosition,
+                                    const FVector& NextPosition,
+                                    const FVector& PlaneNormal,
+                                    const FVector& ReferencePoint,
+                                    const FLocalAxisBasis& LocalBasis) {
+        static_assert(Policy::bSecondaryAxisCorrection,
+                      "Policy does not rebuild joint rotations");
+
+        const FVector WorldPrimary =
+            (NextPosition - CurrentPosition).GetSafeNormal();
+        FVector WorldSecondary = FindPerpendicularOnPlane(
+            PlaneNormal, WorldPrimary, CurrentPosition, ReferencePoint);
+        if constexpr (Policy::bSecondaryAwayFromReference) {
+            WorldSecondary = -WorldSecondary;
+        }
+
+        return BuildRotationFromTwoAxes(WorldPrimary, WorldSecondary,
+                                        LocalBasis);
+    }
+
+    /** 第 Index 个关节的主轴指向点（末端骨骼沿上一节方向外推） */
+    static FVector GetPrimaryAxisPoint(TArrayView<const FCCDIKChainLink> Chain,
+                                       int32 Index) {
+        const FVector CurrentPosition = Chain[Index].Transform.GetLocation();
+        if (Index < Chain.Num() - 1) {
+            return Chain[Index + 1].Transform.GetLocation();
+        }
+        const FVector PrevToCurrent =
+            (CurrentPosition - Chain[Index - 1].Transform.GetLocation())
+                .GetSafeNormal();
+        return CurrentPosition + PrevToCurrent * TipExtrapolation;
+    }
+
+    /** 根据关节位置重建整条链的旋转 */
+    static void RebuildRotations(TArrayView<FCCDIKChainLink> Chain,
+                                 const FVector& PlaneNormal,
+                                 const FVector& ReferencePoint,
+                                 const FLocalAxisBasis& LocalBasis) {
+        if (Chain.Num() < 2) {
+            return;
+        }
+        for (int32 i = 0; i < Chain.Num(); ++i) {
+            Chain[i].Transform.SetRotation(SolveJointRotation(
+                Chain[i].Transform.GetLocation(),
+                GetPrimaryAxisPoint(Chain, i), PlaneNormal, ReferencePoint,
+                LocalBasis));
+        }
+    }
+
+    /**
+     * 根骨骼的pole修正旋转：绕 根->末端 轴旋转，使中间关节落入pole平面并朝向pole
+     * @return 世界空间增量旋转（无需修正时为Identity）
+     */
+    static FQuat CalculateRootPoleCorrection(const FVector& StartPosition,
+                                             const FVector& MiddlePosition,
+                                             const FVector& EndPosition,
+                                             const FVector& PoleTarget) {
+        static_assert(Policy::bPoleCorrection,
+                      "Policy does not apply pole correction");
+
+        const FVector ChainAxis = (EndPosition - StartPosition).GetSafeNormal();
+        const FVector PlaneNormal =
+            FVector::CrossProduct(EndPosition - StartPosition,
+                                  PoleTarget - StartPosition)
+                .GetSafeNormal();
+
+        // 中间关节到平面的投影
+        const float PlaneD = -FVector::DotProduct(PlaneNormal, PoleTarget);
+        const float DistToPlane =
+            FVector::DotProduct(MiddlePosition, PlaneNormal) + PlaneD;
+        const FVector MiddleTarget =
+            MiddlePosition - DistToPlane * PlaneNormal;
+
+        const FVector MiddleVec = MiddlePosition - StartPosition;
+        const FVector TargetVec = MiddleTarget - StartPosition;
+        const float Angle = FMath::Acos(FMath::Clamp(
+            FVector::DotProduct(MiddleVec.GetSafeNormal(),
+                                TargetVec.GetSafeNormal()),
+            -1.f, 1.f));
+        const float Sign =
+            FVector::DotProduct(ChainAxis,
+                                FVector::CrossProduct(MiddleVec, TargetVec)) <
+                    0
+                ? -1.f
+                : 1.f;
+        float FinalAngle = Angle * Sign;
+
+        // 投影点在pole的另一侧时再转半圈
+        const float SideThreshold = 0.01f;
+        const FVector ToPoleTarget = (PoleTarget - MiddleTarget).GetSafeNormal();
+        const FVector ToMiddle = (MiddlePosition - MiddleTarget).GetSafeNormal();
+        if (FVector::DotProduct(ToPoleTarget, ToMiddle) < -SideThreshold) {
+            FinalAngle += PI;
+        }
+
+        if (FMath::Abs(FinalAngle) <= KINDA_SMALL_NUMBER) {
+            return FQuat::Identity;
+        }
+        return FQuat(ChainAxis, FinalAngle);
+    }
+};
+
+using FArcDistributionSolver = TPoleTargetSolver<FArcDistributionPolicy>;
+using FSecondaryAxisSolver = TPoleTargetSolver<FSecondaryAxisPolicy>;
+using FRootPoleCorrectionSolver = TPoleTargetSolver<FRootPoleCorrectionPolicy>;
+
+}  // namespace PoleTargetSolverCore
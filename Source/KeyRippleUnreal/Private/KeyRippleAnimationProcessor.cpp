@@ -1,6 +1,9 @@
 ﻿#include "KeyRippleAnimationProcessor.h"
 
 #include "Common/Public/InstrumentAnimationUtility.h"
+#include "Common/Public/InstrumentGenerationCache.h"
+#include "Common/Public/InstrumentLiveLinkSource.h"
+#include "Common/Public/InstrumentStreamingImport.h"
 #include "Dom/JsonObject.h"
 #include "Dom/JsonValue.h"
 #include "KeyRippleControlRigProcessor.h"
@@ -28,6 +31,13 @@ static const TSet<FString>& GetValidKeyRippleControllerNames() {
     return ValidControllerNames;
 }
 
+/**
+ * 演奏动画轻量撤销记录的名称
+ */
+static FString GetPerformerUndoRecordName(AKeyRippleUnreal* KeyRippleActor) {
+    return KeyRippleActor->GetActorLabel() + TEXT("_Performer");
+}
+
 /**
  * 收集 KeyRipple 中的所有控制器名称
  */
@@ -142,11 +152,13 @@ void UKeyRippleAnimationProcessor::GeneratePerformerAnimation(
            *AnimationPath);
 
     // 调用直接处理动画文件的方法
-    GeneratePerformerAnimationDirect(KeyRippleActor, AnimationPath);
+    GeneratePerformerAnimationDirect(KeyRippleActor, AnimationPath,
+                                     KeyRippleActor->RegenerationWindow);
 }
 
 void UKeyRippleAnimationProcessor::GeneratePerformerAnimationDirect(
-    AKeyRippleUnreal* KeyRippleActor, const FString& AnimationFilePath) {
+    AKeyRippleUnreal* KeyRippleActor, const FString& AnimationFilePath,
+    const FAnimationFrameWindow& FrameWindow) {
     if (!KeyRippleActor) {
         UE_LOG(LogTemp, Error, TEXT("GeneratePerformerAnimationDirect: KeyRippleActor is null"));
         return;
@@ -156,27 +168,17 @@ void UKeyRippleAnimationProcessor::GeneratePerformerAnimationDirect(
            TEXT("Generating performer animation with Control Rig integration: %s"),
            *AnimationFilePath);
 
-    // 1. 读取动画文件
-    FString FileContent;
-    if (!FFileHelper::LoadFileToString(FileContent, *AnimationFilePath)) {
-        UE_LOG(LogTemp, Error, TEXT("Failed to load animation file: %s"),
-               *AnimationFilePath);
-        return;
-    }
-
-    // 2. 解析JSON数组
-    TArray<TSharedPtr<FJsonValue>> JsonArray;
-    TSharedRef<TJsonReader<>> Reader =
-        TJsonReaderFactory<>::Create(FileContent);
+    // 分段子序列模式：演奏者动画写入独立的子序列资产
+    FScopedTakeSequenceGeneration TakeScope(
+        KeyRippleActor->bUseTakeSequences, KeyRippleActor->SkeletalMeshActor,
+        TEXT("Performer"));
 
-    if (!FJsonSerializer::Deserialize(Reader, JsonArray)) {
-        UE_LOG(LogTemp, Error,
-               TEXT("Failed to parse JSON array from animation file: %s"),
-               *AnimationFilePath);
-        return;
-    }
+    // 撤销模式：Light/Disabled 时不向事务缓冲区写入对象快照
+    FScopedGenerationUndoMode UndoMode(
+        KeyRippleActor->GenerationUndoMode,
+        KeyRippleAnimationHelper::GetPerformerUndoRecordName(KeyRippleActor));
 
-    // 3. 获取 Control Rig Instance
+    // 1. 获取 Control Rig Instance
     UControlRig* ControlRigInstance = nullptr;
     UControlRigBlueprint* ControlRigBlueprint = nullptr;
 
@@ -195,7 +197,7 @@ void UKeyRippleAnimationProcessor::GeneratePerformerAnimationDirect(
         return;
     }
 
-    // 4. 获取 Sequencer 和 Level Sequence
+    // 2. 获取 Sequencer 和 Level Sequence
     ULevelSequence* LevelSequence = nullptr;
     TSharedPtr<ISequencer> Sequencer = nullptr;
 
@@ -206,7 +208,7 @@ void UKeyRippleAnimationProcessor::GeneratePerformerAnimationDirect(
         return;
     }
 
-    // 5. 验证并修复重复的轨道
+    // 3. 验证并修复重复的轨道
     bool bHasDuplicateTracks =
         UInstrumentAnimationUtility::ValidateNoExistingTracks(
             LevelSequence, ControlRigInstance, true);
@@ -216,28 +218,105 @@ void UKeyRippleAnimationProcessor::GeneratePerformerAnimationDirect(
                     "Proceeding with animation generation."));
     }
 
-    // 6. 收集需要清理的控制器名称
+    // 4. 收集需要清理的控制器名称
     TSet<FString> ControlNamesToClean;
     KeyRippleAnimationHelper::CollectKeyRippleControllerNames(
         KeyRippleActor, ControlNamesToClean);
 
-    // 7. 清空关键帧（使用通用方法）
-    UE_LOG(LogTemp, Warning,
-           TEXT("Clearing existing Control Rig keyframes before adding new "
-                "keyframes"));
-    UInstrumentAnimationUtility::ClearControlRigKeyframes(
-        LevelSequence, ControlRigInstance, ControlNamesToClean);
+    // 5. 配置批量插入设置
+    FBatchInsertKeyframesSettings Settings;
+    Settings.FramePadding = 300;  // KeyRipple 使用 MaxFrame + 300
+
+    // 配置特殊控制器处理（Tar_ 控制器只插入 X 轴）
+    Settings.SpecialControllerRules.Add(TEXT("Tar_"), true);
+    Settings.FrameWindow = FrameWindow;
+
+    // 6. 输入没有变化时直接从生成缓存恢复（局部重新生成不走缓存）
+    FString Fingerprint;
+    if (!FrameWindow.IsSet()) {
+        UMovieScene* MovieScene = LevelSequence->GetMovieScene();
+        FGenerationFingerprint FingerprintBuilder;
+        FingerprintBuilder.AddString(TEXT("KeyRipple.Performer"));
+        FingerprintBuilder.AddFile(AnimationFilePath);
+        FingerprintBuilder.AddControlRigHierarchy(ControlRigInstance);
+        FingerprintBuilder.AddSettings(Settings);
+        FingerprintBuilder.AddFrameRate(MovieScene->GetTickResolution());
+        FingerprintBuilder.AddFrameRate(MovieScene->GetDisplayRate());
+        FingerprintBuilder.AddInt(KeyRippleActor->OneHandFingerNumber);
+        FingerprintBuilder.AddInt(KeyRippleActor->MinKey);
+        FingerprintBuilder.AddInt(KeyRippleActor->MaxKey);
+        Fingerprint = FingerprintBuilder.ToString();
+    }
+
+    // Light 撤销模式：生成前把现有数据保存到磁盘作为撤销记录
+    UndoMode.RecordPreviousSection(
+        FInstrumentGenerationCache::FindControlRigSection(LevelSequence,
+                                                          ControlRigInstance),
+        ControlNamesToClean);
+
+    if (!Fingerprint.IsEmpty() &&
+        FInstrumentGenerationCache::RestoreSectionChannels(
+            Fingerprint, FInstrumentGenerationCache::FindControlRigSection(
+                             LevelSequence, ControlRigInstance))) {
+        LevelSequence->MarkPackageDirty();
+        UndoMode.LogMemoryReport();
+        UE_LOG(LogTemp, Warning,
+               TEXT("========== GeneratePerformerAnimationDirect Completed "
+                    "(restored from cache %s) =========="),
+               *Fingerprint);
+        return;
+    }
+
+    // 7. 读取动画文件
+    FString FileContent;
+    if (!FFileHelper::LoadFileToString(FileContent, *AnimationFilePath)) {
+        UE_LOG(LogTemp, Error, TEXT("Failed to load animation file: %s"),
+               *AnimationFilePath);
+        return;
+    }
+
+    // 8. 解析JSON数组
+    TArray<TSharedPtr<FJsonValue>> JsonArray;
+    TSharedRef<TJsonReader<>> Reader =
+        TJsonReaderFactory<>::Create(FileContent);
+
+    if (!FJsonSerializer::Deserialize(Reader, JsonArray)) {
+        UE_LOG(LogTemp, Error,
+               TEXT("Failed to parse JSON array from animation file: %s"),
+               *AnimationFilePath);
+        return;
+    }
+
+    // 9. 清空关键帧（使用通用方法）
+    // 局部重新生成时不清空，由批量插入只替换窗口内的关键帧
+    if (FrameWindow.IsSet()) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("Regenerating frames [%d, %d] only, keeping keyframes "
+                    "outside the window"),
+               FrameWindow.StartFrame, FrameWindow.EndFrame);
+    } else {
+        UE_LOG(LogTemp, Warning,
+               TEXT("Clearing existing Control Rig keyframes before adding "
+                    "new keyframes"));
+        UInstrumentAnimationUtility::ClearControlRigKeyframes(
+            LevelSequence, ControlRigInstance, ControlNamesToClean);
+    }
 
     UE_LOG(LogTemp, Warning, TEXT("Starting to process %d animation frames"),
            JsonArray.Num());
 
-    // 8. 处理每一帧并收集关键帧数据
+    // 10. 处理每一帧并收集关键帧数据
     TMap<FString, TArray<FAnimationKeyframe>> ControlKeyframeData;
     int32 ProcessedFrames = 0;
     int32 FailedFrames = 0;
     int32 KeyframesAdded = 0;
 
     for (int32 FrameIndex = 0; FrameIndex < JsonArray.Num(); ++FrameIndex) {
+        // 跳过局部重新生成窗口外的帧
+        if (!FrameWindow.Contains(FrameIndex)) {
+            continue;
+        }
+
         TSharedPtr<FJsonObject> FrameObject = JsonArray[FrameIndex]->AsObject();
 
         // 使用通用方法处理控件容器
@@ -249,18 +328,20 @@ void UKeyRippleAnimationProcessor::GeneratePerformerAnimationDirect(
         ProcessedFrames++;
     }
 
-    // 9. 配置批量插入设置
-    FBatchInsertKeyframesSettings Settings;
-    Settings.FramePadding = 300;  // KeyRipple 使用 MaxFrame + 300
-
-    // 配置特殊控制器处理（Tar_ 控制器只插入 X 轴）
-    Settings.SpecialControllerRules.Add(TEXT("Tar_"), true);
-
-    // 10. 批量插入关键帧（使用通用方法）
+    // 11. 批量插入关键帧（使用通用方法）
     UInstrumentAnimationUtility::BatchInsertControlRigKeys(
         LevelSequence, ControlRigInstance, ControlKeyframeData, Settings);
 
-    // 11. 标记为已修改
+    // 12. 写入生成缓存
+    if (!Fingerprint.IsEmpty()) {
+        FInstrumentGenerationCache::StoreSectionChannels(
+            Fingerprint,
+            FInstrumentGenerationCache::FindControlRigSection(
+                LevelSequence, ControlRigInstance),
+            ControlNamesToClean);
+    }
+
+    // 13. 标记为已修改
     LevelSequence->MarkPackageDirty();
 
     UE_LOG(LogTemp, Warning,
@@ -270,10 +351,24 @@ void UKeyRippleAnimationProcessor::GeneratePerformerAnimationDirect(
     UE_LOG(LogTemp, Warning, TEXT("Failed frames: %d"), FailedFrames);
     UE_LOG(LogTemp, Warning, TEXT("Total keyframes added to Sequencer: %d"),
            KeyframesAdded);
+    UndoMode.LogMemoryReport();
     UE_LOG(LogTemp, Warning,
            TEXT("========== GeneratePerformerAnimationDirect Completed =========="));
 }
 
+bool UKeyRippleAnimationProcessor::RevertPerformerAnimation(
+    AKeyRippleUnreal* KeyRippleActor) {
+    if (!KeyRippleActor || !KeyRippleActor->SkeletalMeshActor) {
+        UE_LOG(LogTemp, Error,
+               TEXT("RevertPerformerAnimation: invalid KeyRippleActor"));
+        return false;
+    }
+
+    return FInstrumentGenerationCache::RestorePreviousGeneration(
+        KeyRippleActor->SkeletalMeshActor,
+        KeyRippleAnimationHelper::GetPerformerUndoRecordName(KeyRippleActor));
+}
+
 // 批量插入控制关键帧 - 现在直接调用通用方法
 void UKeyRippleAnimationProcessor::BatchInsertControlRigKeys(
     ULevelSequence* LevelSequence, UControlRig* ControlRigInstance,
@@ -385,7 +480,8 @@ void UKeyRippleAnimationProcessor::GeneratePianoKeyAnimation(
 
     // Call the new Level Sequencer method
     UKeyRipplePianoProcessor::GenerateInstrumentAnimation(
-        KeyRippleActor, PianoKeyAnimationPath);
+        KeyRippleActor, PianoKeyAnimationPath,
+        KeyRippleActor->RegenerationWindow);
 
     UE_LOG(LogTemp, Warning, TEXT("GeneratePianoKeyAnimation completed"));
 }
@@ -434,6 +530,76 @@ void UKeyRippleAnimationProcessor::GenerateAllAnimation(
     UE_LOG(LogTemp, Warning, TEXT("GenerateAllAnimation completed"));
 }
 
+bool UKeyRippleAnimationProcessor::StartLivePreview(
+    AKeyRippleUnreal* KeyRippleActor) {
+    if (!KeyRippleActor) {
+        UE_LOG(LogTemp, Error, TEXT("StartLivePreview: KeyRippleActor is null"));
+        return false;
+    }
+
+    FString AnimationPath;
+    FString KeyAnimationPath;
+    if (!ParseKeyRippleFile(KeyRippleActor, AnimationPath, KeyAnimationPath) ||
+        AnimationPath.IsEmpty()) {
+        UE_LOG(LogTemp, Error,
+               TEXT("StartLivePreview: Animation path is empty"));
+        return false;
+    }
+
+    FInstrumentLiveLinkStream Stream;
+    Stream.SubjectName =
+        FName(*(KeyRippleActor->GetActorLabel() + TEXT("_Performer")));
+    Stream.FilePaths.Add(AnimationPath);
+    Stream.ControllerNames =
+        KeyRippleAnimationHelper::GetValidKeyRippleControllerNames();
+
+    TArray<FInstrumentLiveLinkStream> Streams;
+    Streams.Add(MoveTemp(Stream));
+    return FInstrumentLiveLinkSource::StartPreview(
+        KeyRippleActor->GetActorLabel(), MoveTemp(Streams));
+}
+
+void UKeyRippleAnimationProcessor::StopLivePreview(
+    AKeyRippleUnreal* KeyRippleActor) {
+    if (KeyRippleActor) {
+        FInstrumentLiveLinkSource::StopPreview(KeyRippleActor->GetActorLabel());
+    }
+}
+
+bool UKeyRippleAnimationProcessor::StartStreamingImport(
+    AKeyRippleUnreal* KeyRippleActor, int32 Port) {
+    if (!KeyRippleActor) {
+        UE_LOG(LogTemp, Error,
+               TEXT("StartStreamingImport: KeyRippleActor is null"));
+        return false;
+    }
+
+    FInstrumentStreamingImportSettings Settings;
+    Settings.SessionName = KeyRippleActor->GetActorLabel();
+    Settings.Port = Port;
+    Settings.PerformerActor = KeyRippleActor->SkeletalMeshActor;
+    Settings.bUseTakeSequences = KeyRippleActor->bUseTakeSequences;
+    Settings.TakeSuffix = TEXT("Performer");
+    Settings.ControllerNames =
+        KeyRippleAnimationHelper::GetValidKeyRippleControllerNames();
+    KeyRippleAnimationHelper::CollectKeyRippleControllerNames(
+        KeyRippleActor, Settings.ControllerNamesToClean);
+
+    // 与 GeneratePerformerAnimationDirect 一致
+    Settings.InsertSettings.FramePadding = 300;
+    Settings.InsertSettings.SpecialControllerRules.Add(TEXT("Tar_"), true);
+
+    return FInstrumentStreamingImportSession::StartSession(MoveTemp(Settings));
+}
+
+void UKeyRippleAnimationProcessor::StopStreamingImport(
+    AKeyRippleUnreal* KeyRippleActor) {
+    if (KeyRippleActor) {
+        FInstrumentStreamingImportSession::StopSession(
+            KeyRippleActor->GetActorLabel());
+    }
+}
+
 void UKeyRippleAnimationProcessor::ClearControlRigKeyframes(
     ULevelSequence* LevelSequence, UControlRig* ControlRigInstance,
     AKeyRippleUnreal* KeyRippleActor) {
@@ -0,0 +1,187 @@
+﻿#include "KeyRippleKeyboardInstancingSubsystem.h"
+
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+
+UKeyRippleKeyboardInstancingSubsystem*
+UKeyRippleKeyboardInstancingSubsystem::Get(const UWorld* World) {
+    return World ? World->GetSubsystem<UKeyRippleKeyboardInstancingSubsystem>()
+                 : nullptr;
+}
+
+void UKeyRippleKeyboardInstancingSubsystem::RegisterKeyboard(
+    const UObject* Owner, TArray<FKeyRippleKeyboardKey> Keys) {
+    if (!Owner) {
+        return;
+    }
+
+    FKeyboardEntry& Entry = Keyboards.FindOrAdd(Owner);
+    Entry.Keys = MoveTemp(Keys);
+    Entry.KeyValues.SetNumZeroed(Entry.Keys.Num());
+    RebuildInstances();
+}
+
+void UKeyRippleKeyboardInstancingSubsystem::UnregisterKeyboard(
+    const UObject* Owner) {
+    if (Keyboards.Remove(Owner) > 0) {
+        RebuildInstances();
+    }
+}
+
+bool UKeyRippleKeyboardInstancingSubsystem::IsKeyboardRegistered(
+    const UObject* Owner) const {
+    return Keyboards.Contains(Owner);
+}
+
+bool UKeyRippleKeyboardInstancingSubsystem::UpdateKeyStates(
+    const UObject* Owner, TConstArrayView<float> KeyValues) {
+    FKeyboardEntry* Entry = Keyboards.Find(Owner);
+    if (!Entry) {
+        return false;
+    }
+
+    TBitArray<> DirtyBatches(false, BatchComponents.Num());
+    const int32 NumKeys = FMath::Min(KeyValues.Num(), Entry->Keys.Num());
+    for (int32 i = 0; i < NumKeys; ++i) {
+        const float Value = KeyValues[i];
+        if (Entry->KeyValues[i] == Value ||
+            Entry->InstanceIndices[i] == INDEX_NONE) {
+            continue;
+        }
+        Entry->KeyValues[i] = Value;
+
+        // Pressed 与逐键材质一样取自琴键曲线，与按下深度相同
+        const int32 BatchIndex = Entry->BatchIndices[i];
+        const float CustomData[NumCustomDataFloats] = {Value, Value};
+        BatchComponents[BatchIndex]->SetCustomData(
+            Entry->InstanceIndices[i], MakeArrayView(CustomData), false);
+        DirtyBatches[BatchIndex] = true;
+    }
+
+    bool bChanged = false;
+    for (TConstSetBitIterator<> It(DirtyBatches); It; ++It) {
+        BatchComponents[It.GetIndex()]->MarkRenderStateDirty();
+        bChanged = true;
+    }
+    return bChanged;
+}
+
+void UKeyRippleKeyboardInstancingSubsystem::Deinitialize() {
+    Keyboards.Reset();
+    BatchComponents.Reset();
+    if (InstancingActor) {
+        InstancingActor->Destroy();
+        InstancingActor = nullptr;
+    }
+    Super::Deinitialize();
+}
+
+bool UKeyRippleKeyboardInstancingSubsystem::DoesSupportWorldType(
+    const EWorldType::Type WorldType) const {
+    return WorldType == EWorldType::Editor || WorldType == EWorldType::PIE ||
+           WorldType == EWorldType::Game;
+}
+
+void UKeyRippleKeyboardInstancingSubsystem::RebuildInstances() {
+    for (UInstancedStaticMeshComponent* Component : BatchComponents) {
+        Component->ClearInstances();
+    }
+
+    // 每个组件的实例变换先收集起来，一次性添加
+    TArray<TArray<FTransform>> BatchTransforms;
+    BatchTransforms.SetNum(BatchComponents.Num());
+    for (TPair<TObjectKey<UObject>, FKeyboardEntry>& Pair : Keyboards) {
+        FKeyboardEntry& Entry = Pair.Value;
+        Entry.BatchIndices.SetNumUninitialized(Entry.Keys.Num());
+        Entry.InstanceIndices.SetNumUninitialized(Entry.Keys.Num());
+
+        for (int32 i = 0; i < Entry.Keys.Num(); ++i) {
+            const int32 BatchIndex = FindOrAddBatch(Entry.Keys[i].Mesh);
+            Entry.BatchIndices[i] = BatchIndex;
+            if (BatchIndex == INDEX_NONE) {
+                Entry.InstanceIndices[i] = INDEX_NONE;
+                continue;
+            }
+
+            BatchTransforms.SetNum(BatchComponents.Num());
+            Entry.InstanceIndices[i] = BatchTransforms[BatchIndex].Add(
+                Entry.Keys[i].Transform);
+        }
+    }
+
+    for (int32 BatchIndex = 0; BatchIndex < BatchComponents.Num();
+         ++BatchIndex) {
+        if (BatchTransforms[BatchIndex].Num() > 0) {
+            BatchComponents[BatchIndex]->AddInstances(
+                BatchTransforms[BatchIndex], false, true);
+        }
+    }
+
+    // 重建后恢复琴键状态
+    for (TPair<TObjectKey<UObject>, FKeyboardEntry>& Pair : Keyboards) {
+        FKeyboardEntry& Entry = Pair.Value;
+        for (int32 i = 0; i < Entry.Keys.Num(); ++i) {
+            if (Entry.InstanceIndices[i] == INDEX_NONE) {
+                continue;
+            }
+            const float CustomData[NumCustomDataFloats] = {Entry.KeyValues[i],
+                                                           Entry.KeyValues[i]};
+            BatchComponents[Entry.BatchIndices[i]]->SetCustomData(
+                Entry.InstanceIndices[i], MakeArrayView(CustomData), false);
+        }
+    }
+
+    for (UInstancedStaticMeshComponent* Component : BatchComponents) {
+        Component->MarkRenderStateDirty();
+    }
+}
+
+int32 UKeyRippleKeyboardInstancingSubsystem::FindOrAddBatch(UStaticMesh* Mesh) {
+    if (!Mesh) {
+        return INDEX_NONE;
+    }
+
+    for (int32 i = 0; i < BatchComponents.Num(); ++i) {
+        if (BatchComponents[i]->GetStaticMesh() == Mesh) {
+            return i;
+        }
+    }
+
+    UWorld* World = GetWorld();
+    if (!World) {
+        return INDEX_NONE;
+    }
+
+    if (!InstancingActor) {
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.Name = MakeUniqueObjectName(
+            World->GetCurrentLevel(), AActor::StaticClass(),
+            TEXT("KeyRippleInstancedKeyboards"));
+        SpawnParams.ObjectFlags |= RF_Transient;
+#if WITH_EDITOR
+        SpawnParams.bHideFromSceneOutliner = true;
+#endif
+        InstancingActor = World->SpawnActor<AActor>(SpawnParams);
+        if (!InstancingActor) {
+            return INDEX_NONE;
+        }
+
+        USceneComponent* Root = NewObject<USceneComponent>(
+            InstancingActor, TEXT("Root"), RF_Transient);
+        InstancingActor->SetRootComponent(Root);
+        Root->RegisterComponent();
+    }
+
+    UInstancedStaticMeshComponent* Component =
+        NewObject<UInstancedStaticMeshComponent>(InstancingActor, NAME_None,
+                                                 RF_Transient);
+    Component->SetStaticMesh(Mesh);
+    Component->SetMobility(EComponentMobility::Movable);
+    Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    Component->SetNumCustomDataFloats(NumCustomDataFloats);
+    Component->SetupAttachment(InstancingActor->GetRootComponent());
+    Component->RegisterComponent();
+
+    return BatchComponents.Add(Component);
+}
@@ -2,6 +2,7 @@
 
 #include "DesktopPlatformModule.h"
 #include "ISequencer.h"
+#include "InstrumentAnimSequenceBakeUtility.h"
 #include "KeyRippleAnimationProcessor.h"
 #include "KeyRippleControlRigProcessor.h"
 #include "KeyRipplePianoProcessor.h"
@@ -345,6 +346,51 @@ void SKeyRippleOperationsPanel::Construct(const FArguments& InArgs) {
                                  .OnClicked(this, &SKeyRippleOperationsPanel::
                                                       OnGenerateAllAnimation)
                                  .HAlign(HAlign_Center)
+                                 .ButtonStyle(FAppStyle::Get(),
+                                              "FlatButton.Default")] +
+                   SVerticalBox::Slot().AutoHeight().Padding(
+                       5.0f)[SNew(SButton)
+                                 .Text(LOCTEXT("BakeToAnimSequenceButton",
+                                               "Bake to Animation Sequence"))
+                                 .OnClicked(this, &SKeyRippleOperationsPanel::
+                                                      OnBakeToAnimSequence)
+                                 .HAlign(HAlign_Center)
+                                 .ButtonStyle(FAppStyle::Get(),
+                                              "FlatButton.Default")] +
+                   SVerticalBox::Slot().AutoHeight().Padding(
+                       5.0f)[SNew(SButton)
+                                 .Text(LOCTEXT("StartLivePreviewButton",
+                                               "Start Live Preview"))
+                                 .OnClicked(this, &SKeyRippleOperationsPanel::
+                                                      OnStartLivePreview)
+                                 .HAlign(HAlign_Center)
+                                 .ButtonStyle(FAppStyle::Get(),
+                                              "FlatButton.Default")] +
+                   SVerticalBox::Slot().AutoHeight().Padding(
+                       5.0f)[SNew(SButton)
+                                 .Text(LOCTEXT("StopLivePreviewButton",
+                                               "Stop Live Preview"))
+                                 .OnClicked(this, &SKeyRippleOperationsPanel::
+                                                      OnStopLivePreview)
+                                 .HAlign(HAlign_Center)
+                                 .ButtonStyle(FAppStyle::Get(),
+                                              "FlatButton.Default")] +
+                   SVerticalBox::Slot().AutoHeight().Padding(
+                       5.0f)[SNew(SButton)
+                                 .Text(LOCTEXT("StartStreamingImportButton",
+                                               "Start Streaming Import"))
+                                 .OnClicked(this, &SKeyRippleOperationsPanel::
+                                                      OnStartStreamingImport)
+                                 .HAlign(HAlign_Center)
+                                 .ButtonStyle(FAppStyle::Get(),
+                                              "FlatButton.Default")] +
+                   SVerticalBox::Slot().AutoHeight().Padding(
+                       5.0f)[SNew(SButton)
+                                 .Text(LOCTEXT("StopStreamingImportButton",
+                                               "Stop Streaming Import"))
+                                 .OnClicked(this, &SKeyRippleOperationsPanel::
+                                                      OnStopStreamingImport)
+                                 .HAlign(HAlign_Center)
                                  .ButtonStyle(FAppStyle::Get(),
                                               "FlatButton.Default")]
 
@@ -514,6 +560,68 @@ FReply SKeyRippleOperationsPanel::OnGenerateAllAnimation() {
     return FReply::Handled();
 }
 
+FReply SKeyRippleOperationsPanel::OnBakeToAnimSequence() {
+    if (!KeyRippleActor.IsValid()) {
+        LastStatusMessage = TEXT("Error: No KeyRipple actor selected");
+        return FReply::Handled();
+    }
+
+    const int32 NumBaked =
+        UInstrumentAnimSequenceBakeUtility::BakeInstrumentToAnimSequences(
+            KeyRippleActor.Get(), FString());
+    LastStatusMessage =
+        FString::Printf(TEXT("Baked %d animation sequences"), NumBaked);
+    return FReply::Handled();
+}
+
+FReply SKeyRippleOperationsPanel::OnStartLivePreview() {
+    if (!KeyRippleActor.IsValid()) {
+        LastStatusMessage = TEXT("Error: No KeyRipple actor selected");
+        return FReply::Handled();
+    }
+
+    LastStatusMessage =
+        UKeyRippleAnimationProcessor::StartLivePreview(KeyRippleActor.Get())
+            ? TEXT("Live preview started")
+            : TEXT("Error: Failed to start live preview");
+    return FReply::Handled();
+}
+
+FReply SKeyRippleOperationsPanel::OnStopLivePreview() {
+    if (!KeyRippleActor.IsValid()) {
+        LastStatusMessage = TEXT("Error: No KeyRipple actor selected");
+        return FReply::Handled();
+    }
+
+    UKeyRippleAnimationProcessor::StopLivePreview(KeyRippleActor.Get());
+    LastStatusMessage = TEXT("Live preview stopped");
+    return FReply::Handled();
+}
+
+FReply SKeyRippleOperationsPanel::OnStartStreamingImport() {
+    if (!KeyRippleActor.IsValid()) {
+        LastStatusMessage = TEXT("Error: No KeyRipple actor selected");
+        return FReply::Handled();
+    }
+
+    LastStatusMessage =
+        UKeyRippleAnimationProcessor::StartStreamingImport(KeyRippleActor.Get())
+            ? TEXT("Streaming import started")
+            : TEXT("Error: Failed to start streaming import");
+    return FReply::Handled();
+}
+
+FReply SKeyRippleOperationsPanel::OnStopStreamingImport() {
+    if (!KeyRippleActor.IsValid()) {
+        LastStatusMessage = TEXT("Error: No KeyRipple actor selected");
+        return FReply::Handled();
+    }
+
+    UKeyRippleAnimationProcessor::StopStreamingImport(KeyRippleActor.Get());
+    LastStatusMessage = TEXT("Streaming import stopped");
+    return FReply::Handled();
+}
+
 FReply SKeyRippleOperationsPanel::OnInitPiano() {
     if (!KeyRippleActor.IsValid()) {
         LastStatusMessage = TEXT("Error: No KeyRipple actor selected");
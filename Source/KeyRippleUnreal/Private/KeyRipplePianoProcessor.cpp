@@ -3,23 +3,68 @@
 #include "Channels/MovieSceneFloatChannel.h"
 #include "Common/Public/InstrumentAnimationUtility.h"
 #include "Common/Public/InstrumentControlRigUtility.h"
+#include "Common/Public/InstrumentGenerationCache.h"
 #include "Common/Public/InstrumentMaterialUtility.h"
 #include "Common/Public/InstrumentMorphTargetUtility.h"
+#include "Common/Public/InstrumentSyncSubsystem.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/SkeletalMeshSocket.h"
 #include "ControlRig.h"
+#include "ControlRigComponent.h"
 #include "Json.h"
 #include "JsonUtilities.h"
 #include "KeyRippleControlRigProcessor.h"
+#include "KeyRippleKeyboardInstancingSubsystem.h"
 #include "LevelEditorSequencerIntegration.h"
 #include "LevelSequenceEditorBlueprintLibrary.h"
+#include "Engine/Texture2D.h"
 #include "Materials/MaterialInstanceConstant.h"
+#include "Materials/MaterialInstanceDynamic.h"
 #include "Misc/FileHelper.h"
+#include "Rendering/SkeletalMeshRenderData.h"
 #include "Sections/MovieSceneComponentMaterialParameterSection.h"
 #include "Serialization/JsonReader.h"
 #include "Serialization/JsonSerializer.h"
 
 #define LOCTEXT_NAMESPACE "KeyRipplePianoProcessor"
 
+namespace KeyRipplePianoHelper {
+/** 按键号判断黑白键（键号模12与MIDI音高一致） */
+static bool IsBlackKey(int32 KeyNumber) {
+    const int32 ModValue = KeyNumber % 12;
+    return ModValue == 1 || ModValue == 3 || ModValue == 6 || ModValue == 8 ||
+           ModValue == 10;
+}
+
+/** 从琴键 Morph Target（动画通道）名称中提取第一个数字作为键号 */
+static int32 ParseKeyNumber(const FString& MorphTargetName) {
+    TArray<FString> NameParts;
+    MorphTargetName.ParseIntoArray(NameParts, TEXT("_"));
+    for (const FString& Part : NameParts) {
+        if (Part.IsNumeric()) {
+            return FCString::Atoi(*Part);
+        }
+    }
+    return INDEX_NONE;
+}
+
+/** 名称以 "_<键号>" 结尾的材质槽为琴键（与 UpdatePianoMaterials 一致） */
+static bool IsKeyMaterialSlot(const FName& SlotName) {
+    FString LastPart;
+    return SlotName.ToString().Split(TEXT("_"), nullptr, &LastPart,
+                                     ESearchCase::IgnoreCase,
+                                     ESearchDir::FromEnd) &&
+           LastPart.IsNumeric();
+}
+
+/** 实例化键盘使用的琴键插槽前缀，插槽名为 key_<键号> */
+static const TCHAR* KeySocketPrefix = TEXT("key_");
+
+/** 键状态纹理在材质中的参数名 */
+static const FName KeyStateTextureParameterName(TEXT("KeyStateTexture"));
+}  // namespace KeyRipplePianoHelper
+
 void UKeyRipplePianoProcessor::UpdatePianoMaterials(
     AKeyRippleUnreal* KeyRippleActor) {
     if (!KeyRippleActor) {
@@ -73,9 +118,7 @@ void UKeyRipplePianoProcessor::UpdatePianoMaterials(
         }
 
         // 判断黑白键
-        int32 ModValue = KeyNumber % 12;
-        bool bIsBlackKey = (ModValue == 1 || ModValue == 3 || ModValue == 6 ||
-                            ModValue == 8 || ModValue == 10);
+        bool bIsBlackKey = KeyRipplePianoHelper::IsBlackKey(KeyNumber);
 
         UMaterialInterface* ParentMaterial = bIsBlackKey
                                                  ? KeyRippleActor->KeyMatBlack
@@ -136,6 +179,14 @@ void UKeyRipplePianoProcessor::InitPiano(AKeyRippleUnreal* KeyRippleActor) {
         return;
     }
 
+    if (KeyRippleActor->KeyboardRenderMode ==
+            EPianoKeyboardRenderMode::KeyStateTexture &&
+        !KeyRippleActor->KeyStateMaterial) {
+        UE_LOG(LogTemp, Error,
+               TEXT("KeyStateMaterial is not assigned in KeyRippleActor"));
+        return;
+    }
+
     // 清空之前生成的材质实例，防止旧资产残留
     KeyRippleActor->GeneratedPianoMaterials.Empty();
 
@@ -144,20 +195,37 @@ void UKeyRipplePianoProcessor::InitPiano(AKeyRippleUnreal* KeyRippleActor) {
     // 🔧 新增：清理现有的动画数据
     CleanupExistingPianoAnimations(KeyRippleActor);
 
+    // 实例化键盘和键状态纹理的琴键状态来自琴键曲线，
+    // 不需要逐键材质和材质轨道
+    const bool bPerKeyMaterials = KeyRippleActor->KeyboardRenderMode ==
+                                  EPianoKeyboardRenderMode::MorphTargets;
+
     // 更新钢琴材质
-    UpdatePianoMaterials(KeyRippleActor);
+    if (bPerKeyMaterials) {
+        // 逐键材质由这里重新设置，之前记录的键状态材质接管前的材质作废，
+        // 避免之后释放键状态纹理时覆盖新的逐键材质
+        KeyRippleActor->KeyStateOriginalMaterials.Reset();
+        UpdatePianoMaterials(KeyRippleActor);
+    } else if (KeyRippleActor->KeyboardRenderMode ==
+               EPianoKeyboardRenderMode::KeyStateTexture) {
+        AssignKeyStateMaterial(KeyRippleActor,
+                               KeyRippleActor->KeyStateMaterial);
+    }
 
     // 初始化钢琴键 Control Rig
     InitPianoKeyControlRig(KeyRippleActor);
 
     // 初始化钢琴材质参数轨道
-    InitPianoMaterialParameterTracks(KeyRippleActor);
+    if (bPerKeyMaterials) {
+        InitPianoMaterialParameterTracks(KeyRippleActor);
+    }
 
     UE_LOG(LogTemp, Warning, TEXT("========== InitPiano Completed =========="));
 }
 
 void UKeyRipplePianoProcessor::GenerateInstrumentAnimation(
-    AKeyRippleUnreal* KeyRippleActor, const FString& PianoKeyAnimationPath) {
+    AKeyRippleUnreal* KeyRippleActor, const FString& PianoKeyAnimationPath,
+    const FAnimationFrameWindow& FrameWindow) {
     if (!KeyRippleActor) {
         UE_LOG(LogTemp, Error, TEXT("KeyRippleActor is null"));
         return;
@@ -177,6 +245,75 @@ void UKeyRipplePianoProcessor::GenerateInstrumentAnimation(
            TEXT("========== GenerateInstrumentAnimation Started =========="));
 
 #if WITH_EDITOR
+    // 分段子序列模式：琴键Morph Target和材质动画写入独立的子序列资产
+    FScopedTakeSequenceGeneration TakeScope(KeyRippleActor->bUseTakeSequences,
+                                            KeyRippleActor->Piano,
+                                            TEXT("Keys"));
+
+    // 撤销模式：Light/Disabled 时不向事务缓冲区写入对象快照
+    // （Light 模式在写入前把琴键曲线保存到磁盘，材质参数轨道不在记录内）
+    FScopedGenerationUndoMode UndoMode(
+        KeyRippleActor->GenerationUndoMode,
+        KeyRippleActor->GetActorLabel() + TEXT("_Keys"));
+
+    ULevelSequence* LevelSequence = nullptr;
+    TSharedPtr<ISequencer> Sequencer = nullptr;
+
+    if (!UInstrumentAnimationUtility::GetActiveLevelSequenceAndSequencer(
+            LevelSequence, Sequencer)) {
+        return;
+    }
+
+    UMovieScene* MovieScene = LevelSequence->GetMovieScene();
+    if (!MovieScene) {
+        UE_LOG(LogTemp, Error, TEXT("MovieScene is null"));
+        return;
+    }
+
+    // 逐键材质模式下材质参数轨道由琴键曲线派生，和琴键曲线一起缓存
+    const bool bPerKeyMaterials = KeyRippleActor->KeyboardRenderMode ==
+                                  EPianoKeyboardRenderMode::MorphTargets;
+
+    // 输入没有变化时直接从生成缓存恢复（局部重新生成不走缓存）
+    FString Fingerprint;
+    if (!FrameWindow.IsSet()) {
+        UControlRig* PianoControlRig = nullptr;
+        UControlRigBlueprint* PianoControlRigBlueprint = nullptr;
+        FInstrumentControlRigUtility::GetControlRigFromSkeletalMeshActor(
+            KeyRippleActor->Piano, PianoControlRig, PianoControlRigBlueprint);
+
+        FGenerationFingerprint FingerprintBuilder;
+        FingerprintBuilder.AddString(TEXT("KeyRipple.PianoKeys"));
+        FingerprintBuilder.AddFile(PianoKeyAnimationPath);
+        FingerprintBuilder.AddControlRigHierarchy(PianoControlRig);
+        FingerprintBuilder.AddFrameRate(MovieScene->GetTickResolution());
+        FingerprintBuilder.AddFrameRate(MovieScene->GetDisplayRate());
+        FingerprintBuilder.AddInt(bPerKeyMaterials ? 1 : 0);
+        if (bPerKeyMaterials) {
+            FingerprintBuilder.AddMaterialSlots(
+                KeyRippleActor->Piano->GetSkeletalMeshComponent());
+        }
+        Fingerprint = FingerprintBuilder.ToString();
+    }
+
+    // Light 撤销模式：写入前把现有琴键曲线保存到磁盘作为撤销记录
+    UndoMode.RecordPreviousInstrumentSection(KeyRippleActor->Piano);
+
+    TArray<UMovieSceneSection*> CachedSections;
+    if (!Fingerprint.IsEmpty() &&
+        FInstrumentGenerationCache::CollectInstrumentSections(
+            KeyRippleActor->Piano, bPerKeyMaterials, CachedSections) &&
+        FInstrumentGenerationCache::RestoreSectionChannels(Fingerprint,
+                                                           CachedSections)) {
+        LevelSequence->MarkPackageDirty();
+        UndoMode.LogMemoryReport();
+        UE_LOG(LogTemp, Warning,
+               TEXT("========== GenerateInstrumentAnimation Completed "
+                    "(restored from cache %s) =========="),
+               *Fingerprint);
+        return;
+    }
+
     // ========== Piano特定的JSON读取逻辑 ==========
     FString JsonContent;
     if (!FFileHelper::LoadFileToString(JsonContent, *PianoKeyAnimationPath)) {
@@ -217,27 +354,14 @@ void UKeyRipplePianoProcessor::GenerateInstrumentAnimation(
     }
 
     // ========== 使用通用方法处理关键帧数据 ==========
-    ULevelSequence* LevelSequence = nullptr;
-    TSharedPtr<ISequencer> Sequencer = nullptr;
-
-    if (!UInstrumentAnimationUtility::GetActiveLevelSequenceAndSequencer(
-            LevelSequence, Sequencer)) {
-        return;
-    }
-
-    UMovieScene* MovieScene = LevelSequence->GetMovieScene();
-    if (!MovieScene) {
-        UE_LOG(LogTemp, Error, TEXT("MovieScene is null"));
-        return;
-    }
-
     FFrameRate TickResolution = MovieScene->GetTickResolution();
     FFrameRate DisplayRate = MovieScene->GetDisplayRate();
 
     // 使用通用处理方法处理KeyDataArray
     TArray<FMorphTargetKeyframeData> KeyframeData;
     if (!UInstrumentMorphTargetUtility::ProcessMorphTargetKeyframeData(
-            KeyDataArray, KeyframeData, TickResolution, DisplayRate)) {
+            KeyDataArray, KeyframeData, TickResolution, DisplayRate,
+            FrameWindow)) {
         UE_LOG(LogTemp, Error,
                TEXT("Failed to process morph target data from JSON"));
         return;
@@ -255,7 +379,7 @@ void UKeyRipplePianoProcessor::GenerateInstrumentAnimation(
     int32 WrittenTargets =
         UInstrumentMorphTargetUtility::WriteMorphTargetAnimationToControlRig(
             KeyRippleActor->Piano, KeyframeData, LevelSequence,
-            TEXT("piano_key_root"));
+            TEXT("piano_key_root"), FrameWindow);
 
     if (WrittenTargets > 0) {
         UE_LOG(LogTemp, Warning,
@@ -268,6 +392,18 @@ void UKeyRipplePianoProcessor::GenerateInstrumentAnimation(
     }
 
     // ========== 生成材质参数动画 ==========
+    // 实例化键盘和键状态纹理直接从琴键曲线更新，每台钢琴只保留一条
+    // Control Rig 轨道
+    if (!bPerKeyMaterials) {
+        FInstrumentGenerationCache::StoreInstrumentSections(
+            Fingerprint, KeyRippleActor->Piano, false);
+        UndoMode.LogMemoryReport();
+        UE_LOG(LogTemp, Warning,
+               TEXT("Key states are driven from the key curves, skipping "
+                    "per-key material animation"));
+        return;
+    }
+
     UE_LOG(LogTemp, Warning,
            TEXT("========== Generating material parameter animation =========="));
 
@@ -298,10 +434,12 @@ void UKeyRipplePianoProcessor::GenerateInstrumentAnimation(
         }
     }
 
-    if (MinFrame.Value != MAX_int32 && MaxFrame.Value != MIN_int32) {
+    // 窗口模式下即使窗口内没有关键帧也要写入，以清除窗口内的旧关键帧
+    if ((MinFrame.Value != MAX_int32 && MaxFrame.Value != MIN_int32) ||
+        FrameWindow.IsSet()) {
         int32 MaterialAnimationResult = GenerateInstrumentMaterialAnimation(
             KeyRippleActor, LevelSequence, MorphTargetKeyframeData, MinFrame,
-            MaxFrame);
+            MaxFrame, FrameWindow);
 
         if (MaterialAnimationResult > 0) {
             UE_LOG(LogTemp, Warning,
@@ -314,6 +452,9 @@ void UKeyRipplePianoProcessor::GenerateInstrumentAnimation(
         }
     }
 
+    FInstrumentGenerationCache::StoreInstrumentSections(
+        Fingerprint, KeyRippleActor->Piano, true);
+    UndoMode.LogMemoryReport();
     UE_LOG(LogTemp, Warning,
            TEXT("========== GenerateInstrumentAnimation Completed =========="));
 #endif
@@ -471,15 +612,15 @@ int32 UKeyRipplePianoProcessor::InitPianoMaterialParameterTracks(
     UE_LOG(LogTemp, Warning, TEXT("Final SkeletalMeshComponent BindingID: %s"),
            *SkeletalMeshCompBindingID.ToString());
 
-    int32 SuccessCount = 0;
-    int32 FailureCount = 0;
     int32 NumMaterials = SkeletalMeshComp->GetNumMaterials();
 
     UE_LOG(LogTemp, Warning,
            TEXT("Checking %d materials for Pressed parameter..."),
            NumMaterials);
 
-    // 现在遍历所有材质槽，只处理材质轨道添加
+    // 先收集所有带 Pressed 参数的材质槽，再一次性批量创建轨道
+    TArray<FMaterialParameterTrackRequest> Requests;
+    Requests.Reserve(NumMaterials);
     for (int32 MaterialSlotIndex = 0; MaterialSlotIndex < NumMaterials;
          ++MaterialSlotIndex) {
         UMaterialInterface* CurrentMaterial =
@@ -489,36 +630,35 @@ int32 UKeyRipplePianoProcessor::InitPianoMaterialParameterTracks(
             continue;
         }
 
-        FString MaterialName = CurrentMaterial->GetName();
-
         // 检查材质是否有 Pressed 参数
         if (UInstrumentMaterialUtility::MaterialHasParameter(CurrentMaterial,
                                                              TEXT("Pressed"))) {
-            // 查找或创建材质参数轨道
-            UMovieSceneComponentMaterialTrack* MaterialTrack =
-                UInstrumentAnimationUtility::FindOrCreateComponentMaterialTrack(
-                    LevelSequence, SkeletalMeshCompBindingID,
-                    MaterialSlotIndex);
-
-            if (MaterialTrack &&
-                UInstrumentAnimationUtility::AddMaterialParameter(
-                    MaterialTrack, TEXT("Pressed"), 0.0f)) {
-                SuccessCount++;
-            } else {
-                UE_LOG(LogTemp, Warning,
-                       TEXT("  ✗ Failed to create material parameter track for "
-                            "'%s' (slot %d)"),
-                       *MaterialName, MaterialSlotIndex);
-                FailureCount++;
-            }
+            Requests.Emplace(MaterialSlotIndex, TEXT("Pressed"), 0.0f);
         } else {
             UE_LOG(LogTemp, Warning,
                    TEXT("  - Material '%s' (slot %d) does not have Pressed "
                         "parameter"),
-                   *MaterialName, MaterialSlotIndex);
+                   *CurrentMaterial->GetName(), MaterialSlotIndex);
         }
     }
 
+    int32 SuccessCount = 0;
+    TArray<int32> FailedRequestIndices;
+    if (Requests.Num() > 0) {
+        SuccessCount =
+            UInstrumentAnimationUtility::BulkCreateMaterialParameterTracks(
+                LevelSequence, SkeletalMeshCompBindingID, Requests, Sequencer,
+                &FailedRequestIndices);
+    }
+
+    for (int32 FailedIndex : FailedRequestIndices) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("  ✗ Failed to create material parameter track for "
+                    "slot %d"),
+               Requests[FailedIndex].MaterialSlotIndex);
+    }
+    const int32 FailureCount = FailedRequestIndices.Num();
+
     UE_LOG(
         LogTemp, Warning,
         TEXT("========== InitPianoMaterialParameterTracks Report =========="));
@@ -540,7 +680,8 @@ int32 UKeyRipplePianoProcessor::GenerateInstrumentMaterialAnimation(
     const TMap<FString,
                TPair<TArray<FFrameNumber>, TArray<FMovieSceneFloatValue>>>&
         MorphTargetKeyframeData,
-    FFrameNumber MinFrame, FFrameNumber MaxFrame) {
+    FFrameNumber MinFrame, FFrameNumber MaxFrame,
+    const FAnimationFrameWindow& FrameWindow) {
     if (!KeyRippleActor) {
         UE_LOG(LogTemp, Error,
                TEXT("KeyRippleActor is null in "
@@ -628,10 +769,9 @@ int32 UKeyRipplePianoProcessor::GenerateInstrumentMaterialAnimation(
 
         for (const TWeakPtr<ISequencer>& WeakSequencer : WeakSequencers) {
             if (TSharedPtr<ISequencer> CurrentSequencer = WeakSequencer.Pin()) {
-                UMovieSceneSequence* RootSequence =
-                    CurrentSequencer->GetRootMovieSceneSequence();
-
-                if (RootSequence && RootSequence == LevelSequence) {
+                // 分段子序列生成时LevelSequence是聚焦的子序列
+                if (UInstrumentAnimationUtility::GetGenerationTargetSequence(
+                        *CurrentSequencer) == LevelSequence) {
                     Sequencer = CurrentSequencer;
                     break;
                 }
@@ -647,8 +787,8 @@ int32 UKeyRipplePianoProcessor::GenerateInstrumentMaterialAnimation(
     }
 
     // 验证传入的LevelSequence是否匹配当前Sequencer
-    UMovieSceneSequence* RootSequence = Sequencer->GetRootMovieSceneSequence();
-    if (!RootSequence || RootSequence != LevelSequence) {
+    if (UInstrumentAnimationUtility::GetGenerationTargetSequence(*Sequencer) !=
+        LevelSequence) {
         UE_LOG(LogTemp, Error,
                TEXT("LevelSequence does not match current Sequencer"));
         return 0;
@@ -778,9 +918,14 @@ int32 UKeyRipplePianoProcessor::GenerateInstrumentMaterialAnimation(
             continue;
         }
 
-        // 清理现有Section并创建新的
-        UMovieSceneSection* NewSection =
-            UInstrumentAnimationUtility::ResetTrackSections(MaterialTrack);
+        // 局部重新生成时保留现有Section，否则清理现有Section并创建新的
+        UMovieSceneSection* NewSection = nullptr;
+        if (FrameWindow.IsSet() && MaterialTrack->GetAllSections().Num() > 0) {
+            NewSection = MaterialTrack->GetAllSections()[0];
+        } else {
+            NewSection =
+                UInstrumentAnimationUtility::ResetTrackSections(MaterialTrack);
+        }
         if (!NewSection) {
             continue;
         }
@@ -794,7 +939,7 @@ int32 UKeyRipplePianoProcessor::GenerateInstrumentMaterialAnimation(
         // 只写入该键对应的关键帧数据
         int32 WrittenParams =
             UInstrumentAnimationUtility::WriteMaterialParameterKeyframes(
-                ParameterSection, KeySpecificData);
+                ParameterSection, KeySpecificData, FrameWindow);
 
         if (WrittenParams > 0) {
             SuccessCount++;
@@ -802,8 +947,16 @@ int32 UKeyRipplePianoProcessor::GenerateInstrumentMaterialAnimation(
                    TEXT("Applied animation to piano key %d (material slot %d)"),
                    PianoKeyNumber, MaterialSlotIndex);
 
-            // 设置Section范围
-            if (MinFrame.Value != MAX_int32 && MaxFrame.Value != MIN_int32) {
+            // 设置Section范围（窗口模式下只扩展）
+            if (FrameWindow.IsSet()) {
+                if (MinFrame.Value != MAX_int32 &&
+                    MaxFrame.Value != MIN_int32) {
+                    ParameterSection->SetRange(TRange<FFrameNumber>::Hull(
+                        ParameterSection->GetRange(),
+                        TRange<FFrameNumber>(MinFrame, MaxFrame + 1)));
+                }
+            } else if (MinFrame.Value != MAX_int32 &&
+                       MaxFrame.Value != MIN_int32) {
                 ParameterSection->SetRange(
                     TRange<FFrameNumber>(MinFrame, MaxFrame + 1));
             }
@@ -836,6 +989,453 @@ int32 UKeyRipplePianoProcessor::GenerateInstrumentMaterialAnimation(
 #endif
 }
 
+void UKeyRipplePianoProcessor::BuildInstancedKeyboardLayout(
+    const AKeyRippleUnreal* KeyRippleActor, TConstArrayView<int32> KeyNumbers,
+    TArray<FKeyRippleKeyboardKey>& OutKeys) {
+    OutKeys.Reset(KeyNumbers.Num());
+    if (!KeyRippleActor || !KeyRippleActor->Piano || KeyNumbers.Num() == 0) {
+        return;
+    }
+
+    const FTransform KeyboardTransform =
+        KeyRippleActor->InstancedKeyboardOffset *
+        KeyRippleActor->Piano->GetActorTransform();
+    const float Spacing = KeyRippleActor->WhiteKeySpacing;
+
+    // 钢琴网格上的琴键插槽（键号 -> 插槽名）
+    TMap<int32, FName> KeySockets;
+    USkeletalMeshComponent* SkeletalMeshComp =
+        KeyRippleActor->Piano->GetSkeletalMeshComponent();
+    USkeletalMesh* PianoMesh =
+        SkeletalMeshComp ? SkeletalMeshComp->GetSkeletalMeshAsset() : nullptr;
+    if (PianoMesh) {
+        for (int32 i = 0; i < PianoMesh->NumSockets(); ++i) {
+            const USkeletalMeshSocket* Socket = PianoMesh->GetSocketByIndex(i);
+            if (!Socket || !Socket->SocketName.ToString().StartsWith(
+                               KeyRipplePianoHelper::KeySocketPrefix)) {
+                continue;
+            }
+            const int32 KeyNumber = KeyRipplePianoHelper::ParseKeyNumber(
+                Socket->SocketName.ToString());
+            if (KeyNumber != INDEX_NONE) {
+                KeySockets.Add(KeyNumber, Socket->SocketName);
+            }
+        }
+    }
+
+    // 从最低音开始数白键，黑键位于前一个白键和后一个白键之间
+    int32 NextKeyNumber = KeyNumbers[0];
+    int32 NumWhiteKeysBelow = 0;
+    for (int32 KeyNumber : KeyNumbers) {
+        for (; NextKeyNumber < KeyNumber; ++NextKeyNumber) {
+            if (!KeyRipplePianoHelper::IsBlackKey(NextKeyNumber)) {
+                ++NumWhiteKeysBelow;
+            }
+        }
+
+        FKeyRippleKeyboardKey& Key = OutKeys.AddDefaulted_GetRef();
+        const bool bBlackKey = KeyRipplePianoHelper::IsBlackKey(KeyNumber);
+        if (const FName* SocketName = KeySockets.Find(KeyNumber)) {
+            Key.Mesh = bBlackKey ? KeyRippleActor->BlackKeyMesh
+                                 : KeyRippleActor->WhiteKeyMesh;
+            Key.Transform = SkeletalMeshComp->GetSocketTransform(*SocketName);
+            continue;
+        }
+
+        FVector Location;
+        if (bBlackKey) {
+            Key.Mesh = KeyRippleActor->BlackKeyMesh;
+            Location = FVector((NumWhiteKeysBelow - 0.5f) * Spacing, 0.0f,
+                               0.0f) +
+                       KeyRippleActor->BlackKeyOffset;
+        } else {
+            Key.Mesh = KeyRippleActor->WhiteKeyMesh;
+            Location = FVector(NumWhiteKeysBelow * Spacing, 0.0f, 0.0f);
+        }
+        Key.Transform = FTransform(Location) * KeyboardTransform;
+    }
+}
+
+void UKeyRipplePianoProcessor::GatherKeyboardSync(
+    AKeyRippleUnreal* KeyRippleActor, const FInstrumentSyncFrameContext& Context,
+    FKeyRippleKeyboardSyncData& SyncData) {
+    SyncData.bHasInput = false;
+    if (!KeyRippleActor || !KeyRippleActor->Piano ||
+        KeyRippleActor->KeyboardRenderMode ==
+            EPianoKeyboardRenderMode::MorphTargets) {
+        return;
+    }
+
+    // Sequencer 中的 Control Rig 优先，运行时播放使用Actor上的组件
+    UControlRig* ControlRig = Context.FindControlRig(KeyRippleActor->Piano);
+    if (!ControlRig) {
+        if (UControlRigComponent* ControlRigComponent =
+                KeyRippleActor->Piano
+                    ->FindComponentByClass<UControlRigComponent>()) {
+            ControlRig = ControlRigComponent->GetControlRig();
+        }
+    }
+    URigHierarchy* Hierarchy = ControlRig ? ControlRig->GetHierarchy() : nullptr;
+    if (!Hierarchy) {
+        return;
+    }
+
+    // 琴键动画通道只在 Control Rig 或层级拓扑变化时重新查找
+    if (SyncData.ControlRig.Get() != ControlRig ||
+        SyncData.TopologyVersion != Hierarchy->GetTopologyVersion()) {
+        SyncData.ControlRig = ControlRig;
+        SyncData.TopologyVersion = Hierarchy->GetTopologyVersion();
+
+        TArray<TPair<int32, int32>> Channels;  // 键号 -> 元素下标
+        TSet<int32> SeenKeyNumbers;
+        for (FRigControlElement* Control : Hierarchy->GetControls()) {
+            if (!Control->IsAnimationChannel()) {
+                continue;
+            }
+            const int32 KeyNumber = KeyRipplePianoHelper::ParseKeyNumber(
+                Control->GetDisplayName().ToString());
+            bool bAlreadySeen = false;
+            SeenKeyNumbers.Add(KeyNumber, &bAlreadySeen);
+            if (KeyNumber != INDEX_NONE && !bAlreadySeen) {
+                Channels.Emplace(KeyNumber, Control->GetIndex());
+            }
+        }
+        Channels.Sort([](const TPair<int32, int32>& A,
+                         const TPair<int32, int32>& B) {
+            return A.Key < B.Key;
+        });
+
+        SyncData.KeyNumbers.Reset(Channels.Num());
+        SyncData.ChannelIndices.Reset(Channels.Num());
+        for (const TPair<int32, int32>& Channel : Channels) {
+            SyncData.KeyNumbers.Add(Channel.Key);
+            SyncData.ChannelIndices.Add(Channel.Value);
+        }
+        SyncData.bLayoutDirty = true;
+    }
+
+    if (KeyRippleActor->KeyboardRenderMode ==
+            EPianoKeyboardRenderMode::Instanced &&
+        (!SyncData.bRegistered ||
+         !SyncData.RegisteredPianoTransform.Equals(
+             KeyRippleActor->Piano->GetActorTransform()))) {
+        SyncData.bLayoutDirty = true;
+    }
+
+    SyncData.KeyValues.SetNumUninitialized(SyncData.ChannelIndices.Num());
+    for (int32 i = 0; i < SyncData.ChannelIndices.Num(); ++i) {
+        SyncData.KeyValues[i] =
+            Hierarchy->GetControlValue(SyncData.ChannelIndices[i])
+                .Get<float>();
+    }
+    SyncData.bHasInput = true;
+}
+
+void UKeyRipplePianoProcessor::ComputeKeyboardSync(
+    FKeyRippleKeyboardSyncData& SyncData) {
+    if (!SyncData.bHasInput) {
+        return;
+    }
+    for (float& Value : SyncData.KeyValues) {
+        Value = FMath::Clamp(Value, 0.0f, 1.0f);
+    }
+}
+
+void UKeyRipplePianoProcessor::ApplyKeyboardSync(
+    AKeyRippleUnreal* KeyRippleActor, FKeyRippleKeyboardSyncData& SyncData) {
+    if (!KeyRippleActor) {
+        return;
+    }
+
+    const EPianoKeyboardRenderMode RenderMode =
+        KeyRippleActor->Piano ? KeyRippleActor->KeyboardRenderMode
+                              : EPianoKeyboardRenderMode::MorphTargets;
+    if (RenderMode != EPianoKeyboardRenderMode::Instanced) {
+        ReleaseInstancedKeyboard(KeyRippleActor, SyncData);
+    }
+    if (RenderMode != EPianoKeyboardRenderMode::KeyStateTexture) {
+        ReleaseKeyStateTexture(KeyRippleActor, SyncData);
+    }
+    if (RenderMode == EPianoKeyboardRenderMode::KeyStateTexture) {
+        ApplyKeyStateTexture(KeyRippleActor, SyncData);
+        return;
+    }
+    if (RenderMode != EPianoKeyboardRenderMode::Instanced) {
+        return;
+    }
+
+    UKeyRippleKeyboardInstancingSubsystem* Subsystem =
+        UKeyRippleKeyboardInstancingSubsystem::Get(KeyRippleActor->GetWorld());
+    if (!Subsystem || !SyncData.bHasInput) {
+        return;
+    }
+
+    if (SyncData.bLayoutDirty) {
+        TArray<FKeyRippleKeyboardKey> Keys;
+        BuildInstancedKeyboardLayout(KeyRippleActor, SyncData.KeyNumbers, Keys);
+        Subsystem->RegisterKeyboard(KeyRippleActor, MoveTemp(Keys));
+        SetPianoKeySectionsHidden(KeyRippleActor, SyncData, true);
+        SetPianoKeyMorphCurvesDisabled(KeyRippleActor, SyncData, true);
+        SyncData.bRegistered = true;
+        SyncData.bLayoutDirty = false;
+        SyncData.RegisteredPianoTransform =
+            KeyRippleActor->Piano->GetActorTransform();
+    }
+
+    Subsystem->UpdateKeyStates(KeyRippleActor, SyncData.KeyValues);
+    SyncData.bHasInput = false;
+}
+
+void UKeyRipplePianoProcessor::ReleaseInstancedKeyboard(
+    AKeyRippleUnreal* KeyRippleActor, FKeyRippleKeyboardSyncData& SyncData) {
+    if (!SyncData.bRegistered) {
+        return;
+    }
+    if (KeyRippleActor) {
+        if (UKeyRippleKeyboardInstancingSubsystem* Subsystem =
+                UKeyRippleKeyboardInstancingSubsystem::Get(
+                    KeyRippleActor->GetWorld())) {
+            Subsystem->UnregisterKeyboard(KeyRippleActor);
+        }
+    }
+    SetPianoKeySectionsHidden(KeyRippleActor, SyncData, false);
+    SetPianoKeyMorphCurvesDisabled(KeyRippleActor, SyncData, false);
+    SyncData.bRegistered = false;
+    SyncData.bLayoutDirty = true;
+}
+
+void UKeyRipplePianoProcessor::SetPianoKeySectionsHidden(
+    AKeyRippleUnreal* KeyRippleActor, FKeyRippleKeyboardSyncData& SyncData,
+    bool bHidden) {
+    USkeletalMeshComponent* SkeletalMeshComp =
+        (KeyRippleActor && KeyRippleActor->Piano)
+            ? KeyRippleActor->Piano->GetSkeletalMeshComponent()
+            : nullptr;
+
+    if (!bHidden) {
+        if (SkeletalMeshComp) {
+            for (const FIntVector& Section : SyncData.HiddenKeySections) {
+                SkeletalMeshComp->ShowMaterialSection(Section.X, Section.Y,
+                                                      true, Section.Z);
+            }
+        }
+        SyncData.HiddenKeySections.Reset();
+        return;
+    }
+
+    // 已隐藏时不重复处理（重新注册布局时也会调用）
+    if (!SkeletalMeshComp || SyncData.HiddenKeySections.Num() > 0) {
+        return;
+    }
+    USkeletalMesh* PianoMesh = SkeletalMeshComp->GetSkeletalMeshAsset();
+    FSkeletalMeshRenderData* RenderData =
+        PianoMesh ? PianoMesh->GetResourceForRendering() : nullptr;
+    if (!RenderData) {
+        return;
+    }
+
+    TSet<int32> KeySlots;
+    const TArray<FName> SlotNames = SkeletalMeshComp->GetMaterialSlotNames();
+    for (int32 SlotIndex = 0; SlotIndex < SlotNames.Num(); ++SlotIndex) {
+        if (KeyRipplePianoHelper::IsKeyMaterialSlot(SlotNames[SlotIndex])) {
+            KeySlots.Add(SlotIndex);
+        }
+    }
+
+    for (int32 LODIndex = 0; LODIndex < RenderData->LODRenderData.Num();
+         ++LODIndex) {
+        const TArray<FSkelMeshRenderSection>& Sections =
+            RenderData->LODRenderData[LODIndex].RenderSections;
+        for (int32 SectionIndex = 0; SectionIndex < Sections.Num();
+             ++SectionIndex) {
+            const int32 MaterialIndex = Sections[SectionIndex].MaterialIndex;
+            if (!KeySlots.Contains(MaterialIndex)) {
+                continue;
+            }
+            SkeletalMeshComp->ShowMaterialSection(MaterialIndex, SectionIndex,
+                                                  false, LODIndex);
+            SyncData.HiddenKeySections.Add(
+                FIntVector(MaterialIndex, SectionIndex, LODIndex));
+        }
+    }
+}
+
+void UKeyRipplePianoProcessor::SetPianoKeyMorphCurvesDisabled(
+    AKeyRippleUnreal* KeyRippleActor, FKeyRippleKeyboardSyncData& SyncData,
+    bool bDisabled) {
+    if (SyncData.bKeyMorphCurvesDisabled == bDisabled) {
+        return;
+    }
+    USkeletalMeshComponent* SkeletalMeshComp =
+        (KeyRippleActor && KeyRippleActor->Piano)
+            ? KeyRippleActor->Piano->GetSkeletalMeshComponent()
+            : nullptr;
+
+    if (!bDisabled) {
+        if (SkeletalMeshComp) {
+            SkeletalMeshComp->ResetAllowedAnimCurveEvaluation();
+        }
+        SyncData.bKeyMorphCurvesDisabled = false;
+        return;
+    }
+
+    TArray<FString> MorphTargetNames;
+    if (!SkeletalMeshComp ||
+        !UInstrumentMorphTargetUtility::GetMorphTargetNames(SkeletalMeshComp,
+                                                            MorphTargetNames)) {
+        return;
+    }
+
+    // 琴键 Morph Target 与琴键动画通道同名，名称中带键号
+    TArray<FName> KeyCurveNames;
+    for (const FString& MorphTargetName : MorphTargetNames) {
+        if (KeyRipplePianoHelper::ParseKeyNumber(MorphTargetName) !=
+            INDEX_NONE) {
+            KeyCurveNames.Add(FName(*MorphTargetName));
+        }
+    }
+    if (KeyCurveNames.Num() == 0) {
+        return;
+    }
+
+    SkeletalMeshComp->SetAllowedAnimCurvesEvaluation(KeyCurveNames, false);
+    SyncData.bKeyMorphCurvesDisabled = true;
+}
+
+int32 UKeyRipplePianoProcessor::AssignKeyStateMaterial(
+    AKeyRippleUnreal* KeyRippleActor, UMaterialInterface* Material) {
+    if (!KeyRippleActor || !KeyRippleActor->Piano || !Material) {
+        return 0;
+    }
+
+    USkeletalMeshComponent* SkeletalMeshComp =
+        KeyRippleActor->Piano->GetSkeletalMeshComponent();
+    if (!SkeletalMeshComp) {
+        return 0;
+    }
+
+    int32 NumAssigned = 0;
+    const TArray<FName> SlotNames = SkeletalMeshComp->GetMaterialSlotNames();
+    for (int32 SlotIndex = 0; SlotIndex < SlotNames.Num(); ++SlotIndex) {
+        if (!KeyRipplePianoHelper::IsKeyMaterialSlot(SlotNames[SlotIndex])) {
+            continue;
+        }
+
+        UMaterialInterface* Current = SkeletalMeshComp->GetMaterial(SlotIndex);
+        if (Current != Material) {
+            // 只记录第一次替换前的材质，之后的替换（如基础材质换成材质实例）
+            // 不会把键状态材质当作原始材质
+            if (!KeyRippleActor->KeyStateOriginalMaterials.Contains(SlotIndex)) {
+                KeyRippleActor->KeyStateOriginalMaterials.Add(SlotIndex,
+                                                              Current);
+            }
+            SkeletalMeshComp->SetMaterial(SlotIndex, Material);
+        }
+        ++NumAssigned;
+    }
+    return NumAssigned;
+}
+
+void UKeyRipplePianoProcessor::ApplyKeyStateTexture(
+    AKeyRippleUnreal* KeyRippleActor, FKeyRippleKeyboardSyncData& SyncData) {
+    using namespace KeyRipplePianoHelper;
+
+    if (!KeyRippleActor || !KeyRippleActor->KeyStateMaterial ||
+        !SyncData.bHasInput) {
+        return;
+    }
+
+    // 1. 每台钢琴一张纹理和一个材质实例，所有琴键材质槽共用
+    UTexture2D*& Texture = KeyRippleActor->GeneratedKeyStateTexture;
+    if (!Texture) {
+        Texture = UTexture2D::CreateTransient(KeyStateTextureWidth, 1,
+                                              PF_R32_FLOAT);
+        if (!Texture) {
+            return;
+        }
+        Texture->SRGB = false;
+        Texture->Filter = TF_Nearest;
+        Texture->AddressX = TA_Clamp;
+        Texture->AddressY = TA_Clamp;
+        Texture->NeverStream = true;
+        Texture->UpdateResource();
+        SyncData.KeyStateTexels.Reset();
+    }
+
+    UMaterialInstanceDynamic*& MaterialInstance =
+        KeyRippleActor->GeneratedKeyStateMaterial;
+    if (!MaterialInstance ||
+        MaterialInstance->Parent != KeyRippleActor->KeyStateMaterial) {
+        MaterialInstance = UMaterialInstanceDynamic::Create(
+            KeyRippleActor->KeyStateMaterial, KeyRippleActor);
+        MaterialInstance->SetTextureParameterValue(KeyStateTextureParameterName,
+                                                   Texture);
+        SyncData.bLayoutDirty = true;
+    }
+
+    if (SyncData.bLayoutDirty || !SyncData.bKeyStateTextureActive) {
+        AssignKeyStateMaterial(KeyRippleActor, MaterialInstance);
+        SyncData.bLayoutDirty = false;
+    }
+    SyncData.bKeyStateTextureActive = true;
+
+    // 2. 按键号写入纹素，与上一次上传相同时跳过
+    TArray<float>& Texels = SyncData.KeyStateTexelScratch;
+    Texels.SetNumUninitialized(KeyStateTextureWidth);
+    FMemory::Memzero(Texels.GetData(), KeyStateTextureWidth * sizeof(float));
+    for (int32 i = 0; i < SyncData.KeyNumbers.Num(); ++i) {
+        const int32 KeyNumber = SyncData.KeyNumbers[i];
+        if (KeyNumber >= 0 && KeyNumber < KeyStateTextureWidth) {
+            Texels[KeyNumber] = SyncData.KeyValues[i];
+        }
+    }
+    SyncData.bHasInput = false;
+    if (Texels == SyncData.KeyStateTexels) {
+        return;
+    }
+    Swap(SyncData.KeyStateTexels, Texels);
+
+    // 3. 上传（数据和区域在渲染线程处理完成后释放）
+    const uint32 NumBytes = KeyStateTextureWidth * sizeof(float);
+    uint8* UploadData = static_cast<uint8*>(FMemory::Malloc(NumBytes));
+    FMemory::Memcpy(UploadData, SyncData.KeyStateTexels.GetData(), NumBytes);
+    Texture->UpdateTextureRegions(
+        0, 1, new FUpdateTextureRegion2D(0, 0, 0, 0, KeyStateTextureWidth, 1),
+        NumBytes, sizeof(float), UploadData,
+        [](uint8* SrcData, const FUpdateTextureRegion2D* Regions) {
+            FMemory::Free(SrcData);
+            delete Regions;
+        });
+}
+
+void UKeyRipplePianoProcessor::ReleaseKeyStateTexture(
+    AKeyRippleUnreal* KeyRippleActor, FKeyRippleKeyboardSyncData& SyncData) {
+    if (!SyncData.bKeyStateTextureActive &&
+        (!KeyRippleActor || KeyRippleActor->KeyStateOriginalMaterials.Num() == 0)) {
+        return;
+    }
+    if (KeyRippleActor) {
+        // 还原接管前的材质槽（nullptr 表示回到网格体默认材质）
+        USkeletalMeshComponent* SkeletalMeshComp =
+            KeyRippleActor->Piano
+                ? KeyRippleActor->Piano->GetSkeletalMeshComponent()
+                : nullptr;
+        if (SkeletalMeshComp) {
+            for (const TPair<int32, UMaterialInterface*>& Pair :
+                 KeyRippleActor->KeyStateOriginalMaterials) {
+                if (Pair.Key < SkeletalMeshComp->GetNumMaterials()) {
+                    SkeletalMeshComp->SetMaterial(Pair.Key, Pair.Value);
+                }
+            }
+        }
+        KeyRippleActor->KeyStateOriginalMaterials.Reset();
+        KeyRippleActor->GeneratedKeyStateTexture = nullptr;
+        KeyRippleActor->GeneratedKeyStateMaterial = nullptr;
+    }
+    SyncData.bKeyStateTextureActive = false;
+    SyncData.KeyStateTexels.Reset();
+}
+
 void UKeyRipplePianoProcessor::CleanupExistingPianoAnimations(
     AKeyRippleUnreal* KeyRippleActor) {
     if (!KeyRippleActor || !KeyRippleActor->Piano) {
@@ -6,6 +6,7 @@
 #include <string>
 #include <vector>
 
+#include "Common/Public/InstrumentControlRigUtility.h"
 #include "Components/SceneComponent.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Components/StaticMeshComponent.h"
@@ -14,6 +15,10 @@
 #include "Engine/StaticMeshActor.h"
 #include "Engine/World.h"
 #include "EngineUtils.h"
+#include "ISequencer.h"
+#include "ISequencerModule.h"
+#include "KeyRipplePianoProcessor.h"
+#include "LevelEditorSequencerIntegration.h"
 #include "Serialization/JsonReader.h"
 #include "Serialization/JsonSerializer.h"
 #include "Serialization/JsonWriter.h"
@@ -48,6 +53,279 @@ void AKeyRippleUnreal::BeginPlay() { Super::BeginPlay(); }
 // Called every frame
 void AKeyRippleUnreal::Tick(float DeltaTime) { Super::Tick(DeltaTime); }
 
+void AKeyRippleUnreal::GetPlaybackActors(
+    TArray<FInstrumentPlaybackActor>& OutActors) const {
+    Super::GetPlaybackActors(OutActors);
+    if (Piano) {
+        OutActors.Add({TEXT("Piano"), Piano, TEXT("Keys")});
+    }
+}
+
+void AKeyRippleUnreal::PostRegisterAllComponents() {
+    Super::PostRegisterAllComponents();
+
+#if WITH_EDITOR
+    if (!HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject)) {
+        BindKeyboardSyncEvents();
+    }
+#endif
+    MarkKeyboardSyncDirty();
+}
+
+void AKeyRippleUnreal::PostUnregisterAllComponents() {
+#if WITH_EDITOR
+    UnbindKeyboardSyncEvents();
+#endif
+    UKeyRipplePianoProcessor::ReleaseInstancedKeyboard(this, KeyboardSyncData);
+    UKeyRipplePianoProcessor::ReleaseKeyStateTexture(this, KeyboardSyncData);
+    Super::PostUnregisterAllComponents();
+}
+
+void AKeyRippleUnreal::BeginDestroy() {
+#if WITH_EDITOR
+    UnbindKeyboardSyncEvents();
+#endif
+    Super::BeginDestroy();
+}
+
+bool AKeyRippleUnreal::NeedsRealtimeSync() const {
+    // 切换回 Morph Targets 后只需同步一次，释放后两个标记都会清除
+    if (KeyboardRenderMode == EPianoKeyboardRenderMode::MorphTargets) {
+        return KeyboardSyncData.bRegistered ||
+               KeyboardSyncData.bKeyStateTextureActive;
+    }
+
+    // 编辑器中只在事件标记了变化后同步；游戏世界没有编辑器事件，每帧同步
+    const UWorld* World = GetWorld();
+    return bKeyboardSyncDirty || (World && World->IsGameWorld());
+}
+
+void AKeyRippleUnreal::GatherRealtimeSync(
+    const FInstrumentSyncFrameContext& Context) {
+    UKeyRipplePianoProcessor::GatherKeyboardSync(this, Context,
+                                                 KeyboardSyncData);
+}
+
+void AKeyRippleUnreal::ComputeRealtimeSync() {
+    UKeyRipplePianoProcessor::ComputeKeyboardSync(KeyboardSyncData);
+}
+
+void AKeyRippleUnreal::ApplyRealtimeSync() {
+    UKeyRipplePianoProcessor::ApplyKeyboardSync(this, KeyboardSyncData);
+
+    // 同步完成后再清除标记，忽略同步自身写入引起的通知
+    bKeyboardSyncDirty = false;
+}
+
+#if WITH_EDITOR
+void AKeyRippleUnreal::PostEditChangeProperty(
+    FPropertyChangedEvent& PropertyChangedEvent) {
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+
+    if (PropertyChangedEvent.Property == nullptr) {
+        return;
+    }
+
+    const FName PropertyName = PropertyChangedEvent.Property->GetFName();
+
+    // 钢琴变化后改为订阅新的 Control Rig
+    if (PropertyName == GET_MEMBER_NAME_CHECKED(AKeyRippleUnreal, Piano)) {
+        RefreshBoundControlRig();
+    }
+
+    // 影响琴键布局或共用材质的属性变化后重新注册
+    if (PropertyName == GET_MEMBER_NAME_CHECKED(AKeyRippleUnreal, Piano) ||
+        PropertyName ==
+            GET_MEMBER_NAME_CHECKED(AKeyRippleUnreal, KeyboardRenderMode) ||
+        PropertyName ==
+            GET_MEMBER_NAME_CHECKED(AKeyRippleUnreal, WhiteKeyMesh) ||
+        PropertyName ==
+            GET_MEMBER_NAME_CHECKED(AKeyRippleUnreal, BlackKeyMesh) ||
+        PropertyName ==
+            GET_MEMBER_NAME_CHECKED(AKeyRippleUnreal, InstancedKeyboardOffset) ||
+        PropertyName ==
+            GET_MEMBER_NAME_CHECKED(AKeyRippleUnreal, WhiteKeySpacing) ||
+        PropertyName ==
+            GET_MEMBER_NAME_CHECKED(AKeyRippleUnreal, BlackKeyOffset) ||
+        PropertyName ==
+            GET_MEMBER_NAME_CHECKED(AKeyRippleUnreal, KeyStateMaterial)) {
+        KeyboardSyncData.bLayoutDirty = true;
+        MarkKeyboardSyncDirty();
+    }
+}
+
+// ========== 琴键同步事件订阅 ==========
+
+void AKeyRippleUnreal::BindKeyboardSyncEvents() {
+    if (bKeyboardSyncEventsBound) {
+        return;
+    }
+    bKeyboardSyncEventsBound = true;
+
+    if (GEngine) {
+        GEngine->OnActorMoved().AddUObject(this,
+                                           &AKeyRippleUnreal::HandleActorMoved);
+    }
+
+    ISequencerModule& SequencerModule =
+        FModuleManager::LoadModuleChecked<ISequencerModule>(TEXT("Sequencer"));
+    OnSequencerCreatedHandle = SequencerModule.RegisterOnSequencerCreated(
+        FOnSequencerCreated::FDelegate::CreateUObject(
+            this, &AKeyRippleUnreal::HandleSequencerCreated));
+
+    // 已经打开的 Sequencer
+    if (FModuleManager::Get().IsModuleLoaded(TEXT("LevelEditor"))) {
+        for (const TWeakPtr<ISequencer>& WeakSequencer :
+             FLevelEditorSequencerIntegration::Get().GetSequencers()) {
+            if (TSharedPtr<ISequencer> Sequencer = WeakSequencer.Pin()) {
+                BindSequencer(Sequencer.ToSharedRef());
+            }
+        }
+    }
+
+    RefreshBoundControlRig();
+}
+
+void AKeyRippleUnreal::UnbindKeyboardSyncEvents() {
+    if (!bKeyboardSyncEventsBound) {
+        return;
+    }
+    bKeyboardSyncEventsBound = false;
+
+    if (GEngine) {
+        GEngine->OnActorMoved().RemoveAll(this);
+    }
+
+    if (ISequencerModule* SequencerModule =
+            FModuleManager::GetModulePtr<ISequencerModule>(TEXT("Sequencer"))) {
+        SequencerModule->UnregisterOnSequencerCreated(OnSequencerCreatedHandle);
+    }
+    OnSequencerCreatedHandle.Reset();
+
+    for (const TWeakPtr<ISequencer>& WeakSequencer : BoundSequencers) {
+        if (TSharedPtr<ISequencer> Sequencer = WeakSequencer.Pin()) {
+            Sequencer->OnGlobalTimeChanged().RemoveAll(this);
+            Sequencer->OnMovieSceneDataChanged().RemoveAll(this);
+        }
+    }
+    BoundSequencers.Reset();
+
+    if (UControlRig* ControlRig = BoundControlRig.Get()) {
+        ControlRig->ControlModified().RemoveAll(this);
+    }
+    if (URigHierarchy* Hierarchy = BoundHierarchy.Get()) {
+        Hierarchy->OnModified().RemoveAll(this);
+    }
+    BoundControlRig.Reset();
+    BoundHierarchy.Reset();
+}
+
+void AKeyRippleUnreal::BindSequencer(TSharedRef<ISequencer> Sequencer) {
+    BoundSequencers.RemoveAll([](const TWeakPtr<ISequencer>& WeakSequencer) {
+        return !WeakSequencer.IsValid();
+    });
+
+    for (const TWeakPtr<ISequencer>& WeakSequencer : BoundSequencers) {
+        if (WeakSequencer.Pin() == Sequencer) {
+            return;
+        }
+    }
+
+    Sequencer->OnGlobalTimeChanged().AddUObject(
+        this, &AKeyRippleUnreal::HandleSequencerTimeChanged);
+    Sequencer->OnMovieSceneDataChanged().AddUObject(
+        this, &AKeyRippleUnreal::HandleMovieSceneDataChanged);
+    BoundSequencers.Add(Sequencer);
+}
+
+void AKeyRippleUnreal::RefreshBoundControlRig() {
+    // 没有打开的 Sequencer 时不会有绑定的 Control Rig，也避免查找时的警告
+    UControlRig* ControlRig = nullptr;
+    if (BoundSequencers.Num() > 0 && Piano) {
+        UControlRigBlueprint* ControlRigBlueprint = nullptr;
+        FInstrumentControlRigUtility::GetControlRigFromSkeletalMeshActor(
+            Piano, ControlRig, ControlRigBlueprint);
+    }
+
+    if (ControlRig == BoundControlRig.Get()) {
+        return;
+    }
+
+    if (UControlRig* OldControlRig = BoundControlRig.Get()) {
+        OldControlRig->ControlModified().RemoveAll(this);
+    }
+    if (URigHierarchy* OldHierarchy = BoundHierarchy.Get()) {
+        OldHierarchy->OnModified().RemoveAll(this);
+    }
+    BoundControlRig.Reset();
+    BoundHierarchy.Reset();
+
+    if (ControlRig) {
+        ControlRig->ControlModified().AddUObject(
+            this, &AKeyRippleUnreal::HandleControlModified);
+        BoundControlRig = ControlRig;
+
+        if (URigHierarchy* Hierarchy = ControlRig->GetHierarchy()) {
+            Hierarchy->OnModified().AddUObject(
+                this, &AKeyRippleUnreal::HandleHierarchyModified);
+            BoundHierarchy = Hierarchy;
+        }
+    }
+
+    MarkKeyboardSyncDirty();
+}
+
+void AKeyRippleUnreal::HandleSequencerCreated(
+    TSharedRef<ISequencer> Sequencer) {
+    BindSequencer(Sequencer);
+    MarkKeyboardSyncDirty();
+}
+
+void AKeyRippleUnreal::HandleSequencerTimeChanged() {
+    // Sequencer打开后才会实例化 Control Rig，未订阅时在这里补上
+    if (!BoundControlRig.IsValid()) {
+        RefreshBoundControlRig();
+    }
+    MarkKeyboardSyncDirty();
+}
+
+void AKeyRippleUnreal::HandleMovieSceneDataChanged(
+    EMovieSceneDataChangeType DataChangeType) {
+    // 结构变化（增删轨道、切换序列）可能替换 Control Rig 实例
+    if (DataChangeType != EMovieSceneDataChangeType::TrackValueChanged &&
+        DataChangeType !=
+            EMovieSceneDataChangeType::TrackValueChangedRefreshImmediately) {
+        RefreshBoundControlRig();
+    }
+    MarkKeyboardSyncDirty();
+}
+
+void AKeyRippleUnreal::HandleControlModified(
+    UControlRig* ControlRig, FRigControlElement* ControlElement,
+    const FRigControlModifiedContext& Context) {
+    MarkKeyboardSyncDirty();
+}
+
+void AKeyRippleUnreal::HandleHierarchyModified(
+    ERigHierarchyNotification Notification, URigHierarchy* Hierarchy,
+    const FRigNotificationSubject& Subject) {
+    // 选择变化不影响琴键状态
+    if (Notification == ERigHierarchyNotification::ElementSelected ||
+        Notification == ERigHierarchyNotification::ElementDeselected) {
+        return;
+    }
+    // 琴键通道的增删在下一次同步时按拓扑版本重新查找
+    MarkKeyboardSyncDirty();
+}
+
+void AKeyRippleUnreal::HandleActorMoved(AActor* Actor) {
+    // Instanced 模式下琴键实例跟随钢琴的变换
+    if (Actor && (Actor == this || Actor == Piano)) {
+        MarkKeyboardSyncDirty();
+    }
+}
+#endif
+
 FString AKeyRippleUnreal::GetControllerName(int32 FingerNumber,
                                             EHandType HandType) const {
     FString HandStr = (HandType == EHandType::LEFT) ? TEXT("_L") : TEXT("_R");
@@ -29,13 +29,23 @@ class KEYRIPPLEUNREAL_API UKeyRippleAnimationProcessor : public UObject {
     UFUNCTION(BlueprintCallable, Category = "KeyRipple Animation Processor")
     static void GeneratePerformerAnimation(AKeyRippleUnreal* KeyRippleActor);
 
+    /**
+     * 恢复轻量撤销模式下保存的上一次生成前的演奏动画
+     * @param KeyRippleActor KeyRippleUnreal 实例
+     * @return 是否恢复成功
+     */
+    UFUNCTION(BlueprintCallable, Category = "KeyRipple Animation Processor")
+    static bool RevertPerformerAnimation(AKeyRippleUnreal* KeyRippleActor);
+
     /**
      * 生成演奏动画（直接处理动画文件）
      * @param KeyRippleActor KeyRippleUnreal 实例
      * @param AnimationFilePath 动画文件路径
+     * @param FrameWindow 局部重新生成窗口，设置后只替换窗口内的关键帧
      */
     static void GeneratePerformerAnimationDirect(AKeyRippleUnreal* KeyRippleActor,
-                                             const FString& AnimationFilePath);
+                                             const FString& AnimationFilePath,
+                                             const FAnimationFrameWindow& FrameWindow = FAnimationFrameWindow());
 
     /**
      * 从KeyRipple文件中解析动画路径
@@ -64,6 +74,40 @@ class KEYRIPPLEUNREAL_API UKeyRippleAnimationProcessor : public UObject {
     UFUNCTION(BlueprintCallable, Category = "KeyRipple Animation Processor")
     static void GenerateAllAnimation(AKeyRippleUnreal* KeyRippleActor);
 
+    /**
+     * 开始实时预览：追踪外部工具正在写入的演奏动画文件，
+     * 通过 Live Link Subject "<Actor标签>_Performer" 推送控制器变换
+     * @param KeyRippleActor KeyRippleUnreal 实例
+     * @return Live Link 源是否已添加
+     */
+    UFUNCTION(BlueprintCallable, Category = "KeyRipple Animation Processor")
+    static bool StartLivePreview(AKeyRippleUnreal* KeyRippleActor);
+
+    /**
+     * 停止实时预览，移除 StartLivePreview 添加的 Live Link 源
+     * @param KeyRippleActor KeyRippleUnreal 实例
+     */
+    UFUNCTION(BlueprintCallable, Category = "KeyRipple Animation Processor")
+    static void StopLivePreview(AKeyRippleUnreal* KeyRippleActor);
+
+    /**
+     * 开始流式导入：连接外部工具的本地端口，边接收演奏帧边写入
+     * 演奏者的 Control Rig 轨道，生成开始几秒后即可在 Sequencer 中看到结果
+     * @param KeyRippleActor KeyRippleUnreal 实例
+     * @param Port 外部工具监听的本地端口
+     * @return 会话是否已开始
+     */
+    UFUNCTION(BlueprintCallable, Category = "KeyRipple Animation Processor")
+    static bool StartStreamingImport(AKeyRippleUnreal* KeyRippleActor,
+                                     int32 Port = 47810);
+
+    /**
+     * 停止流式导入，已收到的帧会先写入 Level Sequence
+     * @param KeyRippleActor KeyRippleUnreal 实例
+     */
+    UFUNCTION(BlueprintCallable, Category = "KeyRipple Animation Processor")
+    static void StopStreamingImport(AKeyRippleUnreal* KeyRippleActor);
+
     /**
      * 清空Control Rig轨道上的所有关键帧
      * @param LevelSequence Level Sequence实例
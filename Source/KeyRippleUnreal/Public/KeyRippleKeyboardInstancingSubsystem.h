@@ -0,0 +1,95 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "KeyRippleKeyboardInstancingSubsystem.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+
+/**
+ * 实例化键盘中的一个琴键
+ */
+struct FKeyRippleKeyboardKey {
+    /** 琴键网格（白键或黑键） */
+    UStaticMesh* Mesh = nullptr;
+
+    /** 琴键的世界变换 */
+    FTransform Transform;
+};
+
+/**
+ * 实例化键盘子系统
+ * 世界中所有使用 Instanced 渲染模式的钢琴共享同一组 Instanced Static Mesh，
+ * 每种琴键网格一个组件，多台钢琴也只需要少量 Draw Call
+ *
+ * 每个琴键实例带有 NumCustomDataFloats 个自定义数据，由琴键曲线每帧更新：
+ *   [0] 按下深度（与琴键 Morph Target 的权重相同）
+ *   [1] Pressed（与逐键材质的 Pressed 参数相同）
+ * 逐键材质的 Pressed 轨道本身就是琴键曲线的拷贝，因此两个值相同，发光等
+ * 效果跟随按下深度；分开两个通道是为了让材质与逐键材质使用同样的输入
+ * 琴键材质需要用 PerInstanceCustomData 读取这两个值
+ */
+UCLASS()
+class KEYRIPPLEUNREAL_API UKeyRippleKeyboardInstancingSubsystem
+    : public UWorldSubsystem {
+    GENERATED_BODY()
+
+   public:
+    /** 每个琴键实例的自定义数据数量 */
+    static constexpr int32 NumCustomDataFloats = 2;
+
+    /** 获取指定世界的子系统，世界不支持时返回nullptr */
+    static UKeyRippleKeyboardInstancingSubsystem* Get(const UWorld* World);
+
+    /**
+     * 注册（或替换）一台钢琴的琴键
+     * 注册和注销会重建所有实例，只在钢琴初始化或移动后调用
+     */
+    void RegisterKeyboard(const UObject* Owner,
+                          TArray<FKeyRippleKeyboardKey> Keys);
+
+    void UnregisterKeyboard(const UObject* Owner);
+
+    bool IsKeyboardRegistered(const UObject* Owner) const;
+
+    /**
+     * 按注册顺序写入每个琴键的状态（0为松开，1为完全按下）
+     * 只有数值变化的琴键会写入，每个组件最多标记一次渲染状态
+     * @return 是否有琴键状态发生变化
+     */
+    bool UpdateKeyStates(const UObject* Owner, TConstArrayView<float> KeyValues);
+
+    /** 实例化组件数量（即所有钢琴琴键的 Draw Call 批次数） */
+    int32 GetNumBatches() const { return BatchComponents.Num(); }
+
+    virtual void Deinitialize() override;
+
+   protected:
+    virtual bool DoesSupportWorldType(
+        const EWorldType::Type WorldType) const override;
+
+   private:
+    /** 一台钢琴的琴键和它们在实例化组件中的位置 */
+    struct FKeyboardEntry {
+        TArray<FKeyRippleKeyboardKey> Keys;
+        TArray<int32> BatchIndices;
+        TArray<int32> InstanceIndices;
+        TArray<float> KeyValues;
+    };
+
+    /** 清空所有实例后按注册顺序重新添加 */
+    void RebuildInstances();
+
+    /** 查找或创建指定网格的实例化组件 */
+    int32 FindOrAddBatch(UStaticMesh* Mesh);
+
+    TMap<TObjectKey<UObject>, FKeyboardEntry> Keyboards;
+
+    /** 承载实例化组件的临时Actor（不保存到关卡） */
+    UPROPERTY(Transient)
+    AActor* InstancingActor = nullptr;
+
+    UPROPERTY(Transient)
+    TArray<UInstancedStaticMeshComponent*> BatchComponents;
+};
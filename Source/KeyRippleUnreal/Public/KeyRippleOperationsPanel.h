@@ -36,6 +36,11 @@ class KEYRIPPLEUNREAL_API SKeyRippleOperationsPanel
     FReply OnGeneratePerformerAnimation();
     FReply OnGeneratePianoKeyAnimation();
     FReply OnGenerateAllAnimation();
+    FReply OnBakeToAnimSequence();
+    FReply OnStartLivePreview();
+    FReply OnStopLivePreview();
+    FReply OnStartStreamingImport();
+    FReply OnStopStreamingImport();
     FReply OnInitPiano();
 
     // Create enum property row (copied from properties panel)
@@ -1,9 +1,13 @@
 ﻿#pragma once
 
 #include "CoreMinimal.h"
+#include "InstrumentAnimationUtility.h"
 #include "KeyRippleUnreal.h"
 #include "KeyRipplePianoProcessor.generated.h"
 
+struct FInstrumentSyncFrameContext;
+struct FKeyRippleKeyboardKey;
+
 UCLASS() class KEYRIPPLEUNREAL_API UKeyRipplePianoProcessor : public UObject {
     GENERATED_BODY()
 
@@ -16,10 +20,15 @@ UCLASS() class KEYRIPPLEUNREAL_API UKeyRipplePianoProcessor : public UObject {
     UFUNCTION(BlueprintCallable, Category = "KeyRipple|Piano")
     static void InitPiano(AKeyRippleUnreal* KeyRippleActor);
 
-    /** 生成乐器动画 */
-    UFUNCTION(BlueprintCallable, Category = "KeyRipple|Piano")
+    /**
+     * 生成乐器动画
+     * @param FrameWindow 局部重新生成窗口，未设置时整体重新生成
+     */
+    UFUNCTION(BlueprintCallable, Category = "KeyRipple|Piano",
+              meta = (AutoCreateRefTerm = "FrameWindow"))
     static void GenerateInstrumentAnimation(
-        AKeyRippleUnreal* KeyRippleActor, const FString& PianoKeyAnimationPath);
+        AKeyRippleUnreal* KeyRippleActor, const FString& PianoKeyAnimationPath,
+        const FAnimationFrameWindow& FrameWindow = FAnimationFrameWindow());
 
     /** 获取钢琴变形目标名称 */
     UFUNCTION(BlueprintCallable, Category = "KeyRipple|Piano")
@@ -38,9 +47,88 @@ UCLASS() class KEYRIPPLEUNREAL_API UKeyRipplePianoProcessor : public UObject {
         const TMap<FString,
                    TPair<TArray<FFrameNumber>, TArray<FMovieSceneFloatValue>>>&
             MorphTargetKeyframeData,
-        FFrameNumber MinFrame, FFrameNumber MaxFrame);
+        FFrameNumber MinFrame, FFrameNumber MaxFrame,
+        const FAnimationFrameWindow& FrameWindow = FAnimationFrameWindow());
+
+    // ========== 实例化键盘（EPianoKeyboardRenderMode::Instanced） ==========
+
+    /**
+     * 按键号计算每个琴键实例的网格和世界变换
+     * 钢琴网格有名为 key_<键号> 的插槽时直接使用插槽的世界变换；
+     * 没有插槽的琴键按直线排列：白键从 InstancedKeyboardOffset 开始按
+     * WhiteKeySpacing 排列，黑键位于两侧白键中点并加上 BlackKeyOffset
+     *
+     * @param KeyNumbers 升序排列的键号（与琴键 Morph Target 名称中的数字一致）
+     */
+    static void BuildInstancedKeyboardLayout(
+        const AKeyRippleUnreal* KeyRippleActor,
+        TConstArrayView<int32> KeyNumbers,
+        TArray<FKeyRippleKeyboardKey>& OutKeys);
+
+    /**
+     * 游戏线程：从钢琴的 Control Rig 读取每个琴键动画通道的当前值
+     * Instanced 和 KeyStateTexture 模式共用
+     */
+    static void GatherKeyboardSync(AKeyRippleUnreal* KeyRippleActor,
+                                   const FInstrumentSyncFrameContext& Context,
+                                   FKeyRippleKeyboardSyncData& SyncData);
+
+    /** 工作线程：把通道值限制为琴键状态，不访问UObject */
+    static void ComputeKeyboardSync(FKeyRippleKeyboardSyncData& SyncData);
+
+    /**
+     * 游戏线程：按渲染方式写入实例化键盘或键状态纹理
+     * Instanced 模式下布局变化时重新注册琴键，随后写入琴键状态；
+     * 不再使用的一方会被释放
+     */
+    static void ApplyKeyboardSync(AKeyRippleUnreal* KeyRippleActor,
+                                  FKeyRippleKeyboardSyncData& SyncData);
 
+    /** 从实例化键盘子系统注销该钢琴的琴键，并重新显示钢琴模型的琴键 */
+    static void ReleaseInstancedKeyboard(AKeyRippleUnreal* KeyRippleActor,
+                                         FKeyRippleKeyboardSyncData& SyncData);
 
+    /**
+     * 隐藏或重新显示钢琴模型中琴键材质槽的网格段（所有LOD）
+     * Instanced 模式下琴键由实例渲染，钢琴模型只保留琴身，避免琴键绘制两次
+     */
+    static void SetPianoKeySectionsHidden(AKeyRippleUnreal* KeyRippleActor,
+                                          FKeyRippleKeyboardSyncData& SyncData,
+                                          bool bHidden);
+
+    /**
+     * 禁用或恢复钢琴模型琴键 Morph Target 曲线的求值
+     * Instanced 模式下琴键网格段已隐藏，不再计算和应用琴键 Morph Target；
+     * 琴键动画通道不受影响，实例化键盘仍从通道读取琴键状态
+     */
+    static void SetPianoKeyMorphCurvesDisabled(
+        AKeyRippleUnreal* KeyRippleActor, FKeyRippleKeyboardSyncData& SyncData,
+        bool bDisabled);
+
+    // ========== 键状态纹理（EPianoKeyboardRenderMode::KeyStateTexture） ==========
+
+    /** 键状态纹理的宽度（键号 0-127） */
+    static constexpr int32 KeyStateTextureWidth = 128;
+
+    /**
+     * 把钢琴所有琴键材质槽设置为 KeyStateMaterial
+     * 每个材质槽第一次被替换前的材质记录在 KeyStateOriginalMaterials 中
+     * （已记录的槽不覆盖），释放时据此还原
+     * @return 设置的材质槽数量
+     */
+    static int32 AssignKeyStateMaterial(AKeyRippleUnreal* KeyRippleActor,
+                                        UMaterialInterface* Material);
+
+    /** 游戏线程：琴键状态变化时上传键状态纹理 */
+    static void ApplyKeyStateTexture(AKeyRippleUnreal* KeyRippleActor,
+                                     FKeyRippleKeyboardSyncData& SyncData);
+
+    /**
+     * 释放键状态纹理，琴键材质槽还原为接管前的原始材质
+     * 只由 InitPiano 设置过材质、实时同步尚未运行时也会还原
+     */
+    static void ReleaseKeyStateTexture(AKeyRippleUnreal* KeyRippleActor,
+                                       FKeyRippleKeyboardSyncData& SyncData);
 
 #if WITH_EDITOR
    private:
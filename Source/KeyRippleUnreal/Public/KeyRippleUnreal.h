@@ -8,6 +8,9 @@
 #include "InstrumentBase.h" 
 #include "KeyRippleUnreal.generated.h"
 
+class ISequencer;
+enum class EMovieSceneDataChangeType;
+
 UENUM(BlueprintType)
 enum class EHandType : uint8 { LEFT = 0, RIGHT = 1 };
 
@@ -17,6 +20,23 @@ enum class EKeyType : uint8 { WHITE = 0, BLACK = 1 };
 UENUM(BlueprintType)
 enum class EPositionType : uint8 { HIGH = 0, LOW = 1, MIDDLE = 2 };
 
+/** 琴键的渲染方式 */
+UENUM(BlueprintType)
+enum class EPianoKeyboardRenderMode : uint8 {
+    /** 钢琴骨骼网格的 Morph Target，每个琴键一个材质实例和材质参数轨道 */
+    MorphTargets = 0 UMETA(DisplayName = "Morph Targets"),
+    /**
+     * 琴键为共享的 Instanced Static Mesh 实例，按下深度和 Pressed 写入
+     * 每实例自定义数据，不创建逐键材质实例和材质参数轨道
+     */
+    Instanced = 1 UMETA(DisplayName = "Instanced"),
+    /**
+     * 琴键仍为 Morph Target，所有琴键材质槽共用一个材质，
+     * 琴键状态写入每台钢琴一张的键状态纹理，不创建逐键材质参数轨道
+     */
+    KeyStateTexture = 2 UMETA(DisplayName = "Morph Targets + Key State Texture")
+};
+
 USTRUCT(BlueprintType)
 struct FSyncReport {
     GENERATED_BODY()
@@ -98,6 +118,42 @@ struct FRecorderTransform {
     }
 };
 
+/**
+ * 实例化键盘和键状态纹理的同步数据
+ * Gather 在游戏线程读取琴键曲线，Compute 只做数学计算，
+ * Apply 在游戏线程写入实例化键盘子系统或键状态纹理
+ *
+ * @note Control Rig 之外的缓存跨帧保留，层级拓扑变化时重建
+ */
+struct FKeyRippleKeyboardSyncData {
+    // ========== 缓存：琴键动画通道 ==========
+    TWeakObjectPtr<UControlRig> ControlRig;
+    uint32 TopologyVersion = 0;
+    /** 按键号升序排列的动画通道下标和键号 */
+    TArray<int32> ChannelIndices;
+    TArray<int32> KeyNumbers;
+
+    // ========== 缓存：已注册的琴键布局 ==========
+    bool bRegistered = false;
+    bool bLayoutDirty = true;
+    FTransform RegisteredPianoTransform;
+    /** 已隐藏的钢琴琴键网格段（X=材质槽，Y=网格段，Z=LOD） */
+    TArray<FIntVector> HiddenKeySections;
+    /** 钢琴模型的琴键 Morph Target 曲线是否已禁止求值 */
+    bool bKeyMorphCurvesDisabled = false;
+
+    // ========== 缓存：键状态纹理 ==========
+    bool bKeyStateTextureActive = false;
+    /** 上一次上传的纹素（按键号索引），没有变化时不上传 */
+    TArray<float> KeyStateTexels;
+    /** 本帧纹素的复用缓冲，避免每帧分配 */
+    TArray<float> KeyStateTexelScratch;
+
+    // ========== 本帧 ==========
+    bool bHasInput = false;
+    TArray<float> KeyValues;
+};
+
 // ========== 向后兼容性别名 ==========
 // 为了保持与现有代码的兼容性，定义FControlKeyframe为FAnimationKeyframe的别名
 // 这样现有的KeyRipple代码可以继续使用FControlKeyframe，但实际使用的是通用的FAnimationKeyframe
@@ -116,6 +172,43 @@ class KEYRIPPLEUNREAL_API AKeyRippleUnreal : public AInstrumentBase {
    public:
     virtual void Tick(float DeltaTime) override;
 
+    /** 演奏者之外追加钢琴 */
+    virtual void GetPlaybackActors(
+        TArray<FInstrumentPlaybackActor>& OutActors) const override;
+
+    virtual void PostRegisterAllComponents() override;
+    virtual void PostUnregisterAllComponents() override;
+    virtual void BeginDestroy() override;
+
+#if WITH_EDITOR
+    /** 渲染方式或键盘布局相关属性改变时重新同步 */
+    virtual void PostEditChangeProperty(
+        FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+    // ========== 实例化键盘（由 UInstrumentSyncSubsystem 调度） ==========
+
+    /**
+     * Instanced 和 KeyStateTexture 模式下，编辑器中只在事件标记了变化后同步，
+     * 游戏世界没有编辑器事件，每帧同步；
+     * 切换回 Morph Targets 后再同步一次以注销实例、还原材质
+     */
+    virtual bool NeedsRealtimeSync() const override;
+
+    virtual void GatherRealtimeSync(
+        const FInstrumentSyncFrameContext& Context) override;
+
+    virtual void ComputeRealtimeSync() override;
+
+    virtual void ApplyRealtimeSync() override;
+
+    /**
+     * 标记琴键状态需要同步，子系统下一帧执行一次同步
+     * 外部直接修改了琴键通道（而没有经过Sequencer或Control Rig通知）时调用
+     */
+    UFUNCTION(BlueprintCallable, Category = "Piano Rendering")
+    void MarkKeyboardSyncDirty() { bKeyboardSyncDirty = true; }
+
     /** 钢琴模型 */
     UPROPERTY(EditAnywhere, BlueprintReadWrite,
               Category = "Basic Properties")
@@ -131,6 +224,70 @@ class KEYRIPPLEUNREAL_API AKeyRippleUnreal : public AInstrumentBase {
               Category = "Basic Properties")
     class UMaterialInstance* KeyMatBlack;
 
+    /**
+     * 琴键渲染方式
+     * Instanced 模式下钢琴模型只保留琴身，琴键由实例化键盘子系统渲染
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Piano Rendering")
+    EPianoKeyboardRenderMode KeyboardRenderMode =
+        EPianoKeyboardRenderMode::MorphTargets;
+
+    /**
+     * 白键网格（材质用 PerInstanceCustomData 0/1 读取按下深度和 Pressed）
+     * Pressed 与逐键材质的 Pressed 轨道一样取自琴键曲线，两者数值相同
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Piano Rendering",
+              meta = (EditCondition = "KeyboardRenderMode == EPianoKeyboardRenderMode::Instanced"))
+    class UStaticMesh* WhiteKeyMesh = nullptr;
+
+    /** 黑键网格 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Piano Rendering",
+              meta = (EditCondition = "KeyboardRenderMode == EPianoKeyboardRenderMode::Instanced"))
+    class UStaticMesh* BlackKeyMesh = nullptr;
+
+    /**
+     * 最低音琴键相对钢琴Actor的变换，X轴为音高增加的方向
+     * 只用于钢琴网格没有 key_<键号> 插槽的琴键；直线排列不考虑真实钢琴
+     * 黑白键宽度的差异，需要精确对齐时在网格上添加琴键插槽
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Piano Rendering",
+              meta = (EditCondition = "KeyboardRenderMode == EPianoKeyboardRenderMode::Instanced"))
+    FTransform InstancedKeyboardOffset;
+
+    /** 相邻白键的间距（厘米） */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Piano Rendering",
+              meta = (EditCondition = "KeyboardRenderMode == EPianoKeyboardRenderMode::Instanced"))
+    float WhiteKeySpacing = 2.35f;
+
+    /** 黑键相对两侧白键中点的偏移 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Piano Rendering",
+              meta = (EditCondition = "KeyboardRenderMode == EPianoKeyboardRenderMode::Instanced"))
+    FVector BlackKeyOffset = FVector::ZeroVector;
+
+    /**
+     * 所有琴键材质槽共用的材质
+     * 用纹理参数 KeyStateTexture（R32F，宽度为键号数量，高度1）读取琴键状态，
+     * 在 U = (键号 + 0.5) / 宽度 处采样；键号由材质从网格数据取得
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Piano Rendering",
+              meta = (EditCondition = "KeyboardRenderMode == EPianoKeyboardRenderMode::KeyStateTexture"))
+    class UMaterialInterface* KeyStateMaterial = nullptr;
+
+    /** 运行时创建的键状态纹理 */
+    UPROPERTY(Transient)
+    class UTexture2D* GeneratedKeyStateTexture = nullptr;
+
+    /** 运行时创建的共用材质实例（引用键状态纹理） */
+    UPROPERTY(Transient)
+    class UMaterialInstanceDynamic* GeneratedKeyStateMaterial = nullptr;
+
+    /**
+     * 键状态纹理接管前各琴键材质槽的原始材质（材质槽下标 -> 材质）
+     * 随关卡保存，InitPiano 设置的材质在重新打开关卡后仍能还原
+     */
+    UPROPERTY()
+    TMap<int32, class UMaterialInterface*> KeyStateOriginalMaterials;
+
     /** 单手手指数量 */
     UPROPERTY(EditAnywhere, BlueprintReadWrite,
               Category = "KeyRipple Configuration")
@@ -288,4 +445,49 @@ class KEYRIPPLEUNREAL_API AKeyRippleUnreal : public AInstrumentBase {
      */
     UFUNCTION(BlueprintCallable, Category = "KeyRipple")
     bool ImportRecorderInfo();
+
+   private:
+    /** 实例化键盘的同步数据 */
+    FKeyRippleKeyboardSyncData KeyboardSyncData;
+
+    /** 有待执行的琴键同步（创建后先同步一次） */
+    bool bKeyboardSyncDirty = true;
+
+#if WITH_EDITOR
+    // ========== 琴键同步事件订阅 ==========
+
+    /** 订阅Sequencer、钢琴 Control Rig 和Actor移动事件 */
+    void BindKeyboardSyncEvents();
+
+    /** 取消全部订阅 */
+    void UnbindKeyboardSyncEvents();
+
+    /** 订阅 Sequencer 的时间变化和数据变化 */
+    void BindSequencer(TSharedRef<ISequencer> Sequencer);
+
+    /** 钢琴的 Control Rig 实例变化时重新订阅 */
+    void RefreshBoundControlRig();
+
+    void HandleSequencerCreated(TSharedRef<ISequencer> Sequencer);
+    void HandleSequencerTimeChanged();
+    void HandleMovieSceneDataChanged(EMovieSceneDataChangeType DataChangeType);
+    void HandleControlModified(UControlRig* ControlRig,
+                               FRigControlElement* ControlElement,
+                               const FRigControlModifiedContext& Context);
+    void HandleHierarchyModified(ERigHierarchyNotification Notification,
+                                 URigHierarchy* Hierarchy,
+                                 const FRigNotificationSubject& Subject);
+    void HandleActorMoved(AActor* Actor);
+
+    /** 已订阅的 Sequencer */
+    TArray<TWeakPtr<ISequencer>> BoundSequencers;
+
+    /** 已订阅的钢琴 Control Rig 及其层级 */
+    TWeakObjectPtr<UControlRig> BoundControlRig;
+    TWeakObjectPtr<URigHierarchy> BoundHierarchy;
+
+    FDelegateHandle OnSequencerCreatedHandle;
+
+    bool bKeyboardSyncEventsBound = false;
+#endif
 };
\ No newline at end of file
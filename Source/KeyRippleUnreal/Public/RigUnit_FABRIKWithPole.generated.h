@@ -1,21 +0,0 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
-
-PRAGMA_DISABLE_DEPRECATION_WARNINGS
-
-#ifdef KEYRIPPLEUNREAL_RigUnit_FABRIKWithPole_generated_h
-#error "RigUnit_FABRIKWithPole.generated.h already included, missing '#pragma once' in RigUnit_FABRIKWithPole.h"
-#endif
-#define KEYRIPPLEUNREAL_RigUnit_FABRIKWithPole_generated_h
-
-#include "CoreMinimal.h"
-#include "UObject/ObjectMacros.h"
-#include "Engine/Engine.h"
-#include "UObject/ScriptMacros.h"
-#include "RigUnit_FABRIKWithPole.h"
-
-#line 1 "Public/RigUnit_FABRIKWithPole.h"
-
-#undef CURRENT_FILE_ID
-#define CURRENT_FILE_ID RigUnit_FABRIKWithPole_h
-
-PRAGMA_ENABLE_DEPRECATION_WARNINGS
\ No newline at end of file
@@ -0,0 +1,21 @@
+﻿using UnrealBuildTool;
+
+/**
+ * 运行时播放模块：不依赖 Sequencer 和任何编辑器模块，
+ * 打包后的游戏可以直接播放烘焙好的演奏
+ */
+public class MusicDollRuntime : ModuleRules
+{
+    public MusicDollRuntime(ReadOnlyTargetRules Target) : base(Target)
+    {
+        PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        PublicDependencyModuleNames.AddRange(new string[] {
+            "Core",
+            "CoreUObject",
+            "Engine",
+            "RigVM",                    // Control Rig 值类型
+            "ControlRig"                // UControlRigComponent（运行时）
+        });
+    }
+}
@@ -0,0 +1,146 @@
+﻿#include "MusicDollPerformanceAsset.h"
+
+#include "Algo/AllOf.h"
+#include "Algo/BinarySearch.h"
+
+namespace MusicDollPerformanceAssetHelper {
+/** 游标之后线性查找的最大区间数，超过后改用二分查找 */
+constexpr int32 MaxLinearCursorSteps = 4;
+
+/** 压缩时一段直线最多覆盖的采样数，限制误差检查的开销 */
+constexpr int32 MaxCompressSpan = 256;
+
+/** 最后一个不大于 Time 的关键帧下标（Time早于第一个关键帧时返回0） */
+int32 FindSegment(const TArray<float>& Times, float Time) {
+    const int32 UpperIndex = Algo::UpperBound(Times, Time);
+    return FMath::Max(UpperIndex - 1, 0);
+}
+}  // namespace MusicDollPerformanceAssetHelper
+
+// ========== FMusicDollCurveChannel ==========
+
+float FMusicDollCurveChannel::Evaluate(float Time, int32& InOutCursor) const {
+    using namespace MusicDollPerformanceAssetHelper;
+
+    const int32 NumKeys = Times.Num();
+    if (NumKeys == 0) {
+        return DefaultValue;
+    }
+    if (NumKeys == 1 || Time <= Times[0]) {
+        InOutCursor = 0;
+        return Values[0];
+    }
+    if (Time >= Times[NumKeys - 1]) {
+        InOutCursor = NumKeys - 1;
+        return Values[NumKeys - 1];
+    }
+
+    // ========== 从上一次的区间开始查找 =========
+    int32 Cursor = FMath::Clamp(InOutCursor, 0, NumKeys - 2);
+    if (Times[Cursor] <= Time) {
+        int32 Steps = 0;
+        while (Times[Cursor + 1] <= Time && Steps < MaxLinearCursorSteps) {
+            ++Cursor;
+            ++Steps;
+        }
+        if (Times[Cursor + 1] <= Time) {
+            Cursor = FindSegment(Times, Time);
+        }
+    } else {
+        // 倒放或跳回
+        Cursor = FindSegment(Times, Time);
+    }
+    InOutCursor = Cursor;
+
+    const float SegmentStart = Times[Cursor];
+    const float SegmentEnd = Times[Cursor + 1];
+    const float Alpha = (Time - SegmentStart) / (SegmentEnd - SegmentStart);
+    return FMath::Lerp(Values[Cursor], Values[Cursor + 1], Alpha);
+}
+
+float FMusicDollCurveChannel::Evaluate(float Time) const {
+    int32 Cursor = MusicDollPerformanceAssetHelper::FindSegment(Times, Time);
+    return Evaluate(Time, Cursor);
+}
+
+void FMusicDollCurveChannel::AddSample(float Time, float Value) {
+    check(Times.Num() == 0 || Times.Last() < Time);
+    Times.Add(Time);
+    Values.Add(Value);
+}
+
+void FMusicDollCurveChannel::Compress(float Tolerance) {
+    using namespace MusicDollPerformanceAssetHelper;
+
+    const int32 NumKeys = Times.Num();
+    if (NumKeys == 0) {
+        return;
+    }
+
+    // 常量通道只保留一个关键帧
+    const bool bConstant = Algo::AllOf(Values, [this, Tolerance](float Value) {
+        return FMath::Abs(Value - Values[0]) <= Tolerance;
+    });
+    if (bConstant) {
+        Times.SetNum(1);
+        Values.SetNum(1);
+        DefaultValue = Values[0];
+        return;
+    }
+
+    TArray<float> KeptTimes;
+    TArray<float> KeptValues;
+    KeptTimes.Add(Times[0]);
+    KeptValues.Add(Values[0]);
+
+    // 上一个保留的关键帧与下一个采样连成直线，中间所有采样的误差都不超过
+    // Tolerance 时去掉当前采样
+    int32 LastKept = 0;
+    for (int32 i = 1; i < NumKeys - 1; ++i) {
+        bool bCanDrop = i - LastKept < MaxCompressSpan;
+        for (int32 k = LastKept + 1; k <= i && bCanDrop; ++k) {
+            const float Alpha = (Times[k] - Times[LastKept]) /
+                                (Times[i + 1] - Times[LastKept]);
+            const float Interpolated =
+                FMath::Lerp(Values[LastKept], Values[i + 1], Alpha);
+            bCanDrop = FMath::Abs(Interpolated - Values[k]) <= Tolerance;
+        }
+
+        if (!bCanDrop) {
+            KeptTimes.Add(Times[i]);
+            KeptValues.Add(Values[i]);
+            LastKept = i;
+        }
+    }
+
+    KeptTimes.Add(Times[NumKeys - 1]);
+    KeptValues.Add(Values[NumKeys - 1]);
+
+    Times = MoveTemp(KeptTimes);
+    Values = MoveTemp(KeptValues);
+    DefaultValue = Values[0];
+}
+
+// ========== UMusicDollPerformanceAsset ==========
+
+const FMusicDollPerformanceTrack* UMusicDollPerformanceAsset::FindTrack(
+    FName Role) const {
+    return Tracks.FindByPredicate(
+        [Role](const FMusicDollPerformanceTrack& Track) {
+            return Track.Role == Role;
+        });
+}
+
+FMusicDollPerformanceTrack& UMusicDollPerformanceAsset::FindOrAddTrack(
+    FName Role) {
+    if (FMusicDollPerformanceTrack* Track = Tracks.FindByPredicate(
+            [Role](const FMusicDollPerformanceTrack& Track) {
+                return Track.Role == Role;
+            })) {
+        return *Track;
+    }
+
+    FMusicDollPerformanceTrack& NewTrack = Tracks.AddDefaulted_GetRef();
+    NewTrack.Role = Role;
+    return NewTrack;
+}
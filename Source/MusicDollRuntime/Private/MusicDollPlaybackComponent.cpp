@@ -0,0 +1,189 @@
+﻿#include "MusicDollPlaybackComponent.h"
+
+#include "Components/SkeletalMeshComponent.h"
+#include "ControlRig.h"
+#include "ControlRigComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "GameFramework/Actor.h"
+#include "MusicDollRuntime.h"
+#include "Rigs/RigHierarchy.h"
+
+UMusicDollPlaybackComponent::UMusicDollPlaybackComponent() {
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.bStartWithTickEnabled = false;
+    // 先写 Control 值，再由 Control Rig 组件在同一帧求值
+    PrimaryComponentTick.TickGroup = TG_PrePhysics;
+}
+
+void UMusicDollPlaybackComponent::BeginPlay() {
+    Super::BeginPlay();
+
+    RebuildBindings();
+    if (bAutoPlay) {
+        Play();
+    }
+}
+
+void UMusicDollPlaybackComponent::Play() {
+    bPlaying = true;
+    SetComponentTickEnabled(true);
+}
+
+void UMusicDollPlaybackComponent::Stop() {
+    bPlaying = false;
+    SetComponentTickEnabled(false);
+}
+
+void UMusicDollPlaybackComponent::SetPlaybackPosition(float NewTime) {
+    PlaybackTime = NewTime;
+    EvaluateAndApply();
+}
+
+void UMusicDollPlaybackComponent::RebuildBindings() {
+    TransformBindings.Reset();
+    FloatBindings.Reset();
+    PlaybackTime = 0.0f;
+
+    AActor* Owner = GetOwner();
+    if (!Owner || !PerformanceAsset) {
+        return;
+    }
+
+    const FMusicDollPerformanceTrack* Track = PerformanceAsset->FindTrack(Role);
+    if (!Track) {
+        UE_LOG(LogMusicDollRuntime, Warning,
+               TEXT("UMusicDollPlaybackComponent: Role '%s' not found in '%s'"),
+               *Role.ToString(), *PerformanceAsset->GetName());
+        return;
+    }
+
+    SkeletalMeshComponent = Owner->FindComponentByClass<USkeletalMeshComponent>();
+
+    // ========== Control Rig 组件：优先使用Actor上已有的 =========
+    ControlRigComponent = Owner->FindComponentByClass<UControlRigComponent>();
+    if (!ControlRigComponent && Track->ControlRigClass && SkeletalMeshComponent) {
+        ControlRigComponent = NewObject<UControlRigComponent>(Owner);
+        ControlRigComponent->ControlRigClass = Track->ControlRigClass;
+        ControlRigComponent->RegisterComponent();
+        ControlRigComponent->AddMappedCompleteSkeletalMesh(SkeletalMeshComponent);
+    }
+    if (ControlRigComponent) {
+        ControlRigComponent->PrimaryComponentTick.AddPrerequisite(
+            this, PrimaryComponentTick);
+    }
+
+    UControlRig* ControlRig =
+        ControlRigComponent ? ControlRigComponent->GetControlRig() : nullptr;
+    URigHierarchy* Hierarchy = ControlRig ? ControlRig->GetHierarchy() : nullptr;
+
+    // ========== 变换曲线 =========
+    if (Hierarchy) {
+        TransformBindings.Reserve(Track->TransformCurves.Num());
+        for (const FMusicDollTransformCurve& Curve : Track->TransformCurves) {
+            const FRigElementKey Key(Curve.ControlName, ERigElementType::Control);
+            const int32 ControlIndex = Hierarchy->GetIndex(Key);
+            if (ControlIndex == INDEX_NONE) {
+                continue;
+            }
+
+            FTransformBinding& Binding = TransformBindings.AddDefaulted_GetRef();
+            Binding.Curve = &Curve;
+            Binding.ControlIndex = ControlIndex;
+            Binding.LocalOffset = Hierarchy->GetLocalControlOffsetTransform(Key);
+        }
+    }
+
+    // ========== 浮点曲线 =========
+    const USkeletalMesh* SkeletalMesh =
+        SkeletalMeshComponent ? SkeletalMeshComponent->GetSkeletalMeshAsset()
+                              : nullptr;
+    FloatBindings.Reserve(Track->FloatCurves.Num());
+    for (const FMusicDollFloatCurve& Curve : Track->FloatCurves) {
+        FFloatBinding Binding;
+        Binding.Curve = &Curve;
+        if (Hierarchy) {
+            Binding.ControlIndex = Hierarchy->GetIndex(
+                FRigElementKey(Curve.ControlName, ERigElementType::Control));
+        }
+        Binding.bHasMorphTarget =
+            bDriveMorphTargets && SkeletalMesh &&
+            SkeletalMesh->FindMorphTarget(Curve.CurveName) != nullptr;
+
+        if (Binding.ControlIndex != INDEX_NONE || Binding.bHasMorphTarget) {
+            FloatBindings.Add(Binding);
+        }
+    }
+
+    UE_LOG(LogMusicDollRuntime, Log,
+           TEXT("UMusicDollPlaybackComponent: '%s' bound %d transform and %d "
+                "float curves for role '%s'"),
+           *Owner->GetName(), TransformBindings.Num(), FloatBindings.Num(),
+           *Role.ToString());
+}
+
+void UMusicDollPlaybackComponent::TickComponent(
+    float DeltaTime, ELevelTick TickType,
+    FActorComponentTickFunction* ThisTickFunction) {
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    if (!bPlaying || !PerformanceAsset) {
+        return;
+    }
+
+    PlaybackTime += DeltaTime * PlayRate;
+
+    const float Duration = PerformanceAsset->Duration;
+    if (Duration > 0.0f) {
+        if (bLooping) {
+            PlaybackTime = FMath::Fmod(PlaybackTime, Duration);
+            if (PlaybackTime < 0.0f) {
+                PlaybackTime += Duration;
+            }
+        } else if (PlaybackTime >= Duration || PlaybackTime <= 0.0f) {
+            PlaybackTime = FMath::Clamp(PlaybackTime, 0.0f, Duration);
+            EvaluateAndApply();
+            Stop();
+            return;
+        }
+    }
+
+    EvaluateAndApply();
+}
+
+void UMusicDollPlaybackComponent::EvaluateAndApply() {
+    UControlRig* ControlRig =
+        ControlRigComponent ? ControlRigComponent->GetControlRig() : nullptr;
+    URigHierarchy* Hierarchy = ControlRig ? ControlRig->GetHierarchy() : nullptr;
+
+    if (Hierarchy) {
+        for (FTransformBinding& Binding : TransformBindings) {
+            float Values[FMusicDollTransformCurve::NumChannels];
+            for (int32 i = 0; i < FMusicDollTransformCurve::NumChannels; ++i) {
+                Values[i] = Binding.Curve->Channels[i].Evaluate(
+                    PlaybackTime, Binding.Cursors[i]);
+            }
+
+            // 旋转通道：X->Roll, Y->Pitch, Z->Yaw
+            const FTransform Value(
+                FRotator(Values[4], Values[5], Values[3]).Quaternion(),
+                FVector(Values[0], Values[1], Values[2]));
+            Hierarchy->SetLocalTransform(Binding.ControlIndex,
+                                         Value * Binding.LocalOffset);
+        }
+    }
+
+    for (FFloatBinding& Binding : FloatBindings) {
+        const float Value =
+            Binding.Curve->Channel.Evaluate(PlaybackTime, Binding.Cursor);
+
+        if (Hierarchy && Binding.ControlIndex != INDEX_NONE) {
+            Hierarchy->SetControlValue(Binding.ControlIndex,
+                                       FRigControlValue::Make<float>(Value),
+                                       ERigControlValueType::Current);
+        }
+        if (Binding.bHasMorphTarget) {
+            SkeletalMeshComponent->SetMorphTarget(Binding.Curve->CurveName,
+                                                  Value);
+        }
+    }
+}
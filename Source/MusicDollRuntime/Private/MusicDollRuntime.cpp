@@ -0,0 +1,9 @@
+﻿#include "MusicDollRuntime.h"
+
+DEFINE_LOG_CATEGORY(LogMusicDollRuntime);
+
+void FMusicDollRuntimeModule::StartupModule() {}
+
+void FMusicDollRuntimeModule::ShutdownModule() {}
+
+IMPLEMENT_MODULE(FMusicDollRuntimeModule, MusicDollRuntime);
@@ -0,0 +1,81 @@
+﻿#include "Misc/AutomationTest.h"
+#include "MusicDollPerformanceAsset.h"
+
+#if WITH_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FMusicDollPerformanceAssetSpec, "MusicDoll.Runtime.PerformanceAsset", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+	FMusicDollCurveChannel Channel;
+
+END_DEFINE_SPEC(FMusicDollPerformanceAssetSpec)
+
+void FMusicDollPerformanceAssetSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		// 0 -> 10 -> 0 的折线，每0.1秒一个采样
+		Channel = FMusicDollCurveChannel();
+		for (int32 i = 0; i <= 20; ++i)
+		{
+			const float Time = i * 0.1f;
+			Channel.AddSample(Time, i <= 10 ? i : 20 - i);
+		}
+	});
+
+	Describe(TEXT("Evaluate"), [this]()
+		{
+			It(TEXT("Should interpolate linearly between keys"), [this]()
+				{
+					TestEqual(TEXT("Midpoint of the first segment"), Channel.Evaluate(0.05f), 0.5f, KINDA_SMALL_NUMBER);
+					TestEqual(TEXT("Peak"), Channel.Evaluate(1.0f), 10.0f, KINDA_SMALL_NUMBER);
+				});
+
+			It(TEXT("Should clamp outside the key range"), [this]()
+				{
+					TestEqual(TEXT("Before the first key"), Channel.Evaluate(-1.0f), 0.0f);
+					TestEqual(TEXT("After the last key"), Channel.Evaluate(5.0f), 0.0f, KINDA_SMALL_NUMBER);
+				});
+
+			It(TEXT("Should give the same result with a cursor when playing forward, jumping and rewinding"), [this]()
+				{
+					int32 Cursor = 0;
+					const float Times[] = {0.0f, 0.033f, 0.066f, 0.1f, 1.45f, 1.5f, 0.2f, 0.25f, 2.0f};
+					for (const float Time : Times)
+					{
+						TestEqual(FString::Printf(TEXT("Time %.3f"), Time), Channel.Evaluate(Time, Cursor), Channel.Evaluate(Time), KINDA_SMALL_NUMBER);
+					}
+				});
+
+			It(TEXT("Should return the default value without keys"), [this]()
+				{
+					FMusicDollCurveChannel Empty;
+					Empty.DefaultValue = 3.0f;
+					TestEqual(TEXT("Default value"), Empty.Evaluate(1.0f), 3.0f);
+				});
+		});
+
+	Describe(TEXT("Compress"), [this]()
+		{
+			It(TEXT("Should keep only the corners of a polyline"), [this]()
+				{
+					Channel.Compress(KINDA_SMALL_NUMBER * 10.0f);
+					TestEqual(TEXT("Start, peak and end"), Channel.Times.Num(), 3);
+					TestEqual(TEXT("Peak value is preserved"), Channel.Evaluate(1.0f), 10.0f, KINDA_SMALL_NUMBER);
+					TestEqual(TEXT("Interpolated value is preserved"), Channel.Evaluate(1.55f), 4.5f, 1.e-3f);
+				});
+
+			It(TEXT("Should collapse a constant channel to one key"), [this]()
+				{
+					FMusicDollCurveChannel Constant;
+					for (int32 i = 0; i < 100; ++i)
+					{
+						Constant.AddSample(i * 0.1f, 2.0f);
+					}
+					Constant.Compress(KINDA_SMALL_NUMBER);
+					TestEqual(TEXT("One key"), Constant.Times.Num(), 1);
+					TestEqual(TEXT("Value"), Constant.Evaluate(4.2f), 2.0f);
+				});
+		});
+}
+
+#endif // WITH_AUTOMATION_TESTS
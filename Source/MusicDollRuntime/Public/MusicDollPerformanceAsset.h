@@ -0,0 +1,132 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Templates/SubclassOf.h"
+#include "MusicDollPerformanceAsset.generated.h"
+
+class UControlRig;
+
+/**
+ * 一条烘焙后的曲线通道
+ * 关键帧之间线性插值，时间单位为秒（相对演奏开始）
+ * 烘焙时按显示帧率采样并去掉可以由相邻关键帧插值得到的关键帧
+ */
+USTRUCT()
+struct MUSICDOLLRUNTIME_API FMusicDollCurveChannel {
+    GENERATED_BODY()
+
+    /** 关键帧时间（秒，递增） */
+    UPROPERTY()
+    TArray<float> Times;
+
+    UPROPERTY()
+    TArray<float> Values;
+
+    /** 没有关键帧时的值 */
+    UPROPERTY()
+    float DefaultValue = 0.0f;
+
+    /**
+     * 用游标求值：InOutCursor 保存上一次所在的关键帧区间，
+     * 顺序播放时每次只前进0或1个区间；跳转较远时改用二分查找
+     */
+    float Evaluate(float Time, int32& InOutCursor) const;
+
+    /** 不带游标的求值（二分查找） */
+    float Evaluate(float Time) const;
+
+    /** 添加一个采样（时间必须递增） */
+    void AddSample(float Time, float Value);
+
+    /** 去掉误差不超过 Tolerance 的中间关键帧 */
+    void Compress(float Tolerance);
+};
+
+/**
+ * 一个变换 Control 的曲线
+ * 6个通道与 Control Rig Section 相同：Location.X/Y/Z、Rotation.X/Y/Z（Roll/Pitch/Yaw，度）
+ * 值相对于 Control 的 Offset（与 Sequencer 中的 Control 值一致）
+ */
+USTRUCT()
+struct MUSICDOLLRUNTIME_API FMusicDollTransformCurve {
+    GENERATED_BODY()
+
+    static constexpr int32 NumChannels = 6;
+
+    UPROPERTY()
+    FName ControlName;
+
+    UPROPERTY()
+    FMusicDollCurveChannel Channels[NumChannels];
+};
+
+/**
+ * 一个浮点 Control（动画通道）的曲线
+ * 琴键、琴弦的 Morph Target 通道与 Morph Target 同名，播放时同时驱动 Morph Target
+ */
+USTRUCT()
+struct MUSICDOLLRUNTIME_API FMusicDollFloatCurve {
+    GENERATED_BODY()
+
+    /** Control Rig 层级中的元素名 */
+    UPROPERTY()
+    FName ControlName;
+
+    /** 通道显示名（Morph Target 名） */
+    UPROPERTY()
+    FName CurveName;
+
+    UPROPERTY()
+    FMusicDollCurveChannel Channel;
+};
+
+/**
+ * 一个角色（演奏者、钢琴、小提琴、琴弓……）的全部曲线
+ */
+USTRUCT()
+struct MUSICDOLLRUNTIME_API FMusicDollPerformanceTrack {
+    GENERATED_BODY()
+
+    /** 角色名，播放组件按角色名选择轨道 */
+    UPROPERTY(VisibleAnywhere, Category = "Performance")
+    FName Role;
+
+    /** 烘焙时绑定的 Control Rig 类，播放组件没有找到 Control Rig 组件时用它创建 */
+    UPROPERTY(VisibleAnywhere, Category = "Performance")
+    TSubclassOf<UControlRig> ControlRigClass;
+
+    UPROPERTY()
+    TArray<FMusicDollTransformCurve> TransformCurves;
+
+    UPROPERTY()
+    TArray<FMusicDollFloatCurve> FloatCurves;
+};
+
+/**
+ * 烘焙后的演奏资产
+ * 编辑器中由 UInstrumentPerformanceCookUtility 从 Level Sequence 的
+ * Control Rig Section 生成，运行时由 UMusicDollPlaybackComponent 播放
+ */
+UCLASS(BlueprintType)
+class MUSICDOLLRUNTIME_API UMusicDollPerformanceAsset : public UDataAsset {
+    GENERATED_BODY()
+
+   public:
+    /** 演奏时长（秒） */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Performance")
+    float Duration = 0.0f;
+
+    /** 烘焙时的采样帧率 */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Performance")
+    FFrameRate SampleRate;
+
+    UPROPERTY(VisibleAnywhere, Category = "Performance")
+    TArray<FMusicDollPerformanceTrack> Tracks;
+
+    /** 按角色名查找轨道 */
+    const FMusicDollPerformanceTrack* FindTrack(FName Role) const;
+
+    /** 按角色名查找或添加轨道（烘焙时使用） */
+    FMusicDollPerformanceTrack& FindOrAddTrack(FName Role);
+};
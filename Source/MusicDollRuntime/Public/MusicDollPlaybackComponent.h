@@ -0,0 +1,112 @@
+﻿#pragma once
+
+#include "Components/ActorComponent.h"
+#include "CoreMinimal.h"
+#include "MusicDollPerformanceAsset.h"
+#include "MusicDollPlaybackComponent.generated.h"
+
+class UControlRig;
+class UControlRigComponent;
+class USkeletalMeshComponent;
+
+/**
+ * 演奏播放组件
+ * 不经过 Sequencer，直接按时间求值 UMusicDollPerformanceAsset 中一个角色的曲线，
+ * 写入 Control Rig 的 Control 值和骨骼网格的 Morph Target
+ *
+ * 用法：添加到演奏者/乐器的骨骼网格Actor上，设置 PerformanceAsset 和 Role。
+ * Actor上有 UControlRigComponent 时使用它；没有时按烘焙时记录的
+ * Control Rig 类创建一个并映射到骨骼网格
+ *
+ * @note 每个通道保存一个游标，顺序播放时求值为O(1)
+ */
+UCLASS(ClassGroup = (MusicDoll), meta = (BlueprintSpawnableComponent))
+class MUSICDOLLRUNTIME_API UMusicDollPlaybackComponent : public UActorComponent {
+    GENERATED_BODY()
+
+   public:
+    UMusicDollPlaybackComponent();
+
+    /** 要播放的演奏资产 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Playback")
+    UMusicDollPerformanceAsset* PerformanceAsset = nullptr;
+
+    /** 资产中的角色名（Performer、Piano、StringInstrument、Bow……） */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Playback")
+    FName Role = TEXT("Performer");
+
+    /** BeginPlay时自动开始播放 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Playback")
+    bool bAutoPlay = true;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Playback")
+    bool bLooping = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Playback")
+    float PlayRate = 1.0f;
+
+    /** 浮点曲线同名的 Morph Target 也一起驱动 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Playback")
+    bool bDriveMorphTargets = true;
+
+    UFUNCTION(BlueprintCallable, Category = "Playback")
+    void Play();
+
+    UFUNCTION(BlueprintCallable, Category = "Playback")
+    void Stop();
+
+    /** 跳转到指定时间（秒）并立即求值 */
+    UFUNCTION(BlueprintCallable, Category = "Playback")
+    void SetPlaybackPosition(float NewTime);
+
+    UFUNCTION(BlueprintPure, Category = "Playback")
+    float GetPlaybackPosition() const { return PlaybackTime; }
+
+    UFUNCTION(BlueprintPure, Category = "Playback")
+    bool IsPlaying() const { return bPlaying; }
+
+    /** 资产或角色改变后重新建立曲线与 Control、Morph Target 的对应关系 */
+    UFUNCTION(BlueprintCallable, Category = "Playback")
+    void RebuildBindings();
+
+    virtual void TickComponent(
+        float DeltaTime, ELevelTick TickType,
+        FActorComponentTickFunction* ThisTickFunction) override;
+
+   protected:
+    virtual void BeginPlay() override;
+
+   private:
+    /** 按当前时间求值所有曲线并写入 */
+    void EvaluateAndApply();
+
+    /** 变换曲线 -> Control */
+    struct FTransformBinding {
+        const FMusicDollTransformCurve* Curve = nullptr;
+        int32 ControlIndex = INDEX_NONE;
+        /** Control 的局部 Offset，Control 值 × Offset = 局部变换 */
+        FTransform LocalOffset;
+        int32 Cursors[FMusicDollTransformCurve::NumChannels] = {};
+    };
+
+    /** 浮点曲线 -> Control 和/或 Morph Target */
+    struct FFloatBinding {
+        const FMusicDollFloatCurve* Curve = nullptr;
+        int32 ControlIndex = INDEX_NONE;
+        bool bHasMorphTarget = false;
+        int32 Cursor = 0;
+    };
+
+    TArray<FTransformBinding> TransformBindings;
+    TArray<FFloatBinding> FloatBindings;
+
+    UPROPERTY(Transient)
+    UControlRigComponent* ControlRigComponent = nullptr;
+
+    UPROPERTY(Transient)
+    USkeletalMeshComponent* SkeletalMeshComponent = nullptr;
+
+    float PlaybackTime = 0.0f;
+
+    bool bPlaying = false;
+};
@@ -3,14 +3,19 @@
 #include "Channels/MovieSceneFloatChannel.h"
 #include "Common/Public/InstrumentAnimationUtility.h"
 #include "Common/Public/InstrumentControlRigUtility.h"
+#include "Common/Public/InstrumentGenerationCache.h"
+#include "Common/Public/InstrumentLiveLinkSource.h"
+#include "Common/Public/InstrumentStreamingImport.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "ControlRig.h"
 #include "Dom/JsonObject.h"
 #include "Dom/JsonValue.h"
 #include "Json.h"
 #include "JsonUtilities.h"
+#include "Misc/Paths.h"
 #include "StringFlowControlRigProcessor.h"
 #include "StringFlowMusicInstrumentProcessor.h"
+#include "StringFlowTransformSyncProcessor.h"
 #include "StringFlowUnreal.h"
 
 #define LOCTEXT_NAMESPACE "StringFlowAnimationProcessor"
@@ -146,6 +151,16 @@ static void ProcessStringFlowAnimationFrame(
         GetValidStringFlowControllerNames(), OutKeyframesAdded);
 }
 
+/**
+ * 演奏动画轻量撤销记录的名称（左右手分别记录）
+ */
+static FString GetPerformerUndoRecordName(AStringFlowUnreal* StringFlowActor,
+                                          const FString& AnimationFilePath) {
+    return FString::Printf(TEXT("%s_Performer_%s"),
+                           *StringFlowActor->GetActorLabel(),
+                           *FPaths::GetBaseFilename(AnimationFilePath));
+}
+
 }  // namespace StringFlowAnimationHelper
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -160,6 +175,11 @@ void UStringFlowAnimationProcessor::GeneratePerformerAnimation(
         return;
     }
 
+    // 分段子序列模式：左右手动画写入同一个独立的子序列资产
+    FScopedTakeSequenceGeneration TakeScope(
+        StringFlowActor->bUseTakeSequences, StringFlowActor->SkeletalMeshActor,
+        TEXT("Performer"));
+
     // 获取LevelSequence
     ULevelSequence* LevelSequence = nullptr;
     TSharedPtr<ISequencer> Sequencer = nullptr;
@@ -190,7 +210,8 @@ void UStringFlowAnimationProcessor::GeneratePerformerAnimation(
                TEXT("Generating left hand animation from: %s"),
                *LeftHandAnimationPath);
         MakePerformerAnimation(StringFlowActor, LeftHandAnimationPath,
-                               LevelSequence);
+                               LevelSequence,
+                               StringFlowActor->RegenerationWindow);
     } else {
         UE_LOG(LogTemp, Warning, TEXT("Left hand animation path is empty"));
     }
@@ -201,12 +222,43 @@ void UStringFlowAnimationProcessor::GeneratePerformerAnimation(
                TEXT("Generating right hand animation from: %s"),
                *RightHandAnimationPath);
         MakePerformerAnimation(StringFlowActor, RightHandAnimationPath,
-                               LevelSequence);
+                               LevelSequence,
+                               StringFlowActor->RegenerationWindow);
     } else {
         UE_LOG(LogTemp, Warning, TEXT("Right hand animation path is empty"));
     }
 }
 
+bool UStringFlowAnimationProcessor::RevertPerformerAnimation(
+    AStringFlowUnreal* StringFlowActor) {
+    if (!StringFlowActor || !StringFlowActor->SkeletalMeshActor) {
+        UE_LOG(LogTemp, Error,
+               TEXT("RevertPerformerAnimation: invalid StringFlowActor"));
+        return false;
+    }
+
+    FString LeftHandAnimationPath;
+    FString RightHandAnimationPath;
+    FString StringVibrationPath;
+    if (!ParseStringFlowConfigFile(StringFlowActor, LeftHandAnimationPath,
+                                   RightHandAnimationPath,
+                                   StringVibrationPath)) {
+        return false;
+    }
+
+    bool bRestored = false;
+    for (const FString& HandPath :
+         {LeftHandAnimationPath, RightHandAnimationPath}) {
+        if (!HandPath.IsEmpty()) {
+            bRestored |= FInstrumentGenerationCache::RestorePreviousGeneration(
+                StringFlowActor->SkeletalMeshActor,
+                StringFlowAnimationHelper::GetPerformerUndoRecordName(
+                    StringFlowActor, HandPath));
+        }
+    }
+    return bRestored;
+}
+
 void UStringFlowAnimationProcessor::GenerateInstrumentAnimation(
     AStringFlowUnreal* StringFlowActor) {
     if (!StringFlowActor) {
@@ -260,10 +312,95 @@ void UStringFlowAnimationProcessor::GenerateAllAnimation(
                     "animation"));
     }
 
+    // 把小提琴和琴弓的跟随关系烘焙为关键帧，播放和渲染不再依赖实时同步
+    UStringFlowTransformSyncProcessor::BakeInstrumentTransforms(StringFlowActor);
+
     UE_LOG(LogTemp, Warning,
            TEXT("========== GenerateAllAnimation Completed =========="));
 }
 
+bool UStringFlowAnimationProcessor::StartLivePreview(
+    AStringFlowUnreal* StringFlowActor) {
+    if (!StringFlowActor) {
+        UE_LOG(LogTemp, Error,
+               TEXT("StartLivePreview: StringFlowActor is null"));
+        return false;
+    }
+
+    FString LeftHandAnimationPath;
+    FString RightHandAnimationPath;
+    FString StringVibrationPath;
+    if (!ParseStringFlowConfigFile(StringFlowActor, LeftHandAnimationPath,
+                                   RightHandAnimationPath,
+                                   StringVibrationPath)) {
+        UE_LOG(LogTemp, Error,
+               TEXT("Failed to parse StringFlow config file in "
+                    "StartLivePreview"));
+        return false;
+    }
+
+    FInstrumentLiveLinkStream Stream;
+    Stream.SubjectName =
+        FName(*(StringFlowActor->GetActorLabel() + TEXT("_Performer")));
+    for (const FString& Path : {LeftHandAnimationPath, RightHandAnimationPath}) {
+        if (!Path.IsEmpty()) {
+            Stream.FilePaths.Add(Path);
+        }
+    }
+    if (Stream.FilePaths.Num() == 0) {
+        UE_LOG(LogTemp, Error,
+               TEXT("StartLivePreview: Hand animation paths are empty"));
+        return false;
+    }
+    Stream.ControllerNames =
+        StringFlowAnimationHelper::GetValidStringFlowControllerNames();
+
+    TArray<FInstrumentLiveLinkStream> Streams;
+    Streams.Add(MoveTemp(Stream));
+    return FInstrumentLiveLinkSource::StartPreview(
+        StringFlowActor->GetActorLabel(), MoveTemp(Streams));
+}
+
+void UStringFlowAnimationProcessor::StopLivePreview(
+    AStringFlowUnreal* StringFlowActor) {
+    if (StringFlowActor) {
+        FInstrumentLiveLinkSource::StopPreview(
+            StringFlowActor->GetActorLabel());
+    }
+}
+
+bool UStringFlowAnimationProcessor::StartStreamingImport(
+    AStringFlowUnreal* StringFlowActor, int32 Port) {
+    if (!StringFlowActor) {
+        UE_LOG(LogTemp, Error,
+               TEXT("StartStreamingImport: StringFlowActor is null"));
+        return false;
+    }
+
+    // 外部工具在同一个连接中发送左右手的帧
+    FInstrumentStreamingImportSettings Settings;
+    Settings.SessionName = StringFlowActor->GetActorLabel();
+    Settings.Port = Port;
+    Settings.PerformerActor = StringFlowActor->SkeletalMeshActor;
+    Settings.bUseTakeSequences = StringFlowActor->bUseTakeSequences;
+    Settings.TakeSuffix = TEXT("Performer");
+    Settings.ControllerNames =
+        StringFlowAnimationHelper::GetValidStringFlowControllerNames();
+    StringFlowAnimationHelper::CollectStringFlowControllerNames(
+        StringFlowActor, Settings.ControllerNamesToClean);
+    Settings.InsertSettings.FramePadding = 1;  // StringFlow 使用 MaxFrame + 1
+
+    return FInstrumentStreamingImportSession::StartSession(MoveTemp(Settings));
+}
+
+void UStringFlowAnimationProcessor::StopStreamingImport(
+    AStringFlowUnreal* StringFlowActor) {
+    if (StringFlowActor) {
+        FInstrumentStreamingImportSession::StopSession(
+            StringFlowActor->GetActorLabel());
+    }
+}
+
 void UStringFlowAnimationProcessor::MakeStringAnimation(
     AStringFlowUnreal* StringFlowActor, const FString& AnimationFilePath,
     ULevelSequence* LevelSequence) {
@@ -395,7 +532,7 @@ void UStringFlowAnimationProcessor::MakeStringAnimation(
 
 void UStringFlowAnimationProcessor::MakePerformerAnimation(
     AStringFlowUnreal* StringFlowActor, const FString& AnimationFilePath,
-    ULevelSequence* LevelSequence) {
+    ULevelSequence* LevelSequence, const FAnimationFrameWindow& FrameWindow) {
     if (!StringFlowActor) {
         UE_LOG(LogTemp, Error,
                TEXT("MakePerformerAnimation: StringFlowActor is null"));
@@ -421,29 +558,13 @@ void UStringFlowAnimationProcessor::MakePerformerAnimation(
            *AnimationFilePath);
 
 #if WITH_EDITOR
-    // 1. 读取动画文件
-    FString FileContent;
-    if (!FFileHelper::LoadFileToString(FileContent, *AnimationFilePath)) {
-        UE_LOG(LogTemp, Error, TEXT("Failed to load animation file: %s"),
-               *AnimationFilePath);
-        return;
-    }
+    // 撤销模式：Light/Disabled 时不向事务缓冲区写入对象快照
+    FScopedGenerationUndoMode UndoMode(
+        StringFlowActor->GenerationUndoMode,
+        StringFlowAnimationHelper::GetPerformerUndoRecordName(
+            StringFlowActor, AnimationFilePath));
 
-    // 2. 解析JSON数组
-    TArray<TSharedPtr<FJsonValue>> JsonArray;
-    TSharedRef<TJsonReader<>> Reader =
-        TJsonReaderFactory<>::Create(FileContent);
-
-    if (!FJsonSerializer::Deserialize(Reader, JsonArray)) {
-        UE_LOG(LogTemp, Error, TEXT("Failed to parse JSON array from file: %s"),
-               *AnimationFilePath);
-        return;
-    }
-
-    UE_LOG(LogTemp, Warning, TEXT("Loaded %d animation frames"),
-           JsonArray.Num());
-
-    // 3. 获取演奏者模型的 Control Rig Instance
+    // 1. 获取演奏者模型的 Control Rig Instance
     UControlRig* ControlRigInstance = nullptr;
     UControlRigBlueprint* ControlRigBlueprint = nullptr;
 
@@ -461,7 +582,7 @@ void UStringFlowAnimationProcessor::MakePerformerAnimation(
         return;
     }
 
-    // 4. 验证并修复重复的轨道
+    // 2. 验证并修复重复的轨道
     bool bHasDuplicateTracks =
         UInstrumentAnimationUtility::ValidateNoExistingTracks(
             LevelSequence, ControlRigInstance, true);
@@ -471,7 +592,7 @@ void UStringFlowAnimationProcessor::MakePerformerAnimation(
                     "Proceeding with animation generation."));
     }
 
-    // 5. 根据文件路径确定要清理的控制器集合
+    // 3. 根据文件路径确定要清理的控制器集合
     TSet<FString> ControlNamesToClean;
 
     // 判断是左手还是右手动画
@@ -509,17 +630,87 @@ void UStringFlowAnimationProcessor::MakePerformerAnimation(
                ControlNamesToClean.Num());
     }
 
-    // 6. 清空关键帧（使用通用方法）
-    UE_LOG(LogTemp, Warning,
-           TEXT("Clearing existing Control Rig keyframes before adding new "
-                "keyframes"));
-    UInstrumentAnimationUtility::ClearControlRigKeyframes(
-        LevelSequence, ControlRigInstance, ControlNamesToClean);
+    // 4. 配置批量插入设置
+    FBatchInsertKeyframesSettings Settings;
+    Settings.FramePadding = 1;  // StringFlow 使用 MaxFrame + 1
+    Settings.FrameWindow = FrameWindow;  // 窗口外的关键帧在批量插入时被过滤
+
+    // 5. 输入没有变化时直接从生成缓存恢复（局部重新生成不走缓存）
+    FString Fingerprint;
+    if (!FrameWindow.IsSet()) {
+        UMovieScene* MovieScene = LevelSequence->GetMovieScene();
+        FGenerationFingerprint FingerprintBuilder;
+        FingerprintBuilder.AddString(TEXT("StringFlow.Performer"));
+        FingerprintBuilder.AddFile(AnimationFilePath);
+        FingerprintBuilder.AddControlRigHierarchy(ControlRigInstance);
+        FingerprintBuilder.AddSettings(Settings);
+        FingerprintBuilder.AddFrameRate(MovieScene->GetTickResolution());
+        FingerprintBuilder.AddFrameRate(MovieScene->GetDisplayRate());
+        FingerprintBuilder.AddInt(StringFlowActor->OneHandFingerNumber);
+        FingerprintBuilder.AddInt(StringFlowActor->StringNumber);
+        Fingerprint = FingerprintBuilder.ToString();
+    }
+
+    // Light 撤销模式：生成前把本手的现有数据保存到磁盘作为撤销记录
+    UndoMode.RecordPreviousSection(
+        FInstrumentGenerationCache::FindControlRigSection(LevelSequence,
+                                                          ControlRigInstance),
+        ControlNamesToClean);
+
+    if (!Fingerprint.IsEmpty() &&
+        FInstrumentGenerationCache::RestoreSectionChannels(
+            Fingerprint, FInstrumentGenerationCache::FindControlRigSection(
+                             LevelSequence, ControlRigInstance))) {
+        LevelSequence->MarkPackageDirty();
+        UndoMode.LogMemoryReport();
+        UE_LOG(LogTemp, Warning,
+               TEXT("========== MakePerformerAnimation Completed "
+                    "(restored from cache %s) =========="),
+               *Fingerprint);
+        return;
+    }
+
+    // 6. 读取动画文件
+    FString FileContent;
+    if (!FFileHelper::LoadFileToString(FileContent, *AnimationFilePath)) {
+        UE_LOG(LogTemp, Error, TEXT("Failed to load animation file: %s"),
+               *AnimationFilePath);
+        return;
+    }
+
+    // 7. 解析JSON数组
+    TArray<TSharedPtr<FJsonValue>> JsonArray;
+    TSharedRef<TJsonReader<>> Reader =
+        TJsonReaderFactory<>::Create(FileContent);
+
+    if (!FJsonSerializer::Deserialize(Reader, JsonArray)) {
+        UE_LOG(LogTemp, Error, TEXT("Failed to parse JSON array from file: %s"),
+               *AnimationFilePath);
+        return;
+    }
+
+    UE_LOG(LogTemp, Warning, TEXT("Loaded %d animation frames"),
+           JsonArray.Num());
+
+    // 8. 清空关键帧（使用通用方法）
+    // 局部重新生成时不清空，由批量插入只替换窗口内的关键帧
+    if (FrameWindow.IsSet()) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("Regenerating frames [%d, %d] only, keeping keyframes "
+                    "outside the window"),
+               FrameWindow.StartFrame, FrameWindow.EndFrame);
+    } else {
+        UE_LOG(LogTemp, Warning,
+               TEXT("Clearing existing Control Rig keyframes before adding "
+                    "new keyframes"));
+        UInstrumentAnimationUtility::ClearControlRigKeyframes(
+            LevelSequence, ControlRigInstance, ControlNamesToClean);
+    }
 
     UE_LOG(LogTemp, Warning, TEXT("Starting to process %d animation frames"),
            JsonArray.Num());
 
-    // 7. 处理每一帧并收集关键帧数据
+    // 9. 处理每一帧并收集关键帧数据
     TMap<FString, TArray<FAnimationKeyframe>> ControlKeyframeData;
     int32 ProcessedFrames = 0;
     int32 FailedFrames = 0;
@@ -528,6 +719,15 @@ void UStringFlowAnimationProcessor::MakePerformerAnimation(
     for (int32 FrameIndex = 0; FrameIndex < JsonArray.Num(); ++FrameIndex) {
         TSharedPtr<FJsonObject> FrameObject = JsonArray[FrameIndex]->AsObject();
 
+        // 跳过局部重新生成窗口外的帧（StringFlow 的帧号来自 frame 字段）
+        if (FrameWindow.IsSet() && FrameObject.IsValid()) {
+            int32 FrameNumber = FrameIndex;
+            FrameObject->TryGetNumberField(TEXT("frame"), FrameNumber);
+            if (!FrameWindow.Contains(FrameNumber)) {
+                continue;
+            }
+        }
+
         // 使用 StringFlow 特定的方法处理帧（负责提取 frame 和 hand_infos）
         StringFlowAnimationHelper::ProcessStringFlowAnimationFrame(
             FrameObject, ControlKeyframeData, FrameIndex, FailedFrames,
@@ -536,15 +736,20 @@ void UStringFlowAnimationProcessor::MakePerformerAnimation(
         ProcessedFrames++;
     }
 
-    // 8. 配置批量插入设置
-    FBatchInsertKeyframesSettings Settings;
-    Settings.FramePadding = 1;  // StringFlow 使用 MaxFrame + 1
-
-    // 9. 批量插入关键帧（使用通用方法）
+    // 10. 批量插入关键帧（使用通用方法）
     UInstrumentAnimationUtility::BatchInsertControlRigKeys(
         LevelSequence, ControlRigInstance, ControlKeyframeData, Settings);
 
-    // 10. 标记为已修改
+    // 11. 写入生成缓存（只保存本手的控制器通道）
+    if (!Fingerprint.IsEmpty()) {
+        FInstrumentGenerationCache::StoreSectionChannels(
+            Fingerprint,
+            FInstrumentGenerationCache::FindControlRigSection(
+                LevelSequence, ControlRigInstance),
+            ControlNamesToClean);
+    }
+
+    // 12. 标记为已修改
     LevelSequence->MarkPackageDirty();
 
     UE_LOG(LogTemp, Warning,
@@ -554,6 +759,7 @@ void UStringFlowAnimationProcessor::MakePerformerAnimation(
     UE_LOG(LogTemp, Warning, TEXT("Failed frames: %d"), FailedFrames);
     UE_LOG(LogTemp, Warning, TEXT("Total keyframes added to Sequencer: %d"),
            KeyframesAdded);
+    UndoMode.LogMemoryReport();
     UE_LOG(LogTemp, Warning,
            TEXT("========== MakePerformerAnimation Completed =========="));
 
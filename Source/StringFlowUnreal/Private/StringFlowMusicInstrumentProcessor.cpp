@@ -3,6 +3,7 @@
 #include "Channels/MovieSceneFloatChannel.h"
 #include "Common/Public/InstrumentAnimationUtility.h"
 #include "Common/Public/InstrumentControlRigUtility.h"
+#include "Common/Public/InstrumentGenerationCache.h"
 #include "Common/Public/InstrumentMaterialUtility.h"
 #include "Common/Public/InstrumentMorphTargetUtility.h"
 #include "Components/SkeletalMeshComponent.h"
@@ -215,15 +216,15 @@ int32 UStringFlowMusicInstrumentProcessor::
            TEXT("✅ Got/Created SkeletalMeshComponent binding: %s"),
            *SkeletalMeshCompBindingID.ToString());
 
-    int32 SuccessCount = 0;
-    int32 FailureCount = 0;
     int32 NumMaterials = SkeletalMeshComp->GetNumMaterials();
 
     UE_LOG(LogTemp, Warning,
            TEXT("Checking %d materials for Vibration parameter..."),
            NumMaterials);
 
-    // 遍历所有材质槽，为每根弦的材质创建参数轨道
+    // 遍历所有材质槽，收集每根弦的材质参数轨道请求
+    TArray<FMaterialParameterTrackRequest> Requests;
+    Requests.Reserve(NumMaterials);
     for (int32 MaterialSlotIndex = 0; MaterialSlotIndex < NumMaterials;
          ++MaterialSlotIndex) {
         UMaterialInterface* CurrentMaterial =
@@ -233,49 +234,36 @@ int32 UStringFlowMusicInstrumentProcessor::
             continue;
         }
 
-        FString MaterialName = CurrentMaterial->GetName();
-
         // 使用Common模块方法检查材质是否有Vibration参数
         if (UInstrumentMaterialUtility::MaterialHasParameter(
                 CurrentMaterial, TEXT("Vibration"))) {
-            // 使用Common模块方法查找或创建材质轨道
-            UMovieSceneComponentMaterialTrack* MaterialTrack =
-                UInstrumentAnimationUtility::FindOrCreateComponentMaterialTrack(
-                    LevelSequence, SkeletalMeshCompBindingID,
-                    MaterialSlotIndex);
-
-            if (MaterialTrack) {
-                // 使用Common模块方法添加参数
-                if (UInstrumentAnimationUtility::AddMaterialParameter(
-                        MaterialTrack, TEXT("Vibration"), 0.0f)) {
-                    SuccessCount++;
-                    UE_LOG(LogTemp, Log,
-                           TEXT("  ✓ Created material parameter track for "
-                                "'%s' (slot %d)"),
-                           *MaterialName, MaterialSlotIndex);
-                } else {
-                    FailureCount++;
-                    UE_LOG(LogTemp, Warning,
-                           TEXT("  ✗ Failed to add Vibration parameter to "
-                                "track for "
-                                "'%s' (slot %d)"),
-                           *MaterialName, MaterialSlotIndex);
-                }
-            } else {
-                FailureCount++;
-                UE_LOG(LogTemp, Warning,
-                       TEXT("  ✗ Failed to create material parameter track for "
-                            "'%s' (slot %d)"),
-                       *MaterialName, MaterialSlotIndex);
-            }
+            Requests.Emplace(MaterialSlotIndex, TEXT("Vibration"), 0.0f);
         } else {
             UE_LOG(LogTemp, Verbose,
                    TEXT("  - Material '%s' (slot %d) does not have Vibration "
                         "parameter"),
-                   *MaterialName, MaterialSlotIndex);
+                   *CurrentMaterial->GetName(), MaterialSlotIndex);
         }
     }
 
+    // 使用Common模块方法一次性创建所有轨道和参数
+    int32 SuccessCount = 0;
+    TArray<int32> FailedRequestIndices;
+    if (Requests.Num() > 0) {
+        SuccessCount =
+            UInstrumentAnimationUtility::BulkCreateMaterialParameterTracks(
+                LevelSequence, SkeletalMeshCompBindingID, Requests, Sequencer,
+                &FailedRequestIndices);
+    }
+
+    for (int32 FailedIndex : FailedRequestIndices) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("  ✗ Failed to create material parameter track for "
+                    "slot %d"),
+               Requests[FailedIndex].MaterialSlotIndex);
+    }
+    const int32 FailureCount = FailedRequestIndices.Num();
+
     UE_LOG(LogTemp, Warning,
            TEXT("========== InitializeStringMaterialAnimationTracks Report "
                 "=========="));
@@ -428,7 +416,8 @@ bool UStringFlowMusicInstrumentProcessor::
         const FString& StringVibrationDataPath,
         TMap<FString,
              TTuple<TArray<FFrameNumber>, TArray<FMovieSceneFloatValue>>>&
-            OutVibrationKeyframeData) {
+            OutVibrationKeyframeData,
+        const FAnimationFrameWindow& FrameWindow) {
     OutVibrationKeyframeData.Empty();
 
     if (!StringFlowActor) {
@@ -512,7 +501,8 @@ bool UStringFlowMusicInstrumentProcessor::
     // ========== 使用通用方法处理关键帧数据 ==========
     TArray<FMorphTargetKeyframeData> KeyframeData;
     if (!UInstrumentMorphTargetUtility::ProcessMorphTargetKeyframeData(
-            KeyDataArray, KeyframeData, TickResolution, DisplayRate)) {
+            KeyDataArray, KeyframeData, TickResolution, DisplayRate,
+            FrameWindow)) {
         UE_LOG(LogTemp, Error, TEXT("Failed to process vibration data"));
         return false;
     }
@@ -529,7 +519,7 @@ bool UStringFlowMusicInstrumentProcessor::
     int32 WrittenTargets =
         UInstrumentMorphTargetUtility::WriteMorphTargetAnimationToControlRig(
             StringFlowActor->StringInstrument, KeyframeData, LevelSequence,
-            TEXT("violin_root"));
+            TEXT("violin_root"), FrameWindow);
 
     if (WrittenTargets == 0) {
         UE_LOG(LogTemp, Error, TEXT("Failed to write morph target animations"));
@@ -573,7 +563,8 @@ int32 UStringFlowMusicInstrumentProcessor::SyncVibrationToMaterialAnimation(
     const TMap<FString,
                TTuple<TArray<FFrameNumber>, TArray<FMovieSceneFloatValue>>>&
         VibrationKeyframeData,
-    FFrameNumber MinFrame, FFrameNumber MaxFrame) {
+    FFrameNumber MinFrame, FFrameNumber MaxFrame,
+    const FAnimationFrameWindow& FrameWindow) {
     if (!StringFlowActor) {
         UE_LOG(LogTemp, Error,
                TEXT("StringFlowActor is null in "
@@ -672,9 +663,15 @@ int32 UStringFlowMusicInstrumentProcessor::SyncVibrationToMaterialAnimation(
             continue;
         }
 
+        // 局部重新生成时复用现有Section，只替换窗口内的关键帧
+        const bool bReuseSection = FrameWindow.IsSet() &&
+                                   MaterialTrack->GetAllSections().Num() > 0;
+
         // 使用Common模块方法重置轨道sections（这会删除所有现有Section并创建新的空Section）
         UMovieSceneSection* NewSection =
-            UInstrumentAnimationUtility::ResetTrackSections(MaterialTrack);
+            bReuseSection
+                ? MaterialTrack->GetAllSections()[0]
+                : UInstrumentAnimationUtility::ResetTrackSections(MaterialTrack);
 
         if (!NewSection) {
             FailureCount++;
@@ -690,12 +687,14 @@ int32 UStringFlowMusicInstrumentProcessor::SyncVibrationToMaterialAnimation(
         }
 
         // 在新创建的空Section中添加Vibration参数（初始值为0）
-        FMaterialParameterInfo ParameterInfo;
-        ParameterInfo.Name = FName(TEXT("Vibration"));
+        if (!bReuseSection) {
+            FMaterialParameterInfo ParameterInfo;
+            ParameterInfo.Name = FName(TEXT("Vibration"));
 
-        ParameterSection->AddScalarParameterKey(
-            ParameterInfo, FFrameNumber(0), 0.0f, TEXT(""), TEXT(""),
-            EMovieSceneKeyInterpolation::Auto);
+            ParameterSection->AddScalarParameterKey(
+                ParameterInfo, FFrameNumber(0), 0.0f, TEXT(""), TEXT(""),
+                EMovieSceneKeyInterpolation::Auto);
+        }
 
         // 准备关键帧数据
         TArray<FMaterialParameterKeyframeData> KeyframeData;
@@ -721,7 +720,8 @@ int32 UStringFlowMusicInstrumentProcessor::SyncVibrationToMaterialAnimation(
 
             // 检查该弦是否映射到当前材质槽
             if (StringIndex >= 0 && StringIndex == MaterialSlotIndex) {
-                if (FrameNumbers.Num() > 0 &&
+                // 窗口模式下允许空数据，用于清除窗口内的旧关键帧
+                if ((FrameNumbers.Num() > 0 || FrameWindow.IsSet()) &&
                     FrameNumbers.Num() == FrameValues.Num()) {
                     FMaterialParameterKeyframeData ParamData(TEXT("Vibration"));
                     ParamData.FrameNumbers = FrameNumbers;
@@ -742,7 +742,7 @@ int32 UStringFlowMusicInstrumentProcessor::SyncVibrationToMaterialAnimation(
         if (KeyframeData.Num() > 0) {
             int32 WrittenParams =
                 UInstrumentAnimationUtility::WriteMaterialParameterKeyframes(
-                    ParameterSection, KeyframeData);
+                    ParameterSection, KeyframeData, FrameWindow);
 
             if (WrittenParams > 0) {
                 SuccessCount++;
@@ -761,10 +761,13 @@ int32 UStringFlowMusicInstrumentProcessor::SyncVibrationToMaterialAnimation(
             SuccessCount++;
         }
 
-        // 设置 Section 范围
+        // 设置 Section 范围（窗口模式下只扩展）
         if (MinFrame.Value != MAX_int32 && MaxFrame.Value != MIN_int32) {
+            TRange<FFrameNumber> NewRange(MinFrame, MaxFrame + 1);
             ParameterSection->SetRange(
-                TRange<FFrameNumber>(MinFrame, MaxFrame + 1));
+                bReuseSection ? TRange<FFrameNumber>::Hull(
+                                    ParameterSection->GetRange(), NewRange)
+                              : NewRange);
         }
     }
 
@@ -832,6 +835,17 @@ void UStringFlowMusicInstrumentProcessor::GenerateInstrumentAnimation(
            TEXT("========== GenerateInstrumentAnimation Started =========="));
 
 #if WITH_EDITOR
+    // 分段子序列模式：弦振动Morph Target和材质动画写入独立的子序列资产
+    FScopedTakeSequenceGeneration TakeScope(
+        StringFlowActor->bUseTakeSequences, StringFlowActor->StringInstrument,
+        TEXT("Strings"));
+
+    // 撤销模式：Light/Disabled 时不向事务缓冲区写入对象快照
+    // （Light 模式在写入前把琴弦曲线保存到磁盘，材质参数轨道不在记录内）
+    FScopedGenerationUndoMode UndoMode(
+        StringFlowActor->GenerationUndoMode,
+        StringFlowActor->GetActorLabel() + TEXT("_Strings"));
+
     // 获取配置文件路径
     FString LeftHandAnimationPath;
     FString RightHandAnimationPath;
@@ -856,17 +870,6 @@ void UStringFlowMusicInstrumentProcessor::GenerateInstrumentAnimation(
     UE_LOG(LogTemp, Warning, TEXT("Generating instrument animation from: %s"),
            *StringVibrationPath);
 
-    // 使用新的Morph Target生成方法
-    TMap<FString, TTuple<TArray<FFrameNumber>, TArray<FMovieSceneFloatValue>>>
-        VibrationKeyframeData;
-
-    if (!LoadAndGenerateStringVibrationAnimation(
-            StringFlowActor, StringVibrationPath, VibrationKeyframeData)) {
-        UE_LOG(LogTemp, Error,
-               TEXT("Failed to load and generate string vibration animation"));
-        return;
-    }
-
     // 使用Common模块的方法获取LevelSequence和Sequencer
     ULevelSequence* LevelSequence = nullptr;
     TSharedPtr<ISequencer> Sequencer = nullptr;
@@ -883,6 +886,57 @@ void UStringFlowMusicInstrumentProcessor::GenerateInstrumentAnimation(
         return;
     }
 
+    // 输入没有变化时直接从生成缓存恢复琴弦曲线和振动材质轨道
+    // （局部重新生成不走缓存）
+    FString Fingerprint;
+    if (!StringFlowActor->RegenerationWindow.IsSet()) {
+        UControlRig* InstrumentControlRig = nullptr;
+        UControlRigBlueprint* InstrumentControlRigBlueprint = nullptr;
+        FInstrumentControlRigUtility::GetControlRigFromSkeletalMeshActor(
+            StringFlowActor->StringInstrument, InstrumentControlRig,
+            InstrumentControlRigBlueprint);
+
+        FGenerationFingerprint FingerprintBuilder;
+        FingerprintBuilder.AddString(TEXT("StringFlow.Strings"));
+        FingerprintBuilder.AddFile(StringVibrationPath);
+        FingerprintBuilder.AddControlRigHierarchy(InstrumentControlRig);
+        FingerprintBuilder.AddFrameRate(MovieScene->GetTickResolution());
+        FingerprintBuilder.AddFrameRate(MovieScene->GetDisplayRate());
+        FingerprintBuilder.AddMaterialSlots(
+            StringFlowActor->StringInstrument->GetSkeletalMeshComponent());
+        Fingerprint = FingerprintBuilder.ToString();
+    }
+
+    // Light 撤销模式：写入前把现有琴弦曲线保存到磁盘作为撤销记录
+    UndoMode.RecordPreviousInstrumentSection(StringFlowActor->StringInstrument);
+
+    TArray<UMovieSceneSection*> CachedSections;
+    if (!Fingerprint.IsEmpty() &&
+        FInstrumentGenerationCache::CollectInstrumentSections(
+            StringFlowActor->StringInstrument, true, CachedSections) &&
+        FInstrumentGenerationCache::RestoreSectionChannels(Fingerprint,
+                                                           CachedSections)) {
+        LevelSequence->MarkPackageDirty();
+        UndoMode.LogMemoryReport();
+        UE_LOG(LogTemp, Warning,
+               TEXT("========== GenerateInstrumentAnimation Completed "
+                    "(restored from cache %s) =========="),
+               *Fingerprint);
+        return;
+    }
+
+    // 使用新的Morph Target生成方法
+    TMap<FString, TTuple<TArray<FFrameNumber>, TArray<FMovieSceneFloatValue>>>
+        VibrationKeyframeData;
+
+    if (!LoadAndGenerateStringVibrationAnimation(
+            StringFlowActor, StringVibrationPath, VibrationKeyframeData,
+            StringFlowActor->RegenerationWindow)) {
+        UE_LOG(LogTemp, Error,
+               TEXT("Failed to load and generate string vibration animation"));
+        return;
+    }
+
     // 计算帧范围
     FFrameNumber MinFrame = FFrameNumber(INT_MAX);
     FFrameNumber MaxFrame = FFrameNumber(INT_MIN);
@@ -895,7 +949,9 @@ void UStringFlowMusicInstrumentProcessor::GenerateInstrumentAnimation(
         }
     }
 
-    if (MinFrame.Value == INT_MAX || MaxFrame.Value == INT_MIN) {
+    // 窗口内没有关键帧时仍需同步，以清除窗口内的旧关键帧
+    if ((MinFrame.Value == INT_MAX || MaxFrame.Value == INT_MIN) &&
+        !StringFlowActor->RegenerationWindow.IsSet()) {
         UE_LOG(LogTemp, Error, TEXT("Invalid frame range"));
         return;
     }
@@ -903,7 +959,7 @@ void UStringFlowMusicInstrumentProcessor::GenerateInstrumentAnimation(
     // 同步到材质动画
     int32 MaterialTracksUpdated = SyncVibrationToMaterialAnimation(
         StringFlowActor, LevelSequence, VibrationKeyframeData, MinFrame,
-        MaxFrame);
+        MaxFrame, StringFlowActor->RegenerationWindow);
 
     UE_LOG(LogTemp, Warning,
            TEXT("========== GenerateInstrumentAnimation Report =========="));
@@ -911,6 +967,9 @@ void UStringFlowMusicInstrumentProcessor::GenerateInstrumentAnimation(
            TEXT("Successfully processed string vibration data"));
     UE_LOG(LogTemp, Warning, TEXT("Material tracks updated: %d"),
            MaterialTracksUpdated);
+    FInstrumentGenerationCache::StoreInstrumentSections(
+        Fingerprint, StringFlowActor->StringInstrument, true);
+    UndoMode.LogMemoryReport();
     UE_LOG(LogTemp, Warning,
            TEXT("========== GenerateInstrumentAnimation Completed =========="));
 
@@ -2,6 +2,7 @@
 
 #include "DesktopPlatformModule.h"
 #include "ISequencer.h"
+#include "InstrumentAnimSequenceBakeUtility.h"
 #include "InstrumentAnimationUtility.h"
 #include "LevelEditorSequencerIntegration.h"
 #include "LevelSequence.h"
@@ -347,6 +348,48 @@ void SStringFlowOperationsPanel::SetActor(AActor* InActor) {
                   .HAlign(HAlign_Center)
                   .ButtonStyle(FAppStyle::Get(), "FlatButton.Default")];
 
+    OperationsContainer->AddSlot().AutoHeight().Padding(
+        5.0f)[SNew(SButton)
+                  .Text(LOCTEXT("BakeToAnimSequenceButton",
+                                "Bake to Animation Sequence"))
+                  .OnClicked(
+                      this, &SStringFlowOperationsPanel::OnBakeToAnimSequence)
+                  .HAlign(HAlign_Center)
+                  .ButtonStyle(FAppStyle::Get(), "FlatButton.Default")];
+
+    OperationsContainer->AddSlot().AutoHeight().Padding(
+        5.0f)[SNew(SButton)
+                  .Text(LOCTEXT("StartLivePreviewButton", "Start Live Preview"))
+                  .OnClicked(
+                      this, &SStringFlowOperationsPanel::OnStartLivePreview)
+                  .HAlign(HAlign_Center)
+                  .ButtonStyle(FAppStyle::Get(), "FlatButton.Default")];
+
+    OperationsContainer->AddSlot().AutoHeight().Padding(
+        5.0f)[SNew(SButton)
+                  .Text(LOCTEXT("StopLivePreviewButton", "Stop Live Preview"))
+                  .OnClicked(this, &SStringFlowOperationsPanel::OnStopLivePreview)
+                  .HAlign(HAlign_Center)
+                  .ButtonStyle(FAppStyle::Get(), "FlatButton.Default")];
+
+    OperationsContainer->AddSlot().AutoHeight().Padding(
+        5.0f)[SNew(SButton)
+                  .Text(LOCTEXT("StartStreamingImportButton",
+                                "Start Streaming Import"))
+                  .OnClicked(
+                      this, &SStringFlowOperationsPanel::OnStartStreamingImport)
+                  .HAlign(HAlign_Center)
+                  .ButtonStyle(FAppStyle::Get(), "FlatButton.Default")];
+
+    OperationsContainer->AddSlot().AutoHeight().Padding(
+        5.0f)[SNew(SButton)
+                  .Text(LOCTEXT("StopStreamingImportButton",
+                                "Stop Streaming Import"))
+                  .OnClicked(
+                      this, &SStringFlowOperationsPanel::OnStopStreamingImport)
+                  .HAlign(HAlign_Center)
+                  .ButtonStyle(FAppStyle::Get(), "FlatButton.Default")];
+
     // Maintenance Section
     OperationsContainer->AddSlot().AutoHeight().Padding(
         5.0f, 15.0f, 5.0f,
@@ -499,6 +542,75 @@ FReply SStringFlowOperationsPanel::OnGenerateAllAnimation() {
     return FReply::Handled();
 }
 
+FReply SStringFlowOperationsPanel::OnBakeToAnimSequence() {
+    if (!StringFlowActor.IsValid()) {
+        LastStatusMessage = TEXT("No actor selected");
+        return FReply::Handled();
+    }
+
+    LastStatusMessage = TEXT("Baking animation sequences...");
+    const int32 NumBaked =
+        UInstrumentAnimSequenceBakeUtility::BakeInstrumentToAnimSequences(
+            StringFlowActor.Get(), FString());
+    LastStatusMessage =
+        FString::Printf(TEXT("Baked %d animation sequences"), NumBaked);
+
+    return FReply::Handled();
+}
+
+FReply SStringFlowOperationsPanel::OnStartLivePreview() {
+    if (!StringFlowActor.IsValid()) {
+        LastStatusMessage = TEXT("No actor selected");
+        return FReply::Handled();
+    }
+
+    LastStatusMessage =
+        UStringFlowAnimationProcessor::StartLivePreview(StringFlowActor.Get())
+            ? TEXT("Live preview started")
+            : TEXT("Error: Failed to start live preview");
+
+    return FReply::Handled();
+}
+
+FReply SStringFlowOperationsPanel::OnStopLivePreview() {
+    if (!StringFlowActor.IsValid()) {
+        LastStatusMessage = TEXT("No actor selected");
+        return FReply::Handled();
+    }
+
+    UStringFlowAnimationProcessor::StopLivePreview(StringFlowActor.Get());
+    LastStatusMessage = TEXT("Live preview stopped");
+
+    return FReply::Handled();
+}
+
+FReply SStringFlowOperationsPanel::OnStartStreamingImport() {
+    if (!StringFlowActor.IsValid()) {
+        LastStatusMessage = TEXT("No actor selected");
+        return FReply::Handled();
+    }
+
+    LastStatusMessage =
+        UStringFlowAnimationProcessor::StartStreamingImport(
+            StringFlowActor.Get())
+            ? TEXT("Streaming import started")
+            : TEXT("Error: Failed to start streaming import");
+
+    return FReply::Handled();
+}
+
+FReply SStringFlowOperationsPanel::OnStopStreamingImport() {
+    if (!StringFlowActor.IsValid()) {
+        LastStatusMessage = TEXT("No actor selected");
+        return FReply::Handled();
+    }
+
+    UStringFlowAnimationProcessor::StopStreamingImport(StringFlowActor.Get());
+    LastStatusMessage = TEXT("Streaming import stopped");
+
+    return FReply::Handled();
+}
+
 FReply SStringFlowOperationsPanel::OnClearStringControlRigKeyframes() {
     if (!StringFlowActor.IsValid()) {
         LastStatusMessage = TEXT("No actor selected");
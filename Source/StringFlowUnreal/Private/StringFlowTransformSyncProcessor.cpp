@@ -1,11 +1,188 @@
 ﻿#include "StringFlowTransformSyncProcessor.h"
 
 #include "Animation/SkeletalMeshActor.h"
+#include "Async/ParallelFor.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Common/Public/InstrumentAnimationUtility.h"
 #include "Common/Public/InstrumentControlRigUtility.h"
+#include "Common/Public/InstrumentGenerationCache.h"
+#include "Common/Public/InstrumentSyncSubsystem.h"
 #include "ControlRig/Public/ControlRig.h"
 #include "Engine/Engine.h"
 #include "StringFlowControlRigProcessor.h"
 
+#if WITH_EDITOR
+namespace StringFlowTransformSyncHelper {
+/** Control Rig Section 中变换 Control 的通道后缀（与批量插入关键帧一致） */
+static const TCHAR* const ControlChannelSuffixes[6] = {
+    TEXT(".Location.X"), TEXT(".Location.Y"), TEXT(".Location.Z"),
+    TEXT(".Rotation.X"), TEXT(".Rotation.Y"), TEXT(".Rotation.Z")};
+
+/**
+ * 不运行 Control Rig，直接从 Section 的关键帧通道求 Control 的全局变换
+ * 初始化在游戏线程完成，Evaluate 只读通道数据，可以在多个线程同时调用
+ */
+struct FControlChannelSampler {
+    struct FLink {
+        FMovieSceneFloatChannel* Channels[6] = {};
+        /** 通道没有关键帧时使用的当前值 */
+        float FallbackValues[6] = {};
+        FTransform LocalOffset = FTransform::Identity;
+
+        FTransform EvaluateValue(const FFrameTime& Time) const {
+            float Values[6];
+            for (int32 i = 0; i < 6; ++i) {
+                if (!Channels[i]->Evaluate(Time, Values[i])) {
+                    Values[i] = FallbackValues[i];
+                }
+            }
+            // 旋转通道：X->Roll, Y->Pitch, Z->Yaw
+            const FRotator Rotation(Values[4], Values[5], Values[3]);
+            return FTransform(Rotation.Quaternion(),
+                              FVector(Values[0], Values[1], Values[2]));
+        }
+    };
+
+    /** 从目标 Control 开始，向上直到第一个没有通道的父级 */
+    TArray<FLink> Links;
+
+    /** 最上层带通道 Control 的父级全局变换，烘焙期间视为不变 */
+    FTransform BaseGlobal = FTransform::Identity;
+
+    bool Initialize(URigHierarchy* Hierarchy, UMovieSceneSection* Section,
+                    const FString& ControlName) {
+        Links.Reset();
+        BaseGlobal = FTransform::Identity;
+
+        FRigElementKey Key(*ControlName, ERigElementType::Control);
+        if (!Hierarchy || !Section || !Hierarchy->Contains(Key)) {
+            return false;
+        }
+
+        FMovieSceneChannelProxy& ChannelProxy = Section->GetChannelProxy();
+        while (Key.IsValid() && Key.Type == ERigElementType::Control) {
+            FLink Link;
+            bool bHasChannels = true;
+            for (int32 i = 0; i < 6 && bHasChannels; ++i) {
+                Link.Channels[i] =
+                    ChannelProxy
+                        .GetChannelByName<FMovieSceneFloatChannel>(
+                            *(Key.Name.ToString() + ControlChannelSuffixes[i]))
+                        .Get();
+                bHasChannels = Link.Channels[i] != nullptr;
+            }
+            if (!bHasChannels) {
+                break;
+            }
+
+            Link.LocalOffset = Hierarchy->GetLocalControlOffsetTransform(Key);
+            const FTransform CurrentValue =
+                Hierarchy->GetLocalTransform(Key).GetRelativeTransform(
+                    Link.LocalOffset);
+            const FVector CurrentLocation = CurrentValue.GetLocation();
+            const FRotator CurrentRotation = CurrentValue.Rotator();
+            Link.FallbackValues[0] = CurrentLocation.X;
+            Link.FallbackValues[1] = CurrentLocation.Y;
+            Link.FallbackValues[2] = CurrentLocation.Z;
+            Link.FallbackValues[3] = CurrentRotation.Roll;
+            Link.FallbackValues[4] = CurrentRotation.Pitch;
+            Link.FallbackValues[5] = CurrentRotation.Yaw;
+            Links.Add(Link);
+
+            Key = Hierarchy->GetFirstParent(Key);
+        }
+
+        if (Key.IsValid()) {
+            BaseGlobal = Hierarchy->GetGlobalTransform(Key);
+        }
+        return true;
+    }
+
+    /** 指定时间（Tick单位）的 Control Rig 全局变换 */
+    FTransform Evaluate(const FFrameTime& Time) const {
+        FTransform Global = BaseGlobal;
+        for (int32 i = Links.Num() - 1; i >= 0; --i) {
+            Global = Links[i].EvaluateValue(Time) * Links[i].LocalOffset *
+                     Global;
+        }
+        return Global;
+    }
+};
+
+/**
+ * 把烘焙好的世界变换写为目标 Control 的关键帧
+ * @param bWriteGlobal true时按 Control Rig 全局变换换算（与小提琴实时同步的
+ *        SetGlobalTransform 一致），false时按局部变换换算（与琴弓一致）
+ */
+static bool WriteBakedControlKeys(AStringFlowUnreal* StringFlowActor,
+                                  ASkeletalMeshActor* TargetActor,
+                                  const FString& ControlName,
+                                  const FString& TakeSuffix, bool bWriteGlobal,
+                                  int32 StartFrame,
+                                  const TArray<FTransform>& WorldTransforms) {
+    // 分段子序列模式：写入目标 Actor 所在的子序列
+    FScopedTakeSequenceGeneration TakeScope(StringFlowActor->bUseTakeSequences,
+                                            TargetActor, TakeSuffix);
+
+    ULevelSequence* LevelSequence = nullptr;
+    TSharedPtr<ISequencer> Sequencer = nullptr;
+    if (!UInstrumentAnimationUtility::GetActiveLevelSequenceAndSequencer(
+            LevelSequence, Sequencer)) {
+        return false;
+    }
+
+    UControlRig* ControlRigInstance = nullptr;
+    UControlRigBlueprint* ControlRigBlueprint = nullptr;
+    if (!FInstrumentControlRigUtility::GetControlRigFromSkeletalMeshActor(
+            TargetActor, ControlRigInstance, ControlRigBlueprint)) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("BakeInstrumentTransforms: Failed to get Control Rig for "
+                    "'%s'"),
+               *ControlName);
+        return false;
+    }
+
+    URigHierarchy* Hierarchy = ControlRigInstance->GetHierarchy();
+    const FRigElementKey Key(*ControlName, ERigElementType::Control);
+    if (!Hierarchy || !Hierarchy->Contains(Key)) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("BakeInstrumentTransforms: Control '%s' not found"),
+               *ControlName);
+        return false;
+    }
+
+    // 世界变换 -> Control 值（相对于 Offset）
+    const FTransform ActorWorldTransform = TargetActor->GetActorTransform();
+    const FTransform Offset =
+        bWriteGlobal ? Hierarchy->GetGlobalControlOffsetTransform(Key)
+                     : Hierarchy->GetLocalControlOffsetTransform(Key);
+
+    TMap<FString, TArray<FAnimationKeyframe>> ControlKeyframeData;
+    TArray<FAnimationKeyframe>& Keyframes = ControlKeyframeData.Add(ControlName);
+    Keyframes.Reserve(WorldTransforms.Num());
+    for (int32 i = 0; i < WorldTransforms.Num(); ++i) {
+        const FTransform Value =
+            WorldTransforms[i]
+                .GetRelativeTransform(ActorWorldTransform)
+                .GetRelativeTransform(Offset);
+        Keyframes.Emplace(StartFrame + i, Value.GetLocation(),
+                          Value.GetRotation());
+    }
+
+    // 只替换烘焙范围内的关键帧，保留Section的其它内容和范围
+    FBatchInsertKeyframesSettings Settings;
+    Settings.FramePadding = 1;
+    Settings.FrameWindow = FAnimationFrameWindow(
+        StartFrame, StartFrame + WorldTransforms.Num() - 1);
+    UInstrumentAnimationUtility::BatchInsertControlRigKeys(
+        LevelSequence, ControlRigInstance, ControlKeyframeData, Settings);
+
+    LevelSequence->MarkPackageDirty();
+    return true;
+}
+}  // namespace StringFlowTransformSyncHelper
+#endif
+
 bool UStringFlowTransformSyncProcessor::SyncAllInstrumentTransforms(
     AStringFlowUnreal* StringFlowActor) {
     if (!StringFlowActor) {
@@ -18,43 +195,184 @@ bool UStringFlowTransformSyncProcessor::SyncAllInstrumentTransforms(
         return true;
     }
 
-    bool bStringSuccess = SyncStringInstrumentTransform(StringFlowActor);
-    bool bBowSuccess = SyncBowTransform(StringFlowActor);
+    FInstrumentSyncFrameContext Context;
+    Context.Initialize();
 
-    return bStringSuccess && bBowSuccess;
+    FStringFlowRealtimeSyncData SyncData;
+    GatherRealtimeSync(StringFlowActor, Context, SyncData);
+    ComputeRealtimeSync(SyncData);
+    return ApplyRealtimeSync(StringFlowActor, SyncData);
 }
 
-bool UStringFlowTransformSyncProcessor::SyncStringInstrumentTransform(
-    AStringFlowUnreal* StringFlowActor) {
-    if (!StringFlowActor) {
-        UE_LOG(LogTemp, Error,
-               TEXT("SyncStringInstrumentTransform: StringFlowActor is null"));
-        return false;
+void UStringFlowTransformSyncProcessor::GatherRealtimeSync(
+    AStringFlowUnreal* StringFlowActor,
+    const FInstrumentSyncFrameContext& Context,
+    FStringFlowRealtimeSyncData& SyncData) {
+    SyncData.Reset();
+
+    if (!StringFlowActor || !StringFlowActor->bEnableRealtimeSync) {
+        return;
     }
 
-    // 如果禁用实时同步，直接返回，避免任何日志
-    if (!StringFlowActor->bEnableRealtimeSync) {
+    ASkeletalMeshActor* Performer = StringFlowActor->SkeletalMeshActor;
+    UControlRig* PerformerControlRig = Context.FindControlRig(Performer);
+    URigHierarchy* PerformerHierarchy =
+        PerformerControlRig ? PerformerControlRig->GetHierarchy() : nullptr;
+    if (!PerformerHierarchy) {
+        return;
+    }
+
+    // ========== 小提琴 =========
+    ASkeletalMeshActor* StringInstrument = StringFlowActor->StringInstrument;
+    UControlRig* InstrumentControlRig =
+        Context.FindControlRig(StringInstrument);
+    if (InstrumentControlRig && InstrumentControlRig->GetHierarchy() &&
+        EnsureStringInstrumentRelationship(StringFlowActor)) {
+        const int32 ControllerRootIndex = PerformerHierarchy->GetIndex(
+            FRigElementKey(TEXT("controller_root"), ERigElementType::Control));
+        const int32 ViolinRootIndex =
+            InstrumentControlRig->GetHierarchy()->GetIndex(
+                FRigElementKey(TEXT("violin_root"), ERigElementType::Control));
+
+        if (ControllerRootIndex != INDEX_NONE &&
+            ViolinRootIndex != INDEX_NONE) {
+            SyncData.InstrumentControlRig = InstrumentControlRig;
+            SyncData.ViolinRootIndex = ViolinRootIndex;
+            SyncData.RelativeTransform =
+                StringFlowActor->CachedStringInstrumentRelativeTransform;
+            SyncData.ControllerRootGlobalTransform =
+                PerformerHierarchy->GetGlobalTransform(ControllerRootIndex);
+            SyncData.PerformerActorTransform = Performer->GetActorTransform();
+            SyncData.InstrumentActorTransform =
+                StringInstrument->GetActorTransform();
+            SyncData.bHasViolinInput = true;
+        } else {
+            UE_LOG(LogTemp, Warning,
+                   TEXT("GatherRealtimeSync: controller_root or violin_root "
+                        "not found"));
+        }
+    }
+
+    // ========== 琴弓 =========
+    ASkeletalMeshActor* Bow = StringFlowActor->Bow;
+    UControlRig* BowControlRig = Context.FindControlRig(Bow);
+    if (BowControlRig && BowControlRig->GetHierarchy()) {
+        const int32 BowControllerIndex = PerformerHierarchy->GetIndex(
+            FRigElementKey(TEXT("bow_controller"), ERigElementType::Control));
+        const int32 StringTouchPointIndex = PerformerHierarchy->GetIndex(
+            FRigElementKey(TEXT("string_touch_point"),
+                           ERigElementType::Control));
+        const int32 BowCtrlIndex = BowControlRig->GetHierarchy()->GetIndex(
+            FRigElementKey(TEXT("bow_ctrl"), ERigElementType::Control));
+
+        if (BowControllerIndex != INDEX_NONE &&
+            StringTouchPointIndex != INDEX_NONE &&
+            BowCtrlIndex != INDEX_NONE) {
+            SyncData.BowControlRig = BowControlRig;
+            SyncData.BowCtrlIndex = BowCtrlIndex;
+            SyncData.BowControllerGlobalTransform =
+                PerformerHierarchy->GetGlobalTransform(BowControllerIndex);
+            SyncData.StringTouchPointGlobalTransform =
+                PerformerHierarchy->GetGlobalTransform(StringTouchPointIndex);
+            SyncData.PerformerActorTransform = Performer->GetActorTransform();
+            SyncData.BowActorTransform = Bow->GetActorTransform();
+            SyncData.BowAxisTowardString = StringFlowActor->BowAxisTowardString;
+            SyncData.bHasBowInput = true;
+        } else {
+            UE_LOG(LogTemp, Warning,
+                   TEXT("GatherRealtimeSync: bow_controller, "
+                        "string_touch_point or bow_ctrl not found"));
+        }
+    }
+}
+
+void UStringFlowTransformSyncProcessor::ComputeRealtimeSync(
+    FStringFlowRealtimeSyncData& SyncData) {
+    // 与 UpdateChildControlFromParent 相同：
+    // 子 Control 新世界变换 = 相对变换 × 父 Control 当前世界变换
+    if (SyncData.bHasViolinInput) {
+        const FTransform ControllerRootWorldTransform =
+            SyncData.ControllerRootGlobalTransform *
+            SyncData.PerformerActorTransform;
+        const FTransform ViolinRootWorldTransform =
+            SyncData.RelativeTransform * ControllerRootWorldTransform;
+        SyncData.ViolinRootGlobalTransform =
+            ViolinRootWorldTransform.GetRelativeTransform(
+                SyncData.InstrumentActorTransform);
+        SyncData.bViolinReady = true;
+    }
+
+    // 与 SetControlRigWorldTransform 相同：忽略缩放，转换到琴弓Actor空间
+    if (SyncData.bHasBowInput) {
+        FTransform BowWorldTransform;
+        if (ComputeBowWorldTransform(
+                SyncData.BowControllerGlobalTransform *
+                    SyncData.PerformerActorTransform,
+                (SyncData.StringTouchPointGlobalTransform *
+                 SyncData.PerformerActorTransform)
+                    .GetLocation(),
+                SyncData.BowAxisTowardString, BowWorldTransform)) {
+            const FTransform BowLocalTransform =
+                BowWorldTransform.GetRelativeTransform(
+                    SyncData.BowActorTransform);
+            SyncData.BowCtrlLocalTransform =
+                FTransform(BowLocalTransform.GetRotation(),
+                           BowLocalTransform.GetLocation(), FVector::OneVector);
+            SyncData.bBowReady = true;
+        }
+    }
+}
+
+bool UStringFlowTransformSyncProcessor::ApplyRealtimeSync(
+    AStringFlowUnreal* StringFlowActor,
+    const FStringFlowRealtimeSyncData& SyncData) {
+    if (!StringFlowActor || !StringFlowActor->bEnableRealtimeSync) {
         return true;
     }
 
-    if (!StringFlowActor->StringInstrument) {
-        return false;
+    auto RefreshSkeletalMesh = [](ASkeletalMeshActor* Actor) {
+        if (USkeletalMeshComponent* SkelMeshComp =
+                Actor ? Actor->GetSkeletalMeshComponent() : nullptr) {
+            SkelMeshComp->RefreshBoneTransforms();
+            SkelMeshComp->MarkRenderTransformDirty();
+            SkelMeshComp->MarkRenderStateDirty();
+        }
+    };
+
+    if (SyncData.bViolinReady) {
+        UControlRig* ControlRig = SyncData.InstrumentControlRig;
+        ControlRig->GetHierarchy()->SetGlobalTransform(
+            SyncData.ViolinRootIndex, SyncData.ViolinRootGlobalTransform);
+        // 小提琴和琴弓共用一个 Control Rig 时在写完琴弓后统一求值
+        if (ControlRig != SyncData.BowControlRig || !SyncData.bBowReady) {
+            ControlRig->Evaluate_AnyThread();
+            RefreshSkeletalMesh(StringFlowActor->StringInstrument);
+        }
     }
 
-    // ========== 检测初始化值是否改变 =========
-    TArray<FTransform> NewValues;
-    bool bValuesChanged = FInstrumentControlRigUtility::HasInitializationValuesChanged(
-        StringFlowActor->SkeletalMeshActor, TEXT("controller_root"),
-        StringFlowActor->StringInstrument, TEXT("violin_root"),
-        StringFlowActor->CachedInitializationValues, NewValues);
+    if (SyncData.bBowReady) {
+        UControlRig* ControlRig = SyncData.BowControlRig;
+        ControlRig->GetHierarchy()->SetLocalTransform(
+            SyncData.BowCtrlIndex, SyncData.BowCtrlLocalTransform);
+        ControlRig->Evaluate_AnyThread();
+        RefreshSkeletalMesh(StringFlowActor->Bow);
+    }
+
+    const bool bViolinSuccess =
+        !StringFlowActor->StringInstrument || SyncData.bViolinReady;
+    const bool bBowSuccess = !StringFlowActor->Bow || SyncData.bBowReady;
+    return bViolinSuccess && bBowSuccess;
+}
 
-    // 如果初始化值改变，标记需要重新初始化
-    if (bValuesChanged) {
+bool UStringFlowTransformSyncProcessor::EnsureStringInstrumentRelationship(
+    AStringFlowUnreal* StringFlowActor) {
+    // ========== 检测相对变换缓存是否失效 =========
+    // 层级修改和Actor变换变化由事件累加版本号，这里只比较几个整数，
+    // 不再每次查找 Control Rig 读取初始变换
+    const FStringFlowSyncSetupVersion SetupVersion =
+        StringFlowActor->GetTransformSyncSetupVersion();
+    if (SetupVersion != StringFlowActor->CachedTransformSyncSetupVersion) {
         StringFlowActor->bStringInstrumentRelativeTransformInitialized = false;
-        StringFlowActor->CachedInitializationValues = NewValues;
-        UE_LOG(LogTemp, Warning,
-               TEXT("SyncStringInstrumentTransform: Initialization values "
-                    "changed, will reinitialize cache"));
     }
 
     // ========== 第一次初始化或值改变后重新初始化：计算并缓存相对变换矩阵 =========
@@ -69,14 +387,38 @@ bool UStringFlowTransformSyncProcessor::SyncStringInstrumentTransform(
             return false;
         }
 
-        // 更新缓存的初始化值
-        StringFlowActor->CachedInitializationValues = NewValues;
+        // 记录本次初始化对应的版本
+        StringFlowActor->CachedTransformSyncSetupVersion = SetupVersion;
         StringFlowActor->bStringInstrumentRelativeTransformInitialized = true;
         UE_LOG(LogTemp, Warning,
                TEXT("SyncStringInstrumentTransform: Control relationship "
                     "initialized and cached"));
     }
 
+    return true;
+}
+
+bool UStringFlowTransformSyncProcessor::SyncStringInstrumentTransform(
+    AStringFlowUnreal* StringFlowActor) {
+    if (!StringFlowActor) {
+        UE_LOG(LogTemp, Error,
+               TEXT("SyncStringInstrumentTransform: StringFlowActor is null"));
+        return false;
+    }
+
+    // 如果禁用实时同步，直接返回，避免任何日志
+    if (!StringFlowActor->bEnableRealtimeSync) {
+        return true;
+    }
+
+    if (!StringFlowActor->StringInstrument) {
+        return false;
+    }
+
+    if (!EnsureStringInstrumentRelationship(StringFlowActor)) {
+        return false;
+    }
+
     // ========== 每帧更新：使用缓存的相对变换矩阵快速更新 =========
     return FInstrumentControlRigUtility::UpdateChildControlFromParent(
         StringFlowActor->SkeletalMeshActor, TEXT("controller_root"),
@@ -112,8 +454,6 @@ bool UStringFlowTransformSyncProcessor::SyncBowTransform(
         return false;
     }
 
-    FVector BowPosition = BowControllerTransform.GetLocation();
-
     // 从人物身上获取琴弓朝向源：string_touch_point
     FTransform StringTouchPointTransform;
     if (!FInstrumentControlRigUtility::GetControlRigControlWorldTransform(
@@ -125,26 +465,50 @@ bool UStringFlowTransformSyncProcessor::SyncBowTransform(
         return false;
     }
 
-    FVector StringTouchPointPosition = StringTouchPointTransform.GetLocation();
+    // ========== 计算琴弓的目标变换 =========
+    FTransform TargetBowTransform;
+    if (!ComputeBowWorldTransform(BowControllerTransform,
+                                  StringTouchPointTransform.GetLocation(),
+                                  StringFlowActor->BowAxisTowardString,
+                                  TargetBowTransform)) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("SyncBowTransform: BowAxisTowardString is zero"));
+        return false;
+    }
+
+    // 变换已变化，更新琴弓：应用位置和旋转
+    if (!FInstrumentControlRigUtility::SetControlRigWorldTransform(
+            StringFlowActor->Bow, TEXT("bow_ctrl"),
+            TargetBowTransform.GetLocation(),
+            TargetBowTransform.GetRotation())) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("SyncBowTransform: Failed to set bow_ctrl transform"));
+        return false;
+    }
+
+    return true;
+}
+
+bool UStringFlowTransformSyncProcessor::ComputeBowWorldTransform(
+    const FTransform& BowControllerWorldTransform,
+    const FVector& StringTouchPointWorldLocation,
+    const FVector& BowAxisTowardString, FTransform& OutBowWorldTransform) {
+    const FVector BowPosition = BowControllerWorldTransform.GetLocation();
 
-    // ========== 计算琴弓的目标旋转 =========
     // 计算琴弓应该指向的方向
     FVector DirectionToString =
-        (StringTouchPointPosition - BowPosition).GetSafeNormal();
+        (StringTouchPointWorldLocation - BowPosition).GetSafeNormal();
 
     // 获取琴弓当前的旋转（从 bow_controller）
-    FQuat CurrentBowRotation = BowControllerTransform.GetRotation();
+    FQuat CurrentBowRotation = BowControllerWorldTransform.GetRotation();
 
     // 获取琴弓在其自身坐标系中的"指向"轴方向
     // BowAxisTowardString
     // 应该是一个单位向量，表示琴弓在局部坐标系中应该指向的轴 例如：(1,0,0) 表示
     // X 轴，(0,1,0) 表示 Y 轴
-    FVector LocalForwardAxis =
-        StringFlowActor->BowAxisTowardString.GetSafeNormal();
+    FVector LocalForwardAxis = BowAxisTowardString.GetSafeNormal();
 
     if (LocalForwardAxis.IsNearlyZero()) {
-        UE_LOG(LogTemp, Warning,
-               TEXT("SyncBowTransform: BowAxisTowardString is zero"));
         return false;
     }
 
@@ -160,20 +524,210 @@ bool UStringFlowTransformSyncProcessor::SyncBowTransform(
     // 目标旋转 = 增量旋转 × 当前旋转
     FQuat TargetRotation = DeltaRotation * CurrentBowRotation;
 
-    // 构建目标变换（包含位置和旋转）
-    FTransform TargetBowTransform(TargetRotation, BowPosition,
-                                  FVector(1.0f, 1.0f, 1.0f));
+    OutBowWorldTransform =
+        FTransform(TargetRotation, BowPosition, FVector(1.0f, 1.0f, 1.0f));
+    return true;
+}
+
+bool UStringFlowTransformSyncProcessor::BakeInstrumentTransforms(
+    AStringFlowUnreal* StringFlowActor) {
+    if (!StringFlowActor) {
+        UE_LOG(LogTemp, Error,
+               TEXT("BakeInstrumentTransforms: StringFlowActor is null"));
+        return false;
+    }
 
-    // 变换已变化，更新琴弓：应用位置和旋转
-    if (!FInstrumentControlRigUtility::SetControlRigWorldTransform(
-            StringFlowActor->Bow, TEXT("bow_ctrl"), BowPosition,
-            TargetRotation)) {
+    if (!StringFlowActor->SkeletalMeshActor) {
+        UE_LOG(LogTemp, Error,
+               TEXT("BakeInstrumentTransforms: SkeletalMeshActor is not "
+                    "assigned"));
+        return false;
+    }
+
+    if (!StringFlowActor->StringInstrument && !StringFlowActor->Bow) {
         UE_LOG(LogTemp, Warning,
-               TEXT("SyncBowTransform: Failed to set bow_ctrl transform"));
+               TEXT("BakeInstrumentTransforms: Neither StringInstrument nor "
+                    "Bow is assigned, nothing to bake"));
         return false;
     }
 
-    return true;
+#if WITH_EDITOR
+    using namespace StringFlowTransformSyncHelper;
+
+    const double StartTime = FPlatformTime::Seconds();
+
+    // ========== 1. 在演奏者的 Section 上准备采样器 =========
+    FControlChannelSampler ControllerRootSampler;
+    FControlChannelSampler BowControllerSampler;
+    FControlChannelSampler StringTouchPointSampler;
+    bool bBakeViolin = false;
+    bool bBakeBow = false;
+    int32 StartFrame = 0;
+    int32 EndFrame = -1;
+    FFrameRate TickResolution;
+    FFrameRate DisplayRate;
+    {
+        FScopedTakeSequenceGeneration TakeScope(
+            StringFlowActor->bUseTakeSequences,
+            StringFlowActor->SkeletalMeshActor, TEXT("Performer"));
+
+        ULevelSequence* LevelSequence = nullptr;
+        TSharedPtr<ISequencer> Sequencer = nullptr;
+        if (!UInstrumentAnimationUtility::GetActiveLevelSequenceAndSequencer(
+                LevelSequence, Sequencer)) {
+            UE_LOG(LogTemp, Error, TEXT("请确保已打开Level Sequence"));
+            return false;
+        }
+
+        UControlRig* PerformerControlRig = nullptr;
+        UControlRigBlueprint* PerformerControlRigBlueprint = nullptr;
+        if (!FInstrumentControlRigUtility::GetControlRigFromSkeletalMeshActor(
+                StringFlowActor->SkeletalMeshActor, PerformerControlRig,
+                PerformerControlRigBlueprint)) {
+            UE_LOG(LogTemp, Error,
+                   TEXT("BakeInstrumentTransforms: Failed to get performer "
+                        "Control Rig"));
+            return false;
+        }
+
+        UMovieSceneSection* Section =
+            FInstrumentGenerationCache::FindControlRigSection(
+                LevelSequence, PerformerControlRig);
+        if (!Section || !Section->HasStartFrame() || !Section->HasEndFrame()) {
+            UE_LOG(LogTemp, Warning,
+                   TEXT("BakeInstrumentTransforms: Performer section has no "
+                        "bounded range"));
+            return false;
+        }
+
+        UMovieScene* MovieScene = LevelSequence->GetMovieScene();
+        TickResolution = MovieScene->GetTickResolution();
+        DisplayRate = MovieScene->GetDisplayRate();
+
+        // Section 范围（Tick）-> 显示帧
+        StartFrame = FFrameRate::TransformTime(
+                         FFrameTime(Section->GetInclusiveStartFrame()),
+                         TickResolution, DisplayRate)
+                         .CeilToFrame()
+                         .Value;
+        EndFrame = FFrameRate::TransformTime(
+                       FFrameTime(Section->GetExclusiveEndFrame() - 1),
+                       TickResolution, DisplayRate)
+                       .FloorToFrame()
+                       .Value;
+
+        // 局部重新生成时只烘焙窗口内的帧
+        const FAnimationFrameWindow& Window =
+            StringFlowActor->RegenerationWindow;
+        if (Window.IsSet()) {
+            StartFrame = FMath::Max(StartFrame, Window.StartFrame);
+            EndFrame = FMath::Min(EndFrame, Window.EndFrame);
+        }
+
+        URigHierarchy* Hierarchy = PerformerControlRig->GetHierarchy();
+        bBakeViolin = StringFlowActor->StringInstrument &&
+                      ControllerRootSampler.Initialize(
+                          Hierarchy, Section, TEXT("controller_root"));
+        bBakeBow = StringFlowActor->Bow &&
+                   BowControllerSampler.Initialize(Hierarchy, Section,
+                                                   TEXT("bow_controller")) &&
+                   StringTouchPointSampler.Initialize(
+                       Hierarchy, Section, TEXT("string_touch_point"));
+    }
+
+    if (EndFrame < StartFrame) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("BakeInstrumentTransforms: Empty frame range [%d, %d]"),
+               StartFrame, EndFrame);
+        return false;
+    }
+
+    // ========== 2. 小提琴的相对变换（与实时同步相同） =========
+    FTransform ViolinRelativeTransform = FTransform::Identity;
+    if (bBakeViolin &&
+        !FInstrumentControlRigUtility::InitializeControlRelationship(
+            StringFlowActor->SkeletalMeshActor, TEXT("controller_root"),
+            StringFlowActor->StringInstrument, TEXT("violin_root"),
+            ViolinRelativeTransform)) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("BakeInstrumentTransforms: Failed to initialize violin "
+                    "relationship, skipping violin"));
+        bBakeViolin = false;
+    }
+
+    if (!bBakeViolin && !bBakeBow) {
+        UE_LOG(LogTemp, Warning,
+               TEXT("BakeInstrumentTransforms: Nothing to bake"));
+        return false;
+    }
+
+    // ========== 3. 按帧并行计算世界变换 =========
+    const int32 NumFrames = EndFrame - StartFrame + 1;
+    const FTransform PerformerWorldTransform =
+        StringFlowActor->SkeletalMeshActor->GetActorTransform();
+    const FVector BowAxisTowardString = StringFlowActor->BowAxisTowardString;
+
+    TArray<FTransform> ViolinWorldTransforms;
+    TArray<FTransform> BowWorldTransforms;
+    if (bBakeViolin) {
+        ViolinWorldTransforms.SetNumUninitialized(NumFrames);
+    }
+    if (bBakeBow) {
+        BowWorldTransforms.SetNumUninitialized(NumFrames);
+    }
+
+    ParallelFor(NumFrames, [&](int32 Index) {
+        const FFrameTime Time = FFrameRate::TransformTime(
+            FFrameTime(FFrameNumber(StartFrame + Index)), DisplayRate,
+            TickResolution);
+
+        if (bBakeViolin) {
+            const FTransform ControllerRootWorld =
+                ControllerRootSampler.Evaluate(Time) * PerformerWorldTransform;
+            ViolinWorldTransforms[Index] =
+                ViolinRelativeTransform * ControllerRootWorld;
+        }
+
+        if (bBakeBow) {
+            const FTransform BowControllerWorld =
+                BowControllerSampler.Evaluate(Time) * PerformerWorldTransform;
+            const FTransform StringTouchPointWorld =
+                StringTouchPointSampler.Evaluate(Time) *
+                PerformerWorldTransform;
+            if (!ComputeBowWorldTransform(
+                    BowControllerWorld, StringTouchPointWorld.GetLocation(),
+                    BowAxisTowardString, BowWorldTransforms[Index])) {
+                BowWorldTransforms[Index] = BowControllerWorld;
+            }
+        }
+    });
+
+    // ========== 4. 写入关键帧 =========
+    bool bViolinBaked = false;
+    bool bBowBaked = false;
+    if (bBakeViolin) {
+        bViolinBaked = WriteBakedControlKeys(
+            StringFlowActor, StringFlowActor->StringInstrument,
+            TEXT("violin_root"), TEXT("Strings"), true, StartFrame,
+            ViolinWorldTransforms);
+    }
+    if (bBakeBow) {
+        bBowBaked = WriteBakedControlKeys(
+            StringFlowActor, StringFlowActor->Bow, TEXT("bow_ctrl"),
+            TEXT("Bow"), false, StartFrame, BowWorldTransforms);
+    }
+
+    UE_LOG(LogTemp, Warning,
+           TEXT("BakeInstrumentTransforms: Baked frames [%d, %d] (violin: "
+                "%s, bow: %s) in %.1f ms"),
+           StartFrame, EndFrame, bViolinBaked ? TEXT("yes") : TEXT("no"),
+           bBowBaked ? TEXT("yes") : TEXT("no"),
+           (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+    return bViolinBaked || bBowBaked;
+#else
+    return false;
+#endif
 }
 
 bool UStringFlowTransformSyncProcessor::GetBoneTransform(
@@ -16,6 +16,10 @@
 #include "Engine/StaticMeshActor.h"
 #include "Engine/World.h"
 #include "EngineUtils.h"
+#include "ISequencer.h"
+#include "ISequencerModule.h"
+#include "Common/Public/InstrumentControlRigUtility.h"
+#include "LevelEditorSequencerIntegration.h"
 #include "LevelSequenceActor.h"
 #include "Serialization/JsonReader.h"
 #include "Serialization/JsonSerializer.h"
@@ -37,26 +41,132 @@ AStringFlowUnreal::AStringFlowUnreal() {
     CachedStringInstrumentRelativeTransform = FTransform::Identity;
     bStringInstrumentRelativeTransformInitialized = false;
 
-    // 初始化缓存的初始化值数组，共4个元素
-    CachedInitializationValues.SetNum(4);
-    for (int32 i = 0; i < 4; ++i) {
-        CachedInitializationValues[i] = FTransform::Identity;
-    }
-
     InitializeControllersAndRecorders();
 }
 
 // Called when the game starts or when spawned
 void AStringFlowUnreal::BeginPlay() { Super::BeginPlay(); }
 
-// Called every frame
-void AStringFlowUnreal::Tick(float DeltaTime) {
-    Super::Tick(DeltaTime);
+// ========== 实时同步 ==========
 
-    // 仅当启用实时同步时才同步弦乐器和琴弓的位置/旋转
-    if (bEnableRealtimeSync) {
-        UStringFlowTransformSyncProcessor::SyncAllInstrumentTransforms(this);
+bool AStringFlowUnreal::NeedsRealtimeSync() const {
+    if (!bEnableRealtimeSync) {
+        return false;
+    }
+
+    // 编辑器中只在事件标记了变化后同步；游戏世界没有编辑器事件，每帧同步
+    const UWorld* World = GetWorld();
+    return bTransformSyncDirty || (World && World->IsGameWorld());
+}
+
+void AStringFlowUnreal::GatherRealtimeSync(
+    const FInstrumentSyncFrameContext& Context) {
+    UStringFlowTransformSyncProcessor::GatherRealtimeSync(this, Context,
+                                                          RealtimeSyncData);
+}
+
+void AStringFlowUnreal::ComputeRealtimeSync() {
+    UStringFlowTransformSyncProcessor::ComputeRealtimeSync(RealtimeSyncData);
+}
+
+void AStringFlowUnreal::ApplyRealtimeSync() {
+    UStringFlowTransformSyncProcessor::ApplyRealtimeSync(this,
+                                                         RealtimeSyncData);
+    RealtimeSyncData.Reset();
+
+    // 同步完成后再清除标记，忽略同步自身写入引起的通知
+    bTransformSyncDirty = false;
+}
+
+void AStringFlowUnreal::PostRegisterAllComponents() {
+    Super::PostRegisterAllComponents();
+
+#if WITH_EDITOR
+    if (!HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject)) {
+        BindTransformSyncEvents();
+    }
+#endif
+    if (!HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject)) {
+        RefreshBoundSceneComponents();
+    }
+    MarkTransformSyncDirty();
+}
+
+void AStringFlowUnreal::PostUnregisterAllComponents() {
+#if WITH_EDITOR
+    UnbindTransformSyncEvents();
+#endif
+    UnbindSceneComponents();
+    Super::PostUnregisterAllComponents();
+}
+
+void AStringFlowUnreal::BeginDestroy() {
+#if WITH_EDITOR
+    UnbindTransformSyncEvents();
+#endif
+    UnbindSceneComponents();
+    Super::BeginDestroy();
+}
+
+// ========== 相对变换缓存版本 ==========
+
+FStringFlowSyncSetupVersion AStringFlowUnreal::GetTransformSyncSetupVersion()
+    const {
+    FStringFlowSyncSetupVersion Version;
+    Version.EventVersion = TransformSyncSetupEventVersion;
+    if (const URigHierarchy* Hierarchy = BoundHierarchy.Get()) {
+        Version.PerformerTopologyVersion = Hierarchy->GetTopologyVersion();
     }
+    if (const URigHierarchy* Hierarchy = BoundInstrumentHierarchy.Get()) {
+        Version.InstrumentTopologyVersion = Hierarchy->GetTopologyVersion();
+    }
+    return Version;
+}
+
+void AStringFlowUnreal::RefreshBoundSceneComponents() {
+    USceneComponent* PerformerRoot =
+        SkeletalMeshActor ? SkeletalMeshActor->GetRootComponent() : nullptr;
+    USceneComponent* InstrumentRoot =
+        StringInstrument ? StringInstrument->GetRootComponent() : nullptr;
+
+    if (PerformerRoot == BoundPerformerRoot.Get() &&
+        InstrumentRoot == BoundInstrumentRoot.Get()) {
+        return;
+    }
+
+    UnbindSceneComponents();
+
+    if (PerformerRoot) {
+        PerformerRoot->TransformUpdated.AddUObject(
+            this, &AStringFlowUnreal::HandleSetupTransformUpdated);
+        BoundPerformerRoot = PerformerRoot;
+    }
+    // 演奏者和乐器可能是同一个Actor
+    if (InstrumentRoot && InstrumentRoot != PerformerRoot) {
+        InstrumentRoot->TransformUpdated.AddUObject(
+            this, &AStringFlowUnreal::HandleSetupTransformUpdated);
+    }
+    BoundInstrumentRoot = InstrumentRoot;
+
+    InvalidateTransformSyncSetup();
+}
+
+void AStringFlowUnreal::UnbindSceneComponents() {
+    if (USceneComponent* PerformerRoot = BoundPerformerRoot.Get()) {
+        PerformerRoot->TransformUpdated.RemoveAll(this);
+    }
+    if (USceneComponent* InstrumentRoot = BoundInstrumentRoot.Get()) {
+        InstrumentRoot->TransformUpdated.RemoveAll(this);
+    }
+    BoundPerformerRoot.Reset();
+    BoundInstrumentRoot.Reset();
+}
+
+void AStringFlowUnreal::HandleSetupTransformUpdated(
+    USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags,
+    ETeleportType Teleport) {
+    // 演奏者或乐器的Actor变换参与相对变换的计算
+    InvalidateTransformSyncSetup();
 }
 
 #if WITH_EDITOR
@@ -70,6 +180,14 @@ void AStringFlowUnreal::PostEditChangeProperty(
 
     const FString PropertyName = PropertyChangedEvent.Property->GetName();
 
+    // 演奏者或乐器变化后改为订阅新的 Control Rig 和根组件
+    if (PropertyName == TEXT("SkeletalMeshActor") ||
+        PropertyName == TEXT("StringInstrument")) {
+        RefreshBoundControlRig();
+        RefreshBoundSceneComponents();
+        InvalidateTransformSyncSetup();
+    }
+
     // 当相关属性改变时，如果启用了实时同步，立即同步
     if (bEnableRealtimeSync && (PropertyName == TEXT("StringInstrument") ||
                                 PropertyName == TEXT("Bow") ||
@@ -79,8 +197,220 @@ void AStringFlowUnreal::PostEditChangeProperty(
         UStringFlowTransformSyncProcessor::SyncAllInstrumentTransforms(this);
     }
 }
+
+// ========== 变换同步事件订阅 ==========
+
+void AStringFlowUnreal::BindTransformSyncEvents() {
+    if (bTransformSyncEventsBound) {
+        return;
+    }
+    bTransformSyncEventsBound = true;
+
+    if (GEngine) {
+        GEngine->OnActorMoved().AddUObject(this,
+                                           &AStringFlowUnreal::HandleActorMoved);
+    }
+
+    ISequencerModule& SequencerModule =
+        FModuleManager::LoadModuleChecked<ISequencerModule>(TEXT("Sequencer"));
+    OnSequencerCreatedHandle = SequencerModule.RegisterOnSequencerCreated(
+        FOnSequencerCreated::FDelegate::CreateUObject(
+            this, &AStringFlowUnreal::HandleSequencerCreated));
+
+    // 已经打开的 Sequencer
+    if (FModuleManager::Get().IsModuleLoaded(TEXT("LevelEditor"))) {
+        for (const TWeakPtr<ISequencer>& WeakSequencer :
+             FLevelEditorSequencerIntegration::Get().GetSequencers()) {
+            if (TSharedPtr<ISequencer> Sequencer = WeakSequencer.Pin()) {
+                BindSequencer(Sequencer.ToSharedRef());
+            }
+        }
+    }
+
+    RefreshBoundControlRig();
+}
+
+void AStringFlowUnreal::UnbindTransformSyncEvents() {
+    if (!bTransformSyncEventsBound) {
+        return;
+    }
+    bTransformSyncEventsBound = false;
+
+    if (GEngine) {
+        GEngine->OnActorMoved().RemoveAll(this);
+    }
+
+    if (ISequencerModule* SequencerModule =
+            FModuleManager::GetModulePtr<ISequencerModule>(TEXT("Sequencer"))) {
+        SequencerModule->UnregisterOnSequencerCreated(OnSequencerCreatedHandle);
+    }
+    OnSequencerCreatedHandle.Reset();
+
+    for (const TWeakPtr<ISequencer>& WeakSequencer : BoundSequencers) {
+        if (TSharedPtr<ISequencer> Sequencer = WeakSequencer.Pin()) {
+            Sequencer->OnGlobalTimeChanged().RemoveAll(this);
+            Sequencer->OnMovieSceneDataChanged().RemoveAll(this);
+        }
+    }
+    BoundSequencers.Reset();
+
+    if (UControlRig* ControlRig = BoundControlRig.Get()) {
+        ControlRig->ControlModified().RemoveAll(this);
+    }
+    if (URigHierarchy* Hierarchy = BoundHierarchy.Get()) {
+        Hierarchy->OnModified().RemoveAll(this);
+    }
+    if (URigHierarchy* Hierarchy = BoundInstrumentHierarchy.Get()) {
+        Hierarchy->OnModified().RemoveAll(this);
+    }
+    BoundControlRig.Reset();
+    BoundHierarchy.Reset();
+    BoundInstrumentHierarchy.Reset();
+}
+
+void AStringFlowUnreal::BindSequencer(TSharedRef<ISequencer> Sequencer) {
+    BoundSequencers.RemoveAll([](const TWeakPtr<ISequencer>& WeakSequencer) {
+        return !WeakSequencer.IsValid();
+    });
+
+    for (const TWeakPtr<ISequencer>& WeakSequencer : BoundSequencers) {
+        if (WeakSequencer.Pin() == Sequencer) {
+            return;
+        }
+    }
+
+    Sequencer->OnGlobalTimeChanged().AddUObject(
+        this, &AStringFlowUnreal::HandleSequencerTimeChanged);
+    Sequencer->OnMovieSceneDataChanged().AddUObject(
+        this, &AStringFlowUnreal::HandleMovieSceneDataChanged);
+    BoundSequencers.Add(Sequencer);
+}
+
+void AStringFlowUnreal::RefreshBoundControlRig() {
+    // 没有打开的 Sequencer 时不会有绑定的 Control Rig，也避免查找时的警告
+    UControlRig* ControlRig = nullptr;
+    UControlRigBlueprint* ControlRigBlueprint = nullptr;
+    UControlRig* InstrumentControlRig = nullptr;
+    if (BoundSequencers.Num() > 0) {
+        if (SkeletalMeshActor) {
+            FInstrumentControlRigUtility::GetControlRigFromSkeletalMeshActor(
+                SkeletalMeshActor, ControlRig, ControlRigBlueprint);
+        }
+        if (StringInstrument) {
+            UControlRigBlueprint* InstrumentBlueprint = nullptr;
+            FInstrumentControlRigUtility::GetControlRigFromSkeletalMeshActor(
+                StringInstrument, InstrumentControlRig, InstrumentBlueprint);
+        }
+    }
+
+    // 乐器的层级只用于相对变换缓存的失效判断
+    URigHierarchy* InstrumentHierarchy =
+        InstrumentControlRig ? InstrumentControlRig->GetHierarchy() : nullptr;
+    if (InstrumentHierarchy != BoundInstrumentHierarchy.Get()) {
+        if (URigHierarchy* OldHierarchy = BoundInstrumentHierarchy.Get()) {
+            OldHierarchy->OnModified().RemoveAll(this);
+        }
+        BoundInstrumentHierarchy.Reset();
+        if (InstrumentHierarchy) {
+            InstrumentHierarchy->OnModified().AddUObject(
+                this, &AStringFlowUnreal::HandleHierarchyModified);
+            BoundInstrumentHierarchy = InstrumentHierarchy;
+        }
+        InvalidateTransformSyncSetup();
+    }
+
+    if (ControlRig == BoundControlRig.Get()) {
+        return;
+    }
+
+    if (UControlRig* OldControlRig = BoundControlRig.Get()) {
+        OldControlRig->ControlModified().RemoveAll(this);
+    }
+    if (URigHierarchy* OldHierarchy = BoundHierarchy.Get()) {
+        OldHierarchy->OnModified().RemoveAll(this);
+    }
+    BoundControlRig.Reset();
+    BoundHierarchy.Reset();
+
+    if (ControlRig) {
+        ControlRig->ControlModified().AddUObject(
+            this, &AStringFlowUnreal::HandleControlModified);
+        BoundControlRig = ControlRig;
+
+        if (URigHierarchy* Hierarchy = ControlRig->GetHierarchy()) {
+            Hierarchy->OnModified().AddUObject(
+                this, &AStringFlowUnreal::HandleHierarchyModified);
+            BoundHierarchy = Hierarchy;
+        }
+    }
+
+    InvalidateTransformSyncSetup();
+}
+
+void AStringFlowUnreal::HandleSequencerCreated(
+    TSharedRef<ISequencer> Sequencer) {
+    BindSequencer(Sequencer);
+    MarkTransformSyncDirty();
+}
+
+void AStringFlowUnreal::HandleSequencerTimeChanged() {
+    // Sequencer打开后才会实例化 Control Rig，未订阅时在这里补上
+    if (!BoundControlRig.IsValid() ||
+        (StringInstrument && !BoundInstrumentHierarchy.IsValid())) {
+        RefreshBoundControlRig();
+    }
+    MarkTransformSyncDirty();
+}
+
+void AStringFlowUnreal::HandleMovieSceneDataChanged(
+    EMovieSceneDataChangeType DataChangeType) {
+    // 结构变化（增删轨道、切换序列）可能替换 Control Rig 实例
+    if (DataChangeType != EMovieSceneDataChangeType::TrackValueChanged &&
+        DataChangeType !=
+            EMovieSceneDataChangeType::TrackValueChangedRefreshImmediately) {
+        RefreshBoundControlRig();
+    }
+    MarkTransformSyncDirty();
+}
+
+void AStringFlowUnreal::HandleControlModified(
+    UControlRig* ControlRig, FRigControlElement* ControlElement,
+    const FRigControlModifiedContext& Context) {
+    MarkTransformSyncDirty();
+}
+
+void AStringFlowUnreal::HandleHierarchyModified(
+    ERigHierarchyNotification Notification, URigHierarchy* Hierarchy,
+    const FRigNotificationSubject& Subject) {
+    // 选择变化不影响变换
+    if (Notification == ERigHierarchyNotification::ElementSelected ||
+        Notification == ERigHierarchyNotification::ElementDeselected) {
+        return;
+    }
+    // 层级结构或初始姿态的修改都会影响缓存的相对变换
+    InvalidateTransformSyncSetup();
+}
+
+void AStringFlowUnreal::HandleActorMoved(AActor* Actor) {
+    if (Actor && (Actor == this || Actor == SkeletalMeshActor ||
+                  Actor == StringInstrument || Actor == Bow)) {
+        MarkTransformSyncDirty();
+    }
+}
 #endif
 
+void AStringFlowUnreal::GetPlaybackActors(
+    TArray<FInstrumentPlaybackActor>& OutActors) const {
+    Super::GetPlaybackActors(OutActors);
+    if (StringInstrument) {
+        OutActors.Add({TEXT("StringInstrument"), StringInstrument,
+                       TEXT("Strings")});
+    }
+    if (Bow) {
+        OutActors.Add({TEXT("Bow"), Bow, TEXT("Bow")});
+    }
+}
+
 FString AStringFlowUnreal::GetFingerControllerName(
     int32 FingerNumber, EStringFlowHandType HandType) const {
     FString HandStr =
@@ -1,5 +1,6 @@
 ﻿#include "Misc/AutomationTest.h"
 #include "StringFlowUnreal.h"
+#include "StringFlowTransformSyncProcessor.h"
 #include "Misc/Paths.h"
 #include "Misc/FileHelper.h"
 #include "HAL/FileManager.h"
@@ -512,6 +513,69 @@ void FStringFlowUnrealSpec::Define()
 					TestEqual(TEXT("RightHandPositionType should be FAR"), static_cast<int32>(TestActor->RightHandPositionType), static_cast<int32>(EStringFlowRightHandPositionType::FAR));
 				});
 		});
+
+	Describe(TEXT("Event-driven transform sync"), [this]()
+		{
+			It(TEXT("Should request an initial sync"), [this]()
+				{
+					TestTrue(TEXT("New actor should be dirty"), TestActor->IsTransformSyncDirty());
+					TestTrue(TEXT("New actor should need a sync"), TestActor->NeedsRealtimeSync());
+				});
+
+			It(TEXT("Should stay idle after syncing"), [this]()
+				{
+					TestActor->SyncRealtimeNow();
+					TestFalse(TEXT("Dirty flag should be cleared after sync"), TestActor->IsTransformSyncDirty());
+					TestFalse(TEXT("Idle actor should not need a sync"), TestActor->NeedsRealtimeSync());
+				});
+
+			It(TEXT("Should sync again once marked dirty"), [this]()
+				{
+					TestActor->SyncRealtimeNow();
+					TestActor->MarkTransformSyncDirty();
+					TestTrue(TEXT("Marked actor should need a sync"), TestActor->NeedsRealtimeSync());
+				});
+
+			It(TEXT("Should not sync when realtime sync is disabled"), [this]()
+				{
+					TestActor->bEnableRealtimeSync = false;
+					TestActor->MarkTransformSyncDirty();
+					TestFalse(TEXT("Disabled actor should not need a sync"), TestActor->NeedsRealtimeSync());
+				});
+
+			It(TEXT("Should invalidate the relative transform cache through the setup version"), [this]()
+				{
+					TestActor->SyncRealtimeNow();
+					const FStringFlowSyncSetupVersion Before = TestActor->GetTransformSyncSetupVersion();
+					TestTrue(TEXT("Version should be stable without events"), Before == TestActor->GetTransformSyncSetupVersion());
+
+					TestActor->InvalidateTransformSyncSetup();
+					TestTrue(TEXT("Version should change after invalidation"), Before != TestActor->GetTransformSyncSetupVersion());
+					TestTrue(TEXT("Invalidation should request a sync"), TestActor->IsTransformSyncDirty());
+				});
+		});
+
+	Describe(TEXT("ComputeBowWorldTransform"), [this]()
+		{
+			It(TEXT("Should follow bow_controller and point the bow axis at the touch point"), [this]()
+				{
+					const FTransform BowController(FQuat::Identity, FVector(10.0f, 0.0f, 0.0f));
+					FTransform BowTransform;
+					const bool bSuccess = UStringFlowTransformSyncProcessor::ComputeBowWorldTransform(
+						BowController, FVector(10.0f, 20.0f, 0.0f), FVector(1.0f, 0.0f, 0.0f), BowTransform);
+
+					TestTrue(TEXT("Should succeed"), bSuccess);
+					TestTrue(TEXT("Bow should stay at bow_controller"), BowTransform.GetLocation().Equals(FVector(10.0f, 0.0f, 0.0f), KINDA_SMALL_NUMBER));
+					TestTrue(TEXT("Bow X axis should point at the touch point"), BowTransform.GetRotation().GetAxisX().Equals(FVector(0.0f, 1.0f, 0.0f), KINDA_SMALL_NUMBER));
+				});
+
+			It(TEXT("Should fail when BowAxisTowardString is zero"), [this]()
+				{
+					FTransform BowTransform;
+					TestFalse(TEXT("Zero axis should fail"), UStringFlowTransformSyncProcessor::ComputeBowWorldTransform(
+						FTransform::Identity, FVector(0.0f, 10.0f, 0.0f), FVector::ZeroVector, BowTransform));
+				});
+		});
 }
 
 #endif // WITH_AUTOMATION_TESTS
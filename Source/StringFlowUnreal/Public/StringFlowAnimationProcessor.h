@@ -178,6 +178,15 @@ class STRINGFLOWUNREAL_API UStringFlowAnimationProcessor : public UObject {
     UFUNCTION(BlueprintCallable, Category = "StringFlow Animation Processor")
     static void GeneratePerformerAnimation(AStringFlowUnreal* StringFlowActor);
 
+    /**
+     * 恢复轻量撤销模式下保存的上一次生成前的演奏动画（左右手）
+     *
+     * @param StringFlowActor 弦乐器Actor实例
+     * @return 任一只手恢复成功即返回true
+     */
+    UFUNCTION(BlueprintCallable, Category = "StringFlow Animation Processor")
+    static bool RevertPerformerAnimation(AStringFlowUnreal* StringFlowActor);
+
     /**
      * 生成乐器动画
      *
@@ -219,11 +228,55 @@ class STRINGFLOWUNREAL_API UStringFlowAnimationProcessor : public UObject {
      * @param StringFlowActor 弦乐器Actor实例
      * @return 无
      *
-     * @note 会调用 GeneratePerformerAnimation 和 GenerateInstrumentAnimation
+     * @note 会调用 GeneratePerformerAnimation 和 GenerateInstrumentAnimation，
+     *       最后把小提琴和琴弓的跟随关系烘焙为关键帧
+     *       （UStringFlowTransformSyncProcessor::BakeInstrumentTransforms）
      */
     UFUNCTION(BlueprintCallable, Category = "StringFlow Animation Processor")
     static void GenerateAllAnimation(AStringFlowUnreal* StringFlowActor);
 
+    /**
+     * 开始实时预览
+     *
+     * 追踪外部工具正在写入的左右手动画文件，两只手的帧合并到
+     * Live Link Subject "<Actor标签>_Performer"，推送控制器变换
+     *
+     * @param StringFlowActor 弦乐器Actor实例
+     * @return Live Link 源是否已添加
+     */
+    UFUNCTION(BlueprintCallable, Category = "StringFlow Animation Processor")
+    static bool StartLivePreview(AStringFlowUnreal* StringFlowActor);
+
+    /**
+     * 停止实时预览，移除 StartLivePreview 添加的 Live Link 源
+     *
+     * @param StringFlowActor 弦乐器Actor实例
+     */
+    UFUNCTION(BlueprintCallable, Category = "StringFlow Animation Processor")
+    static void StopLivePreview(AStringFlowUnreal* StringFlowActor);
+
+    /**
+     * 开始流式导入
+     *
+     * 连接外部工具的本地端口，边接收左右手的演奏帧边写入演奏者的
+     * Control Rig 轨道，生成开始几秒后即可在 Sequencer 中看到结果
+     *
+     * @param StringFlowActor 弦乐器Actor实例
+     * @param Port 外部工具监听的本地端口
+     * @return 会话是否已开始
+     */
+    UFUNCTION(BlueprintCallable, Category = "StringFlow Animation Processor")
+    static bool StartStreamingImport(AStringFlowUnreal* StringFlowActor,
+                                     int32 Port = 47810);
+
+    /**
+     * 停止流式导入，已收到的帧会先写入 Level Sequence
+     *
+     * @param StringFlowActor 弦乐器Actor实例
+     */
+    UFUNCTION(BlueprintCallable, Category = "StringFlow Animation Processor")
+    static void StopStreamingImport(AStringFlowUnreal* StringFlowActor);
+
     /**
      * 解析StringFlow配置文件
      *
@@ -285,13 +338,15 @@ class STRINGFLOWUNREAL_API UStringFlowAnimationProcessor : public UObject {
      * @param AnimationFilePath 动画JSON文件路径（left_hand.json 或
      * right_hand.json）
      * @param LevelSequence Level Sequence实例
+     * @param FrameWindow 局部重新生成窗口，设置后跳过第4步，只替换窗口内的关键帧
      * @return 无
      *
      * @note 操作的是演奏者模型(SkeletalMeshActor)的Control Rig
      * @note 会自动处理四元数旋转和欧拉角展开
      * @note 支持自动帧率转换
      */
-    static void MakePerformerAnimation(AStringFlowUnreal* StringFlowActor,
-                                       const FString& AnimationFilePath,
-                                       ULevelSequence* LevelSequence);
+    static void MakePerformerAnimation(
+        AStringFlowUnreal* StringFlowActor, const FString& AnimationFilePath,
+        ULevelSequence* LevelSequence,
+        const FAnimationFrameWindow& FrameWindow = FAnimationFrameWindow());
 };
@@ -84,13 +84,15 @@ class STRINGFLOWUNREAL_API UStringFlowMusicInstrumentProcessor
      * @param StringFlowActor StringFlowUnreal 实例
      * @param StringVibrationDataPath 弦振动数据JSON文件路径
      * @param OutVibrationKeyframeData 输出的弦振动关键帧数据
+     * @param FrameWindow 局部重新生成窗口，设置后只替换窗口内的关键帧
      * @return 操作是否成功
      */
     static bool LoadAndGenerateStringVibrationAnimation(
         AStringFlowUnreal* StringFlowActor,
         const FString& StringVibrationDataPath,
         TMap<FString, TTuple<TArray<FFrameNumber>, TArray<FMovieSceneFloatValue>>>&
-            OutVibrationKeyframeData);
+            OutVibrationKeyframeData,
+        const FAnimationFrameWindow& FrameWindow = FAnimationFrameWindow());
 
     /**
      * 将振动数据同步写入材质动画轨道
@@ -101,6 +103,7 @@ class STRINGFLOWUNREAL_API UStringFlowMusicInstrumentProcessor
      * @param VibrationKeyframeData 弦振动关键帧数据
      * @param MinFrame 最小帧数
      * @param MaxFrame 最大帧数
+     * @param FrameWindow 局部重新生成窗口，设置后保留现有Section，只替换窗口内的关键帧
      * @return 成功写入的材质参数轨道数量
      */
     static int32 SyncVibrationToMaterialAnimation(
@@ -108,7 +111,8 @@ class STRINGFLOWUNREAL_API UStringFlowMusicInstrumentProcessor
         const TMap<FString,
                    TTuple<TArray<FFrameNumber>, TArray<FMovieSceneFloatValue>>>&
             VibrationKeyframeData,
-        FFrameNumber MinFrame, FFrameNumber MaxFrame);
+        FFrameNumber MinFrame, FFrameNumber MaxFrame,
+        const FAnimationFrameWindow& FrameWindow = FAnimationFrameWindow());
 
    private:
     /**
@@ -40,6 +40,11 @@ private:
 	FReply OnGeneratePerformerAnimation();
 	FReply OnGenerateInstrumentAnimation();
 	FReply OnGenerateAllAnimation();
+	FReply OnBakeToAnimSequence();
+	FReply OnStartLivePreview();
+	FReply OnStopLivePreview();
+	FReply OnStartStreamingImport();
+	FReply OnStopStreamingImport();
 	FReply OnClearStringControlRigKeyframes();
 	FReply OnInitializeStringInstrument();
 
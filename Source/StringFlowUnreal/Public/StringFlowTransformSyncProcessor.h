@@ -9,6 +9,7 @@
 class AStringFlowUnreal;
 class ASkeletalMeshActor;
 class UControlRig;
+struct FInstrumentSyncFrameContext;
 
 /**
  * StringFlow Transform Sync 处理器
@@ -27,6 +28,10 @@ class UControlRig;
  *    - 旋转同步：bow_root 的指定轴指向 string_touch_point
  *    - 轴配置：通过 BowAxisTowardString 属性配置（如 X、Y、Z 轴）
  *
+ * 3. 烘焙：
+ *    - 生成动画后按帧计算上述跟随关系，写为乐器和琴弓 Control Rig 轨道的
+ *      关键帧，播放、渲染（Movie Render Queue）不再依赖实时同步
+ *
  * ============================================================
  * Control 对应关系：
  * ============================================================
@@ -48,8 +53,9 @@ class STRINGFLOWUNREAL_API UStringFlowTransformSyncProcessor : public UObject {
 
    public:
     /**
-     * 同步所有乐器变换（小提琴和琴弓）
-     * 这是主要的调用入口，通常在 AStringFlowUnreal::Tick() 中调用
+     * 立即同步所有乐器变换（小提琴和琴弓）
+     * 与子系统的批量同步走同一条 Gather/Compute/Apply 路径，
+     * 用于属性修改后立即生效等单个Actor的场景
      *
      * @param StringFlowActor StringFlowUnreal实例
      * @return 同步是否成功
@@ -76,7 +82,66 @@ class STRINGFLOWUNREAL_API UStringFlowTransformSyncProcessor : public UObject {
     UFUNCTION(BlueprintCallable, Category = "StringFlow Transform Sync")
     static bool SyncBowTransform(AStringFlowUnreal* StringFlowActor);
 
+    // ========== 批量实时同步的三个阶段（UInstrumentSyncSubsystem 调度） ==========
+
+    /**
+     * 游戏线程：从共享数据中取得 Control Rig，读取计算需要的变换
+     * 相对变换缓存失效时在这里重新初始化
+     */
+    static void GatherRealtimeSync(AStringFlowUnreal* StringFlowActor,
+                                   const FInstrumentSyncFrameContext& Context,
+                                   FStringFlowRealtimeSyncData& SyncData);
+
+    /** 工作线程：计算 violin_root 和 bow_ctrl 的目标变换，不访问UObject */
+    static void ComputeRealtimeSync(FStringFlowRealtimeSyncData& SyncData);
+
+    /**
+     * 游戏线程：写回计算结果，每个 Control Rig 只求值一次
+     * @return 小提琴和琴弓是否都已写回
+     */
+    static bool ApplyRealtimeSync(AStringFlowUnreal* StringFlowActor,
+                                  const FStringFlowRealtimeSyncData& SyncData);
+
+    /**
+     * 把小提琴和琴弓的跟随关系烘焙为关键帧
+     * 直接从演奏者的 Control Rig Section 按帧并行求出 controller_root、
+     * bow_controller 和 string_touch_point 的变换，计算 violin_root 和
+     * bow_ctrl 的值后写入乐器和琴弓的 Control Rig 轨道
+     *
+     * @param StringFlowActor StringFlowUnreal实例
+     * @return 是否至少烘焙了小提琴或琴弓之一
+     *
+     * @note 设置了 RegenerationWindow 时只替换窗口内的关键帧
+     * @note 控制器的父级链中只有带关键帧通道的 Control 按帧求值，
+     *       其余父级按当前姿态视为不变
+     */
+    UFUNCTION(BlueprintCallable, Category = "StringFlow Transform Sync")
+    static bool BakeInstrumentTransforms(AStringFlowUnreal* StringFlowActor);
+
+    /**
+     * 计算琴弓的世界变换：位置跟随 bow_controller，
+     * 旋转在 bow_controller 旋转的基础上使 BowAxisTowardString 指向触弦点
+     * 实时同步和烘焙共用
+     *
+     * @param BowControllerWorldTransform bow_controller 的世界变换
+     * @param StringTouchPointWorldLocation string_touch_point 的世界位置
+     * @param BowAxisTowardString 琴弓局部坐标系中指向弦的轴
+     * @param OutBowWorldTransform [out] 琴弓的世界变换
+     * @return BowAxisTowardString 为零时返回false
+     */
+    static bool ComputeBowWorldTransform(
+        const FTransform& BowControllerWorldTransform,
+        const FVector& StringTouchPointWorldLocation,
+        const FVector& BowAxisTowardString, FTransform& OutBowWorldTransform);
+
    private:
+    /**
+     * 相对变换缓存版本变化时重新计算 violin_root 相对 controller_root 的变换
+     * @return 缓存是否可用
+     */
+    static bool EnsureStringInstrumentRelationship(
+        AStringFlowUnreal* StringFlowActor);
+
     /**
      * 获取指定骨骼的世界位置和旋转
      *
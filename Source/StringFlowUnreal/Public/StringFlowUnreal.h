@@ -5,9 +5,11 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "InstrumentBase.h"
-#include "Tickable.h"
 #include "StringFlowUnreal.generated.h"
 
+class ISequencer;
+enum class EMovieSceneDataChangeType;
+
 // 手部枚举
 UENUM(BlueprintType)
 enum class EStringFlowHandType : uint8 { LEFT = 0, RIGHT = 1 };
@@ -130,12 +132,67 @@ struct FStringFlowSyncReport {
     }
 };
 
+/**
+ * 小提琴相对变换缓存的版本
+ * 由事件计数（层级修改、Actor变换变化、相关属性修改）和两个 Control Rig
+ * 层级的拓扑版本组成，稳态下比较几个整数即可判断缓存是否仍然有效
+ */
+struct FStringFlowSyncSetupVersion {
+    uint32 EventVersion = 0;
+    uint32 PerformerTopologyVersion = 0;
+    uint32 InstrumentTopologyVersion = 0;
+
+    bool operator==(const FStringFlowSyncSetupVersion& Other) const {
+        return EventVersion == Other.EventVersion &&
+               PerformerTopologyVersion == Other.PerformerTopologyVersion &&
+               InstrumentTopologyVersion == Other.InstrumentTopologyVersion;
+    }
+
+    bool operator!=(const FStringFlowSyncSetupVersion& Other) const {
+        return !(*this == Other);
+    }
+};
+
+/**
+ * 一帧的实时同步数据
+ * Gather 在游戏线程填充输入，Compute 只做数学计算，Apply 在游戏线程写回
+ *
+ * @note Control Rig 指针只在同一帧内有效
+ */
+struct FStringFlowRealtimeSyncData {
+    // ========== 小提琴：violin_root 跟随 controller_root ==========
+    UControlRig* InstrumentControlRig = nullptr;
+    int32 ViolinRootIndex = INDEX_NONE;
+    bool bHasViolinInput = false;
+    FTransform RelativeTransform;
+    FTransform ControllerRootGlobalTransform;
+    FTransform PerformerActorTransform;
+    FTransform InstrumentActorTransform;
+
+    // ========== 琴弓：bow_ctrl 跟随 bow_controller，指向 string_touch_point ==========
+    UControlRig* BowControlRig = nullptr;
+    int32 BowCtrlIndex = INDEX_NONE;
+    bool bHasBowInput = false;
+    FTransform BowControllerGlobalTransform;
+    FTransform StringTouchPointGlobalTransform;
+    FTransform BowActorTransform;
+    FVector BowAxisTowardString = FVector::ZeroVector;
+
+    // ========== 计算结果 ==========
+    bool bViolinReady = false;
+    FTransform ViolinRootGlobalTransform;
+    bool bBowReady = false;
+    FTransform BowCtrlLocalTransform;
+
+    void Reset() { *this = FStringFlowRealtimeSyncData(); }
+};
+
 /**
  * AStringFlowUnreal - 小提琴动画系统的核心Actor类
  * 管理小提琴表演的控制器和记录器配置
  */
 UCLASS(Blueprintable, BlueprintType)
-class STRINGFLOWUNREAL_API AStringFlowUnreal : public AInstrumentBase, public FTickableGameObject {
+class STRINGFLOWUNREAL_API AStringFlowUnreal : public AInstrumentBase {
     GENERATED_BODY()
 
    public:
@@ -145,8 +202,6 @@ class STRINGFLOWUNREAL_API AStringFlowUnreal : public AInstrumentBase, public FT
     virtual void BeginPlay() override;
 
    public:
-    virtual void Tick(float DeltaTime) override;
-
     // ========== 配置参数 ==========
 
     /** 每只手的手指数量（通常为4） */
@@ -177,7 +232,11 @@ class STRINGFLOWUNREAL_API AStringFlowUnreal : public AInstrumentBase, public FT
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Transform Sync")
     FVector BowUpAxis;
 
-    /** 是否启用实时同步弦乐器和琴弓的位置/旋转 */
+    /**
+     * 是否启用实时同步弦乐器和琴弓的位置/旋转
+     * 事件驱动：仅在Sequencer时间变化、演奏者Control被修改或相关Actor移动后
+     * 由 UInstrumentSyncSubsystem 在下一帧同步一次，空闲时不做任何工作
+     */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Transform Sync")
     bool bEnableRealtimeSync;
 
@@ -366,6 +425,28 @@ class STRINGFLOWUNREAL_API AStringFlowUnreal : public AInstrumentBase, public FT
     UFUNCTION(BlueprintCallable, Category = "StringFlow")
     bool ImportRecorderInfo(const FString& FilePath);
 
+    /**
+     * 标记乐器变换需要同步，子系统下一帧执行一次同步
+     * 外部直接修改了演奏者姿态（而没有经过Sequencer或Control Rig通知）时调用
+     */
+    UFUNCTION(BlueprintCallable, Category = "Transform Sync")
+    void MarkTransformSyncDirty() { bTransformSyncDirty = true; }
+
+    /** 是否有待执行的变换同步 */
+    bool IsTransformSyncDirty() const { return bTransformSyncDirty; }
+
+    /**
+     * 使小提琴相对变换缓存失效（下一次同步时重新初始化）
+     * 演奏者/乐器的层级、Actor变换或相关属性变化时由事件调用
+     */
+    void InvalidateTransformSyncSetup() {
+        ++TransformSyncSetupEventVersion;
+        MarkTransformSyncDirty();
+    }
+
+    /** 当前的相对变换缓存版本，只读取计数器，不查找 Control Rig */
+    FStringFlowSyncSetupVersion GetTransformSyncSetupVersion() const;
+
 #if WITH_EDITOR
     /**
      * 在编辑器中属性改变时调用，用于实时同步乐器位置
@@ -373,6 +454,10 @@ class STRINGFLOWUNREAL_API AStringFlowUnreal : public AInstrumentBase, public FT
     virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif
 
+    virtual void PostRegisterAllComponents() override;
+    virtual void PostUnregisterAllComponents() override;
+    virtual void BeginDestroy() override;
+
     // ========== 已创建的对象 ==========
 
     /** 已创建的Actor对象映射 */
@@ -399,43 +484,91 @@ class STRINGFLOWUNREAL_API AStringFlowUnreal : public AInstrumentBase, public FT
     bool bStringInstrumentRelativeTransformInitialized;
 
     /**
-     * 用于检测初始化值是否改变的缓存数组
-     * 存储顺序: [0] ParentInitGlobalTransform
-     *           [1] ChildInitGlobalTransform
-     *           [2] ParentActorWorldTransform
-     *           [3] ChildActorWorldTransform
-     * 当这些值发生变化时，需要重新初始化相对变换矩阵
+     * 初始化相对变换矩阵时的缓存版本
+     * 与 GetTransformSyncSetupVersion() 不一致时需要重新初始化
      */
-    UPROPERTY(VisibleAnywhere, Category = "Transform Sync Cache")
-    TArray<FTransform> CachedInitializationValues;
+    FStringFlowSyncSetupVersion CachedTransformSyncSetupVersion;
 
-    // ========== FTickableGameObject 接口实现 ==========
+    // ========== 实时同步（由 UInstrumentSyncSubsystem 调度） ==========
 
-    /**
-     * 检查该对象是否可 Tick
-     */
-    virtual bool IsTickable() const override {
-        return bEnableRealtimeSync;
-    }
+    /** 编辑器中只在事件标记了变化后同步；游戏世界没有编辑器事件，每帧同步 */
+    virtual bool NeedsRealtimeSync() const override;
 
-    /**
-     * 检查该对象是否在编辑器中可 Tick
-     */
-    virtual bool IsTickableInEditor() const override {
-        return bEnableRealtimeSync;
-    }
+    virtual void GatherRealtimeSync(
+        const FInstrumentSyncFrameContext& Context) override;
 
-    /**
-     * 获取统计信息ID（用于性能分析）
-     */
-    virtual TStatId GetStatId() const override {
-        RETURN_QUICK_DECLARE_CYCLE_STAT(AStringFlowUnreal, STATGROUP_Tickables);
-    }
+    virtual void ComputeRealtimeSync() override;
 
-    /**
-     * 获取性能框架信息
-     */
-    virtual bool IsAllowedToTick() const override {
-        return true;
-    }
+    virtual void ApplyRealtimeSync() override;
+
+    /** 演奏者之外追加小提琴和琴弓 */
+    virtual void GetPlaybackActors(
+        TArray<FInstrumentPlaybackActor>& OutActors) const override;
+
+   private:
+    /** 有待执行的变换同步（创建后先同步一次） */
+    bool bTransformSyncDirty = true;
+
+    /** 本帧的实时同步数据 */
+    FStringFlowRealtimeSyncData RealtimeSyncData;
+
+    /** 使相对变换缓存失效的事件计数 */
+    uint32 TransformSyncSetupEventVersion = 0;
+
+    /** 已订阅的演奏者 Control Rig 层级 */
+    TWeakObjectPtr<URigHierarchy> BoundHierarchy;
+
+    /** 已订阅的乐器 Control Rig 层级 */
+    TWeakObjectPtr<URigHierarchy> BoundInstrumentHierarchy;
+
+    /** 已订阅变换变化的演奏者和乐器根组件（游戏世界中同样有效） */
+    TWeakObjectPtr<USceneComponent> BoundPerformerRoot;
+    TWeakObjectPtr<USceneComponent> BoundInstrumentRoot;
+
+    /** 订阅演奏者和乐器根组件的变换变化 */
+    void RefreshBoundSceneComponents();
+
+    /** 取消根组件的订阅 */
+    void UnbindSceneComponents();
+
+    void HandleSetupTransformUpdated(USceneComponent* Component,
+                                     EUpdateTransformFlags UpdateTransformFlags,
+                                     ETeleportType Teleport);
+
+#if WITH_EDITOR
+    // ========== 变换同步事件订阅 ==========
+
+    /** 订阅Sequencer、Control Rig和Actor移动事件 */
+    void BindTransformSyncEvents();
+
+    /** 取消全部订阅 */
+    void UnbindTransformSyncEvents();
+
+    /** 订阅 Sequencer 的时间变化和数据变化 */
+    void BindSequencer(TSharedRef<ISequencer> Sequencer);
+
+    /** 演奏者或乐器的 Control Rig 实例变化时重新订阅 */
+    void RefreshBoundControlRig();
+
+    void HandleSequencerCreated(TSharedRef<ISequencer> Sequencer);
+    void HandleSequencerTimeChanged();
+    void HandleMovieSceneDataChanged(EMovieSceneDataChangeType DataChangeType);
+    void HandleControlModified(UControlRig* ControlRig,
+                               FRigControlElement* ControlElement,
+                               const FRigControlModifiedContext& Context);
+    void HandleHierarchyModified(ERigHierarchyNotification Notification,
+                                 URigHierarchy* Hierarchy,
+                                 const FRigNotificationSubject& Subject);
+    void HandleActorMoved(AActor* Actor);
+
+    /** 已订阅的 Sequencer */
+    TArray<TWeakPtr<ISequencer>> BoundSequencers;
+
+    /** 已订阅的演奏者 Control Rig */
+    TWeakObjectPtr<UControlRig> BoundControlRig;
+
+    FDelegateHandle OnSequencerCreatedHandle;
+
+    bool bTransformSyncEventsBound = false;
+#endif
 };